@@ -0,0 +1,270 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+// Common implementation of rel-graph-slam-se2 and rel-graph-slam-se3: relative graph-SLAM of g2o or TORO datasets,
+// which are read as a stream and inserted into SRBA in batches of keyframes.
+
+#include <srba.h>
+#include <srba/srba_pose_graph_io.h>
+#include <mrpt/gui.h>  // For rendering results as a 3D scene
+#include <mrpt/system/filesystem.h>
+#include <mrpt/system/os.h>
+#include <mrpt/otherlibs/tclap/CmdLine.h>
+#include <fstream>
+
+// Parameters of the app:
+struct RelGraphSLAM_Params
+{
+	TCLAP::CmdLine cmd;
+	TCLAP::UnlabeledValueArg<std::string> arg_dataset;
+	TCLAP::ValueArg<unsigned int> arg_batch;
+	TCLAP::ValueArg<std::string>  arg_output;
+	TCLAP::SwitchArg  arg_no_gui;
+	TCLAP::ValueArg<unsigned int> arg_verbose;
+
+	RelGraphSLAM_Params(int argc, char**argv, const char *app_name) :
+		cmd(app_name, ' ', mrpt::system::MRPT_getVersion().c_str()),
+		arg_dataset("dataset","Input pose graph (g2o or TORO format)",true,"","dataset.g2o",cmd),
+		arg_batch("","batch","Number of keyframes inserted at once. Faster, but less accurate: the local area is only optimized once per batch, around its last KF, and older KFs of the batch only get their new edges initialized",false,1,"N",cmd),
+		arg_output("o","output","Save the optimized graph to this file; in TORO format if its extension is .graph, g2o otherwise",false,"","out.g2o",cmd),
+		arg_no_gui("","no-gui","Don't display any GUI window",cmd, false),
+		arg_verbose("v","verbose","0:quiet, 1:informative, 2:tons of info",false,1,"",cmd)
+	{
+		cmd.parse( argc, argv );
+	}
+};
+
+/** Relative graph-SLAM of a pose graph file.
+  * \tparam SRBA_T An RbaEngine whose landmarks and observations are relative poses of the same kind as its kf2kf poses.
+  * \tparam OBS_SETTER A class with a static "void set(obs_data_t &obs_data, const pose_t &p)".
+  */
+template <class SRBA_T, class OBS_SETTER>
+struct RelGraphSLAM
+{
+	typedef typename SRBA_T::pose_t                pose_t;
+	typedef srba::PoseGraphFileReader<pose_t>      reader_t;
+	typedef srba::PoseGraphFileWriter<pose_t>      writer_t;
+	typedef typename reader_t::record_t            record_t;
+	typedef std::multimap<srba::TKeyFrameID,record_t,std::less<srba::TKeyFrameID>,
+		Eigen::aligned_allocator<std::pair<const srba::TKeyFrameID,record_t> > > edge_buffer_t;
+
+	SRBA_T         rba;
+	size_t         num_late_edges;  //!< Edges to already inserted KFs, which are ignored
+	srba::TKeyFrameID  next_kf_id;
+
+	RelGraphSLAM() : num_late_edges(0), next_kf_id(0) {}
+
+	/** The observations of a new KF from its buffered edges (the edges to nodes with lower IDs) */
+	void build_kf_observations(
+		const srba::TKeyFrameID cur_kf,
+		edge_buffer_t &edges,
+		typename SRBA_T::new_kf_observations_t &list_obs)
+	{
+		list_obs.clear();
+
+		// To emulate graph-SLAM, each keyframe MUST have exactly ONE fixed "fake landmark", representing its pose:
+		{
+			typename SRBA_T::new_kf_observation_t obs_field;
+			obs_field.is_fixed = true;
+			obs_field.obs.feat_id = cur_kf; // Feature ID == keyframe ID
+			OBS_SETTER::set(obs_field.obs.obs_data, pose_t()); // Landmark values are actually ignored.
+			list_obs.push_back( obs_field );
+		}
+
+		// The rest "observations" are real observations of relative poses:
+		std::set<srba::TKeyFrameID> already_seen;
+		std::pair<typename edge_buffer_t::iterator,typename edge_buffer_t::iterator> rng = edges.equal_range(cur_kf);
+		for (typename edge_buffer_t::iterator it=rng.first;it!=rng.second;++it)
+		{
+			const record_t &e = it->second;
+			const srba::TKeyFrameID other_id = (e.from==cur_kf) ? e.to : e.from;
+			if (other_id==cur_kf || !already_seen.insert(other_id).second)
+				continue; // Self-loops and duplicated edges
+
+			// Get the observation (and invert it if the edge was otherway around):
+			const pose_t observed_pose = (e.from==cur_kf) ? e.pose : -e.pose;
+
+			typename SRBA_T::new_kf_observation_t obs_field;
+			obs_field.is_fixed = false;   // "Landmarks" (relative poses) have unknown relative positions (i.e. treat them as unknowns to be estimated)
+			obs_field.is_unknown_with_init_val = false; // Ignored, since all observed "fake landmarks" already have an initialized value.
+			obs_field.obs.feat_id = other_id;  // The observed KF ID
+			OBS_SETTER::set(obs_field.obs.obs_data, observed_pose);
+			list_obs.push_back( obs_field );
+		}
+		edges.erase(rng.first,rng.second);
+
+		if (cur_kf!=0 && list_obs.size()<2)
+			THROW_EXCEPTION_CUSTOM_MSG1("Node #%u has no edges to previous nodes", static_cast<unsigned int>(cur_kf))
+	}
+
+	/** Inserts all the buffered KFs with IDs < \a up_to_kf_id, in batches of \a batch_size */
+	void flush(const srba::TKeyFrameID up_to_kf_id, edge_buffer_t &edges, const size_t batch_size)
+	{
+		while (next_kf_id<up_to_kf_id)
+		{
+			std::vector<typename SRBA_T::new_kf_observations_t> obs_batch;
+			while (next_kf_id<up_to_kf_id && obs_batch.size()<batch_size)
+			{
+				obs_batch.resize(obs_batch.size()+1);
+				build_kf_observations(next_kf_id++, edges, obs_batch.back());
+			}
+
+			//  Here happens the main stuff: create Key-frames, build structures, run optimization, etc.
+			typename SRBA_T::new_kf_info_vector_t new_kf_infos;
+			rba.define_new_keyframes(obs_batch, new_kf_infos, true /* Also run local optimization */ );
+
+			const typename SRBA_T::TNewKeyFrameInfo &last = new_kf_infos.back();
+			std::cout << "Created KFs #" << new_kf_infos.front().kf_id << "-#" << last.kf_id
+				<< " | Optimization error: " << last.optimize_results.total_sqr_error_init << " -> " << last.optimize_results.total_sqr_error_final << std::endl;
+		}
+	}
+
+	/** Read the dataset as a stream: an edge is buffered under its highest node ID, and KFs are inserted as soon as
+	  * an edge to a higher node ID shows up (datasets are sorted by the highest ID of edges). */
+	void process_dataset(const std::string &sFileDataset, const size_t batch_size)
+	{
+		std::ifstream f(sFileDataset.c_str());
+		if (!f.is_open())
+			THROW_EXCEPTION_CUSTOM_MSG1("Cannot open dataset file: %s", sFileDataset.c_str())
+
+		reader_t reader(f);
+		record_t rec;
+		edge_buffer_t edges;
+		srba::TKeyFrameID max_kf_id = 0;
+
+		while (reader.next(rec))
+		{
+			if (!rec.is_edge)
+				continue; // Vertices' poses are not needed
+			const srba::TKeyFrameID kf_id = std::max(rec.from,rec.to);
+			if (kf_id<next_kf_id)
+			{
+				num_late_edges++;
+				continue;
+			}
+			edges.insert( typename edge_buffer_t::value_type(kf_id,rec) );
+			if (kf_id>max_kf_id)
+			{
+				flush(max_kf_id, edges, batch_size);
+				max_kf_id = kf_id;
+			}
+		}
+		// The rest of KFs:
+		flush(max_kf_id+1, edges, batch_size);
+
+		std::cout << "Dataset read: " << reader.line_number() << " lines, " << next_kf_id << " KFs, " << reader.num_skipped_lines() << " skipped lines.\n";
+		if (num_late_edges)
+			std::cerr << "Warning: " << num_late_edges << " edges to already inserted KFs were ignored (the dataset is not sorted by node IDs).\n";
+	}
+
+	/** Saves the global poses of all KFs (wrt KF #0, from the complete spanning tree), then the edges of the input dataset */
+	void save_output(const std::string &sFileOut, const std::string &sFileDataset)
+	{
+		const srba::pose_graph_format_t fmt = mrpt::system::extractFileExtension(sFileOut)=="graph" ? srba::pgfTORO : srba::pgfG2O;
+		std::ofstream fo(sFileOut.c_str());
+		if (!fo.is_open())
+			THROW_EXCEPTION_CUSTOM_MSG1("Cannot create output file: %s", sFileOut.c_str())
+		writer_t writer(fo, fmt);
+
+		typename SRBA_T::frameid2pose_map_t  spantree;
+		rba.create_complete_spanning_tree(0, spantree);
+
+		for (typename SRBA_T::frameid2pose_map_t::const_iterator it=spantree.begin();it!=spantree.end();++it)
+			writer.write_vertex(it->first, it->second.pose);
+
+		std::ifstream f(sFileDataset.c_str());
+		reader_t reader(f);
+		record_t rec;
+		while (reader.next(rec))
+			if (rec.is_edge)
+				writer.write(rec);
+
+		std::cout << "Optimized graph saved to: " << sFileOut << std::endl;
+	}
+
+	void show_results(const bool show_gui)
+	{
+		// Saving RBA graph as a DOT file:
+		const std::string sFil = "graph.dot";
+		std::cout << "Saving final graph of KFs and LMs to: " << sFil << std::endl;
+		rba.save_graph_as_dot(sFil, true /* LMs=save */);
+
+		// Show final "global" map (spanning tree).
+		typename SRBA_T::TOpenGLRepresentationOptions  opengl_options;
+		opengl_options.draw_kf_hierarchical = true;
+		mrpt::opengl::CSetOfObjectsPtr rba_3d = mrpt::opengl::CSetOfObjects::Create();
+
+		rba.build_opengl_representation(
+			0,  // Root KF
+			opengl_options, // Rendering options
+			rba_3d  // Output scene
+			);
+
+		{
+			mrpt::opengl::COpenGLScene scene;
+			scene.insert(rba_3d);
+			scene.saveToFile("final_global_map.3Dscene");
+		}
+
+#if MRPT_HAS_WXWIDGETS
+		if (show_gui)
+		{
+			mrpt::gui::CDisplayWindow3D win("RBA final map",640,480);
+			{
+				mrpt::opengl::COpenGLScenePtr &scene = win.get3DSceneAndLock();
+				scene->clear();
+				scene->insert(rba_3d);
+				win.unlockAccess3DScene();
+			}
+			win.repaint();
+			win.waitForKey();
+		}
+#else
+		MRPT_UNUSED_PARAM(show_gui);
+#endif
+	}
+};
+
+/** Common main() of the apps, once the engine parameters are set */
+template <class SRBA_T, class OBS_SETTER>
+int rel_graph_slam_main(RelGraphSLAM_Params &params, RelGraphSLAM<SRBA_T,OBS_SETTER> &app)
+{
+	try
+	{
+		app.rba.setVerbosityLevel( params.arg_verbose.getValue() );   // 0: None; 1:Important only; 2:Verbose
+		app.rba.parameters.srba.use_robust_kernel = false;
+
+		// =========== Topology parameters ===========
+		app.rba.parameters.srba.max_tree_depth       =
+		app.rba.parameters.srba.max_optimize_depth   = 3;
+		app.rba.parameters.ecp.submap_size           = 40;
+		app.rba.parameters.ecp.min_obs_to_loop_closure = 1;
+		// ===========================================
+
+		std::cout << "RBA parameters:\n-----------------\n";
+		app.rba.parameters.srba.dumpToConsole();
+
+		const std::string sFileDataset = params.arg_dataset.getValue();
+		std::cout << "Processing "<< sFileDataset << " ...\n";
+		app.process_dataset(sFileDataset, std::max(1u, params.arg_batch.getValue()) );
+
+		if (params.arg_output.isSet())
+			app.save_output(params.arg_output.getValue(), sFileDataset);
+
+		app.show_results(!params.arg_no_gui.isSet());
+		return 0; // All ok
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,70 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include "rel-graph-slam-common.h"
+
+using namespace srba;
+using namespace mrpt::utils;
+using namespace std;
+
+// --------------------------------------------------------------------------------
+// Declare a typedef "my_srba_t" for easily referring to my RBA problem type:
+// --------------------------------------------------------------------------------
+struct RBA_OPTIONS : public RBA_OPTIONS_DEFAULT
+{
+	typedef ecps::local_areas_fixed_size            edge_creation_policy_t;  //!< One of the most important choices: how to construct the relative coordinates graph problem
+	typedef options::sensor_pose_on_robot_none           sensor_pose_on_robot_t;  // sensor pose == robot pose
+	typedef options::observation_noise_constant_matrix<observations::RelativePoses_3D>   obs_noise_matrix_t;      // The sensor noise matrix is the same for all observations and equal to some given matrix
+	typedef options::solver_LM_no_schur_sparse_cholesky  solver_t;
+};
+
+typedef RbaEngine<
+	kf2kf_poses::SE3,                // Parameterization  KF-to-KF poses
+	landmarks::RelativePoses3D,      // Parameterization of landmark positions
+	observations::RelativePoses_3D,  // Type of observations
+	RBA_OPTIONS                  // Other parameters
+	>
+	my_srba_t;
+
+struct ObsSetter
+{
+	static void set(observations::RelativePoses_3D::obs_data_t &obs_data, const mrpt::poses::CPose3D &p)
+	{
+		obs_data.x     = p.x();
+		obs_data.y     = p.y();
+		obs_data.z     = p.z();
+		obs_data.yaw   = p.yaw();
+		obs_data.pitch = p.pitch();
+		obs_data.roll  = p.roll();
+	}
+};
+
+const double STD_NOISE_XYZ = 0.001;
+const double STD_NOISE_ANG = DEG2RAD(0.05);
+
+int main(int argc, char**argv)
+{
+	RelGraphSLAM_Params params(argc,argv,"rel-graph-slam-se3: Relative graph-SLAM of 3D pose graphs (g2o or TORO format)");
+	RelGraphSLAM<my_srba_t,ObsSetter> app;
+
+	//app.rba.parameters.srba.optimize_new_edges_alone  = false;  // skip optimizing new edges one by one? Relative graph-slam without landmarks should be robust enough, but just to make sure we can leave this to "true" (default)
+
+	// Information matrix for relative pose observations:
+	{
+		Eigen::Matrix<double,6,6> ObsL;
+		ObsL.setZero();
+		for (int i=0;i<3;i++) ObsL(i,i) = 1/square(STD_NOISE_XYZ);   // x,y,z
+		for (int i=3;i<6;i++) ObsL(i,i) = 1/square(STD_NOISE_ANG);   // yaw,pitch,roll
+
+		// Set:
+		app.rba.parameters.obs_noise.lambda = ObsL;
+	}
+
+	return rel_graph_slam_main(params, app);
+}
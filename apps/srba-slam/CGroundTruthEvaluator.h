@@ -0,0 +1,282 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <srba.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/poses/CPose3DQuat.h>
+#include <mrpt/utils/CTicTac.h>
+#include <fstream>
+
+/** Incremental evaluation of the errors of the SRBA global map wrt ground truth: the global pose of each KF (wrt KF #0) and the
+  *  global position of each landmark (with unknown relative position).
+  *
+  *  Global poses are composed along a spanning tree of the whole graph which grows with the new KFs (each new KF hangs from its
+  *  neighbor closest to the root), so it's not rebuilt in each evaluation. Only the KFs whose path to the root contains some edge
+  *  which was modified since the last evaluation are recomputed (and the landmarks based on them), level by level of the tree, with
+  *  all the KFs in each level in parallel (OpenMP). Landmark errors are also evaluated in parallel.
+  *
+  *  \tparam SRBA_T The RbaEngine type
+  *  \tparam DATASET Gives the ground truth, with gt_path(KF_ID) and gt_map()
+  */
+template <class SRBA_T, class DATASET>
+class CGroundTruthEvaluator
+{
+public:
+	typedef typename SRBA_T::pose_t      pose_t;
+	typedef typename SRBA_T::k2k_edge_t  k2k_edge_t;
+	typedef typename SRBA_T::array_landmark_t  array_landmark_t;
+	typedef typename SRBA_T::TRelativeLandmarkPos     TRelativeLandmarkPos;
+	typedef typename SRBA_T::TRelativeLandmarkPosMap  TRelativeLandmarkPosMap;
+
+	/** Results of one evaluation */
+	struct TErrors
+	{
+		size_t  num_kfs, num_lms;        //!< Number of evaluated KFs and landmarks
+		size_t  num_kfs_updated, num_lms_updated; //!< How many of them were re-evaluated in this call
+		double  kf_rmse_xyz;             //!< RMSE of the KF positions (meters)
+		double  kf_rmse_ang;             //!< RMSE of the KF orientations (radians)
+		double  lm_rmse;                 //!< RMSE of the landmark positions (meters)
+		double  eval_time;               //!< Time spent in this evaluation (seconds)
+
+		TErrors() : num_kfs(0),num_lms(0),num_kfs_updated(0),num_lms_updated(0),kf_rmse_xyz(0),kf_rmse_ang(0),lm_rmse(0),eval_time(0) {}
+	};
+
+	CGroundTruthEvaluator(const DATASET &dataset) : m_dataset(dataset) {}
+
+	/** Opens a file where the errors of each evaluation are appended */
+	bool open(const std::string &sFile)
+	{
+		m_f.open(sFile.c_str());
+		if (!m_f.is_open()) return false;
+		m_f << "% KF_ID  NUM_KFS  KF_RMSE_XYZ  KF_RMSE_ANG_DEG  NUM_LMS  LM_RMSE  NUM_KFS_UPDATED  NUM_LMS_UPDATED  EVAL_TIME_MS\n";
+		return true;
+	}
+
+	/** Evaluates the errors of the current map and, if a file was open(), appends them to it */
+	TErrors evaluate(const SRBA_T &rba)
+	{
+		mrpt::utils::CTicTac tictac;
+		TErrors res;
+
+		const std::vector<mrpt::utils::TNodeID> dirty_kfs = update_tree(rba);
+		res.num_kfs_updated = dirty_kfs.size();
+
+		// KF pose errors, in parallel:
+		const int nDirty = static_cast<int>(dirty_kfs.size());
+		const mrpt::poses::CPose3D gt_root( m_dataset.gt_path(0) );
+#if defined(_OPENMP)
+#	pragma omp parallel for
+#endif
+		for (int i=0;i<nDirty;i++)
+		{
+			TKF &kf = m_kfs[dirty_kfs[i]];
+			const mrpt::poses::CPose3D gt_pose = mrpt::poses::CPose3D(m_dataset.gt_path(dirty_kfs[i])) - gt_root;
+			const mrpt::poses::CPose3D err = mrpt::poses::CPose3D(kf.global_pose) - gt_pose;
+			kf.sqr_err_xyz = mrpt::utils::square(err.x())+mrpt::utils::square(err.y())+mrpt::utils::square(err.z());
+			const double cos_ang = 0.5*(err.getRotationMatrix().trace()-1);
+			kf.sqr_err_ang = mrpt::utils::square(std::acos( std::max(-1.0,std::min(1.0,cos_ang)) ));
+		}
+
+		double sum_xyz=0, sum_ang=0;
+		for (size_t i=0;i<m_kfs.size();i++)
+		{
+			if (!m_kfs[i].in_tree) continue;
+			sum_xyz+=m_kfs[i].sqr_err_xyz;
+			sum_ang+=m_kfs[i].sqr_err_ang;
+			res.num_kfs++;
+		}
+		if (res.num_kfs)
+		{
+			res.kf_rmse_xyz = std::sqrt(sum_xyz/res.num_kfs);
+			res.kf_rmse_ang = std::sqrt(sum_ang/res.num_kfs);
+		}
+
+		// Landmark errors:
+		if (m_dataset.has_GT_map() && SRBA_T::landmark_t::jacob_family==srba::jacob_point_landmark)
+			evaluate_landmarks(rba, gt_root, res);
+
+		res.eval_time = tictac.Tac();
+
+		if (m_f.is_open())
+		{
+			m_f << rba.get_rba_state().keyframes.size()-1 << " " << res.num_kfs << " " << res.kf_rmse_xyz << " " << RAD2DEG(res.kf_rmse_ang) << " "
+				<< res.num_lms << " " << res.lm_rmse << " " << res.num_kfs_updated << " " << res.num_lms_updated << " " << 1e3*res.eval_time << "\n";
+			m_f.flush();
+		}
+		return res;
+	}
+
+private:
+	const DATASET  &m_dataset;
+	std::ofstream   m_f;
+
+	struct TKF
+	{
+		bool               in_tree;     //!< false if not connected to KF #0
+		const k2k_edge_t  *parent_edge; //!< The edge to the parent KF in the tree (NULL for the root)
+		mrpt::utils::TNodeID parent;
+		size_t             depth;
+		pose_t             edge_pose;   //!< The value of parent_edge->inv_pose when global_pose was computed
+		pose_t             global_pose; //!< Wrt KF #0
+		double             sqr_err_xyz, sqr_err_ang;
+
+		TKF() : in_tree(false),parent_edge(NULL),parent(0),depth(0),sqr_err_xyz(0),sqr_err_ang(0) {}
+		MRPT_MAKE_ALIGNED_OPERATOR_NEW
+	};
+	typename mrpt::aligned_containers<TKF>::deque_t  m_kfs;
+
+	struct TLM
+	{
+		array_landmark_t   pos;     //!< The relative position when the error was computed
+		double             sqr_err;
+		MRPT_MAKE_ALIGNED_OPERATOR_NEW
+	};
+	typedef typename mrpt::aligned_containers<srba::TLandmarkID,TLM>::map_t  lms_map_t;
+	struct TLMToEval
+	{
+		srba::TLandmarkID           id;
+		const TRelativeLandmarkPos *rel;
+		TLM                        *cache;
+	};
+	lms_map_t  m_lms;
+	std::vector<char> m_kf_dirty; //!< Of the last update_tree()
+
+	/** Adds the new KFs to the tree and updates the global poses of those affected by modified edges.
+	  * \return The list of KFs whose global pose was recomputed */
+	std::vector<mrpt::utils::TNodeID> update_tree(const SRBA_T &rba)
+	{
+		const typename SRBA_T::rba_problem_state_t &st = rba.get_rba_state();
+		const size_t nOld = m_kfs.size(), nKFs = st.keyframes.size();
+		m_kfs.resize(nKFs);
+		m_kf_dirty.assign(nKFs,0);
+
+		// New KFs: hang them from the neighbor closest to the root:
+		for (size_t k=nOld;k<nKFs;k++)
+		{
+			TKF &kf = m_kfs[k];
+			if (k==0) { kf.in_tree = true; m_kf_dirty[k] = 1; continue; }
+
+			const std::deque<k2k_edge_t*> &edges = st.keyframes[k].adjacent_k2k_edges;
+			for (size_t i=0;i<edges.size();i++)
+			{
+				const mrpt::utils::TNodeID other = edges[i]->from==k ? edges[i]->to : edges[i]->from;
+				if (other>=k || !m_kfs[other].in_tree) continue;
+				if (!kf.in_tree || m_kfs[other].depth+1<kf.depth)
+				{
+					kf.in_tree = true;
+					kf.parent = other;
+					kf.parent_edge = edges[i];
+					kf.depth = m_kfs[other].depth+1;
+				}
+			}
+		}
+
+		// Which KFs must be updated? Parents always have lower IDs, so one pass suffices:
+		size_t max_depth = 0;
+		for (size_t k=1;k<nKFs;k++)
+		{
+			const TKF &kf = m_kfs[k];
+			if (!kf.in_tree) continue;
+			m_kf_dirty[k] = (k>=nOld || m_kf_dirty[kf.parent] || !(kf.edge_pose==kf.parent_edge->inv_pose)) ? 1:0;
+			if (m_kf_dirty[k]) max_depth = std::max(max_depth,kf.depth);
+		}
+
+		// Recompute global poses, level by level:
+		std::vector<std::vector<mrpt::utils::TNodeID> > levels(max_depth+1);
+		for (size_t k=1;k<nKFs;k++)
+			if (m_kf_dirty[k])
+				levels[m_kfs[k].depth].push_back(k);
+
+		for (size_t d=1;d<levels.size();d++)
+		{
+			const std::vector<mrpt::utils::TNodeID> &lev = levels[d];
+			const int nLev = static_cast<int>(lev.size());
+#if defined(_OPENMP)
+#	pragma omp parallel for
+#endif
+			for (int i=0;i<nLev;i++)
+			{
+				TKF &kf = m_kfs[lev[i]];
+				const TKF &parent = m_kfs[kf.parent];
+				kf.edge_pose = kf.parent_edge->inv_pose;
+				// The edge stores the pose of "from" as seen from "to":
+				if (kf.parent_edge->to==lev[i])
+				     kf.global_pose.composeFrom(parent.global_pose, -kf.edge_pose);
+				else kf.global_pose.composeFrom(parent.global_pose, kf.edge_pose);
+			}
+		}
+
+		std::vector<mrpt::utils::TNodeID> dirty;
+		for (size_t k=0;k<nKFs;k++)
+			if (m_kf_dirty[k])
+				dirty.push_back(k);
+		return dirty;
+	}
+
+	void evaluate_landmarks(const SRBA_T &rba, const mrpt::poses::CPose3D &gt_root, TErrors &res)
+	{
+		const TRelativeLandmarkPosMap &lms = rba.get_unknown_feats();
+		const mrpt::math::CMatrixD &gt_map = m_dataset.gt_map();
+
+		// Collect those to be updated (serially, since the map may grow), and drop removed landmarks:
+		std::vector<TLMToEval> to_eval;
+		typename lms_map_t::iterator it_cache = m_lms.begin();
+		for (typename TRelativeLandmarkPosMap::const_iterator it=lms.begin();it!=lms.end();++it)
+		{
+			if (it->first>=static_cast<srba::TLandmarkID>(gt_map.rows()) || !m_kfs[it->second.id_frame_base].in_tree)
+				continue;
+			while (it_cache!=m_lms.end() && it_cache->first<it->first)
+				m_lms.erase(it_cache++);
+			if (it_cache==m_lms.end() || it_cache->first!=it->first)
+				it_cache = m_lms.insert(it_cache, typename lms_map_t::value_type(it->first,TLM()));
+			else if (!m_kf_dirty[it->second.id_frame_base] && it_cache->second.pos==it->second.pos)
+			{
+				++it_cache;
+				continue; // Up-to-date
+			}
+			const TLMToEval e = { it->first, &it->second, &it_cache->second };
+			to_eval.push_back(e);
+			++it_cache;
+		}
+		m_lms.erase(it_cache,m_lms.end());
+		res.num_lms_updated = to_eval.size();
+
+		const int nEval = static_cast<int>(to_eval.size());
+#if defined(_OPENMP)
+#	pragma omp parallel for
+#endif
+		for (int i=0;i<nEval;i++)
+		{
+			const TRelativeLandmarkPos &rel = *to_eval[i].rel;
+			TLM &lm = *to_eval[i].cache;
+			lm.pos = rel.pos;
+
+			array_landmark_t glob = rel.pos;
+			SRBA_T::landmark_t::composePosePoint(glob, m_kfs[rel.id_frame_base].global_pose);
+
+			const srba::TLandmarkID lm_id = to_eval[i].id;
+			double gx,gy,gz;
+			gt_root.inverseComposePoint(gt_map(lm_id,0),gt_map(lm_id,1),gt_map.cols()>2 ? gt_map(lm_id,2) : 0., gx,gy,gz);
+			const double gt_xyz[3] = {gx,gy,gz};
+
+			lm.sqr_err = 0;
+			for (size_t j=0;j<SRBA_T::LM_DIMS && j<3;j++)
+				lm.sqr_err += mrpt::utils::square(glob[j]-gt_xyz[j]);
+		}
+
+		double sum=0;
+		for (typename lms_map_t::const_iterator it=m_lms.begin();it!=m_lms.end();++it)
+			sum+=it->second.sqr_err;
+		res.num_lms = m_lms.size();
+		if (res.num_lms)
+			res.lm_rmse = std::sqrt(sum/res.num_lms);
+	}
+};
@@ -0,0 +1,196 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mrpt/utils/CTimeLogger.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+/** Fixed-size sketch of the distribution of non-negative values: a histogram of logarithmic bins, so quantiles are
+  *  estimated with a bounded relative error (~4.5%, half a bin), whatever the number of samples. Mean, min and max are exact. */
+class TQuantileSketch
+{
+public:
+	TQuantileSketch() : m_bins(NUM_BINS,0) { clear(); }
+
+	void clear()
+	{
+		std::fill(m_bins.begin(),m_bins.end(),0);
+		m_n = 0;
+		m_sum = 0;
+		m_min = std::numeric_limits<double>::max();
+		m_max = 0;
+	}
+
+	/** Adds \a count samples with value \a v */
+	void add(const double v, const uint64_t count = 1)
+	{
+		if (!count) return;
+		m_bins[bin_index(v)] += count;
+		m_n += count;
+		m_sum += v*count;
+		if (v<m_min) m_min = v;
+		if (v>m_max) m_max = v;
+	}
+
+	uint64_t count() const { return m_n; }
+	double mean() const { return m_n ? m_sum/m_n : 0.; }
+	double min() const { return m_n ? m_min : 0.; }
+	double max() const { return m_max; }
+
+	/** Estimated q-quantile (q in [0,1]) */
+	double quantile(const double q) const
+	{
+		if (!m_n) return 0.;
+		const uint64_t rank = static_cast<uint64_t>(q*(m_n-1));
+		uint64_t acc = 0;
+		for (size_t i=0;i<NUM_BINS;i++)
+		{
+			acc+=m_bins[i];
+			if (acc>rank)
+				return std::min(m_max, std::max(m_min, bin_center(i)));
+		}
+		return m_max;
+	}
+
+private:
+	static const int    LOG2_MIN = -30;  //!< Smallest resolved value: 2^-30 (~1 ns if values are times in seconds)
+	static const int    LOG2_MAX = 34;   //!< Largest resolved value: 2^34
+	static const int    BINS_PER_OCTAVE = 8;
+	static const size_t NUM_BINS = (LOG2_MAX-LOG2_MIN)*BINS_PER_OCTAVE + 2; //!< Plus one bin for underflows and one for overflows
+
+	std::vector<uint64_t> m_bins;
+	uint64_t m_n;
+	double   m_sum, m_min, m_max;
+
+	static size_t bin_index(const double v)
+	{
+		if (!(v>=std::ldexp(1.0,LOG2_MIN))) return 0;  // Also NaNs
+		const double b = (std::log(v)/std::log(2.0) - LOG2_MIN) * BINS_PER_OCTAVE;
+		return std::min(NUM_BINS-1, static_cast<size_t>(b)+1);
+	}
+	static double bin_center(const size_t i)
+	{
+		if (i==0) return 0.;
+		return std::pow(2.0, LOG2_MIN + (i-0.5)/BINS_PER_OCTAVE );
+	}
+};
+
+/** Streaming profile statistics for long runs: after each keyframe, the calls to each section of a CTimeLogger since the
+  *  previous keyframe are added to fixed-size sketches (one per profiler section), so memory doesn't grow with the length of the run.
+  *  Every few keyframes, the summaries of the last window are appended to a CSV file, one line per section, so latency
+  *  drifts can be monitored while the program is still running. A summary of the whole run is saved at the end.
+  *
+  *  The logger is not modified, so its own stats still cover the whole run. Since it only reports the number of calls and the mean
+  *  time of each section, the calls since the previous keyframe are found by differences, and accounted with their mean time.
+  */
+class CProfileStatsStreamer
+{
+public:
+	CProfileStatsStreamer() : m_window_first_ts(0), m_num_window_samples(0) {}
+
+	/** Opens "<prefix>_stats.csv" for the rolling summaries; the final summary goes to "<prefix>_summary.csv" */
+	bool open(const std::string &prefix)
+	{
+		m_prefix = prefix;
+		m_f.open((prefix+std::string("_stats.csv")).c_str());
+		if (!m_f.is_open()) return false;
+		m_f << "timestep_ini\ttimestep_end\tsection\tcount\tmean\tmin\tp50\tp90\tp99\tmax\n";
+		m_f.flush();
+		return true;
+	}
+
+	/** Adds to the sketches the calls registered in \a tl since the previous call */
+	void collect(const mrpt::utils::CTimeLogger &tl)
+	{
+		std::map<std::string,mrpt::utils::CTimeLogger::TCallStats> cur_stats;
+		tl.getStats(cur_stats);
+		for (std::map<std::string,mrpt::utils::CTimeLogger::TCallStats>::const_iterator it=cur_stats.begin();it!=cur_stats.end();++it)
+		{
+			const uint64_t n = it->second.n_calls;
+			const double total_t = it->second.mean_t * n;
+			TSnapshot &prev = m_last_snapshot[it->first];
+			if (n<prev.n_calls) prev = TSnapshot(); // The logger was reset by someone else
+			if (n>prev.n_calls)
+				add_value(it->first, std::max(0.0, total_t-prev.total_t)/(n-prev.n_calls), n-prev.n_calls);
+			prev.n_calls = n;
+			prev.total_t = total_t;
+		}
+		m_num_window_samples++;
+	}
+
+	/** Adds values which are not from the profiler (e.g. the size of the map) */
+	void add_value(const std::string &name, const double v, const uint64_t count = 1)
+	{
+		TSection &s = m_sections[name];
+		s.window.add(v,count);
+		s.total.add(v,count);
+	}
+
+	/** Writes the summary of the current window (ending at \a timestep) and starts a new one */
+	void flush_window(const size_t timestep)
+	{
+		if (!m_num_window_samples) return;
+		for (std::map<std::string,TSection>::iterator it=m_sections.begin();it!=m_sections.end();++it)
+		{
+			if (!it->second.window.count()) continue;
+			m_f << m_window_first_ts << "\t" << timestep << "\t\"" << it->first << "\"\t";
+			write_summary(m_f, it->second.window);
+			it->second.window.clear();
+		}
+		m_f.flush();
+		m_window_first_ts = timestep+1;
+		m_num_window_samples = 0;
+	}
+
+	/** Flushes the last window and saves the summary of the whole run */
+	void close(const size_t last_timestep)
+	{
+		flush_window(last_timestep);
+		m_f.close();
+
+		std::ofstream f((m_prefix+std::string("_summary.csv")).c_str());
+		f << "section\tcount\tmean\tmin\tp50\tp90\tp99\tmax\n";
+		for (std::map<std::string,TSection>::const_iterator it=m_sections.begin();it!=m_sections.end();++it)
+		{
+			f << "\"" << it->first << "\"\t";
+			write_summary(f, it->second.total);
+		}
+	}
+
+private:
+	struct TSection
+	{
+		TQuantileSketch window, total;
+	};
+	/** Stats of a profiler section as of the last collect() */
+	struct TSnapshot
+	{
+		TSnapshot() : n_calls(0), total_t(0) {}
+		uint64_t n_calls;
+		double   total_t;
+	};
+
+	std::string   m_prefix;
+	std::ofstream m_f;
+	std::map<std::string,TSection> m_sections;
+	std::map<std::string,TSnapshot> m_last_snapshot;
+	size_t        m_window_first_ts, m_num_window_samples;
+
+	static void write_summary(std::ostream &f, const TQuantileSketch &s)
+	{
+		f << s.count() << "\t" << s.mean() << "\t" << s.min() << "\t" << s.quantile(0.5) << "\t" << s.quantile(0.9) << "\t" << s.quantile(0.99) << "\t" << s.max() << "\n";
+	}
+};
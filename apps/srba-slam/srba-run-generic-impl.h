@@ -15,6 +15,7 @@
 #include <mrpt/system/threads.h>  // for sleep()
 #include <mrpt/random.h>
 #include <mrpt/utils/CFileOutputStream.h>  // For mrpt::math::CMatrixDouble
+#include <mrpt/utils/CConfigFile.h>
 #include <mrpt/vision/CVideoFileWriter.h>
 #include <mrpt/opengl/CGridPlaneXY.h>
 #include <mrpt/opengl/CSetOfLines.h>
@@ -22,6 +23,9 @@
 #include <mrpt/opengl/CPointCloud.h>
 #include <mrpt/opengl/stock_objects.h>
 #include <mrpt/gui/CDisplayWindow3D.h>
+#include <srba/srba_api_replay.h>
+#include "CProfileStatsStreamer.h"
+#include "CGroundTruthEvaluator.h"
 
 // We can use "using namespace" in this header since it's designed to be only included in this app, not in user code.
 using namespace std;
@@ -132,12 +136,18 @@ struct RBA_Run : public RBA_Run_Base
 		//rba.parameters.srba.feedback_user_iteration = &optimization_feedback;
 
 		if (cfg.arg_rba_params_cfg_file.isSet() && mrpt::system::fileExists(cfg.arg_rba_params_cfg_file.getValue()))
-			rba.parameters.srba.loadFromConfigFileName(cfg.arg_rba_params_cfg_file.getValue(), "srba");
+		{
+			const mrpt::utils::CConfigFile rba_cfg(cfg.arg_rba_params_cfg_file.getValue());
+			rba.parameters.srba.loadFromConfigFile(rba_cfg, "srba");
+			rba.parameters.cost_model.loadFromConfigFile(rba_cfg, "cost_model");
+		}
 
 		if (cfg.arg_write_rba_params_cfg_file.isSet())
 		{
-			rba.parameters.srba.saveToConfigFileName(cfg.arg_write_rba_params_cfg_file.getValue(), "srba");
-			return 0; // end program
+			mrpt::utils::CConfigFile rba_cfg(cfg.arg_write_rba_params_cfg_file.getValue());
+			rba.parameters.srba.saveToConfigFile(rba_cfg, "srba");
+			rba.parameters.cost_model.saveToConfigFile(rba_cfg, "cost_model");
+			return 0; // end program (the file is written upon destruction of rba_cfg)
 		}
 
 		// Override max ST depth:
@@ -189,6 +199,29 @@ struct RBA_Run : public RBA_Run_Base
 			cout << endl;
 		}
 
+		// Replay a recorded session instead of processing the dataset?
+		if (cfg.arg_replay_api.isSet())
+		{
+			RbaEngineApiReplayer<my_srba_t> replayer;
+			replayer.open(cfg.arg_replay_api.getValue());
+			cout << "Replaying API log recorded with: " << replayer.get_user_data() << endl;
+
+			mrpt::utils::CTicTac tictac;
+			const size_t nCalls = replayer.replay_all(rba);
+			cout << "Replayed " << nCalls << " calls in " << tictac.Tac() << " s.\n";
+
+			if (replayer.get_num_mismatches())
+			{
+				cerr << "*WARNING* " << replayer.get_num_mismatches() << " calls gave results different from the recorded ones!\n";
+				return 1;
+			}
+			cout << "All the recorded results were reproduced exactly.\n";
+			return 0; // Profiler stats are dumped upon destruction of the engine.
+		}
+
+		if (cfg.arg_record_api.isSet())
+			rba.start_api_recording(cfg.arg_record_api.getValue(), cfg.cmd_line);
+
 		const unsigned int	INCREMENTAL_FRAMES_AT_ONCE  = 1;
 		//const unsigned int	MAX_KNOWN_FEATS_PER_FRAME   =cfg.arg_max_known_feats_per_frame.getValue();
 
@@ -316,10 +349,27 @@ struct RBA_Run : public RBA_Run_Base
 		typename my_srba_t::TRelativeLandmarkPosMap  all_fixed_LMs;
 		typename my_srba_t::TRelativeLandmarkPosMap  all_unknown_LMs_GT; // Ground truth of relative position for feats with unknown rel.pos.
 
-		// Timming stats:
-		map<string,vector<double> >  timming_section_mean_times;
-		map<string,vector<size_t> >  timming_section_call_count;
-		vector<size_t> timming_section_ts; // The time indices for the above.
+		// Timming stats, streamed to disk with bounded memory:
+		CProfileStatsStreamer profile_stats;
+		if (SAVE_TIMING_STATS)
+		{
+			const string sStatsPrefix = mrpt::format("%s_%s", mrpt::system::fileNameStripInvalidChars(cfg.arg_profile_stats.getValue()).c_str(), mrpt::system::fileNameStripInvalidChars( mrpt::system::dateTimeToString( mrpt::system::getCurrentLocalTime() ) ).c_str() );
+			cout << "Saving time stats to: " << sStatsPrefix << "_stats.csv" << endl;
+			if (!profile_stats.open(sStatsPrefix))
+				throw std::runtime_error(mrpt::format("Error creating time stats file with prefix: %s", sStatsPrefix.c_str()));
+		}
+
+		// Periodic evaluation of errors wrt ground truth:
+		const size_t GT_EVAL_PERIOD = dataset.has_GT_path() ? cfg.arg_gt_eval_period.getValue() : 0;
+		if (cfg.arg_gt_eval_period.getValue() && !dataset.has_GT_path())
+			cerr << "*WARNING* --gt-eval-period ignored, since there is no ground truth path (--gt-path)\n";
+		CGroundTruthEvaluator<my_srba_t,CDatasetParserTempl<OBS_TYPE> > gt_eval(dataset);
+		if (GT_EVAL_PERIOD)
+		{
+			cout << "Saving ground truth errors to: " << cfg.arg_gt_eval_file.getValue() << endl;
+			if (!gt_eval.open(cfg.arg_gt_eval_file.getValue()))
+				throw std::runtime_error(mrpt::format("Error creating file: %s", cfg.arg_gt_eval_file.getValue().c_str()));
+		}
 
 		// Simul counters
 		srba::TKeyFrameID  frameIdx;
@@ -501,6 +551,10 @@ struct RBA_Run : public RBA_Run_Base
 
 				next_rba_keyframe_ID = 1 + new_kf_info.kf_id;  // Update last KF ID:
 
+				// Errors wrt ground truth (out of the timed section):
+				if (GT_EVAL_PERIOD && (new_kf_info.kf_id % GT_EVAL_PERIOD)==0)
+					gt_eval.evaluate(rba);
+
 				if (obsIdx<nTotalObs)
 				{
 					ASSERT_EQUAL_(next_rba_keyframe_ID, curFrameIdx)  // This should occur if key_frames in simulation are ordered
@@ -622,27 +676,17 @@ struct RBA_Run : public RBA_Run_Base
 			// Profile stats:
 			if (SAVE_TIMING_STATS)
 			{
+				// Add the timings of this KF to the sketches (the profiler keeps the stats of the whole run):
+				profile_stats.collect(rba.get_time_profiler());
+
 				if ((curFrameIdx % SAVE_TIMING_SEGMENT_LENGTH) == 0  )
 				{
-					// Append time index:
-					timming_section_ts.push_back( curFrameIdx );
-
-					// Append times:
-					map<string,mrpt::utils::CTimeLogger::TCallStats> cur_stats;
-					rba.get_time_profiler().getStats(cur_stats);
-
-					for (map<string,mrpt::utils::CTimeLogger::TCallStats>::const_iterator it=cur_stats.begin();it!=cur_stats.end();++it)
-					{
-						timming_section_mean_times[ it->first ].push_back( it->second.mean_t );
-						timming_section_call_count[ it->first ].push_back( it->second.n_calls );
-					}
-
 					// Other useful stats (although not being times):
-					timming_section_mean_times[ "total_num_kfs" ].push_back( rba.get_rba_state().keyframes.size() );
-					timming_section_mean_times[ "total_num_lms" ].push_back( rba.get_known_feats().size() + rba.get_unknown_feats().size()  );
-					timming_section_mean_times[ "total_num_obs" ].push_back( rba.get_rba_state().all_observations.size() );
+					profile_stats.add_value( "total_num_kfs", rba.get_rba_state().keyframes.size() );
+					profile_stats.add_value( "total_num_lms", rba.get_known_feats().size() + rba.get_unknown_feats().size()  );
+					profile_stats.add_value( "total_num_obs", rba.get_rba_state().all_observations.size() );
 
-					rba.get_time_profiler().clear(); // Reset timers stats
+					profile_stats.flush_window(curFrameIdx);
 				}
 			}
 
@@ -747,7 +791,7 @@ struct RBA_Run : public RBA_Run_Base
 			double total_obs_sqr_err = rba.eval_overall_squared_error();
 			cout << "total_obs_sqr_err = " << total_obs_sqr_err << endl;
 
-			const size_t nObs = rba.get_rba_state().all_observations.size();
+			const size_t nObs = rba.get_rba_state().all_observations.size() - rba.get_rba_state().num_removed_observations;
 			if (nObs) cout << "RMSE per observation = " << sqrt(total_obs_sqr_err / nObs ) << endl;
 		}
 
@@ -774,59 +818,9 @@ struct RBA_Run : public RBA_Run_Base
 		}
 #endif
 
-		// Save profile stats to disk
+		// Last window and summary of the whole run of profile stats:
 		if (SAVE_TIMING_STATS)
-		{
-			const string sStatsPrefix = mrpt::format("%s_%s", mrpt::system::fileNameStripInvalidChars(cfg.arg_profile_stats.getValue()).c_str(), mrpt::system::fileNameStripInvalidChars( mrpt::system::dateTimeToString( mrpt::system::getCurrentLocalTime() ) ).c_str() );
-
-			const string sStatsMean = sStatsPrefix + string("_means.csv");
-			const string sStatsCalls = sStatsPrefix + string("_calls.csv");
-
-			cout << "Saving time stats to:\n" << sStatsMean << endl << sStatsCalls << endl;
-
-			std::stringstream s_means, s_calls;
-
-			const size_t N = timming_section_ts.size();
-
-			// Header line:
-			s_means << "timestep";
-			s_calls << "timestep";
-			for (map<string,vector<double> >::const_iterator it=timming_section_mean_times.begin();it!=timming_section_mean_times.end();++it)
-			{
-				if (it->second.size()!=N) continue;
-
-				s_means << "\t \"" << it->first << "\"";
-				s_calls << "\t \"" << it->first << "\"";
-			}
-			s_means << endl;
-			s_calls << endl;
-
-			// The rest of lines:
-			for (size_t i=0;i<N;i++)
-			{
-				s_means << timming_section_ts[i];
-				for (map<string,vector<double> >::const_iterator it=timming_section_mean_times.begin();it!=timming_section_mean_times.end();++it)
-				{
-					if (it->second.size()!=N) continue;
-					s_means << "\t" << it->second[i];
-				}
-				s_means << endl;
-
-				s_calls << timming_section_ts[i];
-				for (map<string,vector<size_t> >::const_iterator it=timming_section_call_count.begin();it!=timming_section_call_count.end();++it)
-				{
-					if (it->second.size()!=N) continue;
-					s_calls << "\t" << it->second[i];
-				}
-				s_calls << endl;
-			}
-
-			mrpt::utils::CFileOutputStream f_means(sStatsMean), f_calls(sStatsCalls);
-			f_means.printf("%s", s_means.str().c_str() );
-			f_calls.printf("%s", s_calls.str().c_str() );
-
-			cout << "Done.\n";
-		}
+			profile_stats.close(next_rba_keyframe_ID>0 ? next_rba_keyframe_ID-1 : 0);
 
 
 		if (cfg.arg_save_final_graph.isSet())
@@ -57,6 +57,12 @@ struct RBASLAM_Params
 	TCLAP::SwitchArg   arg_eval_overall_sqr_error;
 	TCLAP::SwitchArg   arg_eval_overall_se3_error;
 	TCLAP::SwitchArg   arg_eval_connectivity;
+	TCLAP::ValueArg<unsigned int> arg_gt_eval_period;
+	TCLAP::ValueArg<std::string>  arg_gt_eval_file;
+	TCLAP::ValueArg<std::string> arg_record_api;
+	TCLAP::ValueArg<std::string> arg_replay_api;
+
+	std::string cmd_line; //!< The whole command line, as a single string
 
 	// Parse all cmd-line arguments at construction
 	// ---------------------------------------------------
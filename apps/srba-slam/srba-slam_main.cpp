@@ -79,8 +79,8 @@ RBASLAM_Params::RBASLAM_Params(int argc, char**argv) :
 	arg_list_obs("","list-problems","List all implemented values for '--obs'",cmd, false),
 	arg_no_gui("","no-gui","Don't show the live gui",cmd, false),
 	arg_gui_step_by_step("","step-by-step","If showing the gui, go step by step",cmd, false),
-	arg_profile_stats("","profile-stats","Generate profile stats to CSV files, with the given prefix",false,"","stats",cmd),
-	arg_profile_stats_length("","profile-stats-length","Length in KFs of each saved profiled segment",false,10,"",cmd),
+	arg_profile_stats("","profile-stats","Stream profile stats (mean and quantiles of each profiled section) to CSV files with the given prefix, with bounded memory",false,"","stats",cmd),
+	arg_profile_stats_length("","profile-stats-length","Length in KFs of each window of rolling profile stats, flushed to disk at the end of each window",false,10,"",cmd),
 	arg_add_noise("","add-noise","Add AWG noise to the dataset",cmd, false),
 	arg_noise("","noise","One sigma of the noise model of every component of observations (images,...) or to linear components if they're mixed (default: sensor-dependent)\n If a SRBA config is provided, it will override this value.",false,0.0,"noise_std",cmd),
 	arg_noise_ang("","noise-ang","One sigma of the noise model of every angular component of observations, in degrees (default: sensor-dependent)\n If a SRBA config is provided, it will override this value.",false,0.0,"noise_std",cmd),
@@ -101,8 +101,15 @@ RBASLAM_Params::RBASLAM_Params(int argc, char**argv) :
 	arg_save_final_graph_landmarks("","save-final-graph-landmarks","Save the final graph-map (all KFs and all Landmarks) to a .dot file",false,"","final-map.dot",cmd),
 	arg_eval_overall_sqr_error("","eval-overall-sqr-error","At end, evaluate the overall square error for all the observations with the final estimated model",cmd, false),
 	arg_eval_overall_se3_error("","eval-overall-se3-error","At end, evaluate the overall SE3 error for all relative poses",cmd, false),
-	arg_eval_connectivity("","eval-connectivity","At end, make stats on the graph connectivity",cmd, false)
+	arg_eval_connectivity("","eval-connectivity","At end, make stats on the graph connectivity",cmd, false),
+	arg_gt_eval_period("","gt-eval-period","Evaluate the errors of KF poses and landmarks wrt the ground truth every N KFs (0=never). Requires --gt-path",false,0,"N",cmd),
+	arg_gt_eval_file("","gt-eval-file","File where the ground truth errors of --gt-eval-period are saved",false,"gt_errors.txt","gt_errors.txt",cmd),
+	arg_record_api("","record-api","Record all the calls to the SRBA engine into a binary log file, for later replay with --replay-api",false,"","session.srbalog",cmd),
+	arg_replay_api("","replay-api","Instead of processing the dataset, replay an API log recorded with --record-api (use the same command line as in the recording) and check that its results are reproduced exactly",false,"","session.srbalog",cmd)
 {
+	for (int i=0;i<argc;i++)
+		cmd_line += (i>0 ? std::string(" ") : std::string()) + std::string(argv[i]);
+
 	// Parse arguments:
 	if (!cmd.parse( argc, argv ))
 		throw std::runtime_error(""); // should exit, but without any error msg (should have been dumped to cerr)
@@ -117,6 +124,9 @@ RBASLAM_Params::RBASLAM_Params(int argc, char**argv) :
 	if (!arg_obs.isSet() && !arg_graph_slam.isSet())
 		throw std::runtime_error("Error: argument --obs is mandatory (in non-graph-SLAM) to select the type of observations.\nRun with --list-problems or --help to see all the options or visit http://www.mrpt.org/srba for docs and examples.\n");
 
+	if (arg_record_api.isSet() && arg_replay_api.isSet())
+		throw std::runtime_error("Error: --record-api and --replay-api can't be used at once.");
+
 	if (arg_obs.isSet() && arg_graph_slam.isSet())
 		throw std::runtime_error("Error: argument --obs doesn't apply to relative graph-SLAM.\nRun with --list-problems or --help to see all the options or visit http://www.mrpt.org/srba for docs and examples.\n");
 
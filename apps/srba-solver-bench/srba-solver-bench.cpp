@@ -0,0 +1,138 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+// Runs and times all the solver engines on linear systems saved by RbaEngine
+//  with parameters.srba.dump_linear_systems_prefix, e.g. from:
+//   srba-slam [...] --cfg-file-rba rba.cfg   (with "dump_linear_systems_prefix=sys" in its [srba] section)
+//   srba-solver-bench sys_*.srbals
+
+#include <srba.h>
+#include <srba/srba_linear_system_dump.h>
+#include <mrpt/utils/CTicTac.h>
+
+using namespace srba;
+using namespace std;
+
+const unsigned int NUM_REPETITIONS = 5;
+const double LAMBDA_RETRY_FACTOR = 10.0; // As if Lev-Marq had to retry with a larger lambda
+
+template <class SOLVER_ENGINE, class RBA_ENGINE>
+void bench_solver(const char *solver_name, const TLinearSystemDump<RBA_ENGINE> &sys, mrpt::utils::CTimeLogger &profiler)
+{
+	typedef SOLVER_ENGINE solver_t;
+
+	double t_setup=0, t_solve=0, t_resolve=0;
+	double err=-1, err_resolve=-1;
+	mrpt::utils::CTicTac tictac;
+
+	for (unsigned int rep=0;rep<NUM_REPETITIONS;rep++)
+	{
+		// Solvers may overwrite the Hessians (e.g. with the Schur complement), so each run starts from a fresh copy:
+		typename TLinearSystemDump<RBA_ENGINE>::hessian_Ap_t  HAp  = sys.HAp;
+		typename TLinearSystemDump<RBA_ENGINE>::hessian_f_t   Hf   = sys.Hf;
+		typename TLinearSystemDump<RBA_ENGINE>::hessian_Apf_t HApf = sys.HApf;
+		Eigen::VectorXd minus_grad = sys.minus_grad;
+
+		tictac.Tic();
+		solver_t solver(0 /*verbose*/, profiler, HAp,Hf,HApf, minus_grad, sys.nUnknowns_k2k, sys.nUnknowns_k2f);
+		t_setup += tictac.Tac();
+
+		tictac.Tic();
+		const bool ok = solver.solve(sys.lambda);
+		t_solve += tictac.Tac();
+		if (ok) err = sys.eval_solution_error(sys.lambda, solver.delta_eps);
+
+		solver.realize_lambda_changed();
+		tictac.Tic();
+		const bool ok_resolve = solver.solve(LAMBDA_RETRY_FACTOR*sys.lambda);
+		t_resolve += tictac.Tac();
+		if (ok_resolve) err_resolve = sys.eval_solution_error(LAMBDA_RETRY_FACTOR*sys.lambda, solver.delta_eps);
+	}
+
+	const double K = 1e3/NUM_REPETITIONS;
+	cout << mrpt::format("  %-30s setup=%9.3f ms solve=%9.3f ms re-solve=%9.3f ms", solver_name, K*t_setup, K*t_solve, K*t_resolve);
+	if (err<0 || err_resolve<0)
+	     cout << "  (not positive definite)\n";
+	else cout << mrpt::format("  rel.err=%.2e/%.2e\n", err, err_resolve);
+}
+
+template <class RBA_ENGINE>
+void bench_all_solvers(const string &file)
+{
+	TLinearSystemDump<RBA_ENGINE> sys;
+	sys.load(file);
+
+	size_t nHAp=0, nHApf=0;
+	for (size_t i=0;i<sys.nUnknowns_k2k;i++) {
+		nHAp  += sys.HAp.getCol(i).size();
+		nHApf += sys.HApf.getCol(i).size();
+	}
+	cout << file << ": #k2k=" << sys.nUnknowns_k2k << " #k2f=" << sys.nUnknowns_k2f << " #obs=" << sys.residuals.size()
+		<< " #blocks HAp=" << nHAp << " HApf=" << nHApf << " lambda=" << sys.lambda << endl;
+
+	mrpt::utils::CTimeLogger profiler(false);
+
+	// Add new solver engines here:
+	bench_solver<internal::solver_engine<true ,true ,RBA_ENGINE> >("LM_schur_dense_cholesky",   sys, profiler);
+	bench_solver<internal::solver_engine<true ,false,RBA_ENGINE> >("LM_schur_sparse_cholesky",  sys, profiler);
+	bench_solver<internal::solver_engine<false,false,RBA_ENGINE> >("LM_no_schur_sparse_cholesky",sys, profiler);
+	// External linear solver backends:
+	bench_solver<internal::solver_engine_backend<true ,linear_solvers::eigen_simplicial_ldlt,RBA_ENGINE> >("LM_schur_eigen_ldlt",   sys, profiler);
+	bench_solver<internal::solver_engine_backend<false,linear_solvers::eigen_simplicial_ldlt,RBA_ENGINE> >("LM_no_schur_eigen_ldlt",sys, profiler);
+	bench_solver<internal::solver_engine_backend<true ,linear_solvers::eigen_simplicial_llt ,RBA_ENGINE> >("LM_schur_eigen_llt",    sys, profiler);
+	bench_solver<internal::solver_engine_backend<true ,linear_solvers::csparse_cholesky     ,RBA_ENGINE> >("LM_schur_csparse",      sys, profiler);
+	bench_solver<internal::solver_engine_backend<true ,linear_solvers::mixed_precision_dense_llt<>     ,RBA_ENGINE> >("LM_schur_mixed_dense_llt",      sys, profiler);
+	bench_solver<internal::solver_engine_backend<false,linear_solvers::mixed_precision_simplicial_llt<>,RBA_ENGINE> >("LM_no_schur_mixed_simplicial_llt",sys, profiler);
+#if defined(SRBA_HAS_CHOLMOD)
+	bench_solver<internal::solver_engine_backend<true ,linear_solvers::cholmod_supernodal_llt,RBA_ENGINE> >("LM_schur_cholmod",     sys, profiler);
+	bench_solver<internal::solver_engine_backend<false,linear_solvers::cholmod_supernodal_llt,RBA_ENGINE> >("LM_no_schur_cholmod",  sys, profiler);
+#endif
+}
+
+// Only the dimensions of the problem matter to solvers, so one RbaEngine type is needed for each combination:
+typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D,     observations::MonocularCamera>  srba_se3_lm3d_obs2d_t;
+typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D,     observations::Cartesian_3D>     srba_se3_lm3d_obs3d_t;
+typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D,     observations::StereoCamera>     srba_se3_lm3d_obs4d_t;
+typedef RbaEngine<kf2kf_poses::SE2, landmarks::Euclidean2D,     observations::RangeBearing_2D>  srba_se2_lm2d_obs2d_t;
+typedef RbaEngine<kf2kf_poses::SE2, landmarks::RelativePoses2D, observations::RelativePoses_2D> srba_se2_lm3d_obs3d_t;
+typedef RbaEngine<kf2kf_poses::SE3, landmarks::RelativePoses3D, observations::RelativePoses_3D> srba_se3_lm6d_obs6d_t;
+
+int main(int argc, char**argv)
+{
+	if (argc<2)
+	{
+		cerr << "Usage: " << argv[0] << " <LINEAR_SYSTEM_1.srbals> [<LINEAR_SYSTEM_2.srbals> ...]\n";
+		return 1;
+	}
+
+	try
+	{
+		for (int i=1;i<argc;i++)
+		{
+			const string sFile = argv[i];
+			unsigned int pose_dims, lm_dims, obs_dims;
+			get_linear_system_dump_dims(sFile, pose_dims,lm_dims,obs_dims);
+
+			     if (pose_dims==6 && lm_dims==3 && obs_dims==2) bench_all_solvers<srba_se3_lm3d_obs2d_t>(sFile);
+			else if (pose_dims==6 && lm_dims==3 && obs_dims==3) bench_all_solvers<srba_se3_lm3d_obs3d_t>(sFile);
+			else if (pose_dims==6 && lm_dims==3 && obs_dims==4) bench_all_solvers<srba_se3_lm3d_obs4d_t>(sFile);
+			else if (pose_dims==3 && lm_dims==2 && obs_dims==2) bench_all_solvers<srba_se2_lm2d_obs2d_t>(sFile);
+			else if (pose_dims==3 && lm_dims==3 && obs_dims==3) bench_all_solvers<srba_se2_lm3d_obs3d_t>(sFile);
+			else if (pose_dims==6 && lm_dims==6 && obs_dims==6) bench_all_solvers<srba_se3_lm6d_obs6d_t>(sFile);
+			else
+				cerr << sFile << ": Unsupported problem dimensions: pose=" << pose_dims << " lm=" << lm_dims << " obs=" << obs_dims << endl;
+		}
+		return 0;
+	}
+	catch (std::exception &e)
+	{
+		cerr << "Exception: " << e.what() << endl;
+		return 1;
+	}
+}
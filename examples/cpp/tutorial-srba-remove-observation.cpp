@@ -182,8 +182,16 @@ int main(int argc, char**argv)
 		// Remove observation test:
 		if (cur_kf==kf_at_which_do_remove)
 		{
-			MRPT_TODO("XXX")
-			// obs_index_to_remove = 2; 
+			const TKeyFrameID observing_kf = dataset[obs_index_to_remove].current_kf;
+			const TLandmarkID observed_lm  = dataset[obs_index_to_remove].observed_kf;
+			const bool removed = rba.remove_observation(observing_kf, observed_lm);
+			cout << "Removing observation KF #" << observing_kf << " -> #" << observed_lm << ": " << (removed ? "done" : "not found!") << endl;
+
+			// Re-optimize the local area without that observation:
+			my_srba_t::TOptimizeExtraOutputInfo opt_info;
+			rba.optimize_local_area(new_kf_info.kf_id, rba.parameters.srba.max_optimize_depth, opt_info);
+			cout << "Optimization error after removal: " << opt_info.total_sqr_error_init << " -> " << opt_info.total_sqr_error_final << endl
+				<< "-------------------------------------------------------" << endl;
 		}
 
 
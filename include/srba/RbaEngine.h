@@ -29,6 +29,10 @@
 
 namespace srba
 {
+	namespace internal {
+		template <class RBA_ENGINE> struct api_log_io; // Fwd decl. See impl/api_recorder.h
+	}
+
 	/** The set of default settings for RbaEngine. Use it to inherit your custom RBA_OPTIONS struct (see docs and examples).
 	  * Expected types: 
 	  * - kf2kf_pose_t The parameterization of keyframe-to-keyframe relative poses (edges, problem unknowns).
@@ -99,6 +103,8 @@ namespace srba
 		typedef typename rba_problem_state_t::k2k_edges_deque_t  k2k_edges_deque_t;  //!< A list (deque) of KF-to-KF edges (unknown relative poses).
 
 		typedef typename kf2kf_pose_traits_t::pose_flag_t pose_flag_t;
+		typedef typename kf2kf_pose_traits_t::k2k_prior_t  k2k_prior_t;   //!< A prior factor on a kf2kf relative pose \sa define_new_keyframe()
+		typedef typename kf2kf_pose_traits_t::k2k_priors_t k2k_priors_t;  //!< The priors of one new KF \sa define_new_keyframe()
 		typedef typename kf2kf_pose_traits_t::frameid2pose_map_t  frameid2pose_map_t;
 		typedef typename kf2kf_pose_traits_t::TRelativePosesForEachTarget TRelativePosesForEachTarget;
 		typedef typename landmark_traits_t::TRelativeLandmarkPosMap TRelativeLandmarkPosMap;  //!< An index of feature IDs and their relative locations
@@ -120,6 +126,9 @@ namespace srba
 		/** Default constructor */
 		RbaEngine();
 
+		/** Destructor: also closes the API log file, if recording \sa start_api_recording */
+		~RbaEngine() { stop_api_recording(); }
+
 		/** All the information returned by the local area optimizer \sa define_new_keyframe() */
 		struct TOptimizeExtraOutputInfo
 		{
@@ -129,6 +138,7 @@ namespace srba
 			}
 
 			size_t  num_observations;     //!< Number of individual feature observations taken into account in the optimization
+			size_t  num_priors;           //!< Number of prior factors on the optimized kf2kf edges taken into account in the optimization
 			size_t  num_jacobians;        //!< Number of Jacobian blocks which had been to be evaluated for each relinearization step.
 			size_t  num_kf2kf_edges_optimized; //!< Number of solved unknowns of type "kf-to-kf edge".
 			size_t  num_kf2lm_edges_optimized; //!< Number of solved unknowns of type "kf-to-landmark".
@@ -136,8 +146,9 @@ namespace srba
 			size_t  num_kf_optimized;            //!< Number of individual keyframes taken into account in the optimization
 			size_t  num_lm_optimized;            //!< Number of individual landmarks taken into account in the optimization
 			size_t  num_span_tree_numeric_updates; //!< Number of poses updated in the spanning tree numeric-update stage.
-			double  obs_rmse; //!< RMSE for each observation after optimization
-			double  total_sqr_error_init, total_sqr_error_final; //!< Initial and final total squared error for all the observations
+			size_t  num_lm_rejected_by_geometry;   //!< Number of landmarks left out of optimize_local_area() by the geometric admission tests (see TOptimizeLocalAreaParams::min_landmark_parallax_deg)
+			double  obs_rmse; //!< RMSE for each residual (observation or prior) after optimization
+			double  total_sqr_error_init, total_sqr_error_final; //!< Initial and final total squared error for all the observations and priors
 			double  HAp_condition_number; //!< To be computed only if enabled in parameters.compute_condition_number
 
 			/** Sparsity stats of (the active part of) the Jacobian matrix and hessian matrices: total number of blocks and how many of them are non-zero
@@ -155,6 +166,7 @@ namespace srba
 			void clear()
 			{
 				num_observations = 0;
+				num_priors = 0;
 				num_jacobians = 0;
 				num_kf2kf_edges_optimized = 0;
 				num_kf2lm_edges_optimized = 0;
@@ -162,6 +174,8 @@ namespace srba
 				num_kf_optimized = 0;
 				num_lm_optimized = 0;
 				num_span_tree_numeric_updates=0;
+				num_lm_rejected_by_geometry=0;
+				obs_rmse=0.;
 				total_sqr_error_init=0.;
 				total_sqr_error_final=0.;
 				HAp_condition_number=0.;
@@ -172,6 +186,34 @@ namespace srba
 				extra_results.clear();
 			}
 
+			/** Adds up the results of another, independent optimization: counters and squared errors are summed, the RMSE is that of all
+			  * the residuals together, the condition number is the worst one, and \a extra_results are those of \a o. */
+			void accumulate(const TOptimizeExtraOutputInfo &o)
+			{
+				num_observations += o.num_observations;
+				num_priors += o.num_priors;
+				num_jacobians += o.num_jacobians;
+				num_kf2kf_edges_optimized += o.num_kf2kf_edges_optimized;
+				num_kf2lm_edges_optimized += o.num_kf2lm_edges_optimized;
+				num_total_scalar_optimized += o.num_total_scalar_optimized;
+				num_kf_optimized += o.num_kf_optimized;
+				num_lm_optimized += o.num_lm_optimized;
+				num_span_tree_numeric_updates += o.num_span_tree_numeric_updates;
+				num_lm_rejected_by_geometry += o.num_lm_rejected_by_geometry;
+				total_sqr_error_init += o.total_sqr_error_init;
+				total_sqr_error_final += o.total_sqr_error_final;
+				obs_rmse = (num_observations+num_priors) ? std::sqrt(total_sqr_error_final/(num_observations+num_priors)) : 0.;
+				HAp_condition_number = std::max(HAp_condition_number, o.HAp_condition_number);
+				sparsity_dh_dAp_nnz += o.sparsity_dh_dAp_nnz;  sparsity_dh_dAp_max_size += o.sparsity_dh_dAp_max_size;
+				sparsity_dh_df_nnz += o.sparsity_dh_df_nnz;    sparsity_dh_df_max_size += o.sparsity_dh_df_max_size;
+				sparsity_HAp_nnz += o.sparsity_HAp_nnz;        sparsity_HAp_max_size += o.sparsity_HAp_max_size;
+				sparsity_Hf_nnz += o.sparsity_Hf_nnz;          sparsity_Hf_max_size += o.sparsity_Hf_max_size;
+				sparsity_HApf_nnz += o.sparsity_HApf_nnz;      sparsity_HApf_max_size += o.sparsity_HApf_max_size;
+				optimized_k2k_edge_indices.insert(optimized_k2k_edge_indices.end(), o.optimized_k2k_edge_indices.begin(),o.optimized_k2k_edge_indices.end());
+				optimized_landmark_indices.insert(optimized_landmark_indices.end(), o.optimized_landmark_indices.begin(),o.optimized_landmark_indices.end());
+				extra_results = o.extra_results;
+			}
+
 			MRPT_MAKE_ALIGNED_OPERATOR_NEW  // Required by Eigen containers
 		};
 
@@ -181,7 +223,7 @@ namespace srba
 			TKeyFrameID                kf_id;         //!< The ID of the newly created KF.
 			std::vector<TNewEdgeInfo>  created_edge_ids;  //!< The newly created edges (minimum: 1 edge)
 			TOptimizeExtraOutputInfo   optimize_results;  //!< Results from the least-squares optimization
-			TOptimizeExtraOutputInfo   optimize_results_stg1;  //!< Results from the least-squares optimization
+			TOptimizeExtraOutputInfo   optimize_results_stg1;  //!< Results from the optimization of each new edge alone (TSRBAParameters::optimize_new_edges_alone), accumulated in the order of \a created_edge_ids
 
 			void clear()
 			{
@@ -209,6 +251,44 @@ namespace srba
 			const bool           run_local_optimization = true
 			);
 
+		/** Like define_new_keyframe(), with prior factors on the relative poses between the new KF and some existing ones (e.g. from
+		  *  odometry or IMU preintegration), which are kept as part of the problem and used in all the optimizations of those relative poses.
+		  *
+		  * Each prior is attached to the kf2kf edge between the new KF and k2k_prior_t::kf_id; if the edge creation policy didn't create
+		  *  such an edge, it's created here, with the prior as its initial value. New edges without an approximate initial value
+		  *  are initialized from their prior before the stage-1 optimization (TSRBAParameters::optimize_new_edges_alone).
+		  *
+		  * \note The information matrices are absolute, i.e. not relative to the observation noise: with observation_noise_identity, the
+		  *  optimized cost is sum(|r|^2)/sigma^2 + e'*inf_matrix*e. See k2k_prior_t::inf_matrix.
+		  * \exception std::exception If a prior refers to an unknown KF, or if there're several priors to the same KF.
+		  */
+		void define_new_keyframe(
+			const typename traits_t::new_kf_observations_t  & obs,
+			const k2k_priors_t & priors,
+			TNewKeyFrameInfo   & out_new_kf_info,
+			const bool           run_local_optimization = true
+			);
+
+		typedef typename mrpt::aligned_containers<TNewKeyFrameInfo>::vector_t  new_kf_info_vector_t;
+
+		/** Bulk insertion of several consecutive keyframes, e.g. when loading a dataset. It's like calling define_new_keyframe() for each of them,
+		  *  but the local area is only optimized once, around the last new KF. If \a run_local_optimization is true, the new edges of each KF
+		  *  are still initialized one by one (if TSRBAParameters::optimize_new_edges_alone is set), since the next KFs may be linked through them.
+		  *
+		  * \note This trades accuracy for speed: the intermediate KFs don't get a local area optimization of their own. The edges of those
+		  *  further than TSRBAParameters::max_optimize_depth from the last KF keep their stage-1 estimates (or their initial values, if
+		  *  optimize_new_edges_alone is false) until a later optimization reaches them, and the stage-1 problems of the next KFs start from
+		  *  these unrefined values. The longer the batch wrt max_optimize_depth, the larger the difference with calling define_new_keyframe()
+		  *  for each KF. Use batches of 1 KF where the accuracy of the online estimate matters.
+		  * \param[in]  obs_batch The observations of each new KF, in order.
+		  * \param[out] out_new_kf_infos One entry for each new KF. Only the last one has valid \a optimize_results.
+		  */
+		void define_new_keyframes(
+			const std::vector<typename traits_t::new_kf_observations_t> & obs_batch,
+			new_kf_info_vector_t & out_new_kf_infos,
+			const bool             run_local_optimization = true
+			);
+
 		/** Parameters for optimize_local_area() */
 		struct TOptimizeLocalAreaParams
 		{
@@ -217,11 +297,24 @@ namespace srba
 			TKeyFrameID max_visitable_kf_id; //!< While exploring around the root KF, stop the BFS when KF_ID>=this number (default:infinity)
 			size_t      dont_optimize_landmarks_seen_less_than_n_times;  //!< Set to 1 to try to optimize all landmarks even if they're just observed once, which may makes sense depending on the sensor type (default: 2)
 
+			/** @name Geometric admission of landmarks (see filter_landmarks_by_geometry())
+			  *  Landmarks observed enough times may still be badly constrained, e.g. if a monocular camera saw them from nearly the same viewpoint.
+			  *  These tests use the current estimates of the landmarks and kf2kf edges, ignore the observations from KFs out of the spanning tree
+			  *  of the base KF, and are evaluated again in each optimization, so a rejected landmark is admitted as soon as it's well constrained.
+			  *  @{ */
+			double      min_landmark_parallax_deg;          //!< (Default:0=disabled) Don't optimize point landmarks whose largest angle between the rays from any two observing KFs is below this (in degrees). Typ. 1-3 deg for monocular cameras. Landmarks seen from a single KF are never admitted while this or \a min_landmark_baseline_depth_ratio are enabled.
+			double      min_landmark_baseline_depth_ratio;  //!< (Default:0=disabled) Don't optimize point landmarks whose largest distance between any two observing KFs is below this ratio of their distance to their base KF.
+			double      max_landmark_hf_condition_number;   //!< (Default:0=disabled) Don't optimize landmarks whose Hessian block Hf=sum(J^t*J) (with the unweighted Jacobians of their observations) has a larger condition number, or is singular.
+			/** @} */
+
 			TOptimizeLocalAreaParams() :
 				optimize_k2k_edges(true),
 				optimize_landmarks(true),
 				max_visitable_kf_id( static_cast<TKeyFrameID>(-1) ),
-				dont_optimize_landmarks_seen_less_than_n_times( 2 )
+				dont_optimize_landmarks_seen_less_than_n_times( 2 ),
+				min_landmark_parallax_deg(0),
+				min_landmark_baseline_depth_ratio(0),
+				max_landmark_hf_condition_number(0)
 			{}
 		};
 
@@ -239,6 +332,82 @@ namespace srba
 			const std::vector<size_t> & observation_indices_to_optimize = std::vector<size_t>()
 			);
 
+		/** One of the areas to optimize in optimize_local_areas() */
+		struct TLocalAreaRequest
+		{
+			TKeyFrameID              root_id;
+			unsigned int             win_size;
+			TOptimizeLocalAreaParams params;
+
+			TLocalAreaRequest(const TKeyFrameID root_id_=0, const unsigned int win_size_=0, const TOptimizeLocalAreaParams &params_=TOptimizeLocalAreaParams()) :
+				root_id(root_id_), win_size(win_size_), params(params_)
+			{}
+		};
+
+		/** Like optimize_local_area(), for several areas at once (e.g. distant regions after a large loop closure or a multi-robot map merge).
+		  *  The "footprint" of each area (the KFs whose spanning trees, poses or observations its optimization reads or writes) is first determined
+		  *  from the BFS visitor output. Areas whose footprint does not overlap any other one are then optimized concurrently, each with its
+		  *  own scratch data, while the rest are optimized sequentially afterwards, in the given order. The numeric spanning tree entries of
+		  *  the concurrent areas are created beforehand, and the poses through the optimized edges are marked as outdated afterwards, both serially.
+		  *  If less than two areas are independent, all of them are optimized sequentially.
+		  *
+		  *  Concurrency requires building with OpenMP; otherwise all areas are optimized sequentially, with identical results.
+		  *
+		  * \param[out] out_infos One entry per area, in the same order as \a areas.
+		  * \return The number of areas which were optimized concurrently.
+		  * \note While optimizing concurrently, the time profiler only records the whole operation, and parameters.srba.feedback_user_iteration may be called from several threads.
+		  */
+		size_t optimize_local_areas(
+			const std::vector<TLocalAreaRequest> & areas,
+			std::vector<TOptimizeExtraOutputInfo> & out_infos
+			);
+
+		/** A dry-run of optimize_local_area(): finds out the unknowns and observations which it would optimize, and estimates the size of the
+		  *  involved Jacobians and Hessians, the linear system to factorize in each iteration and the time the whole optimization would take
+		  *  (from \a parameters.cost_model). The problem is not modified in any way, not even numerically.
+		  *
+		  *  This is useful to schedule optimizations, e.g. to choose the window size or to defer optimizations under heavy load.
+		  * \note The cost of this method is similar to that of building the symbolic Hessians, i.e. much smaller than an actual optimization.
+		  * \sa TOptimizationCostModel::fit()
+		  */
+		void estimate_local_area_cost(
+			const TKeyFrameID  root_id,
+			const unsigned int win_size,
+			TOptimizationCostEstimate & out_estimate,
+			const TOptimizeLocalAreaParams &params = TOptimizeLocalAreaParams()
+			) const;
+
+		/** Removes one observation (e.g. an outlier detected by the front-end) from the problem, so it's not used in further optimizations.
+		  * If the landmark was observed more than once from the same KF, the oldest such observation is removed.
+		  *  The observation is only marked as removed (a "tombstone") and its Jacobian blocks are erased, so the indices of all other
+		  *  observations remain valid until the next compact_observations().
+		  * 
+eturn false if there was no such observation.
+		  * 
+ote The base KF of the landmark is not changed, even if it was its observation the one removed.
+		  * 
+ote Runs in O(C+P log M), with C=number of observations of the landmark, P=length of the kf2kf path to its base KF, M=number of observations.
+		  * \sa remove_landmark, TSRBAParameters::removed_obs_compaction_ratio
+		  */
+		bool remove_observation(const TKeyFrameID observing_kf_id, const TLandmarkID feat_id);
+
+		/** Removes a landmark and all its observations from the problem. Its ID may be reused later on for a new landmark.
+		  * 
+eturn false if the landmark does not exist.
+		  * \sa remove_observation
+		  */
+		bool remove_landmark(const TLandmarkID feat_id);
+
+		/** Purges all the observations marked as removed with remove_observation() or remove_landmark(), and re-indexes the rest.
+		  *  This is automatically called from define_new_keyframe() according to TSRBAParameters::removed_obs_compaction_ratio.
+		  * \warning All indices of observations (e.g. those returned by add_observation() or those in TNewKeyFrameInfo) become invalid.
+		  * 
+eturn The number of purged observations.
+		  * 
+ote Runs in O(M log M + N), with M=number of observations, N=number of KFs.
+		  */
+		size_t compact_observations();
+
 
 		struct TOpenGLRepresentationOptions : public landmark_t::render_mode_t::TOpenGLRepresentationOptionsExtra
 		{
@@ -293,7 +462,8 @@ namespace srba
 		/** Evaluates the quality of the overall map/landmark estimations, by computing the sum of the squared
 		  *  error contributions for all observations. For this, this method may have to compute *very long* shortest paths
 		  *  between distant keyframes if no loop-closure edges exist in order to evaluate the best approximation of relative
-		  *  coordinates between observing KFs and features' reference KFs.
+		  *  coordinates between observing KFs and features' reference KFs. The weighted squared errors of the priors of kf2kf edges
+		  *  (see define_new_keyframe()) are added too, in the units of the unweighted observation errors (see k2k_prior_t::inf_matrix).
 		  *
 		  * The worst-case time consumed by this method is O(M*log(N) + N^2 + N E), N=# of KFs, E=# of edges, M=# of observations.
 		  */
@@ -400,6 +570,33 @@ namespace srba
 		/** @} */  // End of Extra API methods
 
 
+		/** @name API call recording (for reproducing field sessions offline)
+		    @{ */
+
+		/** Starts logging all the calls to mutating API methods (define_new_keyframe(), optimize_local_area(), optimize_local_areas(),
+		  *  alloc_keyframe(), create_kf2kf_edge() and clear()), with all their inputs and a summary of their results, to a compressed binary file.
+		  *  Such a log can be fed into a new RbaEngine with RbaEngineApiReplayer, which should reproduce the same results bit by bit,
+		  *  e.g. to profile a field session offline.
+		  *
+		  *  The values in \a parameters.srba are logged before the first call after they change. Other parameters (sensor, sensor pose,
+		  *  noise, edge creation policy) are not: the replaying program must set them up as in the original session, and \a user_data
+		  *  (stored in the log header) can be used to save whatever it needs for that (e.g. its command line).
+		  *  Direct modifications to the problem state through get_rba_state() are not logged either.
+		  *
+		  * \note The problem must be empty (no KFs) when the recording starts.
+		  * \exception std::exception On error creating the file.
+		  */
+		void start_api_recording(const std::string &log_file, const std::string &user_data = std::string());
+
+		/** Stops logging API calls and closes the log file (also automatically done at destruction) \sa start_api_recording */
+		void stop_api_recording();
+
+		/** Whether start_api_recording() was called */
+		inline bool is_api_recording() const { return m_api_rec!=NULL; }
+
+		/** @} */
+
+
 		/** @name Public data fields
 			@{ */
 
@@ -423,6 +620,7 @@ namespace srba
 			// Parameters for optimize_*()
 			// -------------------------------------
 			bool   optimize_new_edges_alone; //!< (Default:true) Before running a whole "local area" optimization, try to optimize new edges one by one to have a better starting point.
+			bool   optimize_new_edges_concurrently; //!< (Default:true) In optimize_new_edges_alone, solve the new edges whose problems are independent in parallel (with OpenMP). The results are the same, set to false to always go one by one.
 			bool   use_robust_kernel;
 			bool   use_robust_kernel_stage1;
 			double kernel_param;
@@ -432,6 +630,10 @@ namespace srba
 			double max_lambda; //!< default: 1e20
 			double min_error_reduction_ratio_to_relinearize; //!< default 0.01
 			bool   numeric_jacobians; //!< (Default:false) Use a numeric approximation of the Jacobians (very slow!) instead of analytical ones.
+			/** (Default:true) For observations whose analytic sensor Jacobian is ill-defined, use a numeric approximation for that observation only,
+			  * instead of ignoring it in that iteration. Numeric Jacobians where h() isn't smooth (e.g. the bearing of a point right on the Z axis) are
+			  * rejected, and sensor models where it makes no sense (e.g. points behind a camera) never use it. \sa internal::sensor_allows_numeric_jacob_fallback */
+			bool   numeric_jacobians_fallback;
 			void (*feedback_user_iteration)(unsigned int iter, const double total_sq_err, const double mean_sqroot_error);
 			bool   compute_condition_number; //!< Compute and return to the user the Hessian condition number of k2k edges (default=false)
 			bool   compute_sparsity_stats;   //!< Compute stats on the sparsity of the problem matrices (default=false)
@@ -439,6 +641,22 @@ namespace srba
 			TCovarianceRecoveryPolicy  cov_recovery; //!< Recover covariance? What method to use? (Default: crpLandmarksApprox)
 			// -------------------------------------
 
+			/** (Default:0=disabled) If >0, observations made from KFs older than this number of KFs (wrt the newest one) are kept
+			  * in single-precision "cold" storage, saving memory in long runs. They are transparently restored if an optimization involves them again.
+			  * Cold storage is lossy (~7 significant digits); observations keep their full precision while they're hot. \sa TObservationDataStore */
+			uint64_t obs_cold_storage_horizon;
+
+			/** (Default:"", disabled) If not empty, the linear system (Jacobians, residuals, noise information matrices, Hessians and gradient) of
+			  * each optimize_edges() call is saved to a new file "<prefix>_NNNNN.srbals", for offline benchmarking of solvers with TLinearSystemDump
+			  * (see the app srba-solver-bench). \sa dump_linear_systems_min_unknowns */
+			std::string dump_linear_systems_prefix;
+			/** (Default:0) Only save linear systems with at least this number of scalar unknowns \sa dump_linear_systems_prefix */
+			size_t dump_linear_systems_min_unknowns;
+
+			/** (Default:0.1) define_new_keyframe() calls compact_observations() when the fraction of removed observations
+			  * (see remove_observation()) exceeds this ratio. Set to 0 to never compact automatically. */
+			double removed_obs_compaction_ratio;
+
 		};
 
 		/** The unique struct which hold all the parameters from the different SRBA modules (sensors, optional features, optimizers,...) */
@@ -449,6 +667,7 @@ namespace srba
 			typename RBA_OPTIONS::sensor_pose_on_robot_t::parameters_t  sensor_pose; //!< Parameters related to the relative pose of sensors wrt the robot (if applicable) 
 			typename RBA_OPTIONS::obs_noise_matrix_t::parameters_t      obs_noise;   //!< Parameters related to the sensor noise covariance matrix
 			typename RBA_OPTIONS::edge_creation_policy_t::parameters_t  ecp;         //!< Parameters for the edge creation policy
+			TOptimizationCostModel                                         cost_model;  //!< Time model for estimate_local_area_cost()
 
 			MRPT_MAKE_ALIGNED_OPERATOR_NEW  // Required by Eigen containers
 		};
@@ -467,6 +686,14 @@ namespace srba
 		const TRelativeLandmarkPosMap & get_known_feats()   const { return rba_state.known_lms; }
 		const TRelativeLandmarkPosMap & get_unknown_feats() const { return rba_state.unknown_lms; }
 
+		/** The last estimated information matrix (inverse covariance) of an unknown landmark position, even if it's no longer in the
+		  * local area being optimized. Only filled in with TSRBAParameters::cov_recovery = crpLandmarksApprox. O(1)
+		  * \return NULL if the landmark does not exist or its position has never been estimated.
+		  */
+		inline const typename hessian_traits_t::TSparseBlocksHessian_f::matrix_t * get_unknown_feat_inf_matrix(const TLandmarkID feat_id) const {
+			return rba_state.unknown_lms_inf_matrices.find(feat_id);
+		}
+
 		const rba_problem_state_t & get_rba_state() const { return rba_state; }
 		rba_problem_state_t       & get_rba_state()       { return rba_state; }
 
@@ -510,13 +737,18 @@ namespace srba
 
 		/**
 		  * \param observation_indices_to_optimize Indices wrt \a rba_state.all_observations. An empty vector means use ALL the observations involving the selected unknowns.
+		  * \param concurrent_num_poses If not NULL, this optimization runs concurrently with others (see optimize_new_edges_alone(), optimize_local_areas()): only these
+		  *  numeric poses are updated as the unknowns change (they must be all the required ones whose paths go through any unknown, with their entries
+		  *  already created), the rest must be up-to-date beforehand, and no other numeric pose is marked as outdated. The caller must call
+		  *  TSpanningTree::mark_edge_modified() for the optimized edges afterwards.
 		  * \sa optimize_local_area
 		  */
 		void optimize_edges(
 			const std::vector<size_t> & run_k2k_edges,
 			const std::vector<size_t> & run_feat_ids_in,
 			TOptimizeExtraOutputInfo & out_info,
-			const std::vector<size_t> & observation_indices_to_optimize = std::vector<size_t>()
+			const std::vector<size_t> & observation_indices_to_optimize = std::vector<size_t>(),
+			const typename rba_problem_state_t::TSpanningTree::numeric_pose_path_list_t * concurrent_num_poses = NULL
 			);
 
 		/** @} */
@@ -591,7 +823,7 @@ namespace srba
 				MRPT_UNUSED_PARAM(current_kf); MRPT_UNUSED_PARAM(cur_dist);
 				if (!edge->feat_has_known_rel_pos)
 				{
-					const TLandmarkID lm_ID = edge->obs.obs.feat_id;
+					const TLandmarkID lm_ID = edge->obs.feat_id;
 					// Use an "==" so we only add the LM_ID to the list ONCE, just when it passes the threshold
 					if (++lm_times_seen[lm_ID] == params.dont_optimize_landmarks_seen_less_than_n_times)
 						lm_IDs_to_optimize.push_back(lm_ID);
@@ -609,6 +841,65 @@ namespace srba
 		  */
 		mutable mrpt::utils::CTimeLogger  m_profiler;
 
+		/** @name API recorder data \sa start_api_recording
+		    @{ */
+		typedef internal::api_log_io<rba_engine_t> api_log_io_t;
+
+		mrpt::utils::CStream  *m_api_rec;               //!< The API log file (NULL: not recording)
+		unsigned int           m_api_rec_depth;         //!< Nesting level of recordable API calls, since only the outermost one (the user call) is logged
+		std::vector<uint8_t>   m_api_rec_last_params;   //!< The last logged parameters.srba, in binary form
+
+		/** Aux RAII object to keep \a m_api_rec_depth in recordable API methods */
+		struct TApiRecScope
+		{
+			TApiRecScope(unsigned int &depth_) : depth(depth_) { ++depth; }
+			~TApiRecScope() { --depth; }
+			unsigned int &depth;
+		};
+
+		/** Returns true if the current API call must be logged */
+		inline bool api_rec_is_outermost() const { return m_api_rec!=NULL && m_api_rec_depth==1; }
+
+		/** Logs the type of a new API call (preceded by the parameters, if they changed). Its arguments must be written next. */
+		void api_rec_call(const uint8_t call_type);
+		/** @} */
+
+		// Forbid making copies of this object, since it owns the API log stream (and the problem state relies on internal lists of pointers):
+		RbaEngine(const RbaEngine &);
+		RbaEngine & operator =(const RbaEngine &);
+
+		size_t m_dump_linsys_counter; //!< Number of linear systems saved so far \sa dump_linear_system
+
+		/** If not NULL, create_kf2kf_edge() leaves here the paths of the symbolic spanning trees to be rebuilt, instead of rebuilding them
+		  * immediately. Used by define_new_keyframe() to rebuild them once for all the new edges. */
+		std::set<TPairKeyFrameID> * m_pending_st_paths;
+
+		/** Stage 1 of define_new_keyframe(): optimizes each new kf2kf edge alone (only if it has no approximate initial value), so
+		  *  they have a good starting point for the local area optimization.
+		  *  Edges whose problems are independent of those of all the previous edges (e.g. several edges from a loop closure) are optimized
+		  *  concurrently if OpenMP is enabled, the rest sequentially afterwards. The results are the same than optimizing them one by one, in order.
+		  * \param[out] out_info The results of all the edges, accumulated in the order of \a new_k2k_edge_ids (see TOptimizeExtraOutputInfo::accumulate()) */
+		void optimize_new_edges_alone(
+			const std::vector<TNewEdgeInfo> & new_k2k_edge_ids,
+			TOptimizeExtraOutputInfo        & out_info );
+
+		/** The stage-1 problem of one new edge in optimize_new_edges_alone() */
+		struct TNewEdgeStage1Task
+		{
+			TNewEdgeStage1Task() : edge_id(0), can_run_concurrently(true) {}
+
+			size_t                   edge_id;
+			std::vector<size_t>      obs_idxs;       //!< The observations in the edge Jacobian column (sorted)
+			std::set<TKeyFrameID>    tree_roots;     //!< The spanning trees whose numeric poses are read
+			std::set<size_t>         other_edges;    //!< All the other edges in the paths of the numeric poses which are read
+			bool                     can_run_concurrently; //!< false if some required pose has no path in the spanning trees
+			typename rba_problem_state_t::TSpanningTree::numeric_pose_path_list_t  own_num_poses; //!< The required numeric poses whose paths go through the edge (the only ones it modifies)
+			TOptimizeExtraOutputInfo info;
+		};
+
+		/** Finds out the observations and numeric poses involved in the stage-1 problem of \a task.edge_id. The entries in \a task.own_num_poses are left as NULL. */
+		void get_new_edge_stage1_footprint(TNewEdgeStage1Task &task);
+
 		/** Creates a new known/unknown position landmark (upon first LM observation ), and expands Jacobians with new observation
 		  * \param[in] new_obs The basic data on the observed landmark: landmark ID, keyframe from which it's observed and parameters ("z" vector) of the observation itself (e.g. pixel coordinates).
 		  * \param[in] fixed_relative_position If not NULL, this is the first observation of a landmark with a fixed, known position. Each such feature can be created only once, next observations MUST have this field set to NULL as with normal ("unfixed") landmarks.
@@ -631,6 +922,32 @@ namespace srba
 			const array_landmark_t * unknown_relative_position_init_val = NULL
 			);
 
+		/** Like add_observation(), for all the observations of a new KF at once (as used in define_new_keyframe()).
+		  * Individual observations are not profiled separately, since the per-call overhead becomes noticeable with thousands of observations per KF.
+		  * The landmark list and the storage of observation data are grown once for the whole batch.
+		  */
+		void add_observations(
+			const TKeyFrameID                                observing_kf_id,
+			const typename traits_t::new_kf_observations_t & obs
+			);
+
+		/** The actual implementation of add_observation().
+		  * \param[in] profile Whether to time the symbolic Jacobians in the "add_observation.jacobs.sym" profiler scope (false for batches). */
+		size_t add_observation_internal(
+			const TKeyFrameID         observing_kf_id,
+			const typename observation_traits_t::observation_t     & new_obs,
+			const array_landmark_t * fixed_relative_position,
+			const array_landmark_t * unknown_relative_position_init_val,
+			const bool               profile
+			);
+
+		/** The actual implementation of remove_observation(): marks the observation #obs_idx as removed and erases its Jacobian blocks */
+		void remove_observation_internal(const size_t obs_idx);
+
+		/** Aux for compact_observations(): changes the row (observation) indices of one Jacobian column according to \a new_idxs */
+		template <class JACOB_COL>
+		void reindex_jacobian_column(JACOB_COL &col, const std::vector<size_t> &new_idxs);
+
 		/** Prepare the list of all required KF roots whose spanning trees need numeric updates with each optimization iteration */
 		void prepare_Jacobians_required_tree_roots(
 			std::set<TKeyFrameID>  & kfs_num_spantrees_to_update,
@@ -706,7 +1023,8 @@ namespace srba
 				const bool _is_inverse_dir,
 				const k2k_edges_deque_t  &_k2k_edges,
 				const typename obs_t::TObservationParams   & _sensor_params,
-				const typename RBA_OPTIONS::sensor_pose_on_robot_t::parameters_t  & _sensor_pose
+				const typename RBA_OPTIONS::sensor_pose_on_robot_t::parameters_t  & _sensor_pose,
+				const array_obs_t & _z_obs
 				) :
 			k2k_edge_id(_k2k_edge_id),
 			pose_d1_wrt_obs(_pose_d1_wrt_obs),
@@ -715,7 +1033,8 @@ namespace srba
 			is_inverse_dir(_is_inverse_dir),
 			k2k_edges(_k2k_edges),
 			sensor_params(_sensor_params),
-			sensor_pose(_sensor_pose)
+			sensor_pose(_sensor_pose),
+			z_obs(_z_obs)
 			{
 			}
 
@@ -727,6 +1046,7 @@ namespace srba
 			const k2k_edges_deque_t  &k2k_edges;
 			const typename obs_t::TObservationParams   & sensor_params;
 			const typename RBA_OPTIONS::sensor_pose_on_robot_t::parameters_t  & sensor_pose;
+			const array_obs_t & z_obs; //!< The real observation
 		};
 
 		struct TNumeric_dh_df_params
@@ -735,12 +1055,14 @@ namespace srba
 				const pose_t * _pose_base_wrt_obs,
 				const array_landmark_t & _xji_i,
 				const typename obs_t::TObservationParams   & _sensor_params,
-				const typename RBA_OPTIONS::sensor_pose_on_robot_t::parameters_t  & _sensor_pose
+				const typename RBA_OPTIONS::sensor_pose_on_robot_t::parameters_t  & _sensor_pose,
+				const array_obs_t & _z_obs
 				) :
 			pose_base_wrt_obs(_pose_base_wrt_obs),
 			xji_i(_xji_i),
 			sensor_params(_sensor_params),
-			sensor_pose(_sensor_pose)
+			sensor_pose(_sensor_pose),
+			z_obs(_z_obs)
 			{
 			}
 
@@ -748,6 +1070,7 @@ namespace srba
 			const array_landmark_t & xji_i;
 			const typename obs_t::TObservationParams   & sensor_params;
 			const typename RBA_OPTIONS::sensor_pose_on_robot_t::parameters_t  & sensor_pose;
+			const array_obs_t & z_obs; //!< The real observation
 		};
 
 		/** Auxiliary method for numeric Jacobian: numerically evaluates the new observation "y" for a small increment "x" in a relative KF-to-KF pose */
@@ -755,6 +1078,48 @@ namespace srba
 		/** Auxiliary method for numeric Jacobian: numerically evaluates the new observation "y" for a small increment "x" in a landmark position  */
 		static void numeric_dh_df(const array_landmark_t &x, const TNumeric_dh_df_params& params, array_obs_t &y);
 
+		/** Numeric dh_dx of an observation whose analytic sensor Jacobian was ill-defined \sa eval_jacob_dh_dx_or_numeric */
+		struct TNumericJacobCacheEntry
+		{
+			array_landmark_t  xji_l;  //!< The linearization point: landmark position wrt the sensor
+			Eigen::Matrix<double,OBS_DIMS,LM_DIMS>  dh_dx;
+
+			MRPT_MAKE_ALIGNED_OPERATOR_NEW  // Required by Eigen containers
+		};
+		typedef typename mrpt::aligned_containers<size_t,TNumericJacobCacheEntry>::map_t  numeric_jacob_cache_t;
+
+		/** Indexed by observation index. Entries are only reused while their linearization point doesn't move, and only kept
+		  * while the analytic Jacobian of their observation is ill-defined and the observation exists. */
+		mutable numeric_jacob_cache_t  m_numeric_jacob_cache;
+
+		/** Drops the cached numeric Jacobian of an observation, if any (thread-safe). O(1) without locking if there's none */
+		void forget_numeric_jacob(const size_t obs_idx) const;
+
+		bool eval_jacob_dh_dx_or_numeric(
+			Eigen::Matrix<double,OBS_DIMS,LM_DIMS> & dh_dx,
+			const array_landmark_t & xji_l,
+			const size_t             obs_idx) const;
+
+		/** Determines the set of all KFs whose spanning-tree entries or incident edges may be read or written while optimizing the given unknowns,
+		  * the list of involved observations and the roots of the spanning trees to be numerically updated. Used in optimize_local_areas() */
+		void get_optimization_footprint(
+			const std::vector<size_t> & k2k_edges,
+			const std::vector<size_t> & lm_IDs,
+			std::set<TKeyFrameID>     & out_kfs,
+			std::vector<size_t>       & out_obs_idxs,
+			std::set<TKeyFrameID>     & out_tree_roots);
+
+		/** Removes from \a lm_IDs the landmarks which don't pass the geometric admission tests enabled in \a params (TOptimizeLocalAreaParams::min_landmark_parallax_deg, etc.)
+		  * Used wherever the unknowns of a local area are assembled. \return The number of removed landmarks */
+		size_t filter_landmarks_by_geometry(
+			std::vector<size_t> & lm_IDs,
+			const TOptimizeLocalAreaParams &params) const;
+
+		/** The geometric admission tests of one landmark, only for point landmarks (see filter_landmarks_by_geometry()) */
+		bool landmark_passes_geometric_tests(
+			const TLandmarkID lm_ID,
+			const TOptimizeLocalAreaParams &params) const;
+
 		static inline void add_edge_ij_to_list_needed_roots(std::set<TKeyFrameID>  & lst, const TKeyFrameID i, const TKeyFrameID j)
 		{
 			lst.insert(i);
@@ -769,6 +1134,21 @@ namespace srba
 			const std::map<size_t,size_t> &obs_global_idx2residual_idx
 			) const;
 
+		/** @name Prior factors on kf2kf edges (see k2k_prior_t). All take the IDs of the kf2kf edges which are the unknowns of an optimization.
+		    @{ */
+		typedef typename mrpt::aligned_containers<array_pose_t>::vector_t  vector_k2k_prior_errors_t;
+
+		/** Evaluates the errors of the priors of the given edges (zero for those without a prior).
+		  * \return The total squared error, weighted by the information matrices */
+		double k2k_priors_errors(const std::vector<size_t> &k2k_edge_ids, vector_k2k_prior_errors_t &out_errs) const;
+		/** Adds the information matrices of the priors to the diagonal blocks of HAp (creating them if needed) */
+		void k2k_priors_add_to_hessian(const std::vector<size_t> &k2k_edge_ids, typename hessian_traits_t::TSparseBlocksHessian_Ap &HAp) const;
+		/** Adds the contribution of the priors to the k2k part of the minus gradient, given their errors from k2k_priors_errors() */
+		void k2k_priors_add_to_minus_gradient(const std::vector<size_t> &k2k_edge_ids, const vector_k2k_prior_errors_t &errs, Eigen::VectorXd &minus_grad) const;
+		/** Attaches the priors of a new KF to its edges, creating those which don't exist (see define_new_keyframe()) */
+		void k2k_priors_attach(const TKeyFrameID new_kf_id, const k2k_priors_t &priors, const typename traits_t::new_kf_observations_t &obs, std::vector<TNewEdgeInfo> &new_k2k_edge_ids);
+		/** @} */
+
 		/** Each of the observations used during the optimization */
 		struct TObsUsed
 		{
@@ -789,6 +1169,20 @@ namespace srba
 			const std::vector<TObsUsed> & observations // In:
 			) const;
 
+		/** Saves the linear system of one optimize_edges() call to a new file, if it has at least parameters.srba.dump_linear_systems_min_unknowns unknowns.
+		  * Must be called before the solver modifies the Hessians. \sa TSRBAParameters::dump_linear_systems_prefix, TLinearSystemDump */
+		void dump_linear_system(
+			const std::vector<typename TSparseBlocksJacobians_dh_dAp::col_t*> & dh_dAp,
+			const std::vector<typename TSparseBlocksJacobians_dh_df::col_t*>  & dh_df,
+			const std::vector<TObsUsed> & involved_obs,
+			const vector_residuals_t & residuals,
+			const std::map<size_t,size_t> & obs_global_idx2residual_idx,
+			const typename hessian_traits_t::TSparseBlocksHessian_Ap  & HAp,
+			const typename hessian_traits_t::TSparseBlocksHessian_f   & Hf,
+			const typename hessian_traits_t::TSparseBlocksHessian_Apf & HApf,
+			const Eigen::VectorXd & minus_grad,
+			const double lambda);
+
 		/** pseudo-huber cost function */
 		static inline double huber_kernel(double delta, const double kernel_param)
 		{
@@ -828,10 +1222,16 @@ namespace srba
 #include "impl/determine_kf2kf_edges_to_create.h"
 #include "impl/reprojection_residuals.h"
 #include "impl/compute_minus_gradient.h"
+#include "impl/k2k_priors.h"
 #include "impl/optimize_edges.h"
 #include "impl/lev-marq_solvers.h"
 #include "impl/bfs_visitor.h"
 #include "impl/optimize_local_area.h"
+#include "impl/landmarks_geometric_admission.h"
+#include "impl/estimate_local_area_cost.h"
+#include "impl/remove_observations.h"
+#include "impl/api_recorder.h"
+#include "impl/linear_system_dump.h"
 // -----------------------------------------------------------------
 //            ^^ End of implementation files ^^
 // -----------------------------------------------------------------
@@ -99,7 +99,7 @@ struct classic_linear_rba
 				// Since this means that the KF is aisolated from the rest of the world, leave the topological distance to infinity.
 			}
 
-			if ( found_distance>=min_dist_for_loop_closure && num_obs_this_base>=params.min_obs_to_loop_closure)
+			if ( found_distance>=min_dist_for_loop_closure && num_obs_this_base>=params.min_obs_to_loop_closure && !rba_engine.get_rba_state().are_keyframes_connected(new_kf_id,to_id))
 			{
 				// The KF is TOO FAR: We will need to create an additional edge:
 				TNewEdgeInfo nei;
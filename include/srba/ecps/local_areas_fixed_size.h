@@ -153,7 +153,7 @@ struct local_areas_fixed_size
 				//	&& 
 				//	central2central_connected_areas.find(c2c_pair)!=central2central_connected_areas.end();
 
-				if (num_obs_this_base>=MINIMUM_OBS_TO_LOOP_CLOSURE) // && !already_connected)
+				if (num_obs_this_base>=MINIMUM_OBS_TO_LOOP_CLOSURE && !rba_engine.get_rba_state().are_keyframes_connected(from_id,to_id))
 				{
 					// The KF is TOO FAR: We will need to create an additional edge:
 					TNewEdgeInfo nei;
@@ -166,15 +166,12 @@ struct local_areas_fixed_size
 					if ( last_timestep_touched_kfs.count(to_id) != 0 )
 					{
 						// Get the relative post from the numeric spanning tree, which should be up-to-date:
-						typename kf2kf_pose_traits<typename traits_t::original_kf2kf_pose_t>::TRelativePosesForEachTarget::const_iterator it_tree4_central = rba_engine.get_rba_state().spanning_tree.num.find(to_id);
-						ASSERT_(it_tree4_central!=rba_engine.get_rba_state().spanning_tree.num.end())
-
-						typename kf2kf_pose_traits<typename traits_t::original_kf2kf_pose_t>::frameid2pose_map_t::const_iterator it_nei_1 = 
-							it_tree4_central->second.find(new_kf_id-1);
-						if (it_nei_1!=it_tree4_central->second.end())
+						typename kf2kf_pose_traits<typename traits_t::original_kf2kf_pose_t>::pose_t pose_nei_1;
+						if (rba_engine.get_rba_state().spanning_tree.num.get(to_id, new_kf_id-1, pose_nei_1))
 						{
 							// Found: reuse this relative pose as a good initial guess for the estimation
-							rba_engine.get_rba_state().k2k_edges[nei.id].inv_pose = -it_nei_1->second.pose; // Note the "-" inverse operator, it is important
+							rba_engine.get_rba_state().k2k_edges[nei.id].inv_pose = -pose_nei_1; // Note the "-" inverse operator, it is important
+							rba_engine.get_rba_state().spanning_tree.mark_edge_modified(nei.id);
 							nei.has_approx_init_val = true;
 						}
 					}
@@ -22,7 +22,44 @@ size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::add_observation(
 	)
 {
 	m_profiler.enter("add_observation");
+	const size_t new_obs_idx = add_observation_internal(observing_kf_id,new_obs,fixed_relative_position,unknown_relative_position_init_val, true /* profile */);
+	m_profiler.leave("add_observation");
+	return new_obs_idx;
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::add_observations(
+	const TKeyFrameID                                observing_kf_id,
+	const typename traits_t::new_kf_observations_t & obs
+	)
+{
+	// Grow the per-landmark and per-observation containers only once for the whole batch
+	// (all_observations and its Jacobian validity flags are deques, which never reallocate):
+	TLandmarkID max_feat_id = 0;
+	for (typename new_kf_observations_t::const_iterator it_obs = obs.begin();it_obs != obs.end();++it_obs)
+		mrpt::utils::keep_max(max_feat_id, it_obs->obs.feat_id);
+	if (!obs.empty() && max_feat_id>=rba_state.all_lms.size())
+		rba_state.all_lms.resize(max_feat_id+1);
+	rba_state.obs_data.reserve(rba_state.obs_data.size()+obs.size());
+
+	for (typename new_kf_observations_t::const_iterator it_obs = obs.begin();it_obs != obs.end();++it_obs)
+	{
+		const typename landmark_traits_t::array_landmark_t *fixed_rel_pos       = it_obs->is_fixed                 ? &it_obs->feat_rel_pos : NULL;
+		const typename landmark_traits_t::array_landmark_t *unk_rel_pos_initval = it_obs->is_unknown_with_init_val ? &it_obs->feat_rel_pos : NULL;
+
+		this->add_observation_internal( observing_kf_id, it_obs->obs, fixed_rel_pos, unk_rel_pos_initval, false /* don't profile */ );
+	}
+}
 
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::add_observation_internal(
+	const TKeyFrameID            observing_kf_id,
+	const typename observation_traits<obs_t>::observation_t     & new_obs,
+	const array_landmark_t * fixed_relative_position,
+	const array_landmark_t * unknown_relative_position_init_val,
+	const bool               profile
+	)
+{
 	ASSERT_( !( fixed_relative_position!=NULL && unknown_relative_position_init_val!=NULL) ) // Both can't be !=NULL at once.
 
 	const bool is_1st_time_seen = ( new_obs.feat_id>=rba_state.all_lms.size() || rba_state.all_lms[new_obs.feat_id].rfp==NULL );
@@ -39,6 +76,12 @@ size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::add_observation(
 
 	rba_state.all_observations.push_back(k2f_edge_t()); // Create new k2f_edge -- O(1)
 	rba_state.all_observations_Jacob_validity.push_back(1);  // Also grow this vector (its content now are irrelevant, they'll be updated in optimization)
+	{
+		// Save the observation data as an array now, only once, and reuse it from now on in optimizations, etc.
+		array_obs_t obs_arr;
+		new_obs.obs_data.getAsArray(obs_arr);
+		rba_state.obs_data.push_back(obs_arr, observing_kf_id);
+	}
 	char * const jacob_valid_bit = &(*rba_state.all_observations_Jacob_validity.rbegin());
 
 	// Get a ref. to observation info, filled in below:
@@ -104,13 +147,24 @@ size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::add_observation(
 
 	// Fill in kf-to-feature edge data:
 	// ------------------------------------
-	new_k2f_edge.obs.kf_id = observing_kf_id;
-	new_k2f_edge.obs.obs   = new_obs;
-	new_k2f_edge.obs.obs.obs_data.getAsArray(new_k2f_edge.obs.obs_arr);  // Save the observation data as an array now, only once, and reuse it from now on in optimizations, etc.
+	new_k2f_edge.obs.feat_id = new_obs.feat_id;
+	new_k2f_edge.obs.kf_id   = observing_kf_id;
 	new_k2f_edge.is_first_obs_of_unknown = is_1st_time_seen && !is_fixed;
 	new_k2f_edge.feat_has_known_rel_pos  = is_fixed;
 	new_k2f_edge.feat_rel_pos = lm_rel_pos;
+	new_k2f_edge.is_removed = false;
+	new_k2f_edge.num_dh_dAp_blocks = 0;
+	new_k2f_edge.next_obs_same_lm = SRBA_INVALID_INDEX;
+	new_k2f_edge.has_numeric_jacob = false;
 
+	// Append to the list of observations of this landmark: O(1)
+	{
+		typename landmark_traits<landmark_t>::TLandmarkEntry &lm_entry = rba_state.all_lms[new_obs.feat_id];
+		if (lm_entry.last_obs_idx!=SRBA_INVALID_INDEX)
+		     rba_state.all_observations[lm_entry.last_obs_idx].next_obs_same_lm = new_obs_idx;
+		else lm_entry.first_obs_idx = new_obs_idx;
+		lm_entry.last_obs_idx = new_obs_idx;
+	}
 
 	// Update keyframe incident edge list:
 	// ---------------------------------------------------------------------
@@ -129,7 +183,7 @@ size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::add_observation(
 	// Add a new (block) row for this new observation (row index = "new_obs_idx" defined above)
 	// We must create a block for each edge in between the observing and the ref. base id.
 	// Note: no error checking here in find's for efficiency...
-	m_profiler.enter("add_observation.jacobs.sym");
+	if (profile) m_profiler.enter("add_observation.jacobs.sym");
 
 	// ===========================
 	// Jacob 1/2: dh_dAp
@@ -158,6 +212,7 @@ size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::add_observation(
 		{
 			const typename rba_problem_state_t::k2k_edge_vector_t & obs_edges = it_obs_ed->second;
 			ASSERT_(!obs_edges.empty())
+			new_k2f_edge.num_dh_dAp_blocks = obs_edges.size();
 
 			TKeyFrameID curKF = observing_kf_id; // The backward running index towards "base_id"
 			for (size_t j=0;j<obs_edges.size();j++)
@@ -196,12 +251,12 @@ size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::add_observation(
 				//entry.sym.rel_poses_path   = &obs_edges;  // Path OBSERVING_KF -> BASE_KF
 
 				// Pointers to placeholders of future numeric results of the spanning tree:
-				entry.sym.rel_pose_base_from_d1 = & rba_state.spanning_tree.num[curKF][base_id];
+				entry.sym.rel_pose_base_from_d1 = & rba_state.spanning_tree.num.get_ref(curKF,base_id);
 				entry.sym.rel_pose_d1_from_obs  =
 					(curKF==observing_kf_id) ?
 						NULL // Use special value "NULL" when the CPose is fixed to the origin.
 						:
-						& rba_state.spanning_tree.num[observing_kf_id][curKF];
+						& rba_state.spanning_tree.num.get_ref(observing_kf_id,curKF);
 
 				// next node after this edge is:
 				curKF = normal_dir ? obs_edges[i]->from : obs_edges[i]->to;
@@ -220,13 +275,10 @@ size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::add_observation(
 	if (!is_fixed && !graph_says_ignore_this_obs) // Only for features with unknown rel.pos.
 	{
 		// "Remap indices" in dh_df for each column are the feature IDs of those feature with unknown positions.
-		const size_t remapIdx = new_k2f_edge.obs.obs.feat_id;
+		const size_t remapIdx = new_k2f_edge.obs.feat_id;
 
-		const mrpt::utils::map_as_vector<size_t,size_t> &dh_df_remap = rba_state.lin_system.dh_df.getColInverseRemappedIndices();
-		const mrpt::utils::map_as_vector<size_t,size_t>::const_iterator it_idx = dh_df_remap.find(remapIdx);  // O(1) in mrpt::utils::map_as_vector()
-		ASSERT_(it_idx!=dh_df_remap.end())
-
-		const size_t col_idx = it_idx->second;
+		const size_t col_idx = rba_state.lin_system.dh_df.findColByRemapIndex(remapIdx);  // O(1) in mrpt::utils::map_as_vector()
+		ASSERT_(col_idx!=SRBA_INVALID_INDEX)
 
 #if OBS_SUPER_VERBOSE
 		cout << "dh_df: col_idx=" << col_idx << " feat_id=" << remapIdx << " obs_idx=" << new_obs_idx <<  endl;
@@ -253,12 +305,10 @@ size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::add_observation(
 			(new_k2f_edge.is_first_obs_of_unknown) ?
 				NULL // Use special value "NULL" when the CPose is fixed to the origin.
 				:
-				& rba_state.spanning_tree.num[observing_kf_id][base_id];
+				& rba_state.spanning_tree.num.get_ref(observing_kf_id,base_id);
 	}
 
-	m_profiler.leave("add_observation.jacobs.sym");
-
-	m_profiler.leave("add_observation");
+	if (profile) m_profiler.leave("add_observation.jacobs.sym");
 
 	return new_obs_idx;
 }
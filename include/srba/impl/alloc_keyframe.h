@@ -18,12 +18,21 @@ namespace srba {
 template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
 TKeyFrameID RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::alloc_keyframe()
 {
+	TApiRecScope api_rec_scope(m_api_rec_depth);
+	const bool api_rec = api_rec_is_outermost();
+	if (api_rec)
+		api_rec_call(internal::arAllocKeyframe);
+
 	// ==== Assign a free ID to the new KF   : O(1) ====
 	const TKeyFrameID new_kf_id = rba_state.keyframes.size();
 
 	// ==== Create new KF struct: insert at end of std::map<>  : O(1) ====
 	rba_state.keyframes.push_back( keyframe_info() );
 	//keyframe_info &kfi_new = rba_state.keyframes.back();
+
+	if (api_rec)
+		api_log_io_t::write_results(*m_api_rec, std::vector<typename api_log_io_t::TCallResult>(1, typename api_log_io_t::TCallResult(new_kf_id)) );
+
 	return new_kf_id;
 }
 
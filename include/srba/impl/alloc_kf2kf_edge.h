@@ -30,22 +30,21 @@ size_t TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::alloc_k
 	new_edge.inv_pose = init_inv_pose_val;
 
 	new_edge.id = k2k_edges.size()-1; // For convenience, save index within the same structure.
+	new_edge.generation = spanning_tree.num.new_generation();
 
-#ifdef _DEBUG
+	// Consistency check for user introducing duplicated edges, and update of the sorted lists of adjacent KFs:  O(log(D)) search + O(D) insertion
+	std::vector<std::pair<TKeyFrameID,size_t> > &adj1 = keyframes[ids.first ].adjacent_kfs_sorted;
+	std::vector<std::pair<TKeyFrameID,size_t> > &adj2 = keyframes[ids.second].adjacent_kfs_sorted;
+	const std::pair<TKeyFrameID,size_t> entry1(ids.second, new_edge.id), entry2(ids.first, new_edge.id);
+
+	const std::vector<std::pair<TKeyFrameID,size_t> >::iterator it1 = std::lower_bound(adj1.begin(),adj1.end(),entry1);
+	if (it1!=adj1.end() && it1->first==ids.second)
 	{
-		// Security consistency check for user introducing duplicated edges:
-		std::deque<k2k_edge_t*> &edges = keyframes[ids.first ].adjacent_k2k_edges;
-		for (size_t i=0;i<edges.size();++i)
-		{
-			const k2k_edge_t &e = *edges[i];
-			if ( (e.to==ids.first && e.from==ids.second) ||
-				 (e.from==ids.first && e.to==ids.second) )
-			{
-				throw std::runtime_error( mrpt::format("[alloc_kf2kf_edge] ERROR: Edge already exists between %u -> %u",static_cast<unsigned int>(ids.first),static_cast<unsigned int>(ids.second) ) );
-			}
-		}
+		k2k_edges.pop_back();
+		throw std::runtime_error( mrpt::format("[alloc_kf2kf_edge] ERROR: Edge already exists between %u -> %u",static_cast<unsigned int>(ids.first),static_cast<unsigned int>(ids.second) ) );
 	}
-#endif
+	adj1.insert(it1, entry1);
+	adj2.insert(std::lower_bound(adj2.begin(),adj2.end(),entry2), entry2);
 
 	// Update adjacency lists:  O(1)
 	keyframes[ids.first ].adjacent_k2k_edges.push_back(&new_edge);
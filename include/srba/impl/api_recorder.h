@@ -0,0 +1,280 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mrpt/utils/CFileGZOutputStream.h>
+#include <mrpt/utils/CMemoryStream.h>
+#include <typeinfo>
+#include <cstring>  // memcmp()
+
+namespace srba {
+namespace internal {
+
+	/** Record types in an API log file, written by RbaEngine::start_api_recording() \sa api_log_io */
+	enum api_record_t
+	{
+		arParams = 1,          //!< A new value of parameters.srba
+		arResult,              //!< A summary of the results of the previous call (missing if it threw an exception)
+		arClear,
+		arAllocKeyframe,
+		arCreateKf2KfEdge,
+		arDefineNewKeyframe,
+		arOptimizeLocalArea,
+		arOptimizeLocalAreas,
+		arRemoveObservation,
+		arRemoveLandmark,
+		arCompactObservations,
+		arDefineNewKeyframes,
+		arDefineNewKeyframeWithPriors
+	};
+
+	/** Binary (de)serialization of the contents of API log files, shared by RbaEngine (writer) and RbaEngineApiReplayer (reader).
+	  * All sizes and IDs are stored as uint64_t, and real numbers as doubles, so files are portable between 32/64bit builds. */
+	template <class RBA_ENGINE>
+	struct api_log_io
+	{
+		static const uint32_t LOG_VERSION = 5;
+		static const char * magic() { return "SRBA_API_LOG"; }
+
+		/** The summary of results stored for each call (one entry per optimized area, if applicable) */
+		struct TCallResult
+		{
+			uint64_t id;  //!< New KF or edge ID, root KF of optimizations, or the return value of removal methods
+			uint64_t num_observations;
+			double   total_sqr_error_init, total_sqr_error_final;
+
+			TCallResult(const uint64_t id_=0) : id(id_), num_observations(0), total_sqr_error_init(0), total_sqr_error_final(0) {}
+			TCallResult(const uint64_t id_, const typename RBA_ENGINE::TOptimizeExtraOutputInfo &info) :
+				id(id_), num_observations(info.num_observations), total_sqr_error_init(info.total_sqr_error_init), total_sqr_error_final(info.total_sqr_error_final)
+			{}
+
+			/** Bit-by-bit comparison (so it's meaningful for NaNs too) */
+			bool operator ==(const TCallResult &o) const {
+				return id==o.id && num_observations==o.num_observations &&
+					0==std::memcmp(&total_sqr_error_init,&o.total_sqr_error_init,sizeof(double)) &&
+					0==std::memcmp(&total_sqr_error_final,&o.total_sqr_error_final,sizeof(double));
+			}
+		};
+
+		static void write_header(mrpt::utils::CStream &out, const std::string &user_data)
+		{
+			out << std::string(magic()) << LOG_VERSION
+				<< static_cast<uint32_t>(RBA_ENGINE::REL_POSE_DIMS) << static_cast<uint32_t>(RBA_ENGINE::LM_DIMS) << static_cast<uint32_t>(RBA_ENGINE::OBS_DIMS)
+				<< std::string(typeid(RBA_ENGINE).name()) << user_data;
+		}
+		/** Throws if the stream is not an API log, or if it was recorded with a different RbaEngine type.
+		  * Since type names are compiler-dependent, logs can only be replayed by programs built with the same compiler than the recorder. */
+		static void read_header(mrpt::utils::CStream &in, std::string &out_engine_type, std::string &out_user_data)
+		{
+			std::string sMagic;
+			uint32_t version, pose_dims, lm_dims, obs_dims;
+			in >> sMagic;
+			if (sMagic!=magic())
+				throw std::runtime_error("[RbaEngineApiReplayer] Not an SRBA API log file");
+			in >> version;
+			if (version!=LOG_VERSION)
+				throw std::runtime_error(mrpt::format("[RbaEngineApiReplayer] Unsupported API log version: %u", static_cast<unsigned int>(version)));
+			in >> pose_dims >> lm_dims >> obs_dims >> out_engine_type >> out_user_data;
+			if (pose_dims!=RBA_ENGINE::REL_POSE_DIMS || lm_dims!=RBA_ENGINE::LM_DIMS || obs_dims!=RBA_ENGINE::OBS_DIMS)
+				throw std::runtime_error(mrpt::format("[RbaEngineApiReplayer] The API log was recorded with a different problem type: %s", out_engine_type.c_str()));
+			if (out_engine_type!=typeid(RBA_ENGINE).name())
+				throw std::runtime_error(mrpt::format("[RbaEngineApiReplayer] The API log was recorded with a different RbaEngine type: %s (expected: %s)", out_engine_type.c_str(), typeid(RBA_ENGINE).name()));
+		}
+
+		static void write_params(mrpt::utils::CStream &out, const typename RBA_ENGINE::TSRBAParameters &p)
+		{
+			out << static_cast<uint64_t>(p.max_tree_depth) << static_cast<uint64_t>(p.max_optimize_depth)
+				<< p.optimize_new_edges_alone << p.use_robust_kernel << p.use_robust_kernel_stage1 << p.kernel_param
+				<< static_cast<uint64_t>(p.max_iters) << p.max_error_per_obs_to_stop << p.max_rho << p.max_lambda
+				<< p.min_error_reduction_ratio_to_relinearize << p.numeric_jacobians
+				<< p.compute_condition_number << p.compute_sparsity_stats
+				<< static_cast<int32_t>(p.cov_recovery) << p.obs_cold_storage_horizon
+				<< p.removed_obs_compaction_ratio << p.numeric_jacobians_fallback << p.optimize_new_edges_concurrently;
+		}
+		static void read_params(mrpt::utils::CStream &in, typename RBA_ENGINE::TSRBAParameters &p)
+		{
+			uint64_t max_tree_depth, max_optimize_depth, max_iters;
+			int32_t  cov_recovery;
+			in >> max_tree_depth >> max_optimize_depth
+				>> p.optimize_new_edges_alone >> p.use_robust_kernel >> p.use_robust_kernel_stage1 >> p.kernel_param
+				>> max_iters >> p.max_error_per_obs_to_stop >> p.max_rho >> p.max_lambda
+				>> p.min_error_reduction_ratio_to_relinearize >> p.numeric_jacobians
+				>> p.compute_condition_number >> p.compute_sparsity_stats
+				>> cov_recovery >> p.obs_cold_storage_horizon
+				>> p.removed_obs_compaction_ratio >> p.numeric_jacobians_fallback >> p.optimize_new_edges_concurrently;
+			p.max_tree_depth = max_tree_depth;
+			p.max_optimize_depth = max_optimize_depth;
+			p.max_iters = static_cast<size_t>(max_iters);
+			p.cov_recovery = static_cast<TCovarianceRecoveryPolicy>(cov_recovery);
+		}
+
+		static void write_observations(mrpt::utils::CStream &out, const typename RBA_ENGINE::new_kf_observations_t &obs)
+		{
+			out << static_cast<uint64_t>(obs.size());
+			typename RBA_ENGINE::array_obs_t obs_arr;
+			for (typename RBA_ENGINE::new_kf_observations_t::const_iterator it=obs.begin();it!=obs.end();++it)
+			{
+				out << static_cast<uint64_t>(it->obs.feat_id) << it->is_fixed << it->is_unknown_with_init_val;
+				it->obs.obs_data.getAsArray(obs_arr);
+				for (size_t i=0;i<RBA_ENGINE::OBS_DIMS;i++)
+					out << static_cast<double>(obs_arr[i]);
+				if (it->is_fixed || it->is_unknown_with_init_val)
+					for (size_t i=0;i<RBA_ENGINE::LM_DIMS;i++)
+						out << static_cast<double>(it->feat_rel_pos[i]);
+			}
+		}
+		static void write_priors(mrpt::utils::CStream &out, const typename RBA_ENGINE::k2k_priors_t &priors)
+		{
+			out << static_cast<uint64_t>(priors.size());
+			for (typename RBA_ENGINE::k2k_priors_t::const_iterator it=priors.begin();it!=priors.end();++it)
+			{
+				out << static_cast<uint64_t>(it->kf_id) << it->inv_pose;
+				for (size_t r=0;r<RBA_ENGINE::REL_POSE_DIMS;r++)
+					for (size_t c=0;c<RBA_ENGINE::REL_POSE_DIMS;c++)
+						out << static_cast<double>(it->inf_matrix(r,c));
+			}
+		}
+		static void read_priors(mrpt::utils::CStream &in, typename RBA_ENGINE::k2k_priors_t &priors)
+		{
+			uint64_t n, kf_id;
+			in >> n;
+			priors.resize(static_cast<size_t>(n));
+			for (typename RBA_ENGINE::k2k_priors_t::iterator it=priors.begin();it!=priors.end();++it)
+			{
+				in >> kf_id >> it->inv_pose;
+				it->kf_id = static_cast<TKeyFrameID>(kf_id);
+				for (size_t r=0;r<RBA_ENGINE::REL_POSE_DIMS;r++)
+					for (size_t c=0;c<RBA_ENGINE::REL_POSE_DIMS;c++)
+						in >> it->inf_matrix(r,c);
+			}
+		}
+
+		static void read_observations(mrpt::utils::CStream &in, typename RBA_ENGINE::new_kf_observations_t &obs)
+		{
+			uint64_t n, feat_id;
+			in >> n;
+			obs.resize(static_cast<size_t>(n));
+			typename RBA_ENGINE::array_obs_t obs_arr;
+			double d;
+			for (typename RBA_ENGINE::new_kf_observations_t::iterator it=obs.begin();it!=obs.end();++it)
+			{
+				in >> feat_id >> it->is_fixed >> it->is_unknown_with_init_val;
+				it->obs.feat_id = static_cast<TLandmarkID>(feat_id);
+				for (size_t i=0;i<RBA_ENGINE::OBS_DIMS;i++) {
+					in >> d; obs_arr[i] = d;
+				}
+				it->obs.obs_data.setFromArray(obs_arr);
+				if (it->is_fixed || it->is_unknown_with_init_val)
+					for (size_t i=0;i<RBA_ENGINE::LM_DIMS;i++) {
+						in >> d; it->feat_rel_pos[i] = d;
+					}
+			}
+		}
+
+		static void write_local_area(mrpt::utils::CStream &out, const TKeyFrameID root_id, const unsigned int win_size, const typename RBA_ENGINE::TOptimizeLocalAreaParams &params)
+		{
+			out << static_cast<uint64_t>(root_id) << static_cast<uint32_t>(win_size)
+				<< params.optimize_k2k_edges << params.optimize_landmarks
+				<< static_cast<uint64_t>(params.max_visitable_kf_id) << static_cast<uint64_t>(params.dont_optimize_landmarks_seen_less_than_n_times)
+				<< params.min_landmark_parallax_deg << params.min_landmark_baseline_depth_ratio << params.max_landmark_hf_condition_number;
+		}
+		static void read_local_area(mrpt::utils::CStream &in, TKeyFrameID &root_id, unsigned int &win_size, typename RBA_ENGINE::TOptimizeLocalAreaParams &params)
+		{
+			uint64_t root, max_visitable_kf_id, dont_opt_lms;
+			uint32_t win;
+			in >> root >> win >> params.optimize_k2k_edges >> params.optimize_landmarks >> max_visitable_kf_id >> dont_opt_lms
+				>> params.min_landmark_parallax_deg >> params.min_landmark_baseline_depth_ratio >> params.max_landmark_hf_condition_number;
+			root_id = static_cast<TKeyFrameID>(root);
+			win_size = win;
+			params.max_visitable_kf_id = static_cast<TKeyFrameID>(max_visitable_kf_id);
+			params.dont_optimize_landmarks_seen_less_than_n_times = static_cast<size_t>(dont_opt_lms);
+		}
+
+		static void write_indices(mrpt::utils::CStream &out, const std::vector<size_t> &idxs)
+		{
+			out << static_cast<uint64_t>(idxs.size());
+			for (size_t i=0;i<idxs.size();i++)
+				out << static_cast<uint64_t>(idxs[i]);
+		}
+		static void read_indices(mrpt::utils::CStream &in, std::vector<size_t> &idxs)
+		{
+			uint64_t n, v;
+			in >> n;
+			idxs.resize(static_cast<size_t>(n));
+			for (size_t i=0;i<idxs.size();i++) {
+				in >> v; idxs[i] = static_cast<size_t>(v);
+			}
+		}
+
+		static void write_results(mrpt::utils::CStream &out, const std::vector<TCallResult> &res)
+		{
+			out << static_cast<uint8_t>(arResult) << static_cast<uint64_t>(res.size());
+			for (size_t i=0;i<res.size();i++)
+				out << res[i].id << res[i].num_observations << res[i].total_sqr_error_init << res[i].total_sqr_error_final;
+		}
+		static void read_results(mrpt::utils::CStream &in, std::vector<TCallResult> &res)
+		{
+			uint64_t n;
+			in >> n;
+			res.resize(static_cast<size_t>(n));
+			for (size_t i=0;i<res.size();i++)
+				in >> res[i].id >> res[i].num_observations >> res[i].total_sqr_error_init >> res[i].total_sqr_error_final;
+		}
+	};
+
+} // end NS internal
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::start_api_recording(const std::string &log_file, const std::string &user_data)
+{
+	ASSERTMSG_(rba_state.keyframes.empty(), "API recording must start with an empty problem, so it can be replayed into a new RbaEngine")
+
+	stop_api_recording();
+
+	mrpt::utils::CFileGZOutputStream *f = new mrpt::utils::CFileGZOutputStream();
+	if (!f->open(log_file))
+	{
+		delete f;
+		THROW_EXCEPTION_CUSTOM_MSG1("Error creating API log file: '%s'", log_file.c_str())
+	}
+	m_api_rec = f;
+	m_api_rec_last_params.clear();
+
+	internal::api_log_io<rba_engine_t>::write_header(*m_api_rec, user_data);
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::stop_api_recording()
+{
+	delete m_api_rec;  // Closes the file
+	m_api_rec = NULL;
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::api_rec_call(const uint8_t call_type)
+{
+	ASSERTDEB_(m_api_rec)
+
+	// Parameters can be freely changed by the user: only log them if they changed since the last call:
+	mrpt::utils::CMemoryStream  buf;
+	internal::api_log_io<rba_engine_t>::write_params(buf, parameters.srba);
+	const uint8_t *params_data = static_cast<const uint8_t*>(buf.getRawBufferData());
+	const size_t   params_len  = static_cast<size_t>(buf.getTotalBytesCount());
+	if (m_api_rec_last_params.size()!=params_len || !std::equal(params_data,params_data+params_len,m_api_rec_last_params.begin()))
+	{
+		m_api_rec_last_params.assign(params_data,params_data+params_len);
+		*m_api_rec << static_cast<uint8_t>(internal::arParams);
+		m_api_rec->WriteBuffer(params_data,params_len);
+	}
+
+	*m_api_rec << call_type;
+}
+
+} // end NS
@@ -60,7 +60,8 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::bfs_visitor(
 			for (size_t i=0;i<kfi.adjacent_k2f_edges.size();i++)
 			{
 				const k2f_edge_t* ed = kfi.adjacent_k2f_edges[i];
-				const TLandmarkID lm_ID = ed->obs.obs.feat_id;
+				if (ed->is_removed) continue;
+				const TLandmarkID lm_ID = ed->obs.feat_id;
 				if (!lm_visited.count(lm_ID))
 				{
 					if (feat_visitor.visit_filter_feat(lm_ID,cur_dist) )
@@ -144,7 +145,8 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::bfs_visitor(
 			for (size_t i=0;i<kfi.adjacent_k2f_edges.size();i++)
 			{
 				const k2f_edge_t* ed = kfi.adjacent_k2f_edges[i];
-				const TLandmarkID lm_ID = ed->obs.obs.feat_id;
+				if (ed->is_removed) continue;
+				const TLandmarkID lm_ID = ed->obs.feat_id;
 				if (!lm_visited.count(lm_ID))
 				{
 					if (feat_visitor.visit_filter_feat(lm_ID,cur_dist) )
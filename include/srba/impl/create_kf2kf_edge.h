@@ -18,6 +18,16 @@ size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::create_kf2kf_edg
 	const typename traits_t::new_kf_observations_t   & obs,
 	const pose_t &init_inv_pose_val )
 {
+	TApiRecScope api_rec_scope(m_api_rec_depth);
+	const bool api_rec = api_rec_is_outermost();
+	if (api_rec)
+	{
+		api_rec_call(internal::arCreateKf2KfEdge);
+		*m_api_rec << static_cast<uint64_t>(new_kf_id) << static_cast<uint64_t>(new_edge.first) << static_cast<uint64_t>(new_edge.second);
+		api_log_io_t::write_observations(*m_api_rec, obs);
+		*m_api_rec << init_inv_pose_val;
+	}
+
 	// 1) Create new kf2kf structures (all but stuff related to the spanning trees)
 	// ---------------------------------------------------------------------------------
 	const size_t ed_id = rba_state.alloc_kf2kf_edge( new_edge, init_inv_pose_val );     // O(1)
@@ -29,10 +39,14 @@ size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::create_kf2kf_edg
 	rba_state.spanning_tree.update_symbolic_new_node(
 		new_kf_id,
 		new_edge,
-		parameters.srba.max_tree_depth );
+		parameters.srba.max_tree_depth,
+		m_pending_st_paths );
 
 	m_profiler.leave("define_new_keyframe.st.update_symbolic");
 
+	if (api_rec)
+		api_log_io_t::write_results(*m_api_rec, std::vector<typename api_log_io_t::TCallResult>(1, typename api_log_io_t::TCallResult(ed_id)) );
+
 	return ed_id;
 }
 
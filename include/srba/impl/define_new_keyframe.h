@@ -11,6 +11,22 @@
 
 namespace srba {
 
+namespace internal
+{
+	/** Whether two sorted vectors have any common element. O(N+M) */
+	inline bool sorted_vectors_intersect(const std::vector<size_t> &a, const std::vector<size_t> &b)
+	{
+		size_t i=0,j=0;
+		while (i<a.size() && j<b.size())
+		{
+			if (a[i]<b[j])      i++;
+			else if (b[j]<a[i]) j++;
+			else return true;
+		}
+		return false;
+	}
+}
+
 // The main entry point of SRBA. See .h and papers for docs.
 template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
 void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::define_new_keyframe(
@@ -18,6 +34,27 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::define_new_keyfram
 	TNewKeyFrameInfo  & out_new_kf_info,
 	const bool          run_local_optimization )
 {
+	define_new_keyframe(obs, k2k_priors_t(), out_new_kf_info, run_local_optimization);
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::define_new_keyframe(
+	const typename traits_t::new_kf_observations_t  & obs,
+	const k2k_priors_t & priors,
+	TNewKeyFrameInfo  & out_new_kf_info,
+	const bool          run_local_optimization )
+{
+	TApiRecScope api_rec_scope(m_api_rec_depth);
+	const bool api_rec = api_rec_is_outermost();
+	if (api_rec)
+	{
+		api_rec_call(priors.empty() ? internal::arDefineNewKeyframe : internal::arDefineNewKeyframeWithPriors);
+		api_log_io_t::write_observations(*m_api_rec, obs);
+		if (!priors.empty())
+			api_log_io_t::write_priors(*m_api_rec, priors);
+		*m_api_rec << run_local_optimization;
+	}
+
 	m_profiler.enter("define_new_keyframe");
 
 	out_new_kf_info.clear();
@@ -33,23 +70,34 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::define_new_keyfram
 
 	// Keep a list of the new kf2kf edges, whose initial values are indeterminate:
 	std::vector<TNewEdgeInfo> new_k2k_edge_ids;
-	determine_kf2kf_edges_to_create(new_kf_id,obs, new_k2k_edge_ids);   // ***** here's the beef! *****
+	// The shortest paths of the symbolic spanning trees are rebuilt only once, after creating all the new edges:
+	std::set<TPairKeyFrameID> pending_st_paths;
+	{
+		struct TDeferPaths // RAII: make sure no dangling pointer is left behind upon exceptions
+		{
+			TDeferPaths(std::set<TPairKeyFrameID>* &ptr_, std::set<TPairKeyFrameID> &s) : ptr(ptr_) { ptr=&s; }
+			~TDeferPaths() { ptr=NULL; }
+			std::set<TPairKeyFrameID>* &ptr;
+		} defer_paths(m_pending_st_paths, pending_st_paths);
+
+		determine_kf2kf_edges_to_create(new_kf_id,obs, new_k2k_edge_ids);   // ***** here's the beef! *****
+
+		// Prior factors: attached to the edges to their KFs, which are created if the ECP didn't:
+		if (!priors.empty())
+			k2k_priors_attach(new_kf_id, priors, obs, new_k2k_edge_ids);
+	}
 
 	m_profiler.leave("define_new_keyframe.determine_edges");
 
+	m_profiler.enter("define_new_keyframe.st.update_paths");
+	rba_state.spanning_tree.update_symbolic_paths(pending_st_paths);
+	m_profiler.leave("define_new_keyframe.st.update_paths");
+
 
 	// Expand symbolic Jacobians to accomodate new observations:      O( No * (P+log C) )
 	// -----------------------------------------------------------------------------
 	m_profiler.enter("define_new_keyframe.add_observations");
-
-	for (typename new_kf_observations_t::const_iterator it_obs = obs.begin();it_obs != obs.end();++it_obs)
-	{
-		const typename landmark_traits_t::array_landmark_t *fixed_rel_pos       = it_obs->is_fixed                 ? &it_obs->feat_rel_pos : NULL;
-		const typename landmark_traits_t::array_landmark_t *unk_rel_pos_initval = it_obs->is_unknown_with_init_val ? &it_obs->feat_rel_pos : NULL;
-
-		this->add_observation( new_kf_id, it_obs->obs, fixed_rel_pos, unk_rel_pos_initval );
-	}
-
+	this->add_observations( new_kf_id, obs );  // Profiled as a whole batch, not per observation
 	m_profiler.leave("define_new_keyframe.add_observations");
 
 	// Update SLAM estimation:
@@ -58,38 +106,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::define_new_keyfram
 	{
 		// Try to initialize the new edges in separate optimizations?
 		if (parameters.srba.optimize_new_edges_alone)
-		{
-			// Do it one by one so we can detect rank-deficient situations, etc.
-			if (!new_k2k_edge_ids.empty())
-			{
-				m_profiler.enter("define_new_keyframe.opt_new_edges");
-
-				// temporarily disable robust kernel for initialization (faster)
-				const bool old_kernel = parameters.srba.use_robust_kernel;
-				parameters.srba.use_robust_kernel= parameters.srba.use_robust_kernel_stage1;
-
-				std::vector<size_t>  k2f_edges_to_opt;  // Empty: only initialize k2k edges.
-				std::vector<size_t>  k2k_edges_to_opt(1);
-
-				for (size_t i=0;i<new_k2k_edge_ids.size();i++)
-				{
-					if (new_k2k_edge_ids[i].has_approx_init_val)
-						continue;  // Already initialized, can skip it.
-					k2k_edges_to_opt[0] = new_k2k_edge_ids[i].id ;
-
-					//TOptimizeExtraOutputInfo  init_opt_info;
-					this->optimize_edges(
-						k2k_edges_to_opt,
-						k2f_edges_to_opt,
-						out_new_kf_info.optimize_results_stg1 /*init_opt_info*/
-						);
-				}
-
-				parameters.srba.use_robust_kernel = old_kernel;
-
-				m_profiler.leave("define_new_keyframe.opt_new_edges");
-			}
-		}
+			optimize_new_edges_alone(new_k2k_edge_ids, out_new_kf_info.optimize_results_stg1);
 
 		m_profiler.enter("define_new_keyframe.optimize");
 
@@ -106,6 +123,27 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::define_new_keyfram
 	}
 
 
+	// Move observations of old KFs out of the active area to compact storage:
+	// -----------------------------------------------------------------------------
+	if (parameters.srba.obs_cold_storage_horizon>0 && new_kf_id>parameters.srba.obs_cold_storage_horizon)
+	{
+		m_profiler.enter("define_new_keyframe.obs_cold_storage");
+		const size_t nChunks = rba_state.obs_data.move_to_cold_storage(new_kf_id-parameters.srba.obs_cold_storage_horizon);
+		m_profiler.leave("define_new_keyframe.obs_cold_storage");
+
+		VERBOSE_LEVEL(2) << "[define_new_keyframe] Moved " << nChunks << " observation chunks to cold storage (" << rba_state.obs_data.num_cold_chunks() << "/" << rba_state.obs_data.num_chunks() << " cold).\n";
+	}
+
+	// Purge removed observations, once they are a significant fraction of all of them (amortized O(1) per removal):
+	// -----------------------------------------------------------------------------
+	if (parameters.srba.removed_obs_compaction_ratio>0 && rba_state.num_removed_observations>0 &&
+		rba_state.num_removed_observations > parameters.srba.removed_obs_compaction_ratio*rba_state.all_observations.size())
+	{
+		m_profiler.enter("define_new_keyframe.compact_observations");
+		this->compact_observations();
+		m_profiler.leave("define_new_keyframe.compact_observations");
+	}
+
 	// Fill out_new_kf_info
 	// -----------------------------------------
 	out_new_kf_info.kf_id = new_kf_id;
@@ -113,8 +151,278 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::define_new_keyfram
 
 	m_profiler.leave("define_new_keyframe");
 
+	if (api_rec)
+		api_log_io_t::write_results(*m_api_rec, std::vector<typename api_log_io_t::TCallResult>(1, typename api_log_io_t::TCallResult(new_kf_id,out_new_kf_info.optimize_results)) );
+
 	VERBOSE_LEVEL(1) << "[define_new_keyframe] Done. New KF #" << out_new_kf_info.kf_id << " with " << out_new_kf_info.created_edge_ids.size() << " new edges.\n";
 } // end of RbaEngine::define_new_keyframe
 
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_new_edges_alone(
+	const std::vector<TNewEdgeInfo> & new_k2k_edge_ids,
+	TOptimizeExtraOutputInfo        & out_info )
+{
+	// Do it one by one so we can detect rank-deficient situations, etc.
+	out_info.clear();
+	if (new_k2k_edge_ids.empty())
+		return;
+
+	m_profiler.enter("define_new_keyframe.opt_new_edges");
+
+	// 1st) The observations and numeric poses of each edge problem:
+	// ------------------------------------------------------------
+	std::vector<TNewEdgeStage1Task> tasks;
+	for (size_t i=0;i<new_k2k_edge_ids.size();i++)
+	{
+		if (new_k2k_edge_ids[i].has_approx_init_val)
+			continue;  // Already initialized, can skip it.
+
+		tasks.push_back(TNewEdgeStage1Task());
+		tasks.back().edge_id = new_k2k_edge_ids[i].id;
+		get_new_edge_stage1_footprint(tasks.back());
+	}
+	const size_t nTasks = tasks.size();
+
+	// 2nd) Select the edges whose problems are independent of those of all the previous edges (no common observation, and none reads
+	//  a pose whose path goes through the other edge), so running them first and concurrently gives the same results than the serial loop:
+	// ------------------------------------------------------------
+	std::vector<size_t>  concurrent_tasks, sequential_tasks;
+	for (size_t i=0;i<nTasks;i++)
+	{
+		bool independent = tasks[i].can_run_concurrently;
+		for (size_t j=0;j<i && independent;j++)
+		{
+			independent =
+				tasks[j].can_run_concurrently &&
+				!tasks[i].other_edges.count(tasks[j].edge_id) &&
+				!tasks[j].other_edges.count(tasks[i].edge_id) &&
+				!internal::sorted_vectors_intersect(tasks[i].obs_idxs, tasks[j].obs_idxs);
+		}
+		if (independent)
+			concurrent_tasks.push_back(i);
+		else
+			sequential_tasks.push_back(i);
+	}
+	if (concurrent_tasks.size()<2 || !parameters.srba.optimize_new_edges_concurrently)
+	{
+		// Nothing to gain (or disabled by the user): just go through them in order:
+		concurrent_tasks.clear();
+		sequential_tasks.clear();
+		for (size_t i=0;i<nTasks;i++)
+			sequential_tasks.push_back(i);
+	}
+
+	// temporarily disable robust kernel for initialization (faster)
+	const bool old_kernel = parameters.srba.use_robust_kernel;
+	parameters.srba.use_robust_kernel= parameters.srba.use_robust_kernel_stage1;
+
+	const std::vector<size_t>  k2f_edges_to_opt;  // Empty: only initialize k2k edges.
+
+	// 3rd) Optimize the independent ones concurrently:
+	// ------------------------------------------------------------
+	const int nConcurrent = static_cast<int>(concurrent_tasks.size());
+	if (nConcurrent)
+	{
+		// This can't be done concurrently: bring all the required numeric poses up-to-date, creating them if needed, and the observations to hot storage.
+		// Each task will then only recompute its own poses, which no other task reads:
+		std::set<TKeyFrameID>  roots;
+		for (int k=0;k<nConcurrent;k++)
+		{
+			const TNewEdgeStage1Task &t = tasks[concurrent_tasks[k]];
+			roots.insert(t.tree_roots.begin(),t.tree_roots.end());
+			for (size_t j=0;j<t.obs_idxs.size();j++)
+				rba_state.obs_data.make_hot(t.obs_idxs[j]);
+		}
+		rba_state.spanning_tree.update_numeric(roots, false);
+
+		for (int k=0;k<nConcurrent;k++)
+		{
+			typename rba_problem_state_t::TSpanningTree::numeric_pose_path_list_t &poses = tasks[concurrent_tasks[k]].own_num_poses;
+			for (size_t j=0;j<poses.size();j++)
+				poses[j].entry = &rba_state.spanning_tree.num.get_entry(poses[j].from, poses[j].to);
+		}
+	}
+	std::vector<std::string> errors(nConcurrent);
+
+	const bool old_profiler_enabled = m_profiler.isEnabled();
+	m_profiler.enable(false);  // CTimeLogger is not thread-safe
+
+#if defined(_OPENMP)
+#	pragma omp parallel for schedule(dynamic)
+#endif
+	for (int k=0;k<nConcurrent;k++)
+	{
+		TNewEdgeStage1Task &t = tasks[concurrent_tasks[k]];
+		try
+		{
+			this->optimize_edges(std::vector<size_t>(1,t.edge_id), k2f_edges_to_opt, t.info, std::vector<size_t>(), &t.own_num_poses);
+		}
+		catch (std::exception &e)
+		{
+			errors[k] = e.what();
+		}
+		catch (...)
+		{
+			errors[k] = "Unknown exception";
+		}
+	}
+
+	m_profiler.enable(old_profiler_enabled);
+
+	if (nConcurrent)
+	{
+		// All the numeric poses through the optimized edges are outdated, except the own poses of each task, which are in sync:
+		for (int k=0;k<nConcurrent;k++)
+		{
+			const TNewEdgeStage1Task &t = tasks[concurrent_tasks[k]];
+			rba_state.spanning_tree.mark_edge_modified(t.edge_id);
+			rba_state.spanning_tree.update_numeric_poses(t.own_num_poses);
+		}
+	}
+
+	for (int k=0;k<nConcurrent;k++)
+	{
+		if (!errors[k].empty())
+		{
+			parameters.srba.use_robust_kernel = old_kernel;
+			throw std::runtime_error(mrpt::format("[optimize_new_edges_alone] Error optimizing new edge #%u:\n%s", static_cast<unsigned int>(tasks[concurrent_tasks[k]].edge_id), errors[k].c_str()));
+		}
+	}
+
+	// 4th) And the rest, sequentially:
+	// ------------------------------------------------------------
+	for (size_t k=0;k<sequential_tasks.size();k++)
+	{
+		TNewEdgeStage1Task &t = tasks[sequential_tasks[k]];
+		this->optimize_edges(std::vector<size_t>(1,t.edge_id), k2f_edges_to_opt, t.info);
+	}
+
+	parameters.srba.use_robust_kernel = old_kernel;
+
+	// Merge the results, in the order of the edges:
+	for (size_t i=0;i<nTasks;i++)
+		out_info.accumulate(tasks[i].info);
+
+	VERBOSE_LEVEL(2) << "[optimize_new_edges_alone] " << nConcurrent << " new edges optimized concurrently, " << sequential_tasks.size() << " sequentially.\n";
+
+	m_profiler.leave("define_new_keyframe.opt_new_edges");
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::get_new_edge_stage1_footprint(TNewEdgeStage1Task &task)
+{
+	typename TSparseBlocksJacobians_dh_dAp::col_t & col = rba_state.lin_system.dh_dAp.getCol(task.edge_id);
+
+	// The numeric poses read by the residuals and Jacobians of each observation, as canonical pairs (i,j), i>j:
+	std::set<TPairKeyFrameID> pairs;
+	for (typename TSparseBlocksJacobians_dh_dAp::col_t::const_iterator it=col.begin();it!=col.end();++it)
+	{
+		const k2f_edge_t &k2f = rba_state.all_observations[it->first];
+		const TKeyFrameID obs_id  = k2f.obs.kf_id;
+		const TKeyFrameID d1_id   = it->second.sym.kf_d;
+		const TKeyFrameID base_id = it->second.sym.kf_base;
+		const TKeyFrameID lm_base_id = k2f.feat_rel_pos->id_frame_base;
+
+		task.obs_idxs.push_back(it->first);
+		if (d1_id!=obs_id)      pairs.insert(TPairKeyFrameID(std::max(d1_id,obs_id),std::min(d1_id,obs_id)));
+		if (base_id!=d1_id)     pairs.insert(TPairKeyFrameID(std::max(base_id,d1_id),std::min(base_id,d1_id)));
+		if (lm_base_id!=obs_id) pairs.insert(TPairKeyFrameID(std::max(lm_base_id,obs_id),std::min(lm_base_id,obs_id)));
+	}
+	std::sort(task.obs_idxs.begin(),task.obs_idxs.end());
+
+	std::vector<typename TSparseBlocksJacobians_dh_dAp::col_t*> dh_dAp(1, &col);
+	prepare_Jacobians_required_tree_roots(task.tree_roots, dh_dAp, std::vector<typename TSparseBlocksJacobians_dh_df::col_t*>());
+
+	for (std::set<TPairKeyFrameID>::const_iterator itP=pairs.begin();itP!=pairs.end();++itP)
+	{
+		typename rba_problem_state_t::TSpanningTree::all_edges_maps_t::const_iterator it_map = rba_state.spanning_tree.sym.all_edges.find(itP->first);
+		if (it_map==rba_state.spanning_tree.sym.all_edges.end()) {
+			task.can_run_concurrently = false;
+			continue;
+		}
+		typename std::map<TKeyFrameID, typename rba_problem_state_t::k2k_edge_vector_t>::const_iterator it_path = it_map->second.find(itP->second);
+		if (it_path==it_map->second.end()) {
+			task.can_run_concurrently = false;
+			continue;
+		}
+
+		const typename rba_problem_state_t::k2k_edge_vector_t & path = it_path->second;
+		bool is_own = false;
+		for (size_t k=0;k<path.size();k++)
+		{
+			if (path[k]->id==task.edge_id)
+				is_own = true;
+			else task.other_edges.insert(path[k]->id);
+		}
+		if (is_own)
+		{
+			typename rba_problem_state_t::TSpanningTree::TNumericPosePath pp;
+			pp.from = itP->first;
+			pp.to   = itP->second;
+			pp.path = &path;
+			task.own_num_poses.push_back(pp);
+		}
+	}
+}
+
+// Bulk version of define_new_keyframe()
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::define_new_keyframes(
+	const std::vector<typename traits_t::new_kf_observations_t> & obs_batch,
+	new_kf_info_vector_t & out_new_kf_infos,
+	const bool             run_local_optimization )
+{
+	TApiRecScope api_rec_scope(m_api_rec_depth);
+	const bool api_rec = api_rec_is_outermost();
+	if (api_rec)
+	{
+		api_rec_call(internal::arDefineNewKeyframes);
+		*m_api_rec << static_cast<uint64_t>(obs_batch.size());
+		for (size_t i=0;i<obs_batch.size();i++)
+			api_log_io_t::write_observations(*m_api_rec, obs_batch[i]);
+		*m_api_rec << run_local_optimization;
+	}
+
+	m_profiler.enter("define_new_keyframes");
+
+	out_new_kf_infos.resize(obs_batch.size());
+	for (size_t i=0;i<obs_batch.size();i++)
+	{
+		TNewKeyFrameInfo &new_kf_info = out_new_kf_infos[i];
+
+		// New KF, edges and observations, without the local area optimization:
+		this->define_new_keyframe(obs_batch[i], new_kf_info, false);
+
+		// But new edges must be initialized right now, since next KFs may be linked through them:
+		if (run_local_optimization && parameters.srba.optimize_new_edges_alone)
+			optimize_new_edges_alone(new_kf_info.created_edge_ids, new_kf_info.optimize_results_stg1);
+	}
+
+	// Only one local area optimization, for the last KF:
+	if (run_local_optimization && !out_new_kf_infos.empty())
+	{
+		m_profiler.enter("define_new_keyframes.optimize");
+
+		TNewKeyFrameInfo &last_kf_info = out_new_kf_infos.back();
+		this->optimize_local_area(
+			last_kf_info.kf_id, // root node
+			parameters.srba.max_optimize_depth,   // win size
+			last_kf_info.optimize_results
+			);
+
+		m_profiler.leave("define_new_keyframes.optimize");
+	}
+
+	m_profiler.leave("define_new_keyframes");
+
+	if (api_rec)
+	{
+		std::vector<typename api_log_io_t::TCallResult> res;
+		for (size_t i=0;i<out_new_kf_infos.size();i++)
+			res.push_back( typename api_log_io_t::TCallResult(out_new_kf_infos[i].kf_id, out_new_kf_infos[i].optimize_results) );
+		api_log_io_t::write_results(*m_api_rec, res);
+	}
+}
+
 
 } // end NS
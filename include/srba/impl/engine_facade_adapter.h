@@ -0,0 +1,280 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+// Implementation of IRbaEngine for any RbaEngine<> instance. Only needed to build the "srba-engines" library
+// (or to add custom instances to it): users of the library only need srba/srba_engine_facade.h
+
+#include <srba.h>
+#include <srba/srba_engine_facade.h>
+
+namespace srba {
+namespace internal
+{
+	/** The RBA_OPTIONS of the precompiled instances: those of each problem type (sensor pose, noise model), with the runtime-selectable ECP and solver */
+	template <class BASE_OPTIONS, class ECP, class SOLVER>
+	struct facade_rba_options : public BASE_OPTIONS
+	{
+		typedef ECP     edge_creation_policy_t;
+		typedef SOLVER  solver_t;
+	};
+
+	// Load/save of the sensor parameters (IRbaEngine::load_parameters()). By default, there's nothing to load:
+	template <class OBS_TYPE>
+	struct facade_sensor_params_io
+	{
+		template <class PARAMS> static void load(PARAMS &p, const mrpt::utils::CConfigFileBase &source) { MRPT_UNUSED_PARAM(p); MRPT_UNUSED_PARAM(source); }
+		template <class PARAMS> static void save(const PARAMS &p, mrpt::utils::CConfigFileBase &out) { MRPT_UNUSED_PARAM(p); MRPT_UNUSED_PARAM(out); }
+	};
+	template <>
+	struct facade_sensor_params_io<observations::MonocularCamera>
+	{
+		static void load(observations::MonocularCamera::TObservationParams &p, const mrpt::utils::CConfigFileBase &source) {
+			if (source.sectionExists("CAMERA")) p.camera_calib.loadFromConfigFile("CAMERA",source);
+		}
+		static void save(const observations::MonocularCamera::TObservationParams &p, mrpt::utils::CConfigFileBase &out) {
+			p.camera_calib.saveToConfigFile("CAMERA",out);
+		}
+	};
+	template <>
+	struct facade_sensor_params_io<observations::StereoCamera>
+	{
+		static void load(observations::StereoCamera::TObservationParams &p, const mrpt::utils::CConfigFileBase &source) {
+			if (source.sectionExists("CAMERA")) p.camera_calib.loadFromConfigFile("CAMERA",source);
+		}
+		static void save(const observations::StereoCamera::TObservationParams &p, mrpt::utils::CConfigFileBase &out) {
+			p.camera_calib.saveToConfigFile("CAMERA",out);
+		}
+	};
+
+	// Load/save of the sensor pose parameters:
+	template <class SENSOR_POSE_OPTION>
+	struct facade_sensor_pose_params_io
+	{
+		template <class PARAMS> static void load(PARAMS &p, const mrpt::utils::CConfigFileBase &source) { MRPT_UNUSED_PARAM(p); MRPT_UNUSED_PARAM(source); }
+		template <class PARAMS> static void save(const PARAMS &p, mrpt::utils::CConfigFileBase &out) { MRPT_UNUSED_PARAM(p); MRPT_UNUSED_PARAM(out); }
+	};
+	template <>
+	struct facade_sensor_pose_params_io<options::sensor_pose_on_robot_se3>
+	{
+		static void load(options::sensor_pose_on_robot_se3::parameters_t &p, const mrpt::utils::CConfigFileBase &source) {
+			const std::string s = source.read_string("sensor_pose","relative_pose","",false);
+			if (!s.empty()) p.relative_pose.fromString(s);
+		}
+		static void save(const options::sensor_pose_on_robot_se3::parameters_t &p, mrpt::utils::CConfigFileBase &out) {
+			out.write("sensor_pose","relative_pose",p.relative_pose.asString());
+		}
+	};
+
+	// Load/save of the observation noise parameters (only the noise model with scalar parameters is supported):
+	template <class NOISE_OPTION>
+	struct facade_obs_noise_params_io
+	{
+		template <class PARAMS> static void load(PARAMS &p, const mrpt::utils::CConfigFileBase &source) { MRPT_UNUSED_PARAM(p); MRPT_UNUSED_PARAM(source); }
+		template <class PARAMS> static void save(const PARAMS &p, mrpt::utils::CConfigFileBase &out) { MRPT_UNUSED_PARAM(p); MRPT_UNUSED_PARAM(out); }
+	};
+	template <>
+	struct facade_obs_noise_params_io<options::observation_noise_identity>
+	{
+		static void load(options::observation_noise_identity::parameters_t &p, const mrpt::utils::CConfigFileBase &source) {
+			p.std_noise_observations = source.read_double("obs_noise","std_noise_observations",p.std_noise_observations,false);
+		}
+		static void save(const options::observation_noise_identity::parameters_t &p, mrpt::utils::CConfigFileBase &out) {
+			out.write("obs_noise","std_noise_observations",p.std_noise_observations);
+		}
+	};
+
+	/** Implementation of IRbaEngine, which forwards each call to a statically-typed RbaEngine<> */
+	template <class RBA_ENGINE>
+	class CRbaEngineFacade : public IRbaEngine
+	{
+	public:
+		typedef RBA_ENGINE rba_engine_t;
+		typedef typename rba_engine_t::kf2kf_pose_t  kf2kf_pose_t;
+		typedef typename rba_engine_t::landmark_t    landmark_t;
+		typedef typename rba_engine_t::obs_t         obs_t;
+		typedef typename rba_engine_t::rba_options_t rba_options_t;
+
+		CRbaEngineFacade(const TRbaEngineConfig &cfg) : m_cfg(cfg) {}
+
+		/** Direct access to the wrapped engine */
+		rba_engine_t & engine() { return m_rba; }
+
+		virtual const TRbaEngineConfig & get_config() const { return m_cfg; }
+
+		virtual size_t get_kf2kf_pose_dims() const { return kf2kf_pose_t::REL_POSE_DIMS; }
+		virtual size_t get_landmark_dims() const { return landmark_t::LM_DIMS; }
+		virtual size_t get_obs_dims() const { return obs_t::OBS_DIMS; }
+
+		virtual void define_new_keyframe(const generic_observations_t &obs, TGenericNewKeyFrameInfo &out_new_kf_info, const bool run_local_optimization)
+		{
+			typename rba_engine_t::new_kf_observations_t list_obs;
+			for (size_t i=0;i<obs.size();i++)
+			{
+				const TGenericObservation &o = obs[i];
+				ASSERTMSG_(o.obs_data.size()==obs_t::OBS_DIMS, mrpt::format("Observation #%u has %u values, expected %u",static_cast<unsigned int>(i),static_cast<unsigned int>(o.obs_data.size()),static_cast<unsigned int>(obs_t::OBS_DIMS)))
+
+				typename rba_engine_t::new_kf_observation_t obs_field;
+				obs_field.obs.feat_id = o.feat_id;
+				obs_field.obs.obs_data.setFromArray(o.obs_data);
+				obs_field.is_fixed = o.is_fixed;
+				obs_field.is_unknown_with_init_val = o.is_unknown_with_init_val;
+				if (o.is_fixed || o.is_unknown_with_init_val)
+				{
+					ASSERTMSG_(o.feat_rel_pos.size()==landmark_t::LM_DIMS, mrpt::format("Observation #%u: wrong length of feat_rel_pos",static_cast<unsigned int>(i)))
+					obs_field.setRelPos(o.feat_rel_pos);
+				}
+				list_obs.push_back(obs_field);
+			}
+
+			typename rba_engine_t::TNewKeyFrameInfo new_kf_info;
+			m_rba.define_new_keyframe(list_obs, new_kf_info, run_local_optimization);
+
+			out_new_kf_info.kf_id = new_kf_info.kf_id;
+			out_new_kf_info.created_edge_ids = new_kf_info.created_edge_ids;
+			copy_optimize_info(new_kf_info.optimize_results, out_new_kf_info.optimize_results);
+		}
+
+		virtual void optimize_local_area(const TKeyFrameID root_id, const unsigned int win_size, TGenericOptimizeInfo &out_info)
+		{
+			typename rba_engine_t::TOptimizeExtraOutputInfo info;
+			m_rba.optimize_local_area(root_id, win_size, info);
+			copy_optimize_info(info, out_info);
+		}
+
+		virtual bool remove_observation(const TKeyFrameID observing_kf_id, const TLandmarkID feat_id) { return m_rba.remove_observation(observing_kf_id,feat_id); }
+		virtual bool remove_landmark(const TLandmarkID feat_id) { return m_rba.remove_landmark(feat_id); }
+
+		virtual double eval_overall_squared_error() const { return m_rba.eval_overall_squared_error(); }
+
+		virtual size_t get_num_keyframes() const { return m_rba.get_rba_state().keyframes.size(); }
+		virtual size_t get_num_kf2kf_edges() const { return m_rba.get_k2k_edges().size(); }
+
+		virtual void get_kf2kf_edge(const size_t edge_id, TKeyFrameID &from, TKeyFrameID &to, mrpt::poses::CPose3D &inv_pose) const
+		{
+			ASSERT_(edge_id<m_rba.get_k2k_edges().size())
+			const typename rba_engine_t::k2k_edge_t &ed = m_rba.get_k2k_edges()[edge_id];
+			from = ed.from;
+			to = ed.to;
+			inv_pose = mrpt::poses::CPose3D(ed.inv_pose);
+		}
+
+		virtual bool get_landmark_rel_pos(const TLandmarkID feat_id, TKeyFrameID &base_kf_id, std::vector<double> &pos) const
+		{
+			const typename rba_engine_t::TRelativeLandmarkPos *lm = NULL;
+			typename rba_engine_t::TRelativeLandmarkPosMap::const_iterator it = m_rba.get_unknown_feats().find(feat_id);
+			if (it!=m_rba.get_unknown_feats().end()) lm = &it->second;
+			else
+			{
+				it = m_rba.get_known_feats().find(feat_id);
+				if (it!=m_rba.get_known_feats().end()) lm = &it->second;
+			}
+			if (!lm) return false;
+
+			base_kf_id = lm->id_frame_base;
+			pos.resize(landmark_t::LM_DIMS);
+			for (size_t i=0;i<landmark_t::LM_DIMS;i++) pos[i]=lm->pos[i];
+			return true;
+		}
+
+		virtual void get_relative_poses(const TKeyFrameID root_id, std::map<TKeyFrameID,mrpt::poses::CPose3D> &out_poses, const size_t max_depth) const
+		{
+			typename rba_engine_t::frameid2pose_map_t span_tree;
+			m_rba.create_complete_spanning_tree(root_id, span_tree, max_depth);
+
+			out_poses.clear();
+			out_poses[root_id] = mrpt::poses::CPose3D();
+			for (typename rba_engine_t::frameid2pose_map_t::const_iterator it=span_tree.begin();it!=span_tree.end();++it)
+				out_poses[it->first] = mrpt::poses::CPose3D(it->second.pose);
+		}
+
+		virtual void load_parameters(const mrpt::utils::CConfigFileBase &source)
+		{
+			m_rba.parameters.srba.loadFromConfigFile(source,"srba");
+			m_rba.parameters.ecp.loadFromConfigFile(source,"ecp");
+			facade_obs_noise_params_io<typename rba_options_t::obs_noise_matrix_t>::load(m_rba.parameters.obs_noise, source);
+			facade_sensor_pose_params_io<typename rba_options_t::sensor_pose_on_robot_t>::load(m_rba.parameters.sensor_pose, source);
+			facade_sensor_params_io<obs_t>::load(m_rba.parameters.sensor, source);
+			m_rba.parameters.cost_model.loadFromConfigFile(source,"cost_model");
+		}
+
+		virtual void save_parameters(mrpt::utils::CConfigFileBase &out) const
+		{
+			m_rba.parameters.srba.saveToConfigFile(out,"srba");
+			m_rba.parameters.ecp.saveToConfigFile(out,"ecp");
+			facade_obs_noise_params_io<typename rba_options_t::obs_noise_matrix_t>::save(m_rba.parameters.obs_noise, out);
+			facade_sensor_pose_params_io<typename rba_options_t::sensor_pose_on_robot_t>::save(m_rba.parameters.sensor_pose, out);
+			facade_sensor_params_io<obs_t>::save(m_rba.parameters.sensor, out);
+			m_rba.parameters.cost_model.saveToConfigFile(out,"cost_model");
+		}
+
+		virtual void clear() { m_rba.clear(); }
+		virtual void setVerbosityLevel(int level) { m_rba.setVerbosityLevel(level); }
+		virtual void enable_time_profiler(bool enable) { m_rba.enable_time_profiler(enable); }
+		virtual bool save_graph_as_dot(const std::string &targetFileName, const bool all_landmarks) const { return m_rba.save_graph_as_dot(targetFileName,all_landmarks); }
+
+		virtual void start_api_recording(const std::string &log_file, const std::string &user_data) { m_rba.start_api_recording(log_file,user_data); }
+		virtual void stop_api_recording() { m_rba.stop_api_recording(); }
+
+		MRPT_MAKE_ALIGNED_OPERATOR_NEW  // Required by Eigen containers
+
+	private:
+		TRbaEngineConfig m_cfg;
+		rba_engine_t     m_rba;
+
+		static void copy_optimize_info(const typename rba_engine_t::TOptimizeExtraOutputInfo &in, TGenericOptimizeInfo &out)
+		{
+			out.num_observations = in.num_observations;
+			out.num_jacobians = in.num_jacobians;
+			out.num_kf2kf_edges_optimized = in.num_kf2kf_edges_optimized;
+			out.num_kf2lm_edges_optimized = in.num_kf2lm_edges_optimized;
+			out.num_total_scalar_optimized = in.num_total_scalar_optimized;
+			out.num_span_tree_numeric_updates = in.num_span_tree_numeric_updates;
+			out.obs_rmse = in.obs_rmse;
+			out.total_sqr_error_init = in.total_sqr_error_init;
+			out.total_sqr_error_final = in.total_sqr_error_final;
+			out.optimized_k2k_edge_indices = in.optimized_k2k_edge_indices;
+			out.optimized_landmark_indices = in.optimized_landmark_indices;
+		}
+	};
+
+	/** Creates an instance of one problem type (KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE), with the ECP and solver given by their names in \a cfg.
+	  * Explicitly instantiating this struct instantiates RbaEngine<> for all the supported ECPs and solvers.
+	  * \tparam BASE_OPTIONS The RBA_OPTIONS of this problem type; its ECP and solver are ignored.
+	  */
+	template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class BASE_OPTIONS>
+	struct rba_engine_facade_factory
+	{
+		/** \return NULL if the ECP or solver are unknown */
+		static IRbaEngine * create(const TRbaEngineConfig &cfg)
+		{
+			if (cfg.ecp=="local_areas_fixed_size") return create_with_ecp<ecps::local_areas_fixed_size>(cfg);
+			if (cfg.ecp=="classic_linear_rba")     return create_with_ecp<ecps::classic_linear_rba>(cfg);
+			return NULL;
+		}
+
+	private:
+		template <class ECP>
+		static IRbaEngine * create_with_ecp(const TRbaEngineConfig &cfg)
+		{
+			if (cfg.solver=="LM_schur_dense_cholesky")     return create_with<ECP,options::solver_LM_schur_dense_cholesky>(cfg);
+			if (cfg.solver=="LM_schur_sparse_cholesky")    return create_with<ECP,options::solver_LM_schur_sparse_cholesky>(cfg);
+			if (cfg.solver=="LM_no_schur_sparse_cholesky") return create_with<ECP,options::solver_LM_no_schur_sparse_cholesky>(cfg);
+			return NULL;
+		}
+
+		template <class ECP,class SOLVER>
+		static IRbaEngine * create_with(const TRbaEngineConfig &cfg)
+		{
+			return new CRbaEngineFacade< RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,facade_rba_options<BASE_OPTIONS,ECP,SOLVER> > >(cfg);
+		}
+	};
+
+} } // end NS
@@ -0,0 +1,161 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+namespace srba {
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::estimate_local_area_cost(
+	const TKeyFrameID  root_id,
+	const unsigned int win_size,
+	TOptimizationCostEstimate & out,
+	const TOptimizeLocalAreaParams &params
+	) const
+{
+	m_profiler.enter("estimate_local_area_cost");
+
+	out.clear();
+
+	const size_t POSE_DIMS = kf2kf_pose_t::REL_POSE_DIMS;
+	const size_t LM_DIMS   = landmark_t::LM_DIMS;
+
+	// 1st) Find the unknowns exactly as optimize_local_area() does:
+	// --------------------------------------------------------------
+	VisitorOptimizeLocalArea my_visitor(this->rba_state,params);
+	this->bfs_visitor(root_id, win_size, win_size<=parameters.srba.max_tree_depth, my_visitor,my_visitor,my_visitor,my_visitor);
+	filter_landmarks_by_geometry(my_visitor.lm_IDs_to_optimize, params);
+
+	// 2nd) Their Jacobian columns, discarding unknowns without observations nor priors (as optimize_edges() does):
+	// --------------------------------------------------------------
+	std::vector<const typename TSparseBlocksJacobians_dh_dAp::col_t*>  dh_dAp;
+	std::vector<const typename TSparseBlocksJacobians_dh_df::col_t*>   dh_df;
+	std::vector<size_t>  k2k_with_prior; // Indices (in dh_dAp) of the k2k unknowns with a prior
+
+	for (size_t i=0;i<my_visitor.k2k_edges_to_optimize.size();i++)
+	{
+		const typename TSparseBlocksJacobians_dh_dAp::col_t & col = rba_state.lin_system.dh_dAp.getCol( my_visitor.k2k_edges_to_optimize[i] );
+		const bool has_prior = rba_state.k2k_edge_priors.count(my_visitor.k2k_edges_to_optimize[i])!=0;
+		if (has_prior)
+			k2k_with_prior.push_back(dh_dAp.size());
+		if (!col.empty() || has_prior)
+			dh_dAp.push_back(&col);
+	}
+	for (size_t i=0;i<my_visitor.lm_IDs_to_optimize.size();i++)
+	{
+		const size_t col_idx = rba_state.lin_system.dh_df.findColByRemapIndex(my_visitor.lm_IDs_to_optimize[i]);  // O(1) with map_as_vector
+		if (col_idx == SRBA_INVALID_INDEX)
+			continue;
+		const typename TSparseBlocksJacobians_dh_df::col_t & col = rba_state.lin_system.dh_df.getCol( col_idx );
+		if (!col.empty())
+			dh_df.push_back(&col);
+	}
+
+	const size_t nUnknowns_k2k = dh_dAp.size();
+	const size_t nUnknowns_k2f = dh_df.size();
+	out.num_k2k_unknowns = nUnknowns_k2k;
+	out.num_lm_unknowns  = nUnknowns_k2f;
+	out.num_total_scalar_unknowns = POSE_DIMS*nUnknowns_k2k + LM_DIMS*nUnknowns_k2f;
+
+	// 3rd) Observations, Jacobian blocks and the k2k unknowns each observation depends on:
+	// --------------------------------------------------------------
+	std::map<size_t, std::vector<size_t> >  obs2k2k; // Observation index => indices (in dh_dAp) of the k2k unknowns in its path (in ascending order)
+	std::set<size_t>  all_obs;
+
+	for (size_t i=0;i<nUnknowns_k2k;i++)
+	{
+		for (typename TSparseBlocksJacobians_dh_dAp::col_t::const_iterator it=dh_dAp[i]->begin();it!=dh_dAp[i]->end();++it)
+		{
+			obs2k2k[it->first].push_back(i);
+			all_obs.insert(it->first);
+		}
+		out.num_jacobian_blocks += dh_dAp[i]->size();
+	}
+	for (size_t i=0;i<nUnknowns_k2f;i++)
+	{
+		for (typename TSparseBlocksJacobians_dh_df::col_t::const_iterator it=dh_df[i]->begin();it!=dh_df[i]->end();++it)
+			all_obs.insert(it->first);
+		out.num_jacobian_blocks += dh_df[i]->size();
+	}
+	out.num_observations = all_obs.size();
+
+	// 4th) Hessian blocks: HAp(i,j)!=0 iff both edges are in the path of some observation.
+	//      Hf is block diagonal, since each observation involves one landmark only.
+	// --------------------------------------------------------------
+	std::set<std::pair<size_t,size_t> >  HAp_blocks; // Upper triangle only: (i<=j)
+	for (std::map<size_t, std::vector<size_t> >::const_iterator it=obs2k2k.begin();it!=obs2k2k.end();++it)
+	{
+		const std::vector<size_t> &edges = it->second;
+		for (size_t a=0;a<edges.size();a++)
+			for (size_t b=a;b<edges.size();b++)
+				HAp_blocks.insert( std::make_pair(edges[a],edges[b]) );
+	}
+	// Priors only add to the diagonal blocks of their edges:
+	for (size_t i=0;i<k2k_with_prior.size();i++)
+		HAp_blocks.insert( std::make_pair(k2k_with_prior[i],k2k_with_prior[i]) );
+	out.num_hessian_blocks_Ap = HAp_blocks.size();
+	out.num_hessian_blocks_f  = nUnknowns_k2f;
+
+	// HApf, and the fill-in of the Schur complement (HAp - HApf * Hf^-1 * HApf^t):
+	std::set<std::pair<size_t,size_t> >  schur_blocks;
+	for (size_t i=0;i<nUnknowns_k2f;i++)
+	{
+		std::set<size_t> lm_edges;
+		for (typename TSparseBlocksJacobians_dh_df::col_t::const_iterator it=dh_df[i]->begin();it!=dh_df[i]->end();++it)
+		{
+			std::map<size_t, std::vector<size_t> >::const_iterator it_o = obs2k2k.find(it->first);
+			if (it_o!=obs2k2k.end())
+				lm_edges.insert(it_o->second.begin(),it_o->second.end());
+		}
+		out.num_hessian_blocks_Apf += lm_edges.size();
+
+		if (RBA_OPTIONS::solver_t::USE_SCHUR)
+		{
+			out.schur_block_products += 0.5*lm_edges.size()*(lm_edges.size()+1);
+			for (std::set<size_t>::const_iterator a=lm_edges.begin();a!=lm_edges.end();++a)
+				for (std::set<size_t>::const_iterator b=a;b!=lm_edges.end();++b)
+					schur_blocks.insert( std::make_pair(*a,*b) );
+		}
+	}
+
+	// 5th) The linear system solved in each iteration:
+	// --------------------------------------------------------------
+	size_t block_dims;
+	if (RBA_OPTIONS::solver_t::USE_SCHUR)
+	{
+		schur_blocks.insert(HAp_blocks.begin(),HAp_blocks.end());
+		out.reduced_system_dim = POSE_DIMS*nUnknowns_k2k;
+		out.reduced_system_nnz_blocks = schur_blocks.size();
+		block_dims = POSE_DIMS;
+	}
+	else
+	{
+		out.reduced_system_dim = out.num_total_scalar_unknowns;
+		out.reduced_system_nnz_blocks = out.num_hessian_blocks_Ap + out.num_hessian_blocks_f + out.num_hessian_blocks_Apf;
+		block_dims = std::max(POSE_DIMS,LM_DIMS);
+	}
+
+	if (RBA_OPTIONS::solver_t::DENSE_CHOLESKY)
+	{
+		const double n = static_cast<double>(out.reduced_system_dim);
+		out.factorization_flops = n*n*n/3.0;
+	}
+	else
+	{
+		out.factorization_flops = static_cast<double>(out.reduced_system_nnz_blocks)*block_dims*block_dims*block_dims;
+	}
+
+	out.estimated_time = parameters.cost_model.predict(out);
+
+	m_profiler.leave("estimate_local_area_cost");
+
+	VERBOSE_LEVEL(2) << "[estimate_local_area_cost] #k2k=" << nUnknowns_k2k << " #k2f=" << nUnknowns_k2f << " #obs=" << out.num_observations << " reduced_nnz_blocks=" << out.reduced_system_nnz_blocks << " est.time=" << out.estimated_time << " s\n";
+}
+
+} // end NS
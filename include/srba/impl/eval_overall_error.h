@@ -29,6 +29,7 @@ double RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::eval_overall_squ
 
 	for (typename rba_problem_state_t::all_observations_deque_t::const_iterator itO=rba_state.all_observations.begin();itO!=rba_state.all_observations.end();++itO)
 	{
+		if (itO->is_removed) continue;
 		const TKeyFrameID obs_id = itO->obs.kf_id;
 		const TKeyFrameID base_id = itO->feat_rel_pos->id_frame_base;
 
@@ -72,7 +73,7 @@ double RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::eval_overall_squ
 				//   root -> *it_want
 				//   *it_want -> root
 				all_rel_poses[root][*it_want] =  it_have->second;
-				all_rel_poses[*it_want][root] = pose_flag_t(-it_have->second.pose, it_have->second.updated);
+				all_rel_poses[*it_want][root] = pose_flag_t(-it_have->second.pose, it_have->second.generation);
 
 				++it_have;
 				++it_want;
@@ -83,9 +84,12 @@ double RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::eval_overall_squ
 	// ---------------------------------------------------------------------------
 	// Evaluate errors:
 	// ---------------------------------------------------------------------------
-	for (typename rba_problem_state_t::all_observations_deque_t::const_iterator itO=rba_state.all_observations.begin();itO!=rba_state.all_observations.end();++itO)
+	size_t obs_idx = 0;
+	array_obs_t z_real;
+	for (typename rba_problem_state_t::all_observations_deque_t::const_iterator itO=rba_state.all_observations.begin();itO!=rba_state.all_observations.end();++itO,++obs_idx)
 	{
 		// Actually measured pixel coords: observations[i]->obs.px
+		if (itO->is_removed) continue;
 
 		const TKeyFrameID obs_frame_id = itO->obs.kf_id;
 		const TKeyFrameID base_id = itO->feat_rel_pos->id_frame_base;
@@ -115,8 +119,8 @@ double RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::eval_overall_squ
 		typename options::internal::resulting_pose_t<typename RBA_OPTIONS::sensor_pose_on_robot_t,REL_POSE_DIMS>::pose_t base_pose_wrt_sensor(mrpt::poses::UNINITIALIZED_POSE);
 		RBA_OPTIONS::sensor_pose_on_robot_t::robot2sensor( *base_pose_wrt_observer, base_pose_wrt_sensor, this->parameters.sensor_pose );
 
-		// Stored observation:
-		const array_obs_t & z_real = itO->obs.obs_arr;
+		// Stored observation (it may be in cold storage, don't rehydrate it just for this):
+		rba_state.obs_data.get(obs_idx, z_real);
 
 		// Predict observation and compare to real obs:
 		residual_t delta;
@@ -131,6 +135,18 @@ double RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::eval_overall_squ
 		sqerr+= delta.squaredNorm();
 	}
 
+	// Prior factors on kf2kf edges:
+	if (!rba_state.k2k_edge_priors.empty())
+	{
+		std::vector<size_t> prior_edge_ids;
+		prior_edge_ids.reserve(rba_state.k2k_edge_priors.size());
+		for (typename rba_problem_state_t::k2k_edge_priors_t::const_iterator it=rba_state.k2k_edge_priors.begin();it!=rba_state.k2k_edge_priors.end();++it)
+			prior_edge_ids.push_back(it->first);
+
+		vector_k2k_prior_errors_t prior_errs;
+		sqerr+= k2k_priors_errors(prior_edge_ids, prior_errs);
+	}
+
 	m_profiler.leave("eval_overall_squared_error");
 
 	return sqerr;
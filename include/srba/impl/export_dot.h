@@ -69,7 +69,8 @@ bool RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::save_graph_as_dot(
 
 			for (typename rba_problem_state_t::all_observations_deque_t::const_iterator itO=rba_state.all_observations.begin();itO!=rba_state.all_observations.end();++itO)
 			{
-				f << itO->obs.kf_id << " -> L" << itO->obs.obs.feat_id << ";\n";
+				if (itO->is_removed) continue;
+				f << itO->obs.kf_id << " -> L" << itO->obs.feat_id << ";\n";
 			}
 			f << "\n";
 		}
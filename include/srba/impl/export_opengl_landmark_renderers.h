@@ -63,11 +63,7 @@ template <> struct LandmarkRendererBase<landmark_rendering_as_point>
 			{
 				lms_to_draw.push_back(itLM);
 
-				typename RBA::hessian_traits_t::landmarks2infmatrix_t::const_iterator it_inf = rba.get_rba_state().unknown_lms_inf_matrices.find(itLM->first);
-
-				if (it_inf != rba.get_rba_state().unknown_lms_inf_matrices.end())
-						lms_to_draw_inf_covs.push_back( &it_inf->second );
-				else	lms_to_draw_inf_covs.push_back(NULL);
+				lms_to_draw_inf_covs.push_back( rba.get_rba_state().unknown_lms_inf_matrices.find(itLM->first) );
 			}
 		}
 
@@ -177,6 +173,7 @@ template <> struct LandmarkRendererBase<landmark_rendering_as_pose_constraints>
 			for (size_t i=0;i<kfi.adjacent_k2f_edges.size();i++)
 			{
 				const typename RBA::k2f_edge_t * k2f = kfi.adjacent_k2f_edges[i];
+				if (k2f->is_removed) continue;
 				const TKeyFrameID other_kf_id = k2f->feat_rel_pos->id_frame_base;
 				if (kf_id==other_kf_id)
 					continue; // It's not an constraint with ANOTHER keyframe
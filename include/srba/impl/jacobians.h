@@ -124,44 +124,40 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::numeric_dh_dAp(con
 	typename options::internal::resulting_pose_t<typename RBA_OPTIONS::sensor_pose_on_robot_t,REL_POSE_DIMS>::pose_t base_pose_wrt_sensor(mrpt::poses::UNINITIALIZED_POSE);
 	RBA_OPTIONS::sensor_pose_on_robot_t::pose_robot2sensor( base_from_obs, base_pose_wrt_sensor, params.sensor_pose );
 
-	// Generate observation:
-	array_obs_t z_zero;
-	z_zero.setZero();
-
-	sensor_model_t::observe_error(y,z_zero,base_pose_wrt_sensor,params.xji_i, params.sensor_params);
-	y=-y; // because the method above evals: "z_zero - h(x)"
+	// Generate observation: "z - h(x)" (the real observation is needed by sensor models which depend on it, e.g. observations::MultiSensor)
+	sensor_model_t::observe_error(y,params.z_obs,base_pose_wrt_sensor,params.xji_i, params.sensor_params);
+	y=params.z_obs-y; // h(x)
 }
 
 #if DEBUG_NOT_UPDATED_ENTRIES
 
 struct TNumSTData
 {
+	TNumSTData() : from(SRBA_INVALID_KEYFRAMEID), to(SRBA_INVALID_KEYFRAMEID) {}
 	TKeyFrameID from, to;
 };
 
-TNumSTData check_num_st_entry_exists(
-	const pose_flag_t * entry,
-	const TRBA_Problem_state::TSpanningTree & st)
+template <class POSE_FLAG>
+struct TFindNumSTEntry
 {
-	for (TRelativePosesForEachTarget::const_iterator it_tree=st.num.begin();it_tree!=st.num.end();++it_tree)
-	{
-		const TKeyFrameID id_from = it_tree->first;
-		const frameid2pose_map_t & tree = it_tree->second;
+	TFindNumSTEntry(const POSE_FLAG *entry_) : entry(entry_) {}
+	const POSE_FLAG *entry;
+	TNumSTData       found;
 
-		for (frameid2pose_map_t::const_iterator it=tree.begin();it!=tree.end();++it)
-		{
-			const TKeyFrameID id_to = it->first;
-			const pose_flag_t & e = it->second;
-			if (&e == entry)
-			{
-				TNumSTData d;
-				d.from = id_from;
-				d.to = id_to;
-				return d;
-			}
-		}
+	void operator()(const TKeyFrameID from, const TKeyFrameID to, const POSE_FLAG &e) {
+		if (&e == entry) { found.from = from; found.to = to; }
 	}
-	ASSERT_(false)
+};
+
+template <class SPANNING_TREE, class POSE_FLAG>
+TNumSTData check_num_st_entry_exists(
+	const POSE_FLAG * entry,
+	const SPANNING_TREE & st)
+{
+	TFindNumSTEntry<POSE_FLAG> f(entry);
+	st.num.for_each_pose(f);
+	ASSERT_(f.found.from!=SRBA_INVALID_KEYFRAMEID)
+	return f.found;
 }
 
 #endif
@@ -178,14 +174,118 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::numeric_dh_df(cons
 	typename options::internal::resulting_pose_t<typename RBA_OPTIONS::sensor_pose_on_robot_t,REL_POSE_DIMS>::pose_t  base_pose_wrt_sensor(mrpt::poses::UNINITIALIZED_POSE);
 	RBA_OPTIONS::sensor_pose_on_robot_t::pose_robot2sensor( *pos_cam, base_pose_wrt_sensor, params.sensor_pose );
 
-	// Generate observation:
-	array_obs_t z_zero;
-	z_zero.setZero();
-	sensor_model_t::observe_error(y,z_zero,base_pose_wrt_sensor,x_local, params.sensor_params);
-	y=-y; // because the method above evals: "z_zero - h(x)"
+	// Generate observation: "z - h(x)" (the real observation is needed by sensor models which depend on it, e.g. observations::MultiSensor)
+	sensor_model_t::observe_error(y,params.z_obs,base_pose_wrt_sensor,x_local, params.sensor_params);
+	y=params.z_obs-y; // h(x)
 }
 
 
+/** Evaluates the sensor model Jacobian dh_dx at xji_l (in sensor coordinates). If the analytic one is ill-defined, falls back to a numeric
+  * approximation (if TSRBAParameters::numeric_jacobians_fallback is set and the sensor model allows it, see internal::sensor_allows_numeric_jacob_fallback),
+  * which is cached until the linearization point of that observation moves.
+  * The numeric Jacobian is rejected if h() isn't smooth around xji_l (e.g. angles wrapping around, or a singularity of the model right there):
+  * the one-sided differences must agree with each other, and central differences with steps eps and eps/2 too.
+  * \return false if no valid Jacobian could be evaluated */
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+bool RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::eval_jacob_dh_dx_or_numeric(
+	Eigen::Matrix<double,OBS_DIMS,LM_DIMS> & dh_dx,
+	const array_landmark_t & xji_l,
+	const size_t             obs_idx) const
+{
+	const bool allow_numeric = parameters.srba.numeric_jacobians_fallback && internal::sensor_allows_numeric_jacob_fallback<sensor_model_t>::value;
+
+	if (internal::sensor_jacob_dh_dx<sensor_model_t>::eval_at(dh_dx,xji_l, rba_state.obs_data,obs_idx, this->parameters.sensor))
+	{
+		forget_numeric_jacob(obs_idx); // Well-defined again: its numeric one, if any, is no longer needed (no lock if there's none)
+		return true;
+	}
+	if (!allow_numeric)
+		return false;
+
+	// The cache is shared among concurrent optimizations (see optimize_local_areas()), but each observation belongs to only one of them,
+	// so its flag k2f_edge_t::has_numeric_jacob can be read without locking:
+	const k2f_edge_t &k2f = rba_state.all_observations[obs_idx];
+	if (k2f.has_numeric_jacob)
+	{
+		bool cached = false;
+#if defined(_OPENMP)
+#	pragma omp critical (srba_numeric_jacob_cache)
+#endif
+		{
+			typename numeric_jacob_cache_t::const_iterator it = m_numeric_jacob_cache.find(obs_idx);
+			if (it!=m_numeric_jacob_cache.end() && it->second.xji_l==xji_l)
+			{
+				dh_dx = it->second.dh_dx;
+				cached = true;
+			}
+		}
+		if (cached)
+			return true;
+	}
+
+	// Finite differences of h() around xji_l, which is already relative to the sensor. The real observation is used
+	// since some sensor models depend on it (e.g. observations::MultiSensor); it cancels out in the differences:
+	static const double REL_TOL = 1e-3, ABS_TOL = 1e-6;
+	const typename options::internal::resulting_pose_t<typename RBA_OPTIONS::sensor_pose_on_robot_t,REL_POSE_DIMS>::pose_t  sensor_origin;
+	array_obs_t z_obs, minus_h0, minus_h[4];  // "z-h()" at: x+eps, x-eps, x+eps/2, x-eps/2
+	rba_state.obs_data.get(obs_idx, z_obs);
+	sensor_model_t::observe_error(minus_h0,z_obs,sensor_origin,xji_l, this->parameters.sensor);
+	bool valid = true;
+	for (size_t i=0;i<LM_DIMS && valid;i++)
+	{
+		const double eps = 1e-6 * std::max(1.0, std::abs(xji_l[i]));
+		const double steps[4] = { eps, -eps, 0.5*eps, -0.5*eps };
+		for (int k=0;k<4;k++)
+		{
+			array_landmark_t x1 = xji_l;
+			x1[i] += steps[k];
+			sensor_model_t::observe_error(minus_h[k],z_obs,sensor_origin,x1, this->parameters.sensor);
+		}
+		for (size_t r=0;r<OBS_DIMS && valid;r++)
+		{
+			const double d_fwd  = (minus_h0[r]-minus_h[0][r])/eps;
+			const double d_bwd  = (minus_h[1][r]-minus_h0[r])/eps;
+			const double d_cent = (minus_h[1][r]-minus_h[0][r])/(2*eps);
+			const double d_half = (minus_h[3][r]-minus_h[2][r])/eps;
+			valid =
+				(d_fwd-d_fwd==0) && (d_bwd-d_bwd==0) && (d_half-d_half==0) && // Finite (not NaN or Inf)
+				std::abs(d_fwd-d_bwd)   <= REL_TOL*(std::abs(d_fwd)+std::abs(d_bwd))   + ABS_TOL && // Not a kink
+				std::abs(d_cent-d_half) <= REL_TOL*(std::abs(d_cent)+std::abs(d_half)) + ABS_TOL;   // Not a jump (which scales as 1/eps)
+			dh_dx(r,i) = d_cent;
+		}
+	}
+
+#if defined(_OPENMP)
+#	pragma omp critical (srba_numeric_jacob_cache)
+#endif
+	{
+		if (valid)
+		{
+			TNumericJacobCacheEntry &e = m_numeric_jacob_cache[obs_idx];
+			e.xji_l = xji_l;
+			e.dh_dx = dh_dx;
+		}
+		else m_numeric_jacob_cache.erase(obs_idx);
+	}
+	k2f.has_numeric_jacob = valid;
+	return valid;
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::forget_numeric_jacob(const size_t obs_idx) const
+{
+	const k2f_edge_t &k2f = rba_state.all_observations[obs_idx];
+	if (!k2f.has_numeric_jacob)
+		return;
+#if defined(_OPENMP)
+#	pragma omp critical (srba_numeric_jacob_cache)
+#endif
+	{
+		m_numeric_jacob_cache.erase(obs_idx);
+	}
+	k2f.has_numeric_jacob = false;
+}
+
 /** Auxiliary sub-jacobian used in compute_jacobian_dh_dp() (it's a static method within specializations of this struct) */
 template <landmark_jacob_family_t JACOB_FAMILY, size_t POINT_DIMS, size_t POSE_DIMS, class RBA_ENGINE_T>
 struct compute_jacobian_dAepsDx_deps;
@@ -234,11 +334,11 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::compute_jacobian_d
 	TNumSTData d1 = check_num_st_entry_exists(&pose_base_wrt_d1, rba_state.spanning_tree);
 #endif
 
-	if (!pose_base_wrt_d1.updated)
+	if (!pose_base_wrt_d1.updated())
 	{
 		std::cerr << " kf_d+1: " << jacob.sym.kf_d << ", base_id: "<< jacob.sym.kf_base << std::endl;
 		rba_state.spanning_tree.save_as_dot_file("_debug_jacob_error_all_STs.dot");
-		ASSERT_(pose_base_wrt_d1.updated)
+		ASSERT_(pose_base_wrt_d1.updated())
 	}
 
 	if (pose_d1_wrt_obs)
@@ -246,12 +346,12 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::compute_jacobian_d
 #if DEBUG_NOT_UPDATED_ENTRIES
 		TNumSTData d2 = check_num_st_entry_exists(pose_d1_wrt_obs, rba_state.spanning_tree);
 #endif
-		if (!pose_d1_wrt_obs->updated)
+		if (!pose_d1_wrt_obs->updated())
 		{
 			std::cerr << " kf_d+1: " << jacob.sym.kf_d << ", obs_frame_id: "<< observation.obs.kf_id << std::endl;
 			rba_state.spanning_tree.save_as_dot_file("_debug_jacob_error_all_STs.dot");
 		}
-		ASSERT_(pose_d1_wrt_obs->updated)
+		ASSERT_(pose_d1_wrt_obs->updated())
 	}
 
 
@@ -296,7 +396,9 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::compute_jacobian_d
 	array_pose_t x_incrs;
 	x_incrs.setConstant(1e-4);
 
-	const TNumeric_dh_dAp_params num_params(jacob.sym.k2k_edge_id,&pose_d1_wrt_obs->pose, pose_base_wrt_d1.pose,jacob.sym.feat_rel_pos->pos, is_inverse_edge_jacobian,k2k_edges,this->parameters.sensor,this->parameters.sensor_pose);
+	array_obs_t z_obs;
+	rba_state.obs_data.get(jacob.sym.obs_idx, z_obs);
+	const TNumeric_dh_dAp_params num_params(jacob.sym.k2k_edge_id,&pose_d1_wrt_obs->pose, pose_base_wrt_d1.pose,jacob.sym.feat_rel_pos->pos, is_inverse_edge_jacobian,k2k_edges,this->parameters.sensor,this->parameters.sensor_pose,z_obs);
 
 	mrpt::math::jacobians::jacob_numeric_estimate(x,&numeric_dh_dAp,x_incrs,num_params,num_jacob);
 
@@ -317,8 +419,8 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::compute_jacobian_d
 	// Converts a point relative to the robot coordinate frame (P) into a point relative to the sensor (RES = P \ominus POSE_IN_ROBOT )
 	RBA_OPTIONS::sensor_pose_on_robot_t::template point_robot2sensor<landmark_t,array_landmark_t>(xji_l,xji_l,this->parameters.sensor_pose );
 
-	// Invoke sensor model:
-	if (!sensor_model_t::eval_jacob_dh_dx(dh_dx,xji_l, this->parameters.sensor))
+	// Invoke sensor model (or its numeric approximation if the analytic Jacobian is ill-defined here):
+	if (!eval_jacob_dh_dx_or_numeric(dh_dx,xji_l, jacob.sym.obs_idx))
 	{
 		// Invalid Jacobian:
 		*jacob.sym.is_valid = 0;
@@ -906,13 +1008,13 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::compute_jacobian_d
 #if DEBUG_NOT_UPDATED_ENTRIES
 		TNumSTData d1 = check_num_st_entry_exists(rel_pose_base_from_obs, rba_state.spanning_tree);
 #endif
-		if (!rel_pose_base_from_obs->updated)
+		if (!rel_pose_base_from_obs->updated())
 		{
 #if DEBUG_NOT_UPDATED_ENTRIES
 			cout << "not updated ST entry for: from=" << d1.from << ", to=" << d1.to << endl;
 #endif
 			rba_state.spanning_tree.save_as_dot_file("_debug_jacob_error_all_STs.dot");
-			ASSERT_(rel_pose_base_from_obs->updated)
+			ASSERT_(rel_pose_base_from_obs->updated())
 		}
 	}
 
@@ -925,7 +1027,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::compute_jacobian_d
 	if (rel_pose_base_from_obs!=NULL)
 	{
 #if 0
-		cout << "dh_df(ft_id="<< observation.obs.obs.feat_id << ", obs_kf="<< observation.obs.kf_id << "): o2b=" << *rel_pose_base_from_obs << endl;
+		cout << "dh_df(ft_id="<< observation.obs.feat_id << ", obs_kf="<< observation.obs.kf_id << "): o2b=" << *rel_pose_base_from_obs << endl;
 #endif
 		// xji_l = rel_pose_base_from_obs (+) xji_i
 		//rel_pose_base_from_obs->pose.composePoint(xji_i, xji_l);
@@ -946,7 +1048,9 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::compute_jacobian_d
 	array_landmark_t x_incrs;
 	x_incrs.setConstant(1e-3);
 
-	const TNumeric_dh_df_params num_params(&rel_pose_base_from_obs->pose,jacob.sym.feat_rel_pos->pos,this->parameters.sensor,this->parameters.sensor_pose);
+	array_obs_t z_obs;
+	rba_state.obs_data.get(jacob.sym.obs_idx, z_obs);
+	const TNumeric_dh_df_params num_params(&rel_pose_base_from_obs->pose,jacob.sym.feat_rel_pos->pos,this->parameters.sensor,this->parameters.sensor_pose,z_obs);
 
 	mrpt::math::jacobians::jacob_numeric_estimate(x,&numeric_dh_df,x_incrs,num_params,num_jacob);
 
@@ -967,8 +1071,8 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::compute_jacobian_d
 	// Converts a point relative to the robot coordinate frame (P) into a point relative to the sensor (RES = P \ominus POSE_IN_ROBOT )
 	RBA_OPTIONS::sensor_pose_on_robot_t::template point_robot2sensor<landmark_t,array_landmark_t>(xji_l,xji_l,this->parameters.sensor_pose );
 
-	// Invoke sensor model:
-	if (!sensor_model_t::eval_jacob_dh_dx(dh_dx,xji_l, this->parameters.sensor))
+	// Invoke sensor model (or its numeric approximation if the analytic Jacobian is ill-defined here):
+	if (!eval_jacob_dh_dx_or_numeric(dh_dx,xji_l, jacob.sym.obs_idx))
 	{
 		// Invalid Jacobian:
 		*jacob.sym.is_valid = 0;
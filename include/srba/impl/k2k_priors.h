@@ -0,0 +1,138 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+namespace srba {
+
+// Prior factors on kf2kf edges. The error of a prior is e = pseudo_log( inv_pose (+) (-)prior ). Since the optimizer
+// updates edges as inv_pose <- exp(incr) (+) inv_pose, the Jacobian de/d(incr) is approximated by the identity,
+// which is exact for zero error. Hence each prior simply adds its information matrix to the diagonal block of its
+// edge in HAp, and -inf_matrix*e to the minus gradient.
+// The total squared error of the optimizer has unweighted observation residuals, while observation terms in H and the
+// gradient are weighted by the noise model (scale_H()/scale_Jtr()). So that the optimum is that of the weighted problem,
+// the squared errors of priors are scaled by obs_noise_matrix_t::other_factors_sqr_error_scale() (sigma^2 for
+// observation_noise_identity), and their H and gradient terms, by the same factor and then the noise model scaling.
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+double RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::k2k_priors_errors(
+	const std::vector<size_t> &k2k_edge_ids,
+	vector_k2k_prior_errors_t &out_errs) const
+{
+	const size_t nEdges = k2k_edge_ids.size();
+	out_errs.resize(nEdges);
+	double total_sqr_err = 0;
+	const double scale = RBA_OPTIONS::obs_noise_matrix_t::other_factors_sqr_error_scale(this->parameters.obs_noise);
+	for (size_t i=0;i<nEdges;i++)
+	{
+		array_pose_t &e = out_errs[i];
+		e.setZero();
+		if (rba_state.k2k_edge_priors.empty()) continue;
+
+		typename rba_problem_state_t::k2k_edge_priors_t::const_iterator it = rba_state.k2k_edge_priors.find(k2k_edge_ids[i]);
+		if (it==rba_state.k2k_edge_priors.end()) continue;
+
+		pose_t inv_prior = it->second.inv_pose;
+		inv_prior.inverse();
+		pose_t d(mrpt::poses::UNINITIALIZED_POSE);
+		d.composeFrom(rba_state.k2k_edges[k2k_edge_ids[i]].inv_pose, inv_prior);
+		se_traits_t::pseudo_log(d, e);
+
+		total_sqr_err += scale * e.dot(it->second.inf_matrix*e);
+	}
+	return total_sqr_err;
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::k2k_priors_add_to_hessian(
+	const std::vector<size_t> &k2k_edge_ids,
+	typename hessian_traits_t::TSparseBlocksHessian_Ap &HAp) const
+{
+	if (rba_state.k2k_edge_priors.empty()) return;
+	const double scale = RBA_OPTIONS::obs_noise_matrix_t::other_factors_sqr_error_scale(this->parameters.obs_noise);
+
+	for (size_t i=0;i<k2k_edge_ids.size();i++)
+	{
+		typename rba_problem_state_t::k2k_edge_priors_t::const_iterator it = rba_state.k2k_edge_priors.find(k2k_edge_ids[i]);
+		if (it==rba_state.k2k_edge_priors.end()) continue;
+
+		Eigen::Matrix<double,REL_POSE_DIMS,REL_POSE_DIMS> H = scale * it->second.inf_matrix;
+		RBA_OPTIONS::obs_noise_matrix_t::template scale_H(H, this->parameters.obs_noise);
+
+		// The diagonal block always exists, even for edges without observations (see sparse_hessian_build_symbolic()):
+		typename hessian_traits_t::TSparseBlocksHessian_Ap::col_t & col = HAp.getCol(i);
+		ASSERTDEB_(col.find(i)!=col.end())
+		col[i].num += H;
+	}
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::k2k_priors_add_to_minus_gradient(
+	const std::vector<size_t> &k2k_edge_ids,
+	const vector_k2k_prior_errors_t &errs,
+	Eigen::VectorXd &minus_grad) const
+{
+	if (rba_state.k2k_edge_priors.empty()) return;
+	ASSERTDEB_(errs.size()==k2k_edge_ids.size())
+	const double scale = RBA_OPTIONS::obs_noise_matrix_t::other_factors_sqr_error_scale(this->parameters.obs_noise);
+
+	for (size_t i=0;i<k2k_edge_ids.size();i++)
+	{
+		typename rba_problem_state_t::k2k_edge_priors_t::const_iterator it = rba_state.k2k_edge_priors.find(k2k_edge_ids[i]);
+		if (it==rba_state.k2k_edge_priors.end()) continue;
+
+		Eigen::Matrix<double,REL_POSE_DIMS,1> g = scale * (it->second.inf_matrix*errs[i]);
+		RBA_OPTIONS::obs_noise_matrix_t::template scale_Jtr(g, this->parameters.obs_noise);
+		minus_grad.block<REL_POSE_DIMS,1>(i*REL_POSE_DIMS,0) -= g;
+	}
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::k2k_priors_attach(
+	const TKeyFrameID new_kf_id,
+	const k2k_priors_t &priors,
+	const typename traits_t::new_kf_observations_t &obs,
+	std::vector<TNewEdgeInfo> &new_k2k_edge_ids)
+{
+	for (size_t i=0;i<priors.size();i++)
+	{
+		const k2k_prior_t &prior = priors[i];
+		ASSERTMSG_(prior.kf_id<new_kf_id, mrpt::format("A prior refers to KF #%u, which is not older than the new KF #%u",static_cast<unsigned int>(prior.kf_id),static_cast<unsigned int>(new_kf_id)))
+
+		size_t ed_id = rba_state.find_kf2kf_edge(prior.kf_id,new_kf_id);
+		if (ed_id==SRBA_INVALID_INDEX)
+		{
+			// Not created by the ECP: create it now, with the prior as initial value:
+			ed_id = create_kf2kf_edge(new_kf_id, TPairKeyFrameID(prior.kf_id,new_kf_id), obs, prior.inv_pose);
+
+			TNewEdgeInfo nei;
+			nei.id = ed_id;
+			nei.has_approx_init_val = true;
+			new_k2k_edge_ids.push_back(nei);
+		}
+		else
+		{
+			k2k_edge_t &ed = rba_state.k2k_edges[ed_id];
+			ASSERTMSG_(ed.from==prior.kf_id && ed.to==new_kf_id, "The edge creation policy created an edge from the new KF: priors are only supported for edges towards the new KF")
+
+			// A better starting point for the stage-1 optimization than the ECP default value:
+			for (size_t k=0;k<new_k2k_edge_ids.size();k++)
+				if (new_k2k_edge_ids[k].id==ed_id && !new_k2k_edge_ids[k].has_approx_init_val)
+				{
+					ed.inv_pose = prior.inv_pose;
+					rba_state.spanning_tree.mark_edge_modified(ed_id);
+				}
+		}
+
+		ASSERTMSG_(rba_state.k2k_edge_priors.find(ed_id)==rba_state.k2k_edge_priors.end(), mrpt::format("Several priors between KFs #%u and #%u",static_cast<unsigned int>(prior.kf_id),static_cast<unsigned int>(new_kf_id)))
+		rba_state.k2k_edge_priors[ed_id] = prior;
+	}
+}
+
+} // end NS
@@ -0,0 +1,197 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mrpt/math/jacobians.h>
+#include <Eigen/Eigenvalues>
+
+namespace srba {
+
+namespace internal
+{
+	/** Dispatches the geometric admission tests of landmarks (see RbaEngine::filter_landmarks_by_geometry()), which only apply to
+	  * real (point) landmarks, not to the "fake landmarks" of relative graph-SLAM problems. */
+	template <landmark_jacob_family_t LM_JACOB_FAMILY>
+	struct landmark_geometric_tests;
+
+	// Specialization for "normal SLAM" (SLAM with real landmarks)
+	template <> struct landmark_geometric_tests<jacob_point_landmark> {
+		template <class RBAENGINE,class PARAMS>
+		static bool eval(const RBAENGINE &rba, const TLandmarkID lm_ID, const PARAMS &params) {
+			return rba.landmark_passes_geometric_tests(lm_ID, params);
+		}
+	};
+
+	// Specialization for relative graph-SLAM (no real landmarks)
+	template <> struct landmark_geometric_tests<jacob_relpose_landmark> {
+		template <class RBAENGINE,class PARAMS>
+		static bool eval(const RBAENGINE &rba, const TLandmarkID lm_ID, const PARAMS &params) {
+			MRPT_UNUSED_PARAM(rba); MRPT_UNUSED_PARAM(lm_ID); MRPT_UNUSED_PARAM(params);
+			return true;
+		}
+	};
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::filter_landmarks_by_geometry(
+	std::vector<size_t> & lm_IDs,
+	const TOptimizeLocalAreaParams &params) const
+{
+	if (params.min_landmark_parallax_deg<=0 && params.min_landmark_baseline_depth_ratio<=0 && params.max_landmark_hf_condition_number<=0)
+		return 0;
+
+	m_profiler.enter("filter_landmarks_by_geometry");
+
+	// Rejected landmarks are tested again, with their new observations, by the next local areas including them
+	// (the triangulation of each landmark is cached, see landmark_passes_geometric_tests()).
+	size_t nKept = 0;
+	for (size_t i=0;i<lm_IDs.size();i++)
+		if (internal::landmark_geometric_tests<landmark_t::jacob_family>::eval(*this, lm_IDs[i], params))
+			lm_IDs[nKept++] = lm_IDs[i];
+
+	const size_t nRejected = lm_IDs.size()-nKept;
+	lm_IDs.resize(nKept);
+
+	m_profiler.leave("filter_landmarks_by_geometry");
+
+	VERBOSE_LEVEL(2) << "[filter_landmarks_by_geometry] " << nRejected << " landmarks rejected, " << nKept << " admitted.\n";
+	return nRejected;
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+bool RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::landmark_passes_geometric_tests(
+	const TLandmarkID lm_ID,
+	const TOptimizeLocalAreaParams &params) const
+{
+	const typename rba_problem_state_t::TLandmarkEntry &lm_e = rba_state.all_lms[lm_ID];
+	if (lm_e.has_known_pos || !lm_e.rfp)
+		return true;
+
+	const TKeyFrameID base_id = lm_e.rfp->id_frame_base;
+	const bool check_triangulation = params.min_landmark_parallax_deg>0 || params.min_landmark_baseline_depth_ratio>0;
+	const bool check_hf = params.max_landmark_hf_condition_number>0;
+
+	// Triangulation is cached per landmark, and only the pairs with observations new since the last test are evaluated.
+	// Observations are appended to the list in order of observing KF, so the last one tells whether there's any:
+	typename landmark_traits<landmark_t>::TTriangulationCache &tc = lm_e.triangulation;
+	const bool update_triangulation = check_triangulation && lm_e.last_obs_idx!=SRBA_INVALID_INDEX &&
+		(tc.last_kf_id==SRBA_INVALID_KEYFRAMEID || rba_state.all_observations[lm_e.last_obs_idx].obs.kf_id>tc.last_kf_id);
+
+	mrpt::math::TPoint3D lm_pt;
+	landmark_t::relativeEuclideanLocation(lm_e.rfp->pos, lm_pt);
+	const Eigen::Vector3d X(lm_pt.x,lm_pt.y,lm_pt.z);  // wrt the base KF
+
+	std::vector<Eigen::Vector3d>  centers;     // Of the observing KFs, wrt the base KF: those already accounted for in the cache...
+	std::vector<Eigen::Vector3d>  new_centers; // ... and the new ones
+	Eigen::Matrix<double,LM_DIMS,LM_DIMS> Hf;
+	Hf.setZero();
+
+	if (update_triangulation || check_hf) // Otherwise, the cache is up to date and there's nothing else to evaluate
+	{
+		for (size_t i=lm_e.first_obs_idx;i!=SRBA_INVALID_INDEX;i=rba_state.all_observations[i].next_obs_same_lm)
+		{
+			const k2f_edge_t &k2f = rba_state.all_observations[i];
+			if (k2f.is_removed)
+				continue;
+			const TKeyFrameID obs_id = k2f.obs.kf_id;
+
+			// The pose of the base KF as seen from the observing one, from the current values of the edges in between
+			//  (the numeric spanning trees may be outdated out of optimize_edges()):
+			pose_t base_wrt_obs;
+			if (obs_id!=base_id)
+			{
+				const TKeyFrameID i_max = std::max(obs_id,base_id), i_min = std::min(obs_id,base_id);
+				typename rba_problem_state_t::TSpanningTree::all_edges_maps_t::const_iterator it_map = rba_state.spanning_tree.sym.all_edges.find(i_max);
+				if (it_map==rba_state.spanning_tree.sym.all_edges.end())
+					continue;
+				typename std::map<TKeyFrameID, typename rba_problem_state_t::k2k_edge_vector_t>::const_iterator it_path = it_map->second.find(i_min);
+				if (it_path==it_map->second.end())
+					continue; // Too far away to be considered
+
+				pose_t min_wrt_max;
+				internal::compose_spanning_tree_path(i_max,it_path->second, min_wrt_max);
+				base_wrt_obs = (obs_id>base_id) ? min_wrt_max : -min_wrt_max;
+			}
+
+			if (update_triangulation)
+			{
+				const mrpt::poses::CPose3D obs_wrt_base(-base_wrt_obs);
+				const bool is_new = (tc.last_kf_id==SRBA_INVALID_KEYFRAMEID || obs_id>tc.last_kf_id);
+				(is_new ? new_centers : centers).push_back(Eigen::Vector3d(obs_wrt_base.x(),obs_wrt_base.y(),obs_wrt_base.z()));
+			}
+
+			if (check_hf)
+			{
+				// Numeric Jacobian of this observation wrt the landmark, at its current estimate:
+				array_obs_t z_obs;
+				rba_state.obs_data.get(i, z_obs);
+				const TNumeric_dh_df_params num_params(&base_wrt_obs,lm_e.rfp->pos,this->parameters.sensor,this->parameters.sensor_pose,z_obs);
+
+				array_landmark_t x;
+				x.setZero(); // Evaluate Jacobian at incr around origin
+				array_landmark_t x_incrs;
+				x_incrs.setConstant(1e-3);
+
+				typename TSparseBlocksJacobians_dh_df::matrix_t  J;
+				mrpt::math::jacobians::jacob_numeric_estimate(x,&numeric_dh_df,x_incrs,num_params,J);
+				if (!J.allFinite())
+					continue;
+
+				Hf.noalias() += J.transpose()*J;
+			}
+		}
+	}
+
+	// Triangulation: the largest angle between the rays from two observing KFs, and the largest distance between them.
+	// Each new center is paired with all the others, so this is O(C) per new observation instead of O(C^2) per test:
+	if (update_triangulation)
+	{
+		for (size_t b=0;b<new_centers.size();b++)
+		{
+			const Eigen::Vector3d ray_b = X-new_centers[b];
+			const double norm_b = ray_b.norm();
+			for (size_t a=0;a<centers.size();a++)
+			{
+				const Eigen::Vector3d ray_a = X-centers[a];
+				const double norms = ray_a.norm()*norm_b;
+				tc.max_baseline = std::max(tc.max_baseline, (centers[a]-new_centers[b]).norm());
+				tc.min_cos_parallax = std::min(tc.min_cos_parallax, norms>0 ? ray_a.dot(ray_b)/norms : -1.0);
+			}
+			centers.push_back(new_centers[b]);
+		}
+		tc.num_centers += new_centers.size();
+		tc.last_kf_id = rba_state.all_observations[lm_e.last_obs_idx].obs.kf_id;
+	}
+
+	if (check_triangulation)
+	{
+		if (tc.num_centers<2)
+			return false; // Not triangulated at all: seen from a single KF
+
+		if (params.min_landmark_parallax_deg>0 && tc.min_cos_parallax > std::cos(mrpt::utils::DEG2RAD(params.min_landmark_parallax_deg)))
+			return false;
+		if (params.min_landmark_baseline_depth_ratio>0 && tc.max_baseline < params.min_landmark_baseline_depth_ratio * X.norm())
+			return false;
+	}
+
+	// Conditioning of the landmark Hessian block (singular if no observation has a valid Jacobian):
+	if (check_hf)
+	{
+		const Eigen::SelfAdjointEigenSolver<Eigen::Matrix<double,LM_DIMS,LM_DIMS> > es(Hf, Eigen::EigenvaluesOnly);
+		const double ev_min = es.eigenvalues().minCoeff();
+		const double ev_max = es.eigenvalues().maxCoeff();
+		if (ev_min<=0 || ev_max > params.max_landmark_hf_condition_number*ev_min)
+			return false;
+	}
+
+	return true;
+}
+
+} // end NS
@@ -590,6 +590,235 @@ namespace internal
 		}
 	};
 
+	// ------------------------------------------------------------------------------------------
+	/** Helper for solver_engine_backend: marginal covariances, only for backends which support them */
+	template <bool HAS_MARGINAL_COVARIANCE>
+	struct backend_marginals
+	{
+		template <class BACKEND>
+		static void get(BACKEND &backend, const size_t nBlocks, const size_t BLOCK_DIMS, std::vector<Eigen::MatrixXd> &out_covs)
+		{
+			out_covs.resize(nBlocks);
+			for (size_t i=0;i<nBlocks;i++)
+				backend.marginal_covariance(i*BLOCK_DIMS,BLOCK_DIMS, out_covs[i]);
+		}
+	};
+	template <>
+	struct backend_marginals<false>
+	{
+		template <class BACKEND>
+		static void get(BACKEND &, const size_t, const size_t, std::vector<Eigen::MatrixXd> &out_covs)
+		{
+			out_covs.clear();
+		}
+	};
+
+	// ------------------------------------------------------------------------------------------
+	/** SOLVER: Lev-Marq with or without Schur, with an external sparse linear solver backend (see srba::linear_solvers) */
+	template <bool USE_SCHUR, class BACKEND, class RBA_ENGINE>
+	struct solver_engine_backend
+	{
+		typedef typename RBA_ENGINE::hessian_traits_t hessian_traits_t;
+		typedef typename BACKEND::sparse_matrix_t     sparse_matrix_t;
+
+		static const size_t POSE_DIMS = RBA_ENGINE::kf2kf_pose_t::REL_POSE_DIMS;
+		static const size_t LM_DIMS   = RBA_ENGINE::landmark_t::LM_DIMS;
+
+		typedef SchurComplement<
+			typename hessian_traits_t::TSparseBlocksHessian_Ap,
+			typename hessian_traits_t::TSparseBlocksHessian_f,
+			typename hessian_traits_t::TSparseBlocksHessian_Apf
+			> schur_t;
+
+		const int m_verbose_level;
+		mrpt::utils::CTimeLogger &m_profiler;
+		const size_t nUnknowns_k2k, nUnknowns_k2f, idx_start_f;
+		const size_t nSystemDims; //!< Size of the system passed to the backend: the reduced one if USE_SCHUR
+		Eigen::VectorXd  delta_eps; //!< The result of solving Ax=b will be stored here
+		typename hessian_traits_t::TSparseBlocksHessian_Ap  &HAp;
+		typename hessian_traits_t::TSparseBlocksHessian_f   &Hf;
+		typename hessian_traits_t::TSparseBlocksHessian_Apf &HApf;
+		Eigen::VectorXd  &minus_grad;
+
+		schur_t *        schur_compl; //!< Only if USE_SCHUR
+		BACKEND          backend;
+		bool             analyzed;      //!< Whether the sparsity pattern was already passed to backend.analyze()
+		sparse_matrix_t  sA;            //!< The last system matrix (upper triangle)
+		bool             sA_is_valid;   //!< Whether the last system was correctly factorized
+		std::vector<Eigen::Triplet<double> >  triplets;  // Here to avoid reallocating memory in each iteration
+
+		/** Constructor */
+		solver_engine_backend(
+			const int verbose_level,
+			mrpt::utils::CTimeLogger & profiler,
+			typename hessian_traits_t::TSparseBlocksHessian_Ap  &HAp_,
+			typename hessian_traits_t::TSparseBlocksHessian_f   &Hf_,
+			typename hessian_traits_t::TSparseBlocksHessian_Apf &HApf_,
+			Eigen::VectorXd  &minus_grad_,
+			const size_t nUnknowns_k2k_,
+			const size_t nUnknowns_k2f_) :
+				m_verbose_level(verbose_level),
+				m_profiler(profiler),
+				nUnknowns_k2k(nUnknowns_k2k_),
+				nUnknowns_k2f(nUnknowns_k2f_),
+				idx_start_f(POSE_DIMS*nUnknowns_k2k_),
+				nSystemDims( USE_SCHUR ? POSE_DIMS*nUnknowns_k2k_ : POSE_DIMS*nUnknowns_k2k_ + LM_DIMS*nUnknowns_k2f_ ),
+				HAp(HAp_),Hf(Hf_),HApf(HApf_),
+				minus_grad(minus_grad_),
+				schur_compl(NULL),
+				analyzed(false),
+				sA_is_valid(false)
+		{
+			if (USE_SCHUR)
+				schur_compl = new schur_t(
+					HAp_,Hf_,HApf_, // The different symbolic/numeric Hessians
+					&minus_grad[0],  // minus gradient of the Ap part
+					// Handle case of no unknown features:
+					nUnknowns_k2f!=0 ? &minus_grad[POSE_DIMS*nUnknowns_k2k] : NULL   // minus gradient of the features part
+					);
+		}
+
+		~solver_engine_backend()
+		{
+			delete schur_compl;
+		}
+
+		/** Adds the upper triangle of a block-symmetric Hessian (plus lambda*I) to "triplets" */
+		template <class HESSIAN>
+		void add_symmetric_blocks(const HESSIAN &H, const size_t nCols, const size_t BLOCK_DIMS, const size_t idx_start, const double lambda)
+		{
+			for (size_t i=0;i<nCols;i++)
+			{	// Only upper-half triangle:
+				const typename HESSIAN::col_t & col_i = H.getCol(i);
+				for (typename HESSIAN::col_t::const_iterator itRowEntry = col_i.begin();itRowEntry != col_i.end(); ++itRowEntry )
+				{
+					const size_t row0 = idx_start+BLOCK_DIMS*itRowEntry->first, col0 = idx_start+BLOCK_DIMS*i;
+					const bool is_diag = (itRowEntry->first==i);
+					for (size_t c=0;c<BLOCK_DIMS;c++)
+						for (size_t r=0;r<(is_diag ? c+1 : BLOCK_DIMS);r++)
+							triplets.push_back( Eigen::Triplet<double>(row0+r,col0+c, itRowEntry->second.num(r,c) + ((is_diag && r==c) ? lambda : 0.0)) );
+				}
+			}
+		}
+
+		// ----------------------------------------------------------------------
+		// Solve the H*Ax = -g system, with the Schur complement (if enabled) and the backend.
+		// Return: true on success. false to retry with a different lambda (Lev-Marq algorithm is assumed)
+		// ----------------------------------------------------------------------
+		bool solve(const double lambda)
+		{
+			if (USE_SCHUR)
+			{
+				DETAILED_PROFILING_ENTER("opt.schur_build_reduced")
+				schur_compl->numeric_build_reduced_system(lambda);
+				DETAILED_PROFILING_LEAVE("opt.schur_build_reduced")
+
+				if (schur_compl->getNumFeaturesFullRank()!=schur_compl->getNumFeatures())
+				{
+					VERBOSE_LEVEL_COLOR(1,mrpt::system::CONCOL_RED) << "[OPT] Schur warning: only " << schur_compl->getNumFeaturesFullRank() << " out of " << schur_compl->getNumFeatures() << " features have full-rank.\n";
+					VERBOSE_LEVEL_COLOR_POST();
+				}
+			}
+
+			DETAILED_PROFILING_ENTER("opt.SparseTripletFill")
+			triplets.clear();
+			add_symmetric_blocks(HAp, nUnknowns_k2k, POSE_DIMS, 0, lambda);
+			if (!USE_SCHUR)
+			{
+				// HApf (stored by rows) --------------------------------------
+				for (size_t i=0;i<nUnknowns_k2k;i++)
+				{
+					const typename hessian_traits_t::TSparseBlocksHessian_Apf::col_t & row_i = HApf.getCol(i);
+					for (typename hessian_traits_t::TSparseBlocksHessian_Apf::col_t::const_iterator itColEntry = row_i.begin();itColEntry != row_i.end(); ++itColEntry )
+						for (size_t c=0;c<LM_DIMS;c++)
+							for (size_t r=0;r<POSE_DIMS;r++)
+								triplets.push_back( Eigen::Triplet<double>(POSE_DIMS*i+r, idx_start_f+LM_DIMS*itColEntry->first+c, itColEntry->second.num(r,c)) );
+				}
+				add_symmetric_blocks(Hf, nUnknowns_k2f, LM_DIMS, idx_start_f, lambda);
+			}
+			sA.resize(nSystemDims,nSystemDims);
+			sA.setFromTriplets(triplets.begin(),triplets.end());
+			DETAILED_PROFILING_LEAVE("opt.SparseTripletFill")
+
+			// The sparsity pattern doesn't change between iterations:
+			if (!analyzed)
+			{
+				DETAILED_PROFILING_ENTER("opt.backend_analyze")
+				backend.analyze(sA);
+				analyzed = true;
+				DETAILED_PROFILING_LEAVE("opt.backend_analyze")
+			}
+
+			DETAILED_PROFILING_ENTER("opt.backend_factorize")
+			sA_is_valid = backend.factorize(sA);
+			DETAILED_PROFILING_LEAVE("opt.backend_factorize")
+			if (!sA_is_valid)
+				return false; // not positive definite so increase lambda and try again
+
+			// backsubtitution gives us "DeltaEps" from Cholesky and "-grad":
+			//
+			//    (J^tJ + lambda*I) DeltaEps = -grad
+			// ----------------------------------------------------------------
+			DETAILED_PROFILING_ENTER("opt.backsub")
+			if (USE_SCHUR)
+			{
+				Eigen::VectorXd delta_Ap;
+				backend.solve(minus_grad.head(nSystemDims), delta_Ap);
+				delta_eps.setZero(POSE_DIMS*nUnknowns_k2k + LM_DIMS*nUnknowns_k2f);
+				delta_eps.head(nSystemDims) = delta_Ap;
+			}
+			else
+			{
+				backend.solve(minus_grad, delta_eps);
+			}
+			DETAILED_PROFILING_LEAVE("opt.backsub")
+
+			if (USE_SCHUR)
+			{
+				// 2nd numeric part: Solve for increments in features ----------
+				DETAILED_PROFILING_ENTER("opt.schur_features")
+				schur_compl->numeric_solve_for_features(
+					&delta_eps[0],
+					// Handle case of no unknown features:
+					nUnknowns_k2f!=0 ? &delta_eps[nUnknowns_k2k*POSE_DIMS] : NULL   // minus gradient of the features part
+					);
+				DETAILED_PROFILING_LEAVE("opt.schur_features")
+			}
+			return true;
+		} // end solve()
+
+		void realize_relinearized()
+		{
+			if (USE_SCHUR)
+			{
+				DETAILED_PROFILING_ENTER("opt.schur_realize_HAp_changed")
+				// Update the starting value of HAp for Schur:
+				schur_compl->realize_HAp_changed();
+				DETAILED_PROFILING_LEAVE("opt.schur_realize_HAp_changed")
+			}
+		}
+		void realize_lambda_changed()
+		{
+			// Nothing to do.
+		}
+		bool was_ith_feature_invertible(const size_t i)
+		{
+			return USE_SCHUR ? schur_compl->was_ith_feature_invertible(i) : true;
+		}
+		/** Here, out_info is of type srba::options::solver_LM_backend<>::extra_results_t */
+		void get_extra_results(typename RBA_ENGINE::rba_options_t::solver_t::extra_results_t & out_info )
+		{
+			out_info.hessian_valid = sA_is_valid;
+			out_info.hessian.swap(sA);
+			if (RBA_ENGINE::rba_options_t::solver_t::K2K_MARGINALS && sA_is_valid)
+			{
+				DETAILED_PROFILING_ENTER("opt.backend_marginals")
+				backend_marginals<BACKEND::HAS_MARGINAL_COVARIANCE>::get(backend, nUnknowns_k2k, POSE_DIMS, out_info.k2k_marginal_covs);
+				DETAILED_PROFILING_LEAVE("opt.backend_marginals")
+			}
+		}
+	};
+
 } // end namespace "internal"
 
 } // End of namespaces
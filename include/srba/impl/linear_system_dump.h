@@ -0,0 +1,198 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mrpt/utils/CFileGZOutputStream.h>
+
+namespace srba {
+namespace internal {
+
+	/** Binary (de)serialization of the linear systems saved by optimize_edges(), shared by RbaEngine (writer) and TLinearSystemDump (reader).
+	  * All sizes and indices are stored as uint64_t, and matrices as row-major sequences of doubles.
+	  * \sa TSRBAParameters::dump_linear_systems_prefix */
+	struct linear_system_dump_io
+	{
+		static const uint32_t DUMP_VERSION = 1;
+		static const char * magic() { return "SRBA_LINEAR_SYSTEM"; }
+
+		static void write_header(mrpt::utils::CStream &out, const uint32_t pose_dims, const uint32_t lm_dims, const uint32_t obs_dims)
+		{
+			out << std::string(magic()) << DUMP_VERSION << pose_dims << lm_dims << obs_dims;
+		}
+		/** Throws if the stream is not a linear system dump */
+		static void read_header(mrpt::utils::CStream &in, uint32_t &pose_dims, uint32_t &lm_dims, uint32_t &obs_dims)
+		{
+			std::string sMagic;
+			uint32_t version;
+			in >> sMagic;
+			if (sMagic!=magic())
+				throw std::runtime_error("[TLinearSystemDump] Not an SRBA linear system dump file");
+			in >> version;
+			if (version!=DUMP_VERSION)
+				throw std::runtime_error(mrpt::format("[TLinearSystemDump] Unsupported linear system dump version: %u", static_cast<unsigned int>(version)));
+			in >> pose_dims >> lm_dims >> obs_dims;
+		}
+
+		template <class MATRIX>
+		static void write_matrix(mrpt::utils::CStream &out, const MATRIX &M)
+		{
+			for (int r=0;r<M.rows();r++)
+				for (int c=0;c<M.cols();c++)
+					out << static_cast<double>(M(r,c));
+		}
+		template <class MATRIX>
+		static void read_matrix(mrpt::utils::CStream &in, MATRIX &M)
+		{
+			double d;
+			for (int r=0;r<M.rows();r++)
+				for (int c=0;c<M.cols();c++) {
+					in >> d; M(r,c) = d;
+				}
+		}
+
+		/** Writes the numeric value of all the blocks in a list of columns of a sparse Jacobian or Hessian, mapping their row indices with \a row_map (if not NULL) */
+		template <class COL>
+		static void write_sparse_cols(mrpt::utils::CStream &out, const std::vector<const COL*> &cols, const std::map<size_t,size_t> *row_map)
+		{
+			out << static_cast<uint64_t>(cols.size());
+			for (size_t i=0;i<cols.size();i++)
+			{
+				out << static_cast<uint64_t>(cols[i]->size());
+				for (typename COL::const_iterator it=cols[i]->begin();it!=cols[i]->end();++it)
+				{
+					size_t row = it->first;
+					if (row_map)
+					{
+						std::map<size_t,size_t>::const_iterator it_row = row_map->find(row);
+						ASSERT_(it_row!=row_map->end())
+						row = it_row->second;
+					}
+					out << static_cast<uint64_t>(row);
+					write_matrix(out, it->second.num);
+				}
+			}
+		}
+		/** \overload For an entire Hessian */
+		template <class SPARSE_MATRIX>
+		static void write_sparse_matrix(mrpt::utils::CStream &out, const SPARSE_MATRIX &M)
+		{
+			std::vector<const typename SPARSE_MATRIX::col_t*> cols(M.getColCount());
+			for (size_t i=0;i<cols.size();i++)
+				cols[i] = &M.getCol(i);
+			write_sparse_cols(out, cols, NULL);
+		}
+		/** Reads a sparse Jacobian or Hessian: only the numeric part of blocks is recovered */
+		template <class SPARSE_MATRIX>
+		static void read_sparse_matrix(mrpt::utils::CStream &in, SPARSE_MATRIX &M)
+		{
+			uint64_t nCols, nBlocks, row;
+			in >> nCols;
+			M.clearAll();
+			M.setColCount(static_cast<size_t>(nCols));
+			for (size_t i=0;i<M.getColCount();i++)
+			{
+				in >> nBlocks;
+				for (uint64_t k=0;k<nBlocks;k++)
+				{
+					in >> row;
+					read_matrix(in, M.getCol(i)[static_cast<size_t>(row)].num);
+				}
+			}
+		}
+
+		template <class VECTOR>
+		static void write_vector(mrpt::utils::CStream &out, const VECTOR &v)
+		{
+			out << static_cast<uint64_t>(v.size());
+			for (size_t i=0;i<static_cast<size_t>(v.size());i++)
+				out << static_cast<double>(v[i]);
+		}
+		static void read_vector(mrpt::utils::CStream &in, Eigen::VectorXd &v)
+		{
+			uint64_t n;
+			in >> n;
+			v.resize(static_cast<size_t>(n));
+			for (size_t i=0;i<static_cast<size_t>(n);i++)
+				in >> v[i];
+		}
+	};
+
+} // end NS internal
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::dump_linear_system(
+	const std::vector<typename TSparseBlocksJacobians_dh_dAp::col_t*> & dh_dAp,
+	const std::vector<typename TSparseBlocksJacobians_dh_df::col_t*>  & dh_df,
+	const std::vector<TObsUsed> & involved_obs,
+	const vector_residuals_t & residuals,
+	const std::map<size_t,size_t> & obs_global_idx2residual_idx,
+	const typename hessian_traits_t::TSparseBlocksHessian_Ap  & HAp,
+	const typename hessian_traits_t::TSparseBlocksHessian_f   & Hf,
+	const typename hessian_traits_t::TSparseBlocksHessian_Apf & HApf,
+	const Eigen::VectorXd & minus_grad,
+	const double lambda)
+{
+	typedef internal::linear_system_dump_io io;
+
+	const size_t nUnknowns_scalars = static_cast<size_t>(minus_grad.size());
+	if (nUnknowns_scalars<parameters.srba.dump_linear_systems_min_unknowns)
+		return;
+
+	// optimize_edges() may be running concurrently (see optimize_local_areas()):
+#if defined(_OPENMP)
+#	pragma omp critical (srba_dump_linear_system)
+#endif
+	{
+		const std::string sFile = mrpt::format("%s_%05u.srbals", parameters.srba.dump_linear_systems_prefix.c_str(), static_cast<unsigned int>(m_dump_linsys_counter++));
+
+		mrpt::utils::CFileGZOutputStream f;
+		if (!f.open(sFile))
+		{
+			VERBOSE_LEVEL(1) << "[OPT] Error creating linear system dump file: " << sFile << std::endl;
+		}
+		else
+		{
+			io::write_header(f, REL_POSE_DIMS, LM_DIMS, OBS_DIMS);
+			f << static_cast<uint64_t>(dh_dAp.size()) << static_cast<uint64_t>(dh_df.size()) << static_cast<uint64_t>(involved_obs.size());
+
+			// Jacobians, with row indices mapped to entries in "residuals":
+			const std::vector<const typename TSparseBlocksJacobians_dh_dAp::col_t*> cdh_dAp(dh_dAp.begin(),dh_dAp.end());
+			const std::vector<const typename TSparseBlocksJacobians_dh_df::col_t*>  cdh_df(dh_df.begin(),dh_df.end());
+			io::write_sparse_cols(f, cdh_dAp, &obs_global_idx2residual_idx);
+			io::write_sparse_cols(f, cdh_df, &obs_global_idx2residual_idx);
+
+			// Per observation: validity of its Jacobians, residual and the effective information matrix (\Lambda, as applied by the noise model):
+			const Eigen::Matrix<double,OBS_DIMS,OBS_DIMS> I = Eigen::Matrix<double,OBS_DIMS,OBS_DIMS>::Identity();
+			for (size_t i=0;i<involved_obs.size();i++)
+			{
+				const size_t obs_idx = involved_obs[i].obs_idx;
+				Eigen::Matrix<double,OBS_DIMS,OBS_DIMS> obs_info = Eigen::Matrix<double,OBS_DIMS,OBS_DIMS>::Zero();
+				RBA_OPTIONS::obs_noise_matrix_t::template accum_JtJ(obs_info, I, I, obs_idx, this->parameters.obs_noise );
+				RBA_OPTIONS::obs_noise_matrix_t::template scale_H(obs_info, this->parameters.obs_noise );
+
+				f << (rba_state.all_observations_Jacob_validity[obs_idx]!=0);
+				for (size_t k=0;k<OBS_DIMS;k++)
+					f << static_cast<double>(residuals[i][k]);
+				io::write_matrix(f, obs_info);
+			}
+
+			// Numeric Hessians (HApf in row-compressed form), the RHS and the initial LM lambda:
+			io::write_sparse_matrix(f, HAp);
+			io::write_sparse_matrix(f, Hf);
+			io::write_sparse_matrix(f, HApf);
+			io::write_vector(f, minus_grad);
+			f << lambda;
+
+			VERBOSE_LEVEL(2) << "[OPT] Linear system saved to: " << sFile << std::endl;
+		}
+	}
+}
+
+} // end NS
@@ -32,7 +32,34 @@ namespace internal
 	template <bool USE_SCHUR, bool DENSE_CHOL,class RBA_ENGINE>
 	struct solver_engine;
 
+	/** Solver with an external linear solver backend (see options::solver_LM_backend) */
+	template <bool USE_SCHUR, class BACKEND, class RBA_ENGINE>
+	struct solver_engine_backend;
+
 	// Implemented in lev-marq_solvers.h
+
+	/** Detects whether a RBA_OPTIONS::solver_t type names a linear solver backend (a "backend_t" typedef) */
+	template <class SOLVER_T>
+	struct solver_has_backend
+	{
+		typedef char yes_t[1];
+		typedef char no_t[2];
+		template <class T> static yes_t & test(typename T::backend_t *);
+		template <class T> static no_t  & test(...);
+		static const bool value = sizeof(test<SOLVER_T>(0))==sizeof(yes_t);
+	};
+
+	/** Selects the solver engine for a given RBA_OPTIONS::solver_t type */
+	template <class SOLVER_T, class RBA_ENGINE, bool HAS_BACKEND = solver_has_backend<SOLVER_T>::value>
+	struct solver_engine_selector
+	{
+		typedef solver_engine<SOLVER_T::USE_SCHUR,SOLVER_T::DENSE_CHOLESKY,RBA_ENGINE> type;
+	};
+	template <class SOLVER_T, class RBA_ENGINE>
+	struct solver_engine_selector<SOLVER_T,RBA_ENGINE,true>
+	{
+		typedef solver_engine_backend<SOLVER_T::USE_SCHUR,typename SOLVER_T::backend_t,RBA_ENGINE> type;
+	};
 }
 
 
@@ -45,13 +72,14 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 	const std::vector<size_t> & run_k2k_edges_in,
 	const std::vector<size_t> & run_feat_ids_in,
 	TOptimizeExtraOutputInfo & out_info,
-	const std::vector<size_t> & in_observation_indices_to_optimize
+	const std::vector<size_t> & in_observation_indices_to_optimize,
+	const typename rba_problem_state_t::TSpanningTree::numeric_pose_path_list_t * concurrent_num_poses
 	)
 {
 	using namespace std;
 	// This method deals with many common tasks to any optimizer: update Jacobians, prepare Hessians, etc. 
 	// The specific solver method details are implemented in "my_solver_t":
-	typedef internal::solver_engine<RBA_OPTIONS::solver_t::USE_SCHUR,RBA_OPTIONS::solver_t::DENSE_CHOLESKY,rba_engine_t> my_solver_t;
+	typedef typename internal::solver_engine_selector<typename RBA_OPTIONS::solver_t,rba_engine_t>::type my_solver_t;
 	
 	m_profiler.enter("opt");
 
@@ -77,7 +105,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 	for (size_t i=0;i<run_k2k_edges_in.size();i++)
 	{
 		const typename TSparseBlocksJacobians_dh_dAp::col_t & col_i = rba_state.lin_system.dh_dAp.getCol( run_k2k_edges_in[i] );
-		if (!col_i.empty()) {
+		if (!col_i.empty() || rba_state.k2k_edge_priors.count(run_k2k_edges_in[i])) {
 			run_k2k_edges.push_back( run_k2k_edges_in[i] );
 			touched_KFs.insert( rba_state.k2k_edges[run_k2k_edges_in[i]].from );
 			touched_KFs.insert( rba_state.k2k_edges[run_k2k_edges_in[i]].to );
@@ -87,12 +115,11 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 			const TKeyFrameID from = rba_state.k2k_edges[run_k2k_edges_in[i]].from;
 			const TKeyFrameID to   = rba_state.k2k_edges[run_k2k_edges_in[i]].to;
 			mrpt::system::setConsoleColor(mrpt::system::CONCOL_RED, true /*cerr*/);
-			std::cerr << "[RbaEngine::optimize_edges] *Warning*: Skipping optimization of k2k edge #"<<run_k2k_edges_in[i] << " (" <<from <<"->"<<to <<") since no observation depends on it.\n";
+			std::cerr << "[RbaEngine::optimize_edges] *Warning*: Skipping optimization of k2k edge #"<<run_k2k_edges_in[i] << " (" <<from <<"->"<<to <<") since no observation nor prior depends on it.\n";
 			mrpt::system::setConsoleColor(mrpt::system::CONCOL_NORMAL, true /*cerr*/);
 		}
 	}
 
-	const mrpt::utils::map_as_vector<size_t,size_t> & dh_df_remap = rba_state.lin_system.dh_df.getColInverseRemappedIndices();
 	for (size_t i=0;i<run_feat_ids_in.size();i++)
 	{
 		const TLandmarkID feat_id = run_feat_ids_in[i];
@@ -102,10 +129,10 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 		ASSERTMSG_(lm_e.rfp!=NULL, "Trying to optimize an unknown feature ID")
 		ASSERTMSG_(!lm_e.has_known_pos,"Trying to optimize a feature with fixed (known) value")
 
-		mrpt::utils::map_as_vector<size_t,size_t>::const_iterator it_remap = dh_df_remap.find(feat_id);   // O(1) with map_as_vector
-		ASSERT_(it_remap != dh_df_remap.end())
+		const size_t col_idx = rba_state.lin_system.dh_df.findColByRemapIndex(feat_id);   // O(1) with map_as_vector
+		ASSERT_(col_idx != SRBA_INVALID_INDEX)
 
-		const typename TSparseBlocksJacobians_dh_df::col_t & col_i = rba_state.lin_system.dh_df.getCol( it_remap->second );
+		const typename TSparseBlocksJacobians_dh_df::col_t & col_i = rba_state.lin_system.dh_df.getCol( col_idx );
 
 		if (!col_i.empty()) {
 			run_feat_ids.push_back( feat_id );
@@ -155,10 +182,10 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 		const TLandmarkID feat_id = run_feat_ids[i];
 		const typename rba_problem_state_t::TLandmarkEntry &lm_e = rba_state.all_lms[feat_id];
 
-		mrpt::utils::map_as_vector<size_t,size_t>::const_iterator it_remap = dh_df_remap.find(feat_id);  // O(1) with map_as_vector
-		ASSERT_(it_remap != dh_df_remap.end())
+		const size_t col_idx = rba_state.lin_system.dh_df.findColByRemapIndex(feat_id);  // O(1) with map_as_vector
+		ASSERT_(col_idx != SRBA_INVALID_INDEX)
 
-		dh_df[i] = &rba_state.lin_system.dh_df.getCol( it_remap->second );
+		dh_df[i] = &rba_state.lin_system.dh_df.getCol( col_idx );
 		k2f_edge_unknowns[i] = lm_e.rfp;
 	}
 
@@ -223,6 +250,8 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 		for (size_t i=0;i<nInObs;i++)
 		{
 			const size_t global_obs_idx = in_observation_indices_to_optimize[i];
+			if (rba_state.all_observations[global_obs_idx].is_removed)
+				continue;
 			const size_t obs_idx = involved_obs.size();
 
 			obs_global_idx2residual_idx[global_obs_idx] = obs_idx;
@@ -233,6 +262,10 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 		}
 	}
 
+	// Bring back to hot storage the observation data of old KFs, if any, since residuals will be evaluated many times:
+	for (size_t i=0;i<involved_obs.size();i++)
+		rba_state.obs_data.make_hot( involved_obs[i].obs_idx );
+
 	DETAILED_PROFILING_LEAVE("opt.build_obs_list")
 
 	const size_t nObs = involved_obs.size();
@@ -253,7 +286,10 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 	// Spanning tree: Update numerically only those entries which we really need:
 	// -------------------------------------------------------------------------------
 	DETAILED_PROFILING_ENTER("opt.update_spanning_tree_num")
-	const size_t count_span_tree_num_update = rba_state.spanning_tree.update_numeric(kfs_num_spantrees_to_update, false /* don't skip those marked as updated, so update all */);
+	const size_t count_span_tree_num_update = concurrent_num_poses ?
+		rba_state.spanning_tree.update_numeric_poses(*concurrent_num_poses)
+		:
+		rba_state.spanning_tree.update_numeric(kfs_num_spantrees_to_update, false /* don't skip those marked as updated, so update all */);
 	DETAILED_PROFILING_LEAVE("opt.update_spanning_tree_num")
 
 
@@ -278,9 +314,11 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 
 	// Mark all required spanning-tree numeric entries as outdated, so an exception will reveal us if
 	//  next time Jacobians are required they haven't been updated as they should:
+	//  (Not while running concurrently, since other threads may be reading the entries which don't depend on our unknowns)
 	// -------------------------------------------------------------------------------
-	for (size_t i=0;i<list_of_required_num_poses.size();i++)
-		list_of_required_num_poses[i]->mark_outdated();
+	if (!concurrent_num_poses)
+		for (size_t i=0;i<list_of_required_num_poses.size();i++)
+			list_of_required_num_poses[i]->mark_outdated();
 
 #if 0  // Save a sparse block representation of the Jacobian.
 	{
@@ -329,6 +367,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 	nInvalidJacobs += sparse_hessian_update_numeric(HAp);
 	nInvalidJacobs += sparse_hessian_update_numeric(Hf);
 	nInvalidJacobs += sparse_hessian_update_numeric(HApf);
+	k2k_priors_add_to_hessian(run_k2k_edges, HAp);
 	DETAILED_PROFILING_LEAVE("opt.sparse_hessian_update_numeric")
 
 	if (nInvalidJacobs) {
@@ -350,9 +389,17 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 	}
 
 	// VERY IMPORTANT: For J^t*J to be invertible, we need a full rank Hessian:
-	//    nObs*OBS_DIMS >= nUnknowns_k2k*POSE_DIMS+nUnknowns_k2f*LM_DIMS
+	//    nObs*OBS_DIMS + nPriors*POSE_DIMS >= nUnknowns_k2k*POSE_DIMS+nUnknowns_k2f*LM_DIMS
 	//
-	ASSERT_ABOVEEQ_(OBS_DIMS*nObs,POSE_DIMS*nUnknowns_k2k+LM_DIMS*nUnknowns_k2f)
+	size_t nPriors = 0;
+	if (!rba_state.k2k_edge_priors.empty())
+		for (size_t i=0;i<nUnknowns_k2k;i++)
+			nPriors += rba_state.k2k_edge_priors.count(run_k2k_edges[i]);
+	ASSERT_ABOVEEQ_(OBS_DIMS*nObs+POSE_DIMS*nPriors,POSE_DIMS*nUnknowns_k2k+LM_DIMS*nUnknowns_k2f)
+
+	// The RMSE is per residual (observation or prior), since all the unknowns may be constrained by priors only:
+	const size_t nResiduals = nObs + nPriors;
+	const double inv_nResiduals = nResiduals ? 1.0/nResiduals : 0.0;
 
 	// ----------------------------------------------------------------
 	//         Iterative Levenberg Marquardt (LM) algorithm
@@ -393,17 +440,20 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 	//  residuals = "h(x)-z" (a vector of 2-vectors).
 	// ---------------------------------------------------------------------------------
 	vector_residuals_t  residuals(nObs);
+	vector_k2k_prior_errors_t  prior_errs; // Errors of the priors of the k2k edges, if any
 
 	DETAILED_PROFILING_ENTER("opt.reprojection_residuals")
 	double total_proj_error = reprojection_residuals(
 		residuals, // Out
 		involved_obs // In
 		);
+	total_proj_error += k2k_priors_errors(run_k2k_edges, prior_errs);
 	DETAILED_PROFILING_LEAVE("opt.reprojection_residuals")
 
-	double RMSE = std::sqrt(total_proj_error/nObs);
+	double RMSE = std::sqrt(total_proj_error*inv_nResiduals);
 
 	out_info.num_observations     = nObs;
+	out_info.num_priors           = nPriors;
 	out_info.num_jacobians        = count_jacobians;
 	out_info.num_kf2kf_edges_optimized = run_k2k_edges.size();
 	out_info.num_kf2lm_edges_optimized = run_feat_ids.size();
@@ -423,8 +473,14 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 
 	DETAILED_PROFILING_ENTER("opt.compute_minus_gradient")
 	compute_minus_gradient(/* Out: */ minus_grad, /* In: */ dh_dAp, dh_df, residuals, obs_global_idx2residual_idx);
+	k2k_priors_add_to_minus_gradient(run_k2k_edges, prior_errs, minus_grad);
 	DETAILED_PROFILING_LEAVE("opt.compute_minus_gradient")
 
+	// Save the linear system for offline solver benchmarks, if enabled (before the solver overwrites HAp):
+	// ---------------------------------------------------------------------------------
+	if (!parameters.srba.dump_linear_systems_prefix.empty())
+		dump_linear_system(dh_dAp, dh_df, involved_obs, residuals, obs_global_idx2residual_idx, HAp,Hf,HApf, minus_grad, lambda);
+
 
 	// Build symbolic structures for Schur complement:
 	// ---------------------------------------------------------------------------------
@@ -443,6 +499,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 	vector<k2k_edge_t>            old_k2k_edge_unknowns;
 	vector<pose_flag_t>      old_span_tree; // In the same order than "list_of_required_num_poses"
 	vector<TRelativeLandmarkPos>  old_k2f_edge_unknowns;
+	vector_k2k_prior_errors_t     new_prior_errs;
 
 #if SRBA_DETAILED_TIME_PROFILING
 	const std::string sLabelProfilerLM_iter = mrpt::format("opt.lm_iteration_k2k=%03u_k2f=%03u", static_cast<unsigned int>(nUnknowns_k2k), static_cast<unsigned int>(nUnknowns_k2f) );
@@ -559,10 +616,18 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 
 
 			DETAILED_PROFILING_ENTER("opt.update_spanning_tree_num")
-			for (size_t i=0;i<list_of_required_num_poses.size();i++)
-				list_of_required_num_poses[i]->mark_outdated();
+			if (concurrent_num_poses)
+			{
+				rba_state.spanning_tree.update_numeric_poses(*concurrent_num_poses);
+			}
+			else
+			{
+				// Outdate all the numeric poses whose paths go thru the modified edges:
+				for (size_t i=0;i<nUnknowns_k2k;i++)
+					rba_state.spanning_tree.mark_edge_modified(k2k_edge_unknowns[i]->id);
 
-			rba_state.spanning_tree.update_numeric(kfs_num_spantrees_to_update, true /* Only those marked as outdated above */);
+				rba_state.spanning_tree.update_numeric(kfs_num_spantrees_to_update, true /* Only those marked as outdated above */);
+			}
 			DETAILED_PROFILING_LEAVE("opt.update_spanning_tree_num")
 
 			// Compute new reprojection errors:
@@ -574,9 +639,10 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 				new_residuals, // Out
 				involved_obs // In
 				);
+			new_total_proj_error += k2k_priors_errors(run_k2k_edges, new_prior_errs);
 			DETAILED_PROFILING_LEAVE("opt.reprojection_residuals")
 
-			const double new_RMSE = std::sqrt(new_total_proj_error/nObs);
+			const double new_RMSE = std::sqrt(new_total_proj_error*inv_nResiduals);
 
 			const double error_reduction_ratio = total_proj_error>0 ? (total_proj_error - new_total_proj_error)/total_proj_error : 0;
 
@@ -599,6 +665,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 				//  (swap where possible, since it's faster)
 				// ---------------------------------------------------------------------
 				residuals.swap( new_residuals );
+				prior_errs.swap( new_prior_errs );
 
 				total_proj_error = new_total_proj_error;
 				RMSE = new_RMSE;
@@ -623,6 +690,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 					sparse_hessian_update_numeric(HAp);
 					sparse_hessian_update_numeric(Hf);
 					sparse_hessian_update_numeric(HApf);
+					k2k_priors_add_to_hessian(run_k2k_edges, HAp);
 					DETAILED_PROFILING_LEAVE("opt.sparse_hessian_update_numeric")
 
 					my_solver.realize_relinearized();
@@ -631,6 +699,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 				// Update gradient:
 				DETAILED_PROFILING_ENTER("opt.compute_minus_gradient")
 				compute_minus_gradient(/* Out: */ minus_grad, /* In: */ dh_dAp, dh_df, residuals, obs_global_idx2residual_idx);
+				k2k_priors_add_to_minus_gradient(run_k2k_edges, prior_errs, minus_grad);
 				DETAILED_PROFILING_LEAVE("opt.compute_minus_gradient")
 
 				const double norm_inf_min_grad = mrpt::math::norm_inf(minus_grad);
@@ -661,6 +730,8 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 
 				// Restore old values and retry again with a different lambda:
 				//DON'T: rba_state.spanning_tree.num = old_span_tree; // NO! Don't do this, since existing pointers will break -> Copy elements one by one:
+				//  (While running concurrently, only our own poses can be written: they are recomputed from the restored edges below)
+				if (!concurrent_num_poses)
 				{
 					const size_t nReqNumPoses = list_of_required_num_poses.size();
 					for (size_t i=0;i<nReqNumPoses;i++) 
@@ -674,6 +745,20 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 				{
 					*k2k_edge_unknowns[i] = old_k2k_edge_unknowns[i];
 				}
+
+				if (concurrent_num_poses)
+				{
+					rba_state.spanning_tree.update_numeric_poses(*concurrent_num_poses);
+				}
+				else
+				{
+					// The restored numeric poses are in sync with the restored edges, while the rest of poses computed with the rejected edges are now outdated:
+					for (size_t i=0;i<nUnknowns_k2k;i++)
+						rba_state.spanning_tree.mark_edge_modified(k2k_edge_unknowns[i]->id);
+					const uint64_t gen = rba_state.spanning_tree.num.current_generation();
+					for (size_t i=0;i<list_of_required_num_poses.size();i++)
+						list_of_required_num_poses[i]->generation = gen;
+				}
 				for (size_t i=0;i<nUnknowns_k2f;i++)
 				{
 					*k2f_edge_unknowns[i] = old_k2f_edge_unknowns[i];
@@ -681,7 +766,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 
 				DETAILED_PROFILING_LEAVE("opt.failedstep_restore_backup")
 
-				VERBOSE_LEVEL(2) << "[OPT] LM iter #"<< iter << " no update,errs: " << sqrt(total_proj_error/nObs) << " < " << sqrt(new_total_proj_error/nObs) << " lambda=" << lambda <<endl;
+				VERBOSE_LEVEL(2) << "[OPT] LM iter #"<< iter << " no update,errs: " << sqrt(total_proj_error*inv_nResiduals) << " < " << sqrt(new_total_proj_error*inv_nResiduals) << " lambda=" << lambda <<endl;
 				lambda *= nu;
 				nu *= 2.0;
 				stop = (lambda>MAX_LAMBDA);
@@ -699,7 +784,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 	std::cout << "residuals" << std::endl;
 	for( size_t r = 0; r < residuals.size(); ++r ) 
 	{
-		std::cout << involved_obs[r].k2f->obs.obs.feat_id << ","
+		std::cout << involved_obs[r].k2f->obs.feat_id << ","
 			 << residuals[r][0] << "," 
 			 << residuals[r][1] << "," 
 			 << residuals[r][2] << "," 
@@ -724,30 +809,40 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_edges(
 	// Recover information on covariances?
 	// ----------------------------------------------
 	DETAILED_PROFILING_ENTER("opt.cov_recovery")
-	rba_state.unknown_lms_inf_matrices.clear();
-	switch (parameters.srba.cov_recovery)
+	bool unknown_cov_recovery = false;
+	// The inf. matrices are shared among concurrent optimizations (see optimize_local_areas()):
+#if defined(_OPENMP)
+#	pragma omp critical (srba_cov_recovery)
+#endif
 	{
-		case crpNone:
-			break;
-		case crpLandmarksApprox:
+		// Only the landmarks in this optimization are updated, the rest keep their last estimated information matrices:
+		switch (parameters.srba.cov_recovery)
 		{
-			for (size_t i=0;i<nUnknowns_k2f;i++)
+			case crpNone:
+				break;
+			case crpLandmarksApprox:
 			{
-				if (!my_solver.was_ith_feature_invertible(i))
-					continue;
+				for (size_t i=0;i<nUnknowns_k2f;i++)
+				{
+					if (!my_solver.was_ith_feature_invertible(i))
+					{
+						rba_state.unknown_lms_inf_matrices.invalidate( run_feat_ids[i] );
+						continue;
+					}
 
-				const typename hessian_traits_t::TSparseBlocksHessian_f::col_t & col_i = Hf.getCol(i);
-				ASSERT_(col_i.rbegin()->first==i)  // Make sure the last block matrix is the diagonal term of the upper-triangular matrix.
+					const typename hessian_traits_t::TSparseBlocksHessian_f::col_t & col_i = Hf.getCol(i);
+					ASSERTDEB_(col_i.rbegin()->first==i)  // Make sure the last block matrix is the diagonal term of the upper-triangular matrix.
 
-				const typename hessian_traits_t::TSparseBlocksHessian_f::matrix_t & inf_mat_src = col_i.rbegin()->second.num;
-				typename hessian_traits_t::TSparseBlocksHessian_f::matrix_t & inf_mat_dst = rba_state.unknown_lms_inf_matrices[ run_feat_ids[i] ];
-				inf_mat_dst = inf_mat_src;
+					rba_state.unknown_lms_inf_matrices.set( run_feat_ids[i], col_i.rbegin()->second.num );
+				}
 			}
+			break;
+			default:
+				unknown_cov_recovery = true;
 		}
-		break;
-		default: 
-			throw std::runtime_error("Unknown value found for 'parameters.srba.cov_recovery'");
 	}
+	if (unknown_cov_recovery)
+		throw std::runtime_error("Unknown value found for 'parameters.srba.cov_recovery'");
 	DETAILED_PROFILING_LEAVE("opt.cov_recovery")
 
 	if (parameters.srba.compute_condition_number)
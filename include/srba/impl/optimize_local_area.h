@@ -20,6 +20,15 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_local_are
 	const std::vector<size_t> & observation_indices_to_optimize
 	)
 {
+	TApiRecScope api_rec_scope(m_api_rec_depth);
+	const bool api_rec = api_rec_is_outermost();
+	if (api_rec)
+	{
+		api_rec_call(internal::arOptimizeLocalArea);
+		api_log_io_t::write_local_area(*m_api_rec, root_id, win_size, params);
+		api_log_io_t::write_indices(*m_api_rec, observation_indices_to_optimize);
+	}
+
 	m_profiler.enter("optimize_local_area");
 
 	// Use prebuilt spanning trees if possible (should be always!)
@@ -45,6 +54,8 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_local_are
 		my_visitor  //k2f_edge_visitor
 		);
 
+	const size_t nLMsRejected = filter_landmarks_by_geometry(my_visitor.lm_IDs_to_optimize, params);
+
 	m_profiler.leave("optimize_local_area.find_edges2opt");
 
 	// 2nd) Optimize them:
@@ -53,8 +64,254 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_local_are
 	{
 		this->optimize_edges(my_visitor.k2k_edges_to_optimize,my_visitor.lm_IDs_to_optimize, out_info, observation_indices_to_optimize);
 	}
+	out_info.num_lm_rejected_by_geometry = nLMsRejected;
 
 	m_profiler.leave("optimize_local_area");
+
+	if (api_rec)
+		api_log_io_t::write_results(*m_api_rec, std::vector<typename api_log_io_t::TCallResult>(1, typename api_log_io_t::TCallResult(root_id,out_info)) );
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::get_optimization_footprint(
+	const std::vector<size_t> & k2k_edges,
+	const std::vector<size_t> & lm_IDs,
+	std::set<TKeyFrameID>     & out_kfs,
+	std::vector<size_t>       & out_obs_idxs,
+	std::set<TKeyFrameID>     & out_tree_roots)
+{
+	out_kfs.clear();
+	out_obs_idxs.clear();
+	out_tree_roots.clear();
+
+	// Jacobian columns of all the unknowns:
+	std::vector<typename TSparseBlocksJacobians_dh_dAp::col_t*>  dh_dAp;
+	std::vector<typename TSparseBlocksJacobians_dh_df::col_t*>   dh_df;
+
+	for (size_t i=0;i<k2k_edges.size();i++)
+	{
+		dh_dAp.push_back( &rba_state.lin_system.dh_dAp.getCol( k2k_edges[i] ) );
+		out_kfs.insert( rba_state.k2k_edges[k2k_edges[i]].from );
+		out_kfs.insert( rba_state.k2k_edges[k2k_edges[i]].to );
+	}
+
+	for (size_t i=0;i<lm_IDs.size();i++)
+	{
+		const size_t col_idx = rba_state.lin_system.dh_df.findColByRemapIndex(lm_IDs[i]);  // O(1) with map_as_vector
+		if (col_idx != SRBA_INVALID_INDEX)
+			dh_df.push_back( &rba_state.lin_system.dh_df.getCol( col_idx ) );
+	}
+
+	// All the involved observations, and their observing & base KFs:
+	std::set<size_t> obs_idxs;
+	for (size_t i=0;i<dh_dAp.size();i++)
+		for (typename TSparseBlocksJacobians_dh_dAp::col_t::const_iterator it=dh_dAp[i]->begin();it!=dh_dAp[i]->end();++it)
+			obs_idxs.insert(it->first);
+	for (size_t i=0;i<dh_df.size();i++)
+		for (typename TSparseBlocksJacobians_dh_df::col_t::const_iterator it=dh_df[i]->begin();it!=dh_df[i]->end();++it)
+			obs_idxs.insert(it->first);
+
+	for (std::set<size_t>::const_iterator it=obs_idxs.begin();it!=obs_idxs.end();++it)
+	{
+		const k2f_edge_t &k2f = rba_state.all_observations[*it];
+		out_kfs.insert( k2f.obs.kf_id );
+		out_kfs.insert( k2f.feat_rel_pos->id_frame_base );
+	}
+	out_obs_idxs.assign(obs_idxs.begin(),obs_idxs.end());
+
+	// Spanning trees which will be numerically updated, and all the KFs (and edges) they reach:
+	prepare_Jacobians_required_tree_roots(out_tree_roots, dh_dAp, dh_df);
+
+	for (std::set<TKeyFrameID>::const_iterator it_root=out_tree_roots.begin();it_root!=out_tree_roots.end();++it_root)
+	{
+		out_kfs.insert(*it_root);
+
+		typename rba_problem_state_t::TSpanningTree::all_edges_maps_t::const_iterator it_map = rba_state.spanning_tree.sym.all_edges.find(*it_root);
+		if (it_map==rba_state.spanning_tree.sym.all_edges.end())
+			continue;
+
+		for (typename std::map<TKeyFrameID, typename rba_problem_state_t::k2k_edge_vector_t>::const_iterator itE=it_map->second.begin();itE!=it_map->second.end();++itE)
+		{
+			out_kfs.insert(itE->first);
+			const typename rba_problem_state_t::k2k_edge_vector_t & path = itE->second;
+			for (size_t k=0;k<path.size();k++)
+			{
+				out_kfs.insert(path[k]->from);
+				out_kfs.insert(path[k]->to);
+			}
+		}
+	}
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::optimize_local_areas(
+	const std::vector<TLocalAreaRequest> & areas,
+	std::vector<TOptimizeExtraOutputInfo> & out_infos
+	)
+{
+	TApiRecScope api_rec_scope(m_api_rec_depth);
+	const bool api_rec = api_rec_is_outermost();
+	if (api_rec)
+	{
+		api_rec_call(internal::arOptimizeLocalAreas);
+		*m_api_rec << static_cast<uint64_t>(areas.size());
+		for (size_t i=0;i<areas.size();i++)
+			api_log_io_t::write_local_area(*m_api_rec, areas[i].root_id, areas[i].win_size, areas[i].params);
+	}
+
+	m_profiler.enter("optimize_local_areas");
+
+	const size_t nAreas = areas.size();
+	out_infos.clear();
+	out_infos.resize(nAreas);
+
+	// 1st) Find the unknowns of each area and their footprints:
+	// ------------------------------------------------------------
+	std::vector<std::vector<size_t> >   k2k_edges(nAreas), lm_IDs(nAreas);
+	std::vector<std::set<TKeyFrameID> > footprints(nAreas), tree_roots(nAreas);
+	std::vector<size_t>                 area_obs, nLMsRejected(nAreas);
+
+	for (size_t i=0;i<nAreas;i++)
+	{
+		const bool use_prebuilt_st = (areas[i].win_size<= parameters.srba.max_tree_depth);
+
+		VisitorOptimizeLocalArea my_visitor(this->rba_state,areas[i].params);
+		this->bfs_visitor(areas[i].root_id, areas[i].win_size, use_prebuilt_st, my_visitor,my_visitor,my_visitor,my_visitor);
+
+		k2k_edges[i].swap(my_visitor.k2k_edges_to_optimize);
+		lm_IDs[i].swap(my_visitor.lm_IDs_to_optimize);
+		nLMsRejected[i] = filter_landmarks_by_geometry(lm_IDs[i], areas[i].params);
+
+		get_optimization_footprint(k2k_edges[i],lm_IDs[i], footprints[i], area_obs, tree_roots[i]);
+
+		// This can't be done concurrently, so bring any observation in cold storage back now:
+		for (size_t j=0;j<area_obs.size();j++)
+			rba_state.obs_data.make_hot(area_obs[j]);
+	}
+
+	// 2nd) Select the areas which don't overlap with any previous one:
+	// ------------------------------------------------------------
+	std::vector<size_t>    concurrent_areas, sequential_areas;
+	std::set<TKeyFrameID>  used_kfs;
+	for (size_t i=0;i<nAreas;i++)
+	{
+		if (k2k_edges[i].empty() && lm_IDs[i].empty())
+			continue;
+
+		bool overlaps = false;
+		for (std::set<TKeyFrameID>::const_iterator it=footprints[i].begin();it!=footprints[i].end() && !overlaps;++it)
+			overlaps = (used_kfs.find(*it)!=used_kfs.end());
+
+		if (overlaps)
+			sequential_areas.push_back(i);
+		else
+		{
+			concurrent_areas.push_back(i);
+			used_kfs.insert(footprints[i].begin(),footprints[i].end());
+		}
+	}
+	if (concurrent_areas.size()<2)
+	{
+		// Nothing to gain: just go through them in order:
+		sequential_areas.insert(sequential_areas.begin(), concurrent_areas.begin(),concurrent_areas.end());
+		concurrent_areas.clear();
+	}
+
+	// 3rd) Optimize independent areas concurrently:
+	// ------------------------------------------------------------
+	const int nConcurrent = static_cast<int>(concurrent_areas.size());
+
+	// The structure of the numeric spanning trees can't be modified concurrently: create all the numeric poses of each area now.
+	// Each area then only recomputes its own poses, those of its spanning tree roots, which are in no other footprint:
+	std::vector<typename rba_problem_state_t::TSpanningTree::numeric_pose_path_list_t> own_num_poses(nConcurrent);
+	for (int k=0;k<nConcurrent;k++)
+	{
+		const std::set<TKeyFrameID> &roots = tree_roots[concurrent_areas[k]];
+		for (std::set<TKeyFrameID>::const_iterator it_root=roots.begin();it_root!=roots.end();++it_root)
+		{
+			typename rba_problem_state_t::TSpanningTree::all_edges_maps_t::const_iterator it_map = rba_state.spanning_tree.sym.all_edges.find(*it_root);
+			if (it_map==rba_state.spanning_tree.sym.all_edges.end())
+				continue;
+
+			for (typename std::map<TKeyFrameID, typename rba_problem_state_t::k2k_edge_vector_t>::const_iterator itE=it_map->second.begin();itE!=it_map->second.end();++itE)
+			{
+				typename rba_problem_state_t::TSpanningTree::TNumericPosePath pp;
+				pp.from  = *it_root;
+				pp.to    = itE->first;
+				pp.entry = &rba_state.spanning_tree.num.get_entry(pp.from, pp.to);
+				pp.path  = &itE->second;
+				own_num_poses[k].push_back(pp);
+			}
+		}
+	}
+
+	std::vector<std::string> errors(nConcurrent);
+
+	const bool old_profiler_enabled = m_profiler.isEnabled();
+	m_profiler.enable(false);  // CTimeLogger is not thread-safe
+
+#if defined(_OPENMP)
+#	pragma omp parallel for schedule(dynamic)
+#endif
+	for (int k=0;k<nConcurrent;k++)
+	{
+		const size_t i = concurrent_areas[k];
+		try
+		{
+			this->optimize_edges(k2k_edges[i],lm_IDs[i], out_infos[i], std::vector<size_t>(), &own_num_poses[k]);
+		}
+		catch (std::exception &e)
+		{
+			errors[k] = e.what();
+		}
+		catch (...)
+		{
+			errors[k] = "Unknown exception";
+		}
+	}
+
+	m_profiler.enable(old_profiler_enabled);
+
+	if (nConcurrent)
+	{
+		// All the numeric poses through the optimized edges are outdated, except the own poses of each area, which are in sync:
+		for (int k=0;k<nConcurrent;k++)
+		{
+			const std::vector<size_t> &edges = k2k_edges[concurrent_areas[k]];
+			for (size_t j=0;j<edges.size();j++)
+				rba_state.spanning_tree.mark_edge_modified(edges[j]);
+			rba_state.spanning_tree.update_numeric_poses(own_num_poses[k]);
+		}
+	}
+
+	for (int k=0;k<nConcurrent;k++)
+		if (!errors[k].empty())
+			throw std::runtime_error(mrpt::format("[optimize_local_areas] Error optimizing area rooted at KF #%u:\n%s", static_cast<unsigned int>(areas[concurrent_areas[k]].root_id), errors[k].c_str()));
+
+	// 4th) And the rest, sequentially:
+	// ------------------------------------------------------------
+	for (size_t k=0;k<sequential_areas.size();k++)
+	{
+		const size_t i = sequential_areas[k];
+		this->optimize_edges(k2k_edges[i],lm_IDs[i], out_infos[i]);
+	}
+
+	for (size_t i=0;i<nAreas;i++)
+		out_infos[i].num_lm_rejected_by_geometry = nLMsRejected[i];
+
+	VERBOSE_LEVEL(1) << "[optimize_local_areas] " << nConcurrent << " areas optimized concurrently, " << sequential_areas.size() << " sequentially.\n";
+
+	m_profiler.leave("optimize_local_areas");
+
+	if (api_rec)
+	{
+		std::vector<typename api_log_io_t::TCallResult> res;
+		for (size_t i=0;i<nAreas;i++)
+			res.push_back( typename api_log_io_t::TCallResult(areas[i].root_id,out_infos[i]) );
+		api_log_io_t::write_results(*m_api_rec, res);
+	}
+
+	return concurrent_areas.size();
 }
 
 
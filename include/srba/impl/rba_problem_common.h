@@ -19,7 +19,11 @@ template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
 RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::RbaEngine() :
 	m_verbose_level(1),
 	rba_state(),
-	m_profiler(true)
+	m_profiler(true),
+	m_api_rec(NULL),
+	m_api_rec_depth(0),
+	m_dump_linsys_counter(0),
+	m_pending_st_paths(NULL)
 {
 	clear();
 }
@@ -28,7 +32,12 @@ RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::RbaEngine() :
 template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
 void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::clear()
 {
+	TApiRecScope api_rec_scope(m_api_rec_depth);
+	if (api_rec_is_outermost())
+		api_rec_call(internal::arClear);
+
 	this->rba_state.clear();
+	m_numeric_jacob_cache.clear();
 }
 
 template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
@@ -38,6 +47,7 @@ RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSRBAParameters::TSRBAP
 	max_optimize_depth   ( 4 ),
 	// -------------------------------
 	optimize_new_edges_alone (true),
+	optimize_new_edges_concurrently (true),
 	use_robust_kernel    ( false ),
 	use_robust_kernel_stage1 ( false ),
 	kernel_param         ( 3. ),
@@ -47,10 +57,14 @@ RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSRBAParameters::TSRBAP
 	max_lambda           ( 1e20 ),
 	min_error_reduction_ratio_to_relinearize ( 0.01 ),
 	numeric_jacobians    ( false ),
+	numeric_jacobians_fallback ( true ),
 	feedback_user_iteration(NULL),
 	compute_condition_number(false),
 	compute_sparsity_stats  (false),
-	cov_recovery         ( crpLandmarksApprox )
+	cov_recovery         ( crpLandmarksApprox ),
+	obs_cold_storage_horizon ( 0 ),
+	dump_linear_systems_min_unknowns ( 0 ),
+	removed_obs_compaction_ratio ( 0.1 )
 {
 }
 
@@ -62,6 +76,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSRBAParameters::l
 	MRPT_LOAD_CONFIG_VAR(max_optimize_depth,uint64_t,source,section)
 
 	MRPT_LOAD_CONFIG_VAR(optimize_new_edges_alone,bool,source,section)
+	MRPT_LOAD_CONFIG_VAR(optimize_new_edges_concurrently,bool,source,section)
 	MRPT_LOAD_CONFIG_VAR(use_robust_kernel,bool,source,section)
 	MRPT_LOAD_CONFIG_VAR(use_robust_kernel_stage1,bool,source,section)
 	MRPT_LOAD_CONFIG_VAR(max_rho,double,source,section)
@@ -69,8 +84,13 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSRBAParameters::l
 	MRPT_LOAD_CONFIG_VAR(kernel_param,double,source,section)
 	MRPT_LOAD_CONFIG_VAR(max_iters,uint64_t,source,section)
 	MRPT_LOAD_CONFIG_VAR(max_error_per_obs_to_stop,double,source,section)
+	MRPT_LOAD_CONFIG_VAR(numeric_jacobians_fallback,bool,source,section)
 
 	cov_recovery = source.read_enum(section, "cov_recovery", cov_recovery);
+	MRPT_LOAD_CONFIG_VAR(obs_cold_storage_horizon,uint64_t,source,section)
+	dump_linear_systems_prefix = source.read_string(section,"dump_linear_systems_prefix",dump_linear_systems_prefix);
+	MRPT_LOAD_CONFIG_VAR(dump_linear_systems_min_unknowns,uint64_t,source,section)
+	MRPT_LOAD_CONFIG_VAR(removed_obs_compaction_ratio,double,source,section)
 }
 
 /** See docs of mrpt::utils::CLoadableOptions */
@@ -81,6 +101,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSRBAParameters::s
 	out.write(section,"max_optimize_depth",max_optimize_depth, /* text width */ 30, 30, "Max. local optimization distance");
 
 	out.write(section,"optimize_new_edges_alone",optimize_new_edges_alone,  /* text width */ 30, 30, "Optimize new edges alone before optimizing the entire local area?");
+	out.write(section,"optimize_new_edges_concurrently",optimize_new_edges_concurrently,  /* text width */ 30, 30, "Optimize independent new edges in parallel?");
 	out.write(section,"use_robust_kernel",use_robust_kernel,  /* text width */ 30, 30, "Use pseudo-Huber kernel?");
 	out.write(section,"use_robust_kernel_stage1",use_robust_kernel_stage1,  /* text width */ 30, 30, "Use pseudo-Huber kernel at stage1?");
 	out.write(section,"kernel_param",kernel_param,  /* text width */ 30, 30, "robust kernel parameter");
@@ -88,7 +109,12 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSRBAParameters::s
 	out.write(section,"max_lambda",max_lambda,  /* text width */ 30, 30, "Lev-Marq optimization: maximum lambda to stop");
 	out.write(section,"max_iters",static_cast<uint64_t>(max_iters),  /* text width */ 30, 30, "Max. iterations for optimization");
 	out.write(section,"max_error_per_obs_to_stop",max_error_per_obs_to_stop,  /* text width */ 30, 30, "Another criterion for stopping optimization");
+	out.write(section,"numeric_jacobians_fallback",numeric_jacobians_fallback,  /* text width */ 30, 30, "Numeric Jacobians for observations with ill-defined analytic ones?");
 	out.write(section,"cov_recovery", mrpt::utils::TEnumType<TCovarianceRecoveryPolicy>::value2name(cov_recovery) ,  /* text width */ 30, 30, "Covariance recovery policy");
+	out.write(section,"obs_cold_storage_horizon",obs_cold_storage_horizon,  /* text width */ 30, 30, "Number of KFs after which observations go to compact storage (0=never)");
+	out.write(section,"dump_linear_systems_prefix",dump_linear_systems_prefix,  /* text width */ 30, 30, "Save linear systems to files with this prefix (empty=disabled)");
+	out.write(section,"dump_linear_systems_min_unknowns",static_cast<uint64_t>(dump_linear_systems_min_unknowns),  /* text width */ 30, 30, "Only save linear systems with at least this number of unknowns");
+	out.write(section,"removed_obs_compaction_ratio",removed_obs_compaction_ratio,  /* text width */ 30, 30, "Compact observations when this fraction of them were removed (0=never)");
 }
 
 
@@ -116,21 +142,17 @@ void TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::compute_a
 
 }
 
-/** Returns true if the pair of KFs are connected thru a kf2kf edge, no matter the direction of the edge.
-  * Runs in worst-case O(D) with D the degree of the KF graph (that is, the maximum number of edges adjacent to one KF) */
+// See header for docs
 template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
-bool TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::are_keyframes_connected(const TKeyFrameID id1, const TKeyFrameID id2) const
+size_t TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::find_kf2kf_edge(const TKeyFrameID id1, const TKeyFrameID id2) const
 {
 	ASSERT_BELOW_(id1, keyframes.size())
 	ASSERT_BELOW_(id2, keyframes.size())
 
-	const std::deque<k2k_edge_t*> & id1_adj = keyframes[id1].adjacent_k2k_edges;
-
-	for (size_t i=0;i<id1_adj.size();i++)
-		if ( id2== getTheOtherFromPair2(id1, *id1_adj[i]) )
-			return true;
+	const std::vector<std::pair<TKeyFrameID,size_t> > & id1_adj = keyframes[id1].adjacent_kfs_sorted;
+	const std::vector<std::pair<TKeyFrameID,size_t> >::const_iterator it = std::lower_bound(id1_adj.begin(),id1_adj.end(), std::make_pair(id2,static_cast<size_t>(0)) );
 
-	return false;
+	return (it!=id1_adj.end() && it->first==id2) ? it->second : SRBA_INVALID_INDEX;
 }
 
 } // end NS
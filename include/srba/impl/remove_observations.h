@@ -0,0 +1,256 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+namespace srba {
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+bool RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::remove_observation(const TKeyFrameID observing_kf_id, const TLandmarkID feat_id)
+{
+	TApiRecScope api_rec_scope(m_api_rec_depth);
+	const bool api_rec = api_rec_is_outermost();
+	if (api_rec)
+	{
+		api_rec_call(internal::arRemoveObservation);
+		*m_api_rec << static_cast<uint64_t>(observing_kf_id) << static_cast<uint64_t>(feat_id);
+	}
+
+	m_profiler.enter("remove_observation");
+
+	// Walk the list of observations of this landmark: O(C)
+	size_t obs_idx = SRBA_INVALID_INDEX;
+	if (feat_id<rba_state.all_lms.size() && rba_state.all_lms[feat_id].rfp!=NULL)
+	{
+		for (size_t i=rba_state.all_lms[feat_id].first_obs_idx;i!=SRBA_INVALID_INDEX;i=rba_state.all_observations[i].next_obs_same_lm)
+		{
+			const k2f_edge_t &k2f = rba_state.all_observations[i];
+			if (!k2f.is_removed && k2f.obs.kf_id==observing_kf_id)
+			{
+				obs_idx = i;
+				break;
+			}
+		}
+	}
+
+	const bool found = (obs_idx!=SRBA_INVALID_INDEX);
+	if (found)
+		remove_observation_internal(obs_idx);
+
+	m_profiler.leave("remove_observation");
+
+	if (api_rec)
+		api_log_io_t::write_results(*m_api_rec, std::vector<typename api_log_io_t::TCallResult>(1, typename api_log_io_t::TCallResult(found ? 1:0)) );
+
+	VERBOSE_LEVEL(2) << "[remove_observation] KF #" << observing_kf_id << " -> LM #" << feat_id << (found ? ": removed obs #" : ": not found") << (found ? mrpt::format("%u",static_cast<unsigned int>(obs_idx)) : std::string()) << "\n";
+
+	return found;
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+bool RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::remove_landmark(const TLandmarkID feat_id)
+{
+	TApiRecScope api_rec_scope(m_api_rec_depth);
+	const bool api_rec = api_rec_is_outermost();
+	if (api_rec)
+	{
+		api_rec_call(internal::arRemoveLandmark);
+		*m_api_rec << static_cast<uint64_t>(feat_id);
+	}
+
+	m_profiler.enter("remove_landmark");
+
+	const bool found = (feat_id<rba_state.all_lms.size() && rba_state.all_lms[feat_id].rfp!=NULL);
+	if (found)
+	{
+		typename landmark_traits<landmark_t>::TLandmarkEntry &lm_entry = rba_state.all_lms[feat_id];
+
+		for (size_t i=lm_entry.first_obs_idx;i!=SRBA_INVALID_INDEX;i=rba_state.all_observations[i].next_obs_same_lm)
+			remove_observation_internal(i);
+
+		if (lm_entry.has_known_pos)
+			rba_state.known_lms.erase(feat_id);
+		else
+		{
+			rba_state.unknown_lms.erase(feat_id);
+			rba_state.unknown_lms_inf_matrices.invalidate(feat_id);
+
+			// Its (now empty) column in dh_df is kept, but no longer reachable from the feature ID:
+			const size_t col_idx = rba_state.lin_system.dh_df.findColByRemapIndex(feat_id);
+			if (col_idx!=SRBA_INVALID_INDEX)
+			{
+				rba_state.lin_system.dh_df.getCol(col_idx).clear();
+				rba_state.lin_system.dh_df.unmapCol(feat_id);
+			}
+		}
+
+		// The tombstones of its observations are unlinked from this entry, so the ID can be reused for a new landmark:
+		lm_entry = typename landmark_traits<landmark_t>::TLandmarkEntry();
+	}
+
+	m_profiler.leave("remove_landmark");
+
+	if (api_rec)
+		api_log_io_t::write_results(*m_api_rec, std::vector<typename api_log_io_t::TCallResult>(1, typename api_log_io_t::TCallResult(found ? 1:0)) );
+
+	return found;
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::remove_observation_internal(const size_t obs_idx)
+{
+	ASSERTDEB_(obs_idx<rba_state.all_observations.size())
+	k2f_edge_t &k2f = rba_state.all_observations[obs_idx];
+	if (k2f.is_removed)
+		return;
+
+	forget_numeric_jacob(obs_idx);
+
+	// Its pairs may be the best ones of the triangulation tests:
+	if (k2f.obs.feat_id<rba_state.all_lms.size())
+		rba_state.all_lms[k2f.obs.feat_id].triangulation = typename landmark_traits<landmark_t>::TTriangulationCache();
+
+	// Jacobian dh_df: only for landmarks with unknown positions
+	if (!k2f.feat_has_known_rel_pos)
+	{
+		const size_t col_idx = rba_state.lin_system.dh_df.findColByRemapIndex(k2f.obs.feat_id);
+		if (col_idx!=SRBA_INVALID_INDEX)
+			rba_state.lin_system.dh_df.getCol(col_idx).erase(obs_idx);
+	}
+
+	// Jacobian dh_dAp: one block for each kf2kf edge in the path between the observing and the base KF.
+	if (k2f.num_dh_dAp_blocks>0)
+	{
+		const TKeyFrameID base_id = k2f.feat_rel_pos->id_frame_base;
+		const TKeyFrameID from = std::max(k2f.obs.kf_id, base_id);
+		const TKeyFrameID to   = std::min(k2f.obs.kf_id, base_id);
+
+		size_t nErased = 0;
+		typename rba_problem_state_t::TSpanningTree::all_edges_maps_t::const_iterator it_map = rba_state.spanning_tree.sym.all_edges.find(from);
+		if (it_map != rba_state.spanning_tree.sym.all_edges.end())
+		{
+			typename std::map<TKeyFrameID, typename rba_problem_state_t::k2k_edge_vector_t >::const_iterator it_obs_ed = it_map->second.find(to);
+			if (it_obs_ed != it_map->second.end())
+				for (size_t i=0;i<it_obs_ed->second.size();i++)
+					nErased += rba_state.lin_system.dh_dAp.getCol(it_obs_ed->second[i]->id).erase(obs_idx);
+		}
+
+		// The shortest path may have changed since the observation was inserted: look in all the columns.
+		if (nErased!=k2f.num_dh_dAp_blocks)
+			for (size_t i=0;i<rba_state.lin_system.dh_dAp.getColCount();i++)
+				rba_state.lin_system.dh_dAp.getCol(i).erase(obs_idx);
+	}
+
+	// Leave a tombstone: the entry in all_observations and in the KF list of adjacent edges is kept until compact_observations()
+	k2f.is_removed = true;
+	rba_state.all_observations_Jacob_validity[obs_idx] = 0;
+	rba_state.num_removed_observations++;
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+size_t RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::compact_observations()
+{
+	TApiRecScope api_rec_scope(m_api_rec_depth);
+	const bool api_rec = api_rec_is_outermost();
+	if (api_rec)
+		api_rec_call(internal::arCompactObservations);
+
+	const size_t nRemoved = rba_state.num_removed_observations;
+	if (nRemoved>0)
+	{
+		m_profiler.enter("compact_observations");
+
+		const size_t nOldObs = rba_state.all_observations.size();
+
+		// Map: old -> new observation indices:
+		std::vector<size_t> new_idxs(nOldObs, SRBA_INVALID_INDEX);
+		size_t nNewObs = 0;
+		for (size_t i=0;i<nOldObs;i++)
+			if (!rba_state.all_observations[i].is_removed)
+				new_idxs[i] = nNewObs++;
+		ASSERT_EQUAL_(nNewObs+nRemoved, nOldObs)
+
+		// Observations, their data and validity flags:
+		typename rba_problem_state_t::all_observations_deque_t  new_all_obs;
+		std::deque<char>                                        new_jacob_validity;
+		TObservationDataStore<obs_t>                            new_obs_data;
+		array_obs_t obs_arr;
+		for (size_t i=0;i<nOldObs;i++)
+		{
+			if (new_idxs[i]==SRBA_INVALID_INDEX) continue;
+			new_all_obs.push_back(rba_state.all_observations[i]);
+			new_all_obs.back().next_obs_same_lm = SRBA_INVALID_INDEX;
+			new_all_obs.back().has_numeric_jacob = false; // The cache is cleared below
+			new_jacob_validity.push_back(rba_state.all_observations_Jacob_validity[i]);
+			rba_state.obs_data.get(i, obs_arr);
+			new_obs_data.push_back(obs_arr, rba_state.all_observations[i].obs.kf_id);
+		}
+		rba_state.all_observations.swap(new_all_obs);
+		rba_state.all_observations_Jacob_validity.swap(new_jacob_validity);
+		rba_state.obs_data.swap(new_obs_data);
+		if (parameters.srba.obs_cold_storage_horizon>0 && rba_state.keyframes.size()>parameters.srba.obs_cold_storage_horizon+1)
+			rba_state.obs_data.move_to_cold_storage(rba_state.keyframes.size()-1-parameters.srba.obs_cold_storage_horizon);
+
+		// Lists of observations of each landmark:
+		for (size_t i=0;i<rba_state.all_lms.size();i++)
+			rba_state.all_lms[i].first_obs_idx = rba_state.all_lms[i].last_obs_idx = SRBA_INVALID_INDEX;
+		for (size_t i=0;i<nNewObs;i++)
+		{
+			typename landmark_traits<landmark_t>::TLandmarkEntry &lm_entry = rba_state.all_lms[rba_state.all_observations[i].obs.feat_id];
+			if (lm_entry.last_obs_idx!=SRBA_INVALID_INDEX)
+			     rba_state.all_observations[lm_entry.last_obs_idx].next_obs_same_lm = i;
+			else lm_entry.first_obs_idx = i;
+			lm_entry.last_obs_idx = i;
+		}
+
+		// Incident k2f edges of each KF (they kept pointers to the old entries):
+		for (size_t i=0;i<rba_state.keyframes.size();i++)
+			rba_state.keyframes[i].adjacent_k2f_edges.clear();
+		for (size_t i=0;i<nNewObs;i++)
+			rba_state.keyframes[rba_state.all_observations[i].obs.kf_id].adjacent_k2f_edges.push_back( &rba_state.all_observations[i] );
+
+		// Row indices in the Jacobians:
+		for (size_t c=0;c<rba_state.lin_system.dh_dAp.getColCount();c++)
+			reindex_jacobian_column(rba_state.lin_system.dh_dAp.getCol(c), new_idxs);
+		for (size_t c=0;c<rba_state.lin_system.dh_df.getColCount();c++)
+			reindex_jacobian_column(rba_state.lin_system.dh_df.getCol(c), new_idxs);
+
+		rba_state.num_removed_observations = 0;
+		m_numeric_jacob_cache.clear(); // Indexed by the old observation indices
+
+		m_profiler.leave("compact_observations");
+
+		VERBOSE_LEVEL(2) << "[compact_observations] Purged " << nRemoved << " removed observations, " << nNewObs << " left.\n";
+	}
+
+	if (api_rec)
+		api_log_io_t::write_results(*m_api_rec, std::vector<typename api_log_io_t::TCallResult>(1, typename api_log_io_t::TCallResult(nRemoved)) );
+
+	return nRemoved;
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+template <class JACOB_COL>
+void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::reindex_jacobian_column(JACOB_COL &col, const std::vector<size_t> &new_idxs)
+{
+	if (col.empty()) return;
+	JACOB_COL new_col;
+	for (typename JACOB_COL::const_iterator it=col.begin();it!=col.end();++it)
+	{
+		const size_t new_idx = new_idxs[it->first];
+		ASSERTDEB_(new_idx!=SRBA_INVALID_INDEX)
+		// O(1) insertion at the end, since the order of indices is preserved:
+		typename JACOB_COL::iterator it_new = new_col.insert(new_col.end(), typename JACOB_COL::value_type(new_idx, it->second));
+		it_new->second.sym.obs_idx  = new_idx;
+		it_new->second.sym.is_valid = &rba_state.all_observations_Jacob_validity[new_idx];
+	}
+	col.swap(new_col);
+}
+
+} // end NS
@@ -22,6 +22,7 @@ double RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::reprojection_res
 	if (residuals.size()!=nObs) residuals.resize(nObs);
 
 	double total_sqr_err = 0;
+	pose_t aux_inv_pose;
 
 	for (size_t i=0;i<nObs;i++)
 	{
@@ -42,21 +43,24 @@ double RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::reprojection_res
 		}
 		else
 		{
-			// num[SOURCE] |--> map[TARGET] = CPose3D of TARGET as seen from SOURCE
-			const typename TRelativePosesForEachTarget::const_iterator itPoseMap_for_base_id = rba_state.spanning_tree.num.find(obs_frame_id);
-			ASSERT_( itPoseMap_for_base_id != rba_state.spanning_tree.num.end() )
-
-			const typename frameid2pose_map_t::const_iterator itRelPose = itPoseMap_for_base_id->second.find(base_id);
-			ASSERT_( itRelPose != itPoseMap_for_base_id->second.end() )
-
-			base_pose_wrt_observer = &itRelPose->second.pose;
+			// num.get(SOURCE,TARGET) = CPose3D of TARGET as seen from SOURCE
+			// Normally, it is directly stored (or cached, since the Jacobians also use it); otherwise, it's inverted on the fly:
+			const pose_flag_t *rel_pose = rba_state.spanning_tree.num.find(obs_frame_id,base_id);
+			if (rel_pose)
+				base_pose_wrt_observer = &rel_pose->pose;
+			else
+			{
+				const bool found = rba_state.spanning_tree.num.get(obs_frame_id,base_id, aux_inv_pose);
+				ASSERT_(found)
+				base_pose_wrt_observer = &aux_inv_pose;
+			}
 		}
 
 		// pose_robot2sensor(): pose wrt sensor = pose_wrt_robot (-) sensor_pose_on_the_robot
 		typename options::internal::resulting_pose_t<typename RBA_OPTIONS::sensor_pose_on_robot_t,REL_POSE_DIMS>::pose_t base_pose_wrt_sensor(mrpt::poses::UNINITIALIZED_POSE);
 		RBA_OPTIONS::sensor_pose_on_robot_t::pose_robot2sensor( *base_pose_wrt_observer, base_pose_wrt_sensor, this->parameters.sensor_pose );
 
-		const array_obs_t & real_obs = observations[i].k2f->obs.obs_arr;
+		const array_obs_t & real_obs = rba_state.obs_data.get_hot(observations[i].obs_idx);
 		residual_t &delta = residuals[i];
 
 		// Generate observation and compare to real obs:
@@ -14,35 +14,17 @@ namespace srba {
 #define UPDATE_NUM_ST_VERBOSE  0
 #define DEBUG_GARBAGE_FILL_ALL_NUMS	0
 
-/** Updates all the numeric SE(3) poses from a given entry from \a sym.all_edges[i] */
-template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
-size_t TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSpanningTree::update_numeric_only_all_from_node(
-	const typename all_edges_maps_t::const_iterator & it,
-	bool skip_marked_as_uptodate)
+namespace internal
 {
-	// num[SOURCE] |--> map[TARGET] = CPose3D of TARGET as seen from SOURCE
-	const TKeyFrameID id_from = it->first;
-	frameid2pose_map_t &frameid2pose_map = num[id_from];   // O(1) with map_as_vector
-
-	for (typename std::map<TKeyFrameID, k2k_edge_vector_t >::const_iterator itE = it->second.begin();itE != it->second.end();++itE)
+	/** Accumulates the inverse poses of the edges in a spanning tree path from \a id_from, in the order established by the path,
+	  * into the pose of the last KF as seen from \a id_from */
+	template <class POSE,class K2K_EDGE_VECTOR>
+	void compose_spanning_tree_path(const TKeyFrameID id_from, const K2K_EDGE_VECTOR &ev, POSE &accum)
 	{
-		const TKeyFrameID id_to   = itE->first;
-
-		pose_flag_t & i2j = frameid2pose_map[id_to];
-		pose_flag_t & j2i = num[id_to][id_from];  // O(1) with map_as_vector
-
-		if (skip_marked_as_uptodate && i2j.updated && j2i.updated)
-			continue;
-
-		// Go recompute this pose:
-		const k2k_edge_vector_t &ev = itE->second;
-
-		// Accumulate inverse poses in the order established by the path:
-		pose_t accum;
 		TKeyFrameID curKF = id_from;
 
 #if UPDATE_NUM_ST_VERBOSE
-		std::cout << "ST.NUM["<<id_from<<"]["<<id_to<<"] : ";
+		std::cout << "ST.NUM["<<id_from<<"] : ";
 #endif
 		for (size_t k=0;k<ev.size();k++)
 		{
@@ -63,35 +45,55 @@ size_t TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSpanni
 #endif
 			}
 		}
-
-		// Save in map:
-		i2j.pose = accum;
-		i2j.updated = true;
-
-		// And also symmetric (inverse) pose:
-		j2i.pose = -accum;
-		j2i.updated = true;
-
 #if UPDATE_NUM_ST_VERBOSE
 		std::cout << " "<< accum.asString() << std::endl;
 #endif
 	}
+}
+
+/** Updates all the numeric SE(3) poses from a given entry from \a sym.all_edges[i] */
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+size_t TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSpanningTree::update_numeric_only_all_from_node(
+	const typename all_edges_maps_t::const_iterator & it,
+	bool skip_marked_as_uptodate)
+{
+	// num.get(SOURCE,TARGET) = CPose3D of TARGET as seen from SOURCE
+	// "all_edges" only has entries (i,j) with i>j, which is also the only direction stored in "num".
+	const TKeyFrameID id_from = it->first;
+
+	for (typename std::map<TKeyFrameID, k2k_edge_vector_t >::const_iterator itE = it->second.begin();itE != it->second.end();++itE)
+	{
+		typename num_spanning_tree_t::TEntry & i2j = num.get_entry(id_from,itE->first);  // O(log N), N=size of the tree
+		const k2k_edge_vector_t &ev = itE->second;
+
+		if (skip_marked_as_uptodate && num.is_updated(i2j,ev))
+			continue;
+
+		// Go recompute this pose:
+		pose_t accum;
+		internal::compose_spanning_tree_path(id_from,ev, accum);
+
+		// Save, and also the symmetric (inverse) pose only if someone holds a pointer to it:
+		num.update_pose(i2j, accum);
+	}
 
 	return it->second.size();
 }
 
 #if DEBUG_GARBAGE_FILL_ALL_NUMS
 
+struct TSetPoseToGarbage
+{
+	template <class POSE_FLAG>
+	void operator()(const TKeyFrameID, const TKeyFrameID, POSE_FLAG &pf) { pf.pose.setToNaN(); }
+};
+
 template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
 void setAllNumericToGarbage(typename TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSpanningTree &st)
 {
 	// Mark all numeric values to trash so we detect if some goes un-initialized.
-	for (typename kf2kf_pose_traits<kf2kf_pose_t>::TRelativePosesForEachTarget::iterator it=st.num.begin();it!=st.num.end();++it)
-	{
-		typename kf2kf_pose_traits<kf2kf_pose_t>::frameid2pose_map_t & m = it->second;
-		for (typename kf2kf_pose_traits<kf2kf_pose_t>::frameid2pose_map_t::iterator it2=m.begin();it2!=m.end();++it2)
-			it2->second.pose.setToNaN();
-	}
+	TSetPoseToGarbage f;
+	st.num.for_each_pose(f);
 }
 #endif
 
@@ -126,4 +128,24 @@ size_t TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSpanni
 	return pose_count;
 }
 
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSpanningTree::mark_edge_modified(const size_t edge_id)
+{
+	ASSERTDEB_(edge_id<m_parent->k2k_edges.size())
+	m_parent->k2k_edges[edge_id].generation = num.new_generation();
+}
+
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+size_t TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSpanningTree::update_numeric_poses(const numeric_pose_path_list_t & poses)
+{
+	for (size_t i=0;i<poses.size();i++)
+	{
+		ASSERTDEB_(poses[i].entry && poses[i].path)
+		pose_t accum;
+		internal::compose_spanning_tree_path(poses[i].from,*poses[i].path, accum);
+		num.update_pose(*poses[i].entry, accum);
+	}
+	return poses.size();
+}
+
 } // end NS
@@ -19,15 +19,17 @@ template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
 void TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSpanningTree::update_symbolic_new_node(
 	const TKeyFrameID                    new_node_id,
 	const TPairKeyFrameID & new_edge,
-	const topo_dist_t                    max_depth
+	const topo_dist_t                    max_depth,
+	std::set<TPairKeyFrameID>          * pending_paths
 	)
 {
 	using namespace std;
 	ASSERT_(max_depth>=1)
 
-	// Maintain a list of those nodes whose list of shortest spanning trees ("next_edge") has been modified, so we
-	// can rebuild their "all_edges" lists.
-	std::set<TPairKeyFrameID> kfs_with_modified_next_edge;
+	// Maintain a list of those pairs of nodes whose shortest spanning trees ("next_edge") has been modified, so we
+	// can rebuild their "all_edges" lists. Since "all_edges" is symmetric, only the (max,min) pair is stored.
+	std::set<TPairKeyFrameID> local_modified_pairs;
+	std::set<TPairKeyFrameID> &kfs_with_modified_next_edge = pending_paths ? *pending_paths : local_modified_pairs;
 
 	// Generic algorithm for 1 or more new edges at once from the new_kf_id to the rest of the graph:
 	// -----------------------------------------------------------------------------------------------
@@ -114,8 +116,7 @@ cout << "ST: Shorter path ST["<<s<<"]["<<r<<"].N was "<<st_s[r].next << " => "<<
 						ASSERT_NOT_EQUAL_(s,ste_r_inSTs.next) // no self-loops!
 
 						// Mark nodes with their "next_node" modified:
-						kfs_with_modified_next_edge.insert( make_pair(s,r) );
-						kfs_with_modified_next_edge.insert( make_pair(r,s) );
+						kfs_with_modified_next_edge.insert( make_pair(std::max(r,s),std::min(r,s)) );
 					}
 					// Otherwise, leave things stay.
 				}
@@ -143,8 +144,7 @@ cout << "ST: New path ST["<<s<<"]["<<r<<"].N ="<<(ste_s2ik ? ste_s2ik->next : ne
 						ASSERT_NOT_EQUAL_(s, ste_r_inSTs.next) // no self-loops!
 
 						// Mark nodes with their "next_node" modified:
-						kfs_with_modified_next_edge.insert(make_pair(r,s));
-						kfs_with_modified_next_edge.insert(make_pair(s,r));
+						kfs_with_modified_next_edge.insert( make_pair(std::max(r,s),std::min(r,s)) );
 					}
 				}
 
@@ -167,28 +167,9 @@ cout << "ST: New path ST["<<s<<"]["<<r<<"].N ="<<(ste_s2ik ? ste_s2ik->next : ne
 #endif
 
 	// Update "all_edges" --------------------------------------------
-	// Only for those who were really modified.
-	for (std::set<TPairKeyFrameID>::const_iterator it=kfs_with_modified_next_edge.begin();it!=kfs_with_modified_next_edge.end();++it)
-	{
-		const TKeyFrameID kf_id = it->first;
-		const std::map<TKeyFrameID,TSpanTreeEntry> & Ds = sym.next_edge[ kf_id ];  // O(1) in map_as_vector
-
-		std::map<TKeyFrameID,TSpanTreeEntry>::const_iterator it2=Ds.find(it->second);
-		ASSERT_(it2!=Ds.end())
-		
-
-		const TKeyFrameID dst_kf_id = it2->first;
-
-		const TKeyFrameID from = std::max(dst_kf_id, kf_id);
-		const TKeyFrameID to   = std::min(dst_kf_id, kf_id);
-
-		// find_path_bfs
-		typename kf2kf_pose_traits<KF2KF_POSE_TYPE>::k2k_edge_vector_t & path = sym.all_edges[from][to];  // O(1) in map_as_vector
-		path.clear();
-		bool path_found = m_parent->find_path_bfs(from,to, NULL, &path);
-		ASSERT_(path_found)
-	} // end for each "kfs_with_modified_next_edge"
-
+	// Only for those who were really modified, now or later on if the caller wants to do it once for several new edges:
+	if (!pending_paths)
+		update_symbolic_paths(kfs_with_modified_next_edge);
 
 #if defined(SYM_ST_EXTRA_SECURITY_CHECKS)
 	{
@@ -210,6 +191,27 @@ cout << "ST: New path ST["<<s<<"]["<<r<<"].N ="<<(ste_s2ik ? ste_s2ik->next : ne
 #endif
 }
 
+/** Rebuilds the shortest paths in "all_edges" for the given (max,min) pairs of KFs */
+template <class KF2KF_POSE_TYPE,class LM_TYPE,class OBS_TYPE,class RBA_OPTIONS>
+void TRBA_Problem_state<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::TSpanningTree::update_symbolic_paths(const std::set<TPairKeyFrameID> & kf_pairs)
+{
+	for (std::set<TPairKeyFrameID>::const_iterator it=kf_pairs.begin();it!=kf_pairs.end();++it)
+	{
+		const TKeyFrameID from = it->first;
+		const TKeyFrameID to   = it->second;
+		ASSERTDEB_(from>to)
+
+		// find_path_bfs
+		typename kf2kf_pose_traits<KF2KF_POSE_TYPE>::k2k_edge_vector_t & path = sym.all_edges[from][to];  // O(1) in map_as_vector
+		path.clear();
+		bool path_found = m_parent->find_path_bfs(from,to, NULL, &path);
+		ASSERT_(path_found)
+
+		// Its numeric pose (if already computed) is now outdated:
+		num.mark_outdated(from,to);
+	}
+}
+
 template <class k2k_edge_t>
 struct TBFSEntry
 {
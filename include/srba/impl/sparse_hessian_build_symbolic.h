@@ -41,7 +41,7 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::sparse_hessian_bui
 	for (size_t i=0;i<nUnknowns_k2k;i++)
 	{
 		const JACOB_COLUMN_dh_dAp & col_i = *dh_dAp[i];
-		ASSERT_(!col_i.empty()) // I guess this shouldn't happen...
+		// The column is empty for edges constrained only by a prior (see k2k_prior_t): the diagonal block is created anyway, below.
 
 		// j=i
 		// -----
@@ -66,7 +66,6 @@ void RbaEngine<KF2KF_POSE_TYPE,LM_TYPE,OBS_TYPE,RBA_OPTIONS>::sparse_hessian_bui
 		for (size_t j=i+1;j<nUnknowns_k2k;j++)
 		{
 			const JACOB_COLUMN_dh_dAp & col_j = *dh_dAp[j];
-			ASSERTMSG_(!col_j.empty(),mrpt::format("col_j,i=%u,j=%u empty (nUnknowns_k2k=%u)!",static_cast<unsigned int>(i),static_cast<unsigned int>(j),static_cast<unsigned int>(nUnknowns_k2k))) // I guess this shouldn't happen...
 
 			// code below based on "std::set_intersection"
 			typename JACOB_COLUMN_dh_dAp::const_iterator it_i = col_i.begin();
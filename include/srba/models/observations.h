@@ -11,6 +11,7 @@
 
 #include <mrpt/utils/TCamera.h>
 #include <mrpt/utils/TStereoCamera.h>
+#include <mrpt/poses/CPose3D.h>
 
 namespace srba {
 namespace observations {
@@ -37,6 +38,12 @@ namespace observations {
 				obs[0] = px.x;
 				obs[1] = px.y;
 			}
+			/** Inverse of getAsArray(): rebuilds this observation from a plain array of its parameters */
+			template <class ARRAY>
+			inline void setFromArray(const ARRAY &obs) {
+				px.x = obs[0];
+				px.y = obs[1];
+			}
 		};
 
 		/** The type "TObservationParams" must be declared in each "observations::TYPE" to 
@@ -65,6 +72,12 @@ namespace observations {
 				obs[0] = left_px.x;  obs[1] = left_px.y;
 				obs[2] = right_px.x; obs[3] = right_px.y;
 			}
+			/** Inverse of getAsArray(): rebuilds this observation from a plain array of its parameters */
+			template <class ARRAY>
+			inline void setFromArray(const ARRAY &obs) {
+				left_px.x = obs[0];  left_px.y = obs[1];
+				right_px.x = obs[2]; right_px.y = obs[3];
+			}
 		};
 
 		/** The type "TObservationParams" must be declared in each "observations::TYPE" to 
@@ -92,6 +105,11 @@ namespace observations {
 			inline void getAsArray(ARRAY &obs) const {
 				obs[0] = pt.x; obs[1] = pt.y; obs[2] = pt.z; 
 			}
+			/** Inverse of getAsArray(): rebuilds this observation from a plain array of its parameters */
+			template <class ARRAY>
+			inline void setFromArray(const ARRAY &obs) {
+				pt.x = obs[0]; pt.y = obs[1]; pt.z = obs[2];
+			}
 		};
 
 		/** The type "TObservationParams" must be declared in each "observations::TYPE" to 
@@ -119,6 +137,11 @@ namespace observations {
 			inline void getAsArray(ARRAY &obs) const {
 				obs[0] = pt.x; obs[1] = pt.y;
 			}
+			/** Inverse of getAsArray(): rebuilds this observation from a plain array of its parameters */
+			template <class ARRAY>
+			inline void setFromArray(const ARRAY &obs) {
+				pt.x = obs[0]; pt.y = obs[1];
+			}
 		};
 
 		/** The type "TObservationParams" must be declared in each "observations::TYPE" to 
@@ -148,6 +171,11 @@ namespace observations {
 			inline void getAsArray(ARRAY &obs) const {
 				obs[0] = range; obs[1] = yaw; obs[2] = pitch; 
 			}
+			/** Inverse of getAsArray(): rebuilds this observation from a plain array of its parameters */
+			template <class ARRAY>
+			inline void setFromArray(const ARRAY &obs) {
+				range = obs[0]; yaw = obs[1]; pitch = obs[2];
+			}
 		};
 
 		/** The type "TObservationParams" must be declared in each "observations::TYPE" to 
@@ -176,6 +204,11 @@ namespace observations {
 			inline void getAsArray(ARRAY &obs) const {
 				obs[0] = range; obs[1] = yaw;
 			}
+			/** Inverse of getAsArray(): rebuilds this observation from a plain array of its parameters */
+			template <class ARRAY>
+			inline void setFromArray(const ARRAY &obs) {
+				range = obs[0]; yaw = obs[1];
+			}
 		};
 
 		/** The type "TObservationParams" must be declared in each "observations::TYPE" to 
@@ -204,6 +237,11 @@ namespace observations {
 			inline void getAsArray(ARRAY &obs) const {
 				obs[0]=x; obs[1]=y; obs[2]=yaw;
 			}
+			/** Inverse of getAsArray(): rebuilds this observation from a plain array of its parameters */
+			template <class ARRAY>
+			inline void setFromArray(const ARRAY &obs) {
+				x=obs[0]; y=obs[1]; yaw=obs[2];
+			}
 		};
 
 		/** The type "TObservationParams" must be declared in each "observations::TYPE" to 
@@ -233,6 +271,12 @@ namespace observations {
 				obs[0]=x; obs[1]=y; obs[2]=z; 
 				obs[3]=yaw; obs[4]=pitch; obs[5]=roll;
 			}
+			/** Inverse of getAsArray(): rebuilds this observation from a plain array of its parameters */
+			template <class ARRAY>
+			inline void setFromArray(const ARRAY &obs) {
+				x=obs[0]; y=obs[1]; z=obs[2];
+				yaw=obs[3]; pitch=obs[4]; roll=obs[5];
+			}
 		};
 
 		/** The type "TObservationParams" must be declared in each "observations::TYPE" to 
@@ -245,6 +289,82 @@ namespace observations {
 
 	// -------------------------------------------------------------------------------------------------
 
+	/** Observation = one observation from any of two different sensors of the same rig (e.g. a stereo camera and a 3D LiDAR),
+	  *  so all of them share the keyframes, the spanning trees and one joint optimization in a single RbaEngine.
+	  *  Nest this type to handle more than two sensors, e.g. MultiSensor<StereoCamera,MultiSensor<RangeBearing_3D,Cartesian_3D> >.
+	  *
+	  * Observations are stored as fixed-size arrays of OBS_DIMS = max(dims of A, dims of B)+1 values: the sub-observation,
+	  *  padded with zeros, and the index of the sensor (0:A, 1:B) in the last element. The residuals of the padding and of
+	  *  the sensor index are always zero, so they don't contribute to the Hessian.
+	  *
+	  * 
+ote Each sub-observation residual is whitened by its own std. deviation (TObservationParams::std_noise_a, std_noise_b)
+	  *  in the sensor model, hence use observation_noise_identity with std_noise_observations=1 for these observations.
+	  * \sa sensor_model<landmarks::Euclidean3D,MultiSensor<OBS_A,OBS_B> >
+	  */
+	template <class OBS_A, class OBS_B>
+	struct MultiSensor
+	{
+		static const size_t  MAX_SUB_DIMS = OBS_A::OBS_DIMS>OBS_B::OBS_DIMS ? OBS_A::OBS_DIMS : OBS_B::OBS_DIMS;
+		static const size_t  OBS_DIMS = MAX_SUB_DIMS+1; //!< The largest sub-observation, plus the sensor index
+
+		/** The observation-specific data structure */
+		struct obs_data_t
+		{
+			obs_data_t() : sensor(0) {}
+
+			unsigned int                  sensor; //!< Which sensor made this observation: 0 for \a a, 1 for \a b
+			typename OBS_A::obs_data_t    a;      //!< The observation, if sensor==0
+			typename OBS_B::obs_data_t    b;      //!< The observation, if sensor==1
+
+			/** Converts this observation into a plain array of its parameters */
+			template <class ARRAY>
+			inline void getAsArray(ARRAY &obs) const {
+				for (size_t i=0;i<MAX_SUB_DIMS;i++) obs[i] = 0;
+				if (sensor==0) {
+					typename observation_traits<OBS_A>::array_obs_t  sub;
+					a.getAsArray(sub);
+					for (size_t i=0;i<OBS_A::OBS_DIMS;i++) obs[i] = sub[i];
+				}
+				else {
+					typename observation_traits<OBS_B>::array_obs_t  sub;
+					b.getAsArray(sub);
+					for (size_t i=0;i<OBS_B::OBS_DIMS;i++) obs[i] = sub[i];
+				}
+				obs[MAX_SUB_DIMS] = sensor;
+			}
+			/** Inverse of getAsArray(): rebuilds this observation from a plain array of its parameters */
+			template <class ARRAY>
+			inline void setFromArray(const ARRAY &obs) {
+				sensor = obs[MAX_SUB_DIMS]!=0 ? 1:0;
+				if (sensor==0) {
+					typename observation_traits<OBS_A>::array_obs_t  sub;
+					for (size_t i=0;i<OBS_A::OBS_DIMS;i++) sub[i] = obs[i];
+					a.setFromArray(sub);
+				}
+				else {
+					typename observation_traits<OBS_B>::array_obs_t  sub;
+					for (size_t i=0;i<OBS_B::OBS_DIMS;i++) sub[i] = obs[i];
+					b.setFromArray(sub);
+				}
+			}
+		};
+
+		/** The type "TObservationParams" must be declared in each "observations::TYPE" to 
+		  *  hold sensor-specific parameters, etc. needed in the sensor model. */
+		struct TObservationParams
+		{
+			TObservationParams() : std_noise_a(1.0), std_noise_b(1.0) {}
+
+			typename OBS_A::TObservationParams  a;  //!< Parameters of the sensor model of \a a
+			typename OBS_B::TObservationParams  b;  //!< Parameters of the sensor model of \a b
+			double  std_noise_a, std_noise_b;       //!< Std. deviation of the observations of each sensor, in their own units (Default=1)
+			mrpt::poses::CPose3D  sensor_pose_a, sensor_pose_b; //!< Pose of each sensor wrt the frame of the observations of the RBA engine, i.e. the rig (Default=origin)
+		};
+	};
+
+	// -------------------------------------------------------------------------------------------------
+
 	/** @} */
 
 }
@@ -547,20 +547,12 @@ namespace srba {
 			const landmark_traits<LANDMARK_T>::array_landmark_t & lm_pos,
 			const OBS_T::TObservationParams                     & params)
 		{
-			mrpt::math::TPoint3D  l; // wrt sensor (local coords)
-			base_pose_wrt_observer.composePoint(lm_pos[0],lm_pos[1],lm_pos[2], l.x,l.y,l.z);
-			
-			static const mrpt::poses::CPose3D origin;
-			double range,yaw,pitch;
-			origin.sphericalCoordinates(
-				l,  // In: point
-				range,yaw,pitch // Out: spherical coords							
-				);
+			MRPT_UNUSED_PARAM(params);
+			double x,y,z; // wrt sensor (local coords)
+			base_pose_wrt_observer.composePoint(lm_pos[0],lm_pos[1],lm_pos[2], x,y,z);
 
 			observation_traits<OBS_T>::array_obs_t  pred_obs;  // prediction
-			pred_obs[0] = range;
-			pred_obs[1] = yaw;
-			pred_obs[2] = pitch;
+			predict(x,y,z, pred_obs);
 			out_obs_err = z_obs - pred_obs;
 		}
 
@@ -588,21 +580,35 @@ namespace srba {
 		{
 			MRPT_UNUSED_PARAM(sensor_params);
 			// xji_l[0:2]=[X Y Z]
-			mrpt::math::CMatrixDouble33 dh_dx_(mrpt::math::UNINITIALIZED_MATRIX);
-
-			static const mrpt::poses::CPose3DQuat origin;
-			double range,yaw,pitch;
-			origin.sphericalCoordinates(
-				mrpt::math::TPoint3D(xji_l[0],xji_l[1],xji_l[2]),  // In: point
-				range,yaw,pitch, // Out: spherical coords
-				&dh_dx_,   // dh_dx
-				NULL       // dh_dp (not needed)
-				);
-
-			dh_dx = dh_dx_;
+			const double x = xji_l[0], y = xji_l[1], z = xji_l[2];
+			const double rho2 = x*x+y*y;  // Squared distance to the Z axis
+			const double r2   = rho2+z*z;
+			if (rho2<=0)
+				return false; // Yaw is undefined along the Z axis
+
+			const double rho = std::sqrt(rho2), r = std::sqrt(r2);
+			const double r_inv = 1.0/r, rho2_inv = 1.0/rho2, k = z/(rho*r2);
+
+			// d(range)/d(x,y,z):
+			dh_dx(0,0) = x*r_inv;  dh_dx(0,1) = y*r_inv;  dh_dx(0,2) = z*r_inv;
+			// d(yaw)/d(x,y,z), with yaw=atan2(y,x):
+			dh_dx(1,0) = -y*rho2_inv;  dh_dx(1,1) = x*rho2_inv;  dh_dx(1,2) = 0;
+			// d(pitch)/d(x,y,z), with pitch=-atan2(z,rho):
+			dh_dx(2,0) = x*k;  dh_dx(2,1) = y*k;  dh_dx(2,2) = -rho/r2;
 			return true;
 		}
 
+		/** Closed-form (range,yaw,pitch) of a point given in sensor local coordinates, with the same conventions than 
+		  * mrpt::poses::CPose3D::sphericalCoordinates() (pitch is positive for points below the XY plane). */
+		template <class ARRAY>
+		static inline void predict(const double x, const double y, const double z, ARRAY &pred_obs)
+		{
+			const double rho2 = x*x+y*y;
+			pred_obs[0] = std::sqrt(rho2+z*z);
+			pred_obs[1] = (x==0 && y==0) ? 0.0 : std::atan2(y,x);
+			pred_obs[2] = -std::atan2(z,std::sqrt(rho2));
+		}
+
 		/** Inverse observation model for first-seen landmarks. Needed to avoid having landmarks at (0,0,0) which 
 		  *  leads to undefined Jacobians. This is invoked only when both "unknown_relative_position_init_val" and "is_fixed" are "false" 
 		  *  in an observation. 
@@ -930,6 +936,206 @@ namespace srba {
 
 	// -------------------------------------------------------------------------------------------------------------
 
+	/** Sensor model: 3D landmarks in Euclidean coordinates + observations from any of two sensors of a rig, each one at
+	  *  its own pose on the rig (see observations::MultiSensor). Each observation is evaluated with the sensor model of its own type
+	  *  (sensor_model<landmarks::Euclidean3D,OBS_A> or sensor_model<landmarks::Euclidean3D,OBS_B>), and its residual
+	  *  and Jacobian are whitened with the std. deviation of that sensor, so all observations feed one joint optimization.
+	  *  The numeric Jacobian fallback is only allowed if both sensor models allow it (see internal::sensor_allows_numeric_jacob_fallback).
+	  */
+	template <class OBS_A, class OBS_B>
+	struct sensor_model<landmarks::Euclidean3D,observations::MultiSensor<OBS_A,OBS_B> >
+	{
+		// --------------------------------------------------------------------------------
+		// Typedefs for the sake of generality in the signature of methods below:
+		//   *DONT FORGET* to change these when writing new sensor models.
+		// --------------------------------------------------------------------------------
+		typedef observations::MultiSensor<OBS_A,OBS_B>  OBS_T;
+		typedef landmarks::Euclidean3D                  LANDMARK_T;
+		// --------------------------------------------------------------------------------
+
+		static const size_t OBS_DIMS = OBS_T::OBS_DIMS;
+		static const size_t LM_DIMS  = LANDMARK_T::LM_DIMS;
+		static const size_t SENSOR_IDX = OBS_T::MAX_SUB_DIMS; //!< The position of the sensor index in observation arrays
+
+		typedef Eigen::Matrix<double,OBS_DIMS,LM_DIMS>                 TJacobian_dh_dx;     //!< A Jacobian of the correct size for each dh_dx
+		typedef typename landmark_traits<LANDMARK_T>::array_landmark_t array_landmark_t;    //!< a 2D or 3D point
+		typedef typename observation_traits<OBS_T>::array_obs_t        array_obs_t;
+		typedef typename OBS_T::TObservationParams                     TObservationParams;
+
+		typedef sensor_model<LANDMARK_T,OBS_A>  sensor_model_a_t;
+		typedef sensor_model<LANDMARK_T,OBS_B>  sensor_model_b_t;
+
+		/** Executes the (negative) observation-error model: "-( h(lm_pos,pose) - z_obs)" 
+		  * \param[out] out_obs_err The output of the predicted sensor value
+		  * \param[in] z_obs The real observation, to be contrasted to the prediction of this sensor model
+		  * \param[in] base_pose_wrt_observer The relative pose of the observed landmark's base KF, wrt to the current sensor pose (which may be different than the observer KF pose if the sensor is not at the "robot origin").
+		  * \param[in] lm_pos The relative landmark position wrt its base KF.
+		  * \param[in] params The sensor-specific parameters.
+		  */
+		template <class POSE_T>
+		static void observe_error(
+			array_obs_t              & out_obs_err, 
+			const array_obs_t        & z_obs, 
+			const POSE_T             & base_pose_wrt_observer,
+			const array_landmark_t   & lm_pos,
+			const TObservationParams & params)
+		{
+			array_landmark_t x = lm_pos;  // wrt the rig
+			LANDMARK_T::composePosePoint(x, base_pose_wrt_observer);
+
+			out_obs_err.setZero(); // The padding and the sensor index
+			if (z_obs[SENSOR_IDX]==0)
+			     sub_observe_error<sensor_model_a_t>(out_obs_err,z_obs,x,params.sensor_pose_a,params.a,params.std_noise_a);
+			else sub_observe_error<sensor_model_b_t>(out_obs_err,z_obs,x,params.sensor_pose_b,params.b,params.std_noise_b);
+		}
+
+		/** Evaluates the partial Jacobian dh_dx:
+		  * \code
+		  *            d h(x')
+		  * dh_dx = -------------
+		  *             d x' 
+		  *
+		  * \endcode
+		  *  With: 
+		  *    - x' = x^{j,i}_l  The relative location of the observed landmark wrt to the robot/camera at the instant of observation. (See notation on papers)
+		  *    - h(x): Observation model: h(): landmark location --> observation
+		  * 
+		  * Unlike other sensor models, the Jacobian depends on which sensor made the observation, hence the extra argument \a z_obs
+		  *  (see internal::sensor_jacob_dh_dx<>).
+		  *
+		  * \param[out] dh_dx The output matrix Jacobian. Values at input are undefined (i.e. they cannot be asssumed to be zeros by default).
+		  * \param[in]  xji_l The relative location of the observed landmark wrt to the robot/camera at the instant of observation.
+		  * \param[in]  z_obs The real observation.
+		  * \param[in] sensor_params Sensor-specific parameters, as set by the user.
+		  *
+		  * \return true if the Jacobian is well-defined, false to mark it as ill-defined and ignore it during this step of the optimization
+		  */
+		static bool eval_jacob_dh_dx(
+			TJacobian_dh_dx          & dh_dx,
+			const array_landmark_t   & xji_l, 
+			const array_obs_t        & z_obs,
+			const TObservationParams & sensor_params)
+		{
+			dh_dx.setZero(); // The padding and the sensor index
+			if (z_obs[SENSOR_IDX]==0)
+			     return sub_eval_jacob_dh_dx<sensor_model_a_t>(dh_dx,xji_l,z_obs,sensor_params.sensor_pose_a,sensor_params.a,sensor_params.std_noise_a);
+			else return sub_eval_jacob_dh_dx<sensor_model_b_t>(dh_dx,xji_l,z_obs,sensor_params.sensor_pose_b,sensor_params.b,sensor_params.std_noise_b);
+		}
+
+		/** Inverse observation model for first-seen landmarks. Needed to avoid having landmarks at (0,0,0) which 
+		  *  leads to undefined Jacobians. This is invoked only when both "unknown_relative_position_init_val" and "is_fixed" are "false" 
+		  *  in an observation. 
+		  * The LM location must not be exact at all, just make sure it doesn't have an undefined Jacobian.
+		  *
+		  * \param[out] out_lm_pos The relative landmark position wrt the current observing KF.
+		  * \param[in]  obs The observation itself.
+		  * \param[in]   params The sensor-specific parameters.
+		  */
+		static void inverse_sensor_model(
+			array_landmark_t                                       & out_lm_pos,
+			const typename observation_traits<OBS_T>::obs_data_t   & obs, 
+			const TObservationParams                               & params)
+		{
+			// Wrt the sensor, then wrt the rig:
+			if (obs.sensor==0)
+			{
+				sensor_model_a_t::inverse_sensor_model(out_lm_pos,obs.a,params.a);
+				LANDMARK_T::composePosePoint(out_lm_pos, params.sensor_pose_a);
+			}
+			else
+			{
+				sensor_model_b_t::inverse_sensor_model(out_lm_pos,obs.b,params.b);
+				LANDMARK_T::composePosePoint(out_lm_pos, params.sensor_pose_b);
+			}
+		}
+
+	private:
+		/** The identity transformation, for evaluating the sub-models on points already relative to their sensor */
+		struct TIdentityPose
+		{
+			inline void composePoint(const double lx,const double ly,const double lz, double &gx,double &gy,double &gz) const {
+				gx=lx; gy=ly; gz=lz;
+			}
+		};
+
+		template <class SUB_MODEL>
+		static void sub_observe_error(
+			array_obs_t              & out_obs_err, 
+			const array_obs_t        & z_obs, 
+			const array_landmark_t   & x_wrt_rig,
+			const mrpt::poses::CPose3D & sensor_pose,
+			const typename SUB_MODEL::TObservationParams & sub_params,
+			const double std_noise)
+		{
+			typename observation_traits<typename SUB_MODEL::OBS_T>::array_obs_t  sub_z, sub_err;
+			for (size_t i=0;i<SUB_MODEL::OBS_DIMS;i++) sub_z[i] = z_obs[i];
+
+			array_landmark_t x;  // wrt the sensor
+			LANDMARK_T::inverseComposePosePoint(x_wrt_rig, x, sensor_pose);
+
+			SUB_MODEL::observe_error(sub_err,sub_z,TIdentityPose(),x,sub_params);
+			for (size_t i=0;i<SUB_MODEL::OBS_DIMS;i++) out_obs_err[i] = sub_err[i]/std_noise;
+		}
+
+		template <class SUB_MODEL>
+		static bool sub_eval_jacob_dh_dx(
+			TJacobian_dh_dx          & dh_dx,
+			const array_landmark_t   & xji_l,
+			const array_obs_t        & z_obs,
+			const mrpt::poses::CPose3D & sensor_pose,
+			const typename SUB_MODEL::TObservationParams & sub_params,
+			const double std_noise)
+		{
+			typename observation_traits<typename SUB_MODEL::OBS_T>::array_obs_t  sub_z;
+			for (size_t i=0;i<SUB_MODEL::OBS_DIMS;i++) sub_z[i] = z_obs[i];
+
+			array_landmark_t x;  // wrt the sensor: x = R^t * (xji_l - t)
+			LANDMARK_T::inverseComposePosePoint(xji_l, x, sensor_pose);
+
+			typename SUB_MODEL::TJacobian_dh_dx  sub_dh_dx;
+			if (!internal::sensor_jacob_dh_dx<SUB_MODEL>::eval(sub_dh_dx,x,sub_z,sub_params))
+				return false;
+
+			// Chain rule: dh/dxji_l = dh/dx * dx/dxji_l = dh/dx * R^t
+			dh_dx.template block<SUB_MODEL::OBS_DIMS,LM_DIMS>(0,0) = sub_dh_dx * sensor_pose.getRotationMatrix().transpose() * (1.0/std_noise);
+			return true;
+		}
+
+	};  // end of struct sensor_model<landmarks::Euclidean3D,observations::MultiSensor<OBS_A,OBS_B> >
+
+	namespace internal {
+		/** The Jacobian of observations::MultiSensor depends on which sensor made each observation */
+		template <class OBS_A, class OBS_B>
+		struct sensor_jacob_dh_dx< sensor_model<landmarks::Euclidean3D,observations::MultiSensor<OBS_A,OBS_B> > >
+		{
+			typedef sensor_model<landmarks::Euclidean3D,observations::MultiSensor<OBS_A,OBS_B> > sensor_model_t;
+
+			template <class OBS_STORE_T>
+			static inline bool eval_at(typename sensor_model_t::TJacobian_dh_dx &dh_dx, const typename sensor_model_t::array_landmark_t &xji_l, const OBS_STORE_T &obs_store, const size_t obs_idx, const typename sensor_model_t::TObservationParams &params) {
+				typename sensor_model_t::array_obs_t  z_obs;
+				obs_store.get(obs_idx, z_obs);
+				return sensor_model_t::eval_jacob_dh_dx(dh_dx,xji_l,z_obs,params);
+			}
+			static inline bool eval(typename sensor_model_t::TJacobian_dh_dx &dh_dx, const typename sensor_model_t::array_landmark_t &xji_l, const typename sensor_model_t::array_obs_t &z_obs, const typename sensor_model_t::TObservationParams &params) {
+				return sensor_model_t::eval_jacob_dh_dx(dh_dx,xji_l,z_obs,params);
+			}
+		};
+
+		/** Cameras reject points behind them, where a numeric Jacobian of the projection would be meaningless */
+		template <> struct sensor_allows_numeric_jacob_fallback< sensor_model<landmarks::Euclidean3D,observations::MonocularCamera> > { static const bool value = false; };
+		template <> struct sensor_allows_numeric_jacob_fallback< sensor_model<landmarks::Euclidean3D,observations::StereoCamera> >    { static const bool value = false; };
+		/** observations::MultiSensor: only if both sensors allow it */
+		template <class OBS_A, class OBS_B>
+		struct sensor_allows_numeric_jacob_fallback< sensor_model<landmarks::Euclidean3D,observations::MultiSensor<OBS_A,OBS_B> > >
+		{
+			static const bool value =
+				sensor_allows_numeric_jacob_fallback< sensor_model<landmarks::Euclidean3D,OBS_A> >::value &&
+				sensor_allows_numeric_jacob_fallback< sensor_model<landmarks::Euclidean3D,OBS_B> >::value;
+		};
+	}
+
+	// -------------------------------------------------------------------------------------------------------------
+
 	/** @} */
 
 } // end NS
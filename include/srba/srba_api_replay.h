@@ -0,0 +1,223 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+/** \file srba_api_replay.h
+  * \brief Replays API logs recorded with RbaEngine::start_api_recording()
+  */
+
+#include <mrpt/utils/CFileGZInputStream.h>
+
+namespace srba
+{
+	/** Feeds an API log, recorded with RbaEngine::start_api_recording(), into a new RbaEngine.
+	  *
+	  * All the logged calls are repeated with exactly the same inputs and parameters.srba values, so a deterministic engine
+	  * reproduces the original results bit by bit: the summary of results logged for each call (IDs, number of observations and
+	  * initial/final squared errors) is compared against the replayed one, and differences are counted in get_num_mismatches().
+	  * This allows profiling (and validating optimizations of) real field sessions offline.
+	  *
+	  * Sensor, noise and edge creation policy parameters must be set by the user in the target engine before replaying, as in the original session.
+	  *
+	  * \tparam RBA_ENGINE The same RbaEngine<> type used to record the log.
+	  */
+	template <class RBA_ENGINE>
+	class RbaEngineApiReplayer
+	{
+	public:
+		typedef internal::api_log_io<RBA_ENGINE> api_log_io_t;
+		typedef typename api_log_io_t::TCallResult TCallResult;
+
+		RbaEngineApiReplayer() : m_num_calls(0), m_num_mismatches(0) {}
+
+		/** Opens an API log and reads its header.
+		  * \exception std::exception If the file can't be read, is not an API log or was recorded with a different RbaEngine type. */
+		void open(const std::string &log_file)
+		{
+			if (!m_in.open(log_file))
+				THROW_EXCEPTION_CUSTOM_MSG1("Error opening API log file: '%s'", log_file.c_str())
+			api_log_io_t::read_header(m_in, m_engine_type, m_user_data);
+			m_num_calls = m_num_mismatches = 0;
+			m_last_results.clear();
+		}
+
+		/** The user data passed to RbaEngine::start_api_recording() */
+		const std::string & get_user_data() const { return m_user_data; }
+		/** The (compiler-dependent) name of the RbaEngine type which recorded the log */
+		const std::string & get_recorded_engine_type() const { return m_engine_type; }
+
+		/** Replays the next logged call into \a rba. Its results are checked when reading the next record.
+		  * \return false at the end of the log. */
+		bool replay_next(RBA_ENGINE &rba)
+		{
+			for (;;)
+			{
+				uint8_t rec_type;
+				if (m_in.ReadBuffer(&rec_type,1)!=1)
+					return false; // EOF
+
+				switch (rec_type)
+				{
+				case internal::arParams:
+					api_log_io_t::read_params(m_in, rba.parameters.srba);
+					break;
+				case internal::arResult:
+					{
+						std::vector<TCallResult> res;
+						api_log_io_t::read_results(m_in, res);
+						if (res.size()!=m_last_results.size() || !std::equal(res.begin(),res.end(),m_last_results.begin()))
+							m_num_mismatches++;
+					}
+					break;
+				default:
+					replay_call(rec_type, rba);
+					m_num_calls++;
+					return true;
+				};
+			}
+		}
+
+		/** Replays all the remaining calls in the log. \return The number of replayed calls */
+		size_t replay_all(RBA_ENGINE &rba)
+		{
+			size_t n=0;
+			while (replay_next(rba))
+				n++;
+			return n;
+		}
+
+		size_t get_num_replayed_calls() const { return m_num_calls; } //!< Number of calls replayed since open()
+		size_t get_num_mismatches() const { return m_num_mismatches; } //!< Number of calls whose replayed results differ from the logged ones
+
+	private:
+		mrpt::utils::CFileGZInputStream  m_in;
+		std::string               m_engine_type, m_user_data;
+		size_t                    m_num_calls, m_num_mismatches;
+		std::vector<TCallResult>  m_last_results; //!< Results of the last replayed call
+
+		void replay_call(const uint8_t call_type, RBA_ENGINE &rba)
+		{
+			m_last_results.clear();
+			switch (call_type)
+			{
+			case internal::arClear:
+				rba.clear();
+				break;
+			case internal::arAllocKeyframe:
+				m_last_results.push_back( TCallResult( rba.alloc_keyframe() ) );
+				break;
+			case internal::arCreateKf2KfEdge:
+				{
+					uint64_t new_kf_id, from, to;
+					typename RBA_ENGINE::new_kf_observations_t obs;
+					typename RBA_ENGINE::pose_t init_inv_pose_val;
+					m_in >> new_kf_id >> from >> to;
+					api_log_io_t::read_observations(m_in, obs);
+					m_in >> init_inv_pose_val;
+					const size_t ed_id = rba.create_kf2kf_edge(static_cast<TKeyFrameID>(new_kf_id), TPairKeyFrameID(static_cast<TKeyFrameID>(from),static_cast<TKeyFrameID>(to)), obs, init_inv_pose_val);
+					m_last_results.push_back( TCallResult(ed_id) );
+				}
+				break;
+			case internal::arDefineNewKeyframe:
+				{
+					typename RBA_ENGINE::new_kf_observations_t obs;
+					bool run_local_optimization;
+					api_log_io_t::read_observations(m_in, obs);
+					m_in >> run_local_optimization;
+
+					typename RBA_ENGINE::TNewKeyFrameInfo new_kf_info;
+					rba.define_new_keyframe(obs, new_kf_info, run_local_optimization);
+					m_last_results.push_back( TCallResult(new_kf_info.kf_id, new_kf_info.optimize_results) );
+				}
+				break;
+			case internal::arDefineNewKeyframeWithPriors:
+				{
+					typename RBA_ENGINE::new_kf_observations_t obs;
+					typename RBA_ENGINE::k2k_priors_t priors;
+					bool run_local_optimization;
+					api_log_io_t::read_observations(m_in, obs);
+					api_log_io_t::read_priors(m_in, priors);
+					m_in >> run_local_optimization;
+
+					typename RBA_ENGINE::TNewKeyFrameInfo new_kf_info;
+					rba.define_new_keyframe(obs, priors, new_kf_info, run_local_optimization);
+					m_last_results.push_back( TCallResult(new_kf_info.kf_id, new_kf_info.optimize_results) );
+				}
+				break;
+			case internal::arDefineNewKeyframes:
+				{
+					uint64_t n;
+					bool run_local_optimization;
+					m_in >> n;
+					std::vector<typename RBA_ENGINE::new_kf_observations_t> obs_batch(static_cast<size_t>(n));
+					for (size_t i=0;i<obs_batch.size();i++)
+						api_log_io_t::read_observations(m_in, obs_batch[i]);
+					m_in >> run_local_optimization;
+
+					typename RBA_ENGINE::new_kf_info_vector_t new_kf_infos;
+					rba.define_new_keyframes(obs_batch, new_kf_infos, run_local_optimization);
+					for (size_t i=0;i<new_kf_infos.size();i++)
+						m_last_results.push_back( TCallResult(new_kf_infos[i].kf_id, new_kf_infos[i].optimize_results) );
+				}
+				break;
+			case internal::arOptimizeLocalArea:
+				{
+					TKeyFrameID root_id;
+					unsigned int win_size;
+					typename RBA_ENGINE::TOptimizeLocalAreaParams params;
+					std::vector<size_t> obs_idxs;
+					api_log_io_t::read_local_area(m_in, root_id, win_size, params);
+					api_log_io_t::read_indices(m_in, obs_idxs);
+
+					typename RBA_ENGINE::TOptimizeExtraOutputInfo out_info;
+					rba.optimize_local_area(root_id, win_size, out_info, params, obs_idxs);
+					m_last_results.push_back( TCallResult(root_id, out_info) );
+				}
+				break;
+			case internal::arOptimizeLocalAreas:
+				{
+					uint64_t n;
+					m_in >> n;
+					std::vector<typename RBA_ENGINE::TLocalAreaRequest> areas(static_cast<size_t>(n));
+					for (size_t i=0;i<areas.size();i++)
+						api_log_io_t::read_local_area(m_in, areas[i].root_id, areas[i].win_size, areas[i].params);
+
+					std::vector<typename RBA_ENGINE::TOptimizeExtraOutputInfo> out_infos;
+					rba.optimize_local_areas(areas, out_infos);
+					for (size_t i=0;i<areas.size();i++)
+						m_last_results.push_back( TCallResult(areas[i].root_id, out_infos[i]) );
+				}
+				break;
+			case internal::arRemoveObservation:
+				{
+					uint64_t kf_id, feat_id;
+					m_in >> kf_id >> feat_id;
+					const bool found = rba.remove_observation(static_cast<TKeyFrameID>(kf_id), static_cast<TLandmarkID>(feat_id));
+					m_last_results.push_back( TCallResult(found ? 1:0) );
+				}
+				break;
+			case internal::arRemoveLandmark:
+				{
+					uint64_t feat_id;
+					m_in >> feat_id;
+					const bool found = rba.remove_landmark(static_cast<TLandmarkID>(feat_id));
+					m_last_results.push_back( TCallResult(found ? 1:0) );
+				}
+				break;
+			case internal::arCompactObservations:
+				m_last_results.push_back( TCallResult( rba.compact_observations() ) );
+				break;
+			default:
+				THROW_EXCEPTION_CUSTOM_MSG1("Corrupted API log: unknown record type %u", static_cast<unsigned int>(call_type))
+			};
+		}
+	};
+
+} // end of namespace "srba"
@@ -0,0 +1,198 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mrpt/utils/CLoadableOptions.h>
+#include <mrpt/poses/CPose3D.h>
+#include "srba_types.h"
+#include <memory>  // For auto_ptr, unique_ptr
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+
+// Symbols of the precompiled library "srba-engines" (see src/CMakeLists.txt):
+#if defined(_WIN32) && defined(SRBA_ENGINES_SHARED_LIB)
+#	if defined(srba_engines_EXPORTS)
+#		define SRBA_ENGINES_IMPEXP __declspec(dllexport)
+#	else
+#		define SRBA_ENGINES_IMPEXP __declspec(dllimport)
+#	endif
+#else
+#	define SRBA_ENGINES_IMPEXP
+#endif
+
+namespace srba
+{
+	/** \defgroup mrpt_srba_facade Runtime-configurable, precompiled RBA engines
+	  *  RbaEngine<> is a header-only template, so choosing a problem type, solver or edge creation policy means recompiling.
+	  *  The library "srba-engines" explicitly instantiates the most common combinations, which are created at runtime from a
+	  *  TRbaEngineConfig (e.g. loaded from a config file) with create_rba_engine(), and used through the abstract IRbaEngine interface.
+	  *
+	  *  Each method of IRbaEngine is one virtual call which forwards to the wrapped RbaEngine<>: all the inner loops
+	  *  (Jacobians, Hessians, solvers,...) run in the statically-typed engine. The only overhead is copying the inputs and outputs
+	  *  of each call from/to the generic types below (e.g. observations as vectors of doubles).
+	  *
+	  *  Programs using these headers must link against the "srba-engines" library (see SRBA_ENGINES_LIBS in srba-config.cmake).
+	  * \ingroup mrpt_srba_grp */
+
+	/** The selection of an RbaEngine<> instance, by the names of its template arguments.
+	  * \sa create_rba_engine, get_available_rba_engines
+	  * \ingroup mrpt_srba_facade */
+	struct SRBA_ENGINES_IMPEXP TRbaEngineConfig : public mrpt::utils::CLoadableOptions
+	{
+		TRbaEngineConfig();
+
+		/** See docs of mrpt::utils::CLoadableOptions */
+		virtual void  loadFromConfigFile(const mrpt::utils::CConfigFileBase & source,const std::string & section);
+		/** See docs of mrpt::utils::CLoadableOptions */
+		virtual void  saveToConfigFile(mrpt::utils::CConfigFileBase &out,const std::string & section) const;
+
+		std::string  kf2kf_pose;   //!< One of kf2kf_poses::* (Default:"SE3")
+		std::string  landmark;     //!< One of landmarks::* (Default:"Euclidean3D")
+		std::string  observation;  //!< One of observations::* (Default:"Cartesian_3D")
+		std::string  solver;       //!< "LM_schur_dense_cholesky" (default), "LM_schur_sparse_cholesky" or "LM_no_schur_sparse_cholesky" (see options::solver_*)
+		std::string  ecp;          //!< The edge creation policy: "local_areas_fixed_size" (default) or "classic_linear_rba" (see ecps::*)
+
+		/** A human-readable description, e.g. "SE3/Euclidean3D/Cartesian_3D solver=LM_schur_dense_cholesky ecp=local_areas_fixed_size" */
+		std::string asString() const;
+	};
+
+	/** A type-erased RbaEngine::new_kf_observation_t \ingroup mrpt_srba_facade */
+	struct TGenericObservation
+	{
+		TGenericObservation() : feat_id(0), is_fixed(false), is_unknown_with_init_val(false) {}
+
+		TLandmarkID          feat_id;   //!< Observed what
+		std::vector<double>  obs_data;  //!< The IRbaEngine::get_obs_dims() parameters of the observation, in the order of observations::TYPE::obs_data_t::getAsArray()
+		bool                 is_fixed;  //!< See RbaEngine::new_kf_observation_t
+		bool                 is_unknown_with_init_val; //!< See RbaEngine::new_kf_observation_t
+		std::vector<double>  feat_rel_pos;  //!< IRbaEngine::get_landmark_dims() values, only used if \a is_fixed or \a is_unknown_with_init_val are true
+	};
+	typedef std::vector<TGenericObservation> generic_observations_t; //!< All the observations from a new KF \ingroup mrpt_srba_facade
+
+	/** A type-erased RbaEngine::TOptimizeExtraOutputInfo, without the solver-specific results \ingroup mrpt_srba_facade */
+	struct TGenericOptimizeInfo
+	{
+		TGenericOptimizeInfo() { clear(); }
+
+		size_t  num_observations;
+		size_t  num_jacobians;
+		size_t  num_kf2kf_edges_optimized;
+		size_t  num_kf2lm_edges_optimized;
+		size_t  num_total_scalar_optimized;
+		size_t  num_span_tree_numeric_updates;
+		double  obs_rmse;
+		double  total_sqr_error_init, total_sqr_error_final;
+		std::vector<size_t> optimized_k2k_edge_indices;
+		std::vector<size_t> optimized_landmark_indices;
+
+		void clear()
+		{
+			num_observations = num_jacobians = num_kf2kf_edges_optimized = num_kf2lm_edges_optimized = num_total_scalar_optimized = num_span_tree_numeric_updates = 0;
+			obs_rmse = total_sqr_error_init = total_sqr_error_final = 0.;
+			optimized_k2k_edge_indices.clear();
+			optimized_landmark_indices.clear();
+		}
+	};
+
+	/** A type-erased RbaEngine::TNewKeyFrameInfo \ingroup mrpt_srba_facade */
+	struct TGenericNewKeyFrameInfo
+	{
+		TKeyFrameID                kf_id;             //!< The ID of the newly created KF.
+		std::vector<TNewEdgeInfo>  created_edge_ids;  //!< The newly created edges (minimum: 1 edge)
+		TGenericOptimizeInfo       optimize_results;  //!< Results from the least-squares optimization
+	};
+
+	/** The abstract interface of all precompiled RbaEngine<> instances. Relative poses are always returned as CPose3D (SE(2) poses are
+	  *  converted), and landmark positions and observations as plain vectors of their parameters.
+	  * \sa create_rba_engine, RbaEngine
+	  * \ingroup mrpt_srba_facade */
+	class IRbaEngine
+	{
+	public:
+		virtual ~IRbaEngine() {}
+
+		/** The configuration used to create this engine */
+		virtual const TRbaEngineConfig & get_config() const = 0;
+
+		virtual size_t get_kf2kf_pose_dims() const = 0; //!< kf2kf_pose_t::REL_POSE_DIMS
+		virtual size_t get_landmark_dims() const = 0;   //!< landmark_t::LM_DIMS
+		virtual size_t get_obs_dims() const = 0;        //!< obs_t::OBS_DIMS
+
+		/** See RbaEngine::define_new_keyframe() \exception std::exception If an observation or landmark position has the wrong length */
+		virtual void define_new_keyframe(
+			const generic_observations_t & obs,
+			TGenericNewKeyFrameInfo      & out_new_kf_info,
+			const bool                     run_local_optimization = true ) = 0;
+
+		/** See RbaEngine::optimize_local_area(), with the default TOptimizeLocalAreaParams */
+		virtual void optimize_local_area(
+			const TKeyFrameID      root_id,
+			const unsigned int     win_size,
+			TGenericOptimizeInfo & out_info ) = 0;
+
+		virtual bool remove_observation(const TKeyFrameID observing_kf_id, const TLandmarkID feat_id) = 0; //!< See RbaEngine::remove_observation()
+		virtual bool remove_landmark(const TLandmarkID feat_id) = 0; //!< See RbaEngine::remove_landmark()
+
+		virtual double eval_overall_squared_error() const = 0; //!< See RbaEngine::eval_overall_squared_error()
+
+		virtual size_t get_num_keyframes() const = 0;
+		virtual size_t get_num_kf2kf_edges() const = 0;
+		/** Returns one kf2kf edge, with \a inv_pose the pose of \a from as seen from \a to (see k2k_edge_t) */
+		virtual void get_kf2kf_edge(const size_t edge_id, TKeyFrameID &from, TKeyFrameID &to, mrpt::poses::CPose3D &inv_pose) const = 0;
+
+		/** The relative position of a landmark (known or unknown) wrt its base KF \return false if there's no such landmark */
+		virtual bool get_landmark_rel_pos(const TLandmarkID feat_id, TKeyFrameID &base_kf_id, std::vector<double> &pos) const = 0;
+
+		/** See RbaEngine::create_complete_spanning_tree(): the poses of all KFs up to \a max_depth from \a root_id, relative to it */
+		virtual void get_relative_poses(
+			const TKeyFrameID root_id,
+			std::map<TKeyFrameID,mrpt::poses::CPose3D> & out_poses,
+			const size_t max_depth = std::numeric_limits<size_t>::max() ) const = 0;
+
+		/** Loads all the parameters of the engine from these sections of a config file (missing values are left unchanged):
+		  *  - [srba]: RbaEngine::TSRBAParameters
+		  *  - [ecp]: the parameters of the edge creation policy
+		  *  - [obs_noise]: "std_noise_observations", for options::observation_noise_identity
+		  *  - [sensor_pose]: "relative_pose", as "[x y z yaw pitch roll]" (angles in degrees), for options::sensor_pose_on_robot_se3
+		  *  - [CAMERA]: the camera calibration, for observations::MonocularCamera and observations::StereoCamera
+		  *  - [cost_model]: the coefficients of TOptimizationCostModel, as calibrated with TOptimizationCostModel::fit()
+		  */
+		virtual void load_parameters(const mrpt::utils::CConfigFileBase & source) = 0;
+		/** Saves all the parameters with the same layout than load_parameters() */
+		virtual void save_parameters(mrpt::utils::CConfigFileBase & out) const = 0;
+
+		virtual void clear() = 0;  //!< See RbaEngine::clear()
+		virtual void setVerbosityLevel(int level) = 0;  //!< See RbaEngine::setVerbosityLevel()
+		virtual void enable_time_profiler(bool enable=true) = 0;  //!< See RbaEngine::enable_time_profiler()
+		virtual bool save_graph_as_dot(const std::string &targetFileName, const bool all_landmarks = false) const = 0; //!< See RbaEngine::save_graph_as_dot()
+
+		virtual void start_api_recording(const std::string &log_file, const std::string &user_data = std::string()) = 0; //!< See RbaEngine::start_api_recording()
+		virtual void stop_api_recording() = 0; //!< See RbaEngine::stop_api_recording()
+	};
+
+#if MRPT_HAS_CXX11
+	typedef std::unique_ptr<IRbaEngine> IRbaEnginePtr;
+#else
+	typedef std::auto_ptr<IRbaEngine> IRbaEnginePtr;
+#endif
+
+	/** Creates a new, empty engine for the given problem type, solver and edge creation policy.
+	  * \exception std::exception If that combination is not precompiled in the library (see get_available_rba_engines())
+	  * \ingroup mrpt_srba_facade */
+	SRBA_ENGINES_IMPEXP IRbaEnginePtr create_rba_engine(const TRbaEngineConfig &cfg);
+
+	/** Returns the problem types (kf2kf_pose, landmark, observation) precompiled in the library. Each of them is available with all
+	  *  the solvers and edge creation policies listed in TRbaEngineConfig.
+	  * \ingroup mrpt_srba_facade */
+	SRBA_ENGINES_IMPEXP void get_available_rba_engines(std::vector<TRbaEngineConfig> &out_problems);
+
+} // end NS
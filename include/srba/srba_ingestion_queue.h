@@ -0,0 +1,196 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+/** \file srba_ingestion_queue.h
+  * \brief Optional multi-producer front door for feeding new keyframes into one RbaEngine from several threads (requires C++11)
+  */
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+namespace srba
+{
+	/** A lock-free, multiple-producer/single-consumer (MPSC) queue of pending keyframes for an RbaEngine.
+	  *
+	  * RbaEngine is not thread-safe. Instead of wrapping all calls in a mutex (which blocks sensor threads during whole optimizations),
+	  * any number of producer threads can call submit(), which never blocks, while one single "engine thread" owns the RbaEngine
+	  * and periodically calls process_pending() to run define_new_keyframe() for all the queued submissions.
+	  *
+	  * Each submission returns a handle (a std::future) which becomes ready with the resulting TNewKeyFrameInfo (or with the exception thrown
+	  * while processing it) once the engine thread has processed it.
+	  *
+	  * Ordering: all the submissions pending at each call to process_pending() are processed in ascending order of their user-provided
+	  * \a timestamp (ties are kept in submission order). Keyframe IDs are assigned in that processing order.
+	  *
+	  * Implementation: an intrusive MPSC list (D. Vyukov's design): producers do one atomic exchange; the consumer never waits on producers.
+	  *
+	  * \tparam RBA_ENGINE Any RbaEngine<> type.
+	  */
+	template <class RBA_ENGINE>
+	class RbaEngineIngestionQueue
+	{
+	public:
+		typedef typename RBA_ENGINE::new_kf_observations_t  new_kf_observations_t;
+		typedef typename RBA_ENGINE::TNewKeyFrameInfo       TNewKeyFrameInfo;
+		typedef std::future<TNewKeyFrameInfo>               handle_t; //!< The result of one submission, ready after the engine thread processed it
+
+		RbaEngineIngestionQueue() : m_head(&m_stub), m_tail(&m_stub), m_seq(0)
+		{
+			m_stub.next.store(NULL, std::memory_order_relaxed);
+		}
+
+		~RbaEngineIngestionQueue()
+		{
+			// Free (unprocessed) pending nodes:
+			TNode *n = m_tail;
+			while (n)
+			{
+				TNode *next = n->next.load(std::memory_order_acquire);
+				if (n!=&m_stub) delete n;
+				n = next;
+			}
+			for (size_t i=0;i<m_pending.size();i++)
+				delete m_pending[i];
+		}
+
+		/** Enqueues a new keyframe. Can be called from any thread. Lock-free, never blocks on the engine thread.
+		  * \param[in] obs The observations of the new KF (moved into the queue).
+		  * \param[in] timestamp Any monotonic user time (e.g. sensor timestamp), used to order submissions of different producers.
+		  * \param[in] run_local_optimization Passed to RbaEngine::define_new_keyframe()
+		  */
+		handle_t submit(new_kf_observations_t && obs, const double timestamp, const bool run_local_optimization = true)
+		{
+			TNode *n = new TNode();
+			n->obs.swap(obs);
+			n->timestamp = timestamp;
+			n->seq = m_seq.fetch_add(1, std::memory_order_relaxed);
+			n->run_local_optimization = run_local_optimization;
+			handle_t h = n->result.get_future();
+			push(n);
+			return h;
+		}
+
+		/** \overload (copies the observations) */
+		handle_t submit(const new_kf_observations_t & obs, const double timestamp, const bool run_local_optimization = true)
+		{
+			new_kf_observations_t obs_copy(obs);
+			return submit(std::move(obs_copy), timestamp, run_local_optimization);
+		}
+
+		/** To be called ONLY from the thread which owns \a rba: runs define_new_keyframe() for the pending submissions, in timestamp order.
+		  * \param[in] max_kfs Maximum number of KFs to process in this call (the rest, with the newest timestamps, remain queued).
+		  * \return The number of processed KFs.
+		  */
+		size_t process_pending(RBA_ENGINE &rba, const size_t max_kfs = std::numeric_limits<size_t>::max())
+		{
+			// Drain everything published so far, then sort:
+			for (TNode *n = pop(); n!=NULL; n = pop())
+				m_pending.push_back(n);
+			if (m_pending.empty())
+				return 0;
+
+			std::sort(m_pending.begin(),m_pending.end(), TNodeOrder());
+
+			const size_t nProc = std::min(max_kfs, m_pending.size());
+			for (size_t i=0;i<nProc;i++)
+			{
+				TNode *n = m_pending[i];
+				try
+				{
+					TNewKeyFrameInfo  new_kf_info;
+					rba.define_new_keyframe(n->obs, new_kf_info, n->run_local_optimization);
+					n->result.set_value(new_kf_info);
+				}
+				catch (...)
+				{
+					n->result.set_exception(std::current_exception());
+				}
+				delete n;
+			}
+			m_pending.erase(m_pending.begin(), m_pending.begin()+nProc);
+			return nProc;
+		}
+
+		/** Returns true if there are no submissions waiting to be processed. Only reliable from the engine thread. */
+		bool empty() const {
+			return m_pending.empty() && m_tail==&m_stub && m_stub.next.load(std::memory_order_acquire)==NULL;
+		}
+
+	private:
+		struct TNode
+		{
+			std::atomic<TNode*>   next;
+			new_kf_observations_t obs;
+			double                timestamp;
+			uint64_t              seq;       //!< Submission order, to break ties in timestamps
+			bool                  run_local_optimization;
+			std::promise<TNewKeyFrameInfo> result;
+
+			TNode() : next(NULL), timestamp(0), seq(0), run_local_optimization(true) {}
+		};
+
+		struct TNodeOrder
+		{
+			bool operator()(const TNode *a, const TNode *b) const {
+				return a->timestamp<b->timestamp || (a->timestamp==b->timestamp && a->seq<b->seq);
+			}
+		};
+
+		/** Producers: O(1), one atomic exchange */
+		void push(TNode *n)
+		{
+			n->next.store(NULL, std::memory_order_relaxed);
+			TNode *prev = m_head.exchange(n, std::memory_order_acq_rel);
+			prev->next.store(n, std::memory_order_release); // Publish
+		}
+
+		/** Consumer only: returns NULL if empty, or if a producer is just in the middle of a push() (it'll be seen in the next call). */
+		TNode * pop()
+		{
+			TNode *tail = m_tail;
+			TNode *next = tail->next.load(std::memory_order_acquire);
+			if (tail==&m_stub)
+			{
+				if (!next) return NULL;
+				m_tail = next;
+				tail = next;
+				next = next->next.load(std::memory_order_acquire);
+			}
+			if (next)
+			{
+				m_tail = next;
+				return tail;
+			}
+			// "tail" is the last published node: re-insert the stub behind it so we can unlink it.
+			if (tail != m_head.load(std::memory_order_acquire))
+				return NULL; // A push() is in progress
+			push(&m_stub);
+			next = tail->next.load(std::memory_order_acquire);
+			if (next)
+			{
+				m_tail = next;
+				return tail;
+			}
+			return NULL;
+		}
+
+		std::atomic<TNode*>  m_head;  //!< Producers side
+		TNode               *m_tail;  //!< Consumer side
+		TNode                m_stub;  //!< Dummy node, so the list is never empty
+		std::atomic<uint64_t> m_seq;
+		std::vector<TNode*>  m_pending; //!< Popped from the MPSC list, but not processed yet (only accessed by the consumer)
+	};
+
+} // end of namespace "srba"
@@ -0,0 +1,387 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mrpt/math/CSparseMatrix.h>
+#include <Eigen/Sparse>
+#include <Eigen/Cholesky>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#if defined(SRBA_HAS_CHOLMOD)
+#	include <Eigen/CholmodSupport>
+#endif
+
+namespace srba {
+namespace internal
+{
+	/** Default implementation of marginal_covariance() for backends which can only solve A*x=b: one solve per column of the block */
+	template <class BACKEND>
+	void marginal_covariance_by_solves(BACKEND &backend, const size_t dim, const size_t first, const size_t n, Eigen::MatrixXd &out_cov)
+	{
+		out_cov.resize(n,n);
+		Eigen::VectorXd e = Eigen::VectorXd::Zero(dim), x;
+		for (size_t k=0;k<n;k++)
+		{
+			e[first+k] = 1.0;
+			backend.solve(e,x);
+			e[first+k] = 0.0;
+			out_cov.col(k) = x.segment(first,n);
+		}
+	}
+
+	/** Solves A*x=b with a single-precision factorization of A plus iterative refinement in double precision:
+	  *  x = inv(L L^t)*b; then, up to \a max_sweeps times: r = b-A*x (in double), x += inv(L L^t)*r.
+	  * Stops when |r| <= rel_tol*|b|, or as soon as a sweep doesn't reduce |r| (the system is too ill-conditioned for the single-precision factor).
+	  * A is the double-precision UPPER triangle of the system matrix.
+	  * \return Whether |r| <= rel_tol*|b| was reached. */
+	template <class MATRIX, class FLOAT_CHOL>
+	bool solve_with_iterative_refinement(
+		const MATRIX &A, const FLOAT_CHOL &chol,
+		const Eigen::VectorXd &b, Eigen::VectorXd &x,
+		const size_t max_sweeps, const double rel_tol,
+		size_t &out_sweeps, double &out_rel_residual)
+	{
+		Eigen::VectorXf xf = chol.solve(Eigen::VectorXf(b.cast<float>()));
+		x = xf.cast<double>();
+		out_sweeps = 0;
+
+		const double b_norm = b.norm();
+		if (b_norm==0) { out_rel_residual = 0; return true; }
+
+		Eigen::VectorXd r, x_prev;
+		double prev_rel_residual = std::numeric_limits<double>::max();
+		for (;;)
+		{
+			r.noalias() = b - A.template selfadjointView<Eigen::Upper>() * x;
+			out_rel_residual = r.norm()/b_norm;
+			if (out_rel_residual<=rel_tol)
+				return true;
+			if (out_rel_residual>=prev_rel_residual)
+			{
+				// Stagnated or diverging: keep the previous (better) solution
+				x.swap(x_prev);
+				out_rel_residual = prev_rel_residual;
+				return false;
+			}
+			if (out_sweeps>=max_sweeps)
+				return false;
+
+			prev_rel_residual = out_rel_residual;
+			x_prev = x;
+			xf = chol.solve(Eigen::VectorXf(r.cast<float>()));
+			x += xf.cast<double>();
+			out_sweeps++;
+		}
+	}
+
+	/** Common part of the mixed precision backends: refinement parameters, statistics and the fallback to a double-precision factorization
+	  * (of type DOUBLE_CHOL, created on demand from the double-precision UPPER triangle) for systems where refinement doesn't converge. */
+	template <unsigned int MAX_REFINEMENT_SWEEPS, unsigned int REL_TOL_DIGITS, class DOUBLE_CHOL>
+	struct mixed_precision_refinement
+	{
+		typedef Eigen::SparseMatrix<double> sparse_matrix_t;
+
+		mixed_precision_refinement() : m_last_sweeps(0), m_last_rel_residual(0), m_last_used_fallback(false), m_num_fallbacks(0), m_double_chol_valid(false) {}
+
+		static double refinement_rel_tol() { return std::pow(10.0, -static_cast<double>(REL_TOL_DIGITS)); }
+
+		/** Refines the solution of the single-precision factor \a float_chol and, if it doesn't converge, solves again in double precision */
+		template <class FLOAT_CHOL, class DOUBLE_FACTORIZE>
+		void solve(const FLOAT_CHOL &float_chol, const DOUBLE_FACTORIZE &double_factorize, const Eigen::VectorXd &b, Eigen::VectorXd &x)
+		{
+			m_last_used_fallback = false;
+			if (internal::solve_with_iterative_refinement(m_A,float_chol, b,x, MAX_REFINEMENT_SWEEPS,refinement_rel_tol(), m_last_sweeps,m_last_rel_residual))
+				return;
+
+			// Not accurate enough: fall back to double precision (factored once per factorize(), then reused by the next solves)
+			if (!m_double_chol_valid)
+			{
+				double_factorize(m_A, m_double_chol);
+				m_double_chol_valid = (m_double_chol.info()==Eigen::Success);
+			}
+			if (!m_double_chol_valid)
+				return; // Keep the refined solution, the best we have
+			x = m_double_chol.solve(b);
+			m_last_rel_residual = b.norm()>0 ? (b - m_A.template selfadjointView<Eigen::Upper>()*x).norm()/b.norm() : 0;
+			m_last_used_fallback = true;
+			m_num_fallbacks++;
+		}
+
+		/** Must be called with each new system matrix */
+		void set_matrix(const sparse_matrix_t &A)
+		{
+			m_A = A;
+			m_double_chol_valid = false;
+		}
+
+		sparse_matrix_t   m_A;        //!< Double-precision system, for the residuals and the fallback
+		size_t  m_last_sweeps;
+		double  m_last_rel_residual;
+		bool    m_last_used_fallback;
+		size_t  m_num_fallbacks;
+		DOUBLE_CHOL  m_double_chol;
+		bool    m_double_chol_valid;
+	};
+}
+
+/** Sparse linear solver backends for options::solver_LM_backend
+  *
+  * A backend solves the symmetric, positive-definite systems A*x=b built in each Lev-Marq iteration, where A is either the
+  * entire Hessian (plus lambda*I) or its Schur complement. It must be a default-constructible class with these members:
+  * \code
+  *  struct my_backend
+  *  {
+  *    typedef Eigen::SparseMatrix<double> sparse_matrix_t;  // Column-compressed, only the UPPER triangle of A is filled in.
+  *
+  *    static const char* name();
+  *
+  *    // Symbolic analysis (fill-reducing ordering, elimination tree,...). Called once for each sparsity pattern of A.
+  *    void analyze(const sparse_matrix_t &A);
+  *    // Numeric factorization of A, with the same sparsity pattern than in the last call to analyze().
+  *    // Returns false if A is not positive definite (Lev-Marq will then retry with a larger lambda).
+  *    bool factorize(const sparse_matrix_t &A);
+  *    // Solves A*x=b with the last factorization. "x" is resized as needed.
+  *    void solve(const Eigen::VectorXd &b, Eigen::VectorXd &x);
+  *
+  *    // Optional: marginal covariances, i.e. the diagonal blocks of inv(A).
+  *    static const bool HAS_MARGINAL_COVARIANCE = true;
+  *    // The n x n block of inv(A) starting at (first,first), from the last factorization:
+  *    void marginal_covariance(const size_t first, const size_t n, Eigen::MatrixXd &out_cov);
+  *  };
+  * \endcode
+  * marginal_covariance() is only required if HAS_MARGINAL_COVARIANCE=true. All the backends in this namespace support it.
+  *
+  * \ingroup mrpt_srba_options_solver
+  */
+namespace linear_solvers
+{
+	/** Backend: Eigen's SimplicialLDLT (sparse Cholesky LDL^t without square roots, with AMD ordering) */
+	struct eigen_simplicial_ldlt
+	{
+		typedef Eigen::SparseMatrix<double> sparse_matrix_t;
+		static const bool HAS_MARGINAL_COVARIANCE = true;
+
+		static const char* name() { return "eigen_simplicial_ldlt"; }
+
+		void analyze(const sparse_matrix_t &A) { m_chol.analyzePattern(A); }
+		bool factorize(const sparse_matrix_t &A)
+		{
+			m_chol.factorize(A);
+			// LDL^t also "succeeds" with indefinite matrices: check D instead
+			return m_chol.info()==Eigen::Success && (m_chol.vectorD().size()==0 || m_chol.vectorD().minCoeff()>0);
+		}
+		void solve(const Eigen::VectorXd &b, Eigen::VectorXd &x) { x = m_chol.solve(b); }
+		void marginal_covariance(const size_t first, const size_t n, Eigen::MatrixXd &out_cov) {
+			internal::marginal_covariance_by_solves(*this, static_cast<size_t>(m_chol.rows()), first,n, out_cov);
+		}
+
+	private:
+		Eigen::SimplicialLDLT<sparse_matrix_t, Eigen::Upper> m_chol;
+	};
+
+	/** Backend: Eigen's SimplicialLLT (sparse Cholesky LL^t, with AMD ordering) */
+	struct eigen_simplicial_llt
+	{
+		typedef Eigen::SparseMatrix<double> sparse_matrix_t;
+		static const bool HAS_MARGINAL_COVARIANCE = true;
+
+		static const char* name() { return "eigen_simplicial_llt"; }
+
+		void analyze(const sparse_matrix_t &A) { m_chol.analyzePattern(A); }
+		bool factorize(const sparse_matrix_t &A)
+		{
+			m_chol.factorize(A);
+			return m_chol.info()==Eigen::Success;
+		}
+		void solve(const Eigen::VectorXd &b, Eigen::VectorXd &x) { x = m_chol.solve(b); }
+		void marginal_covariance(const size_t first, const size_t n, Eigen::MatrixXd &out_cov) {
+			internal::marginal_covariance_by_solves(*this, static_cast<size_t>(m_chol.rows()), first,n, out_cov);
+		}
+
+	private:
+		Eigen::SimplicialLLT<sparse_matrix_t, Eigen::Upper> m_chol;
+	};
+
+	/** Backend: CSparse sparse Cholesky (mrpt::math::CSparseMatrix), as used by the built-in sparse solvers.
+	  * It has no separate symbolic step: the analysis is redone in the first factorization only. */
+	struct csparse_cholesky
+	{
+		typedef Eigen::SparseMatrix<double> sparse_matrix_t;
+		static const bool HAS_MARGINAL_COVARIANCE = true;
+
+		static const char* name() { return "csparse_cholesky"; }
+
+		csparse_cholesky() : m_chol(NULL), m_dim(0) {}
+		~csparse_cholesky() { delete m_chol; }
+
+		void analyze(const sparse_matrix_t &A) { MRPT_UNUSED_PARAM(A); delete m_chol; m_chol=NULL; }
+		bool factorize(const sparse_matrix_t &A)
+		{
+			mrpt::math::CSparseMatrix sA(A.rows(),A.cols());
+			for (int j=0;j<A.outerSize();++j)
+				for (sparse_matrix_t::InnerIterator it(A,j);it;++it)
+					sA.insert_entry(it.row(),it.col(),it.value());
+			sA.compressFromTriplet();
+			m_dim = static_cast<size_t>(A.rows());
+			try
+			{
+				if (!m_chol)
+				     m_chol = new mrpt::math::CSparseMatrix::CholeskyDecomp(sA);
+				else m_chol->update(sA);
+			}
+			catch (mrpt::math::CExceptionNotDefPos &)
+			{
+				return false;
+			}
+			return true;
+		}
+		void solve(const Eigen::VectorXd &b, Eigen::VectorXd &x) { m_chol->backsub(b,x); }
+		void marginal_covariance(const size_t first, const size_t n, Eigen::MatrixXd &out_cov) {
+			internal::marginal_covariance_by_solves(*this, m_dim, first,n, out_cov);
+		}
+
+	private:
+		mrpt::math::CSparseMatrix::CholeskyDecomp *m_chol;
+		size_t m_dim;
+		csparse_cholesky(const csparse_cholesky &); // Not copyable
+		csparse_cholesky & operator =(const csparse_cholesky &);
+	};
+
+	/** Backend: mixed precision dense Cholesky. The system is factored with a dense LL^t in single precision (about twice as fast and
+	  * half the memory than in double precision), while residuals are evaluated in double precision in a few sweeps of iterative
+	  * refinement. Best suited for the reduced (Schur) system of wide local areas, where the dense factorization dominates each iteration.
+	  *
+	  * Each refinement sweep reduces the error by a factor of about cond(A)*1e-7, so systems with condition numbers up to ~1e5 reach the
+	  * tolerance in a few sweeps. If refinement doesn't reach it (too ill-conditioned systems, or too few sweeps), the system is solved
+	  * again with a double-precision factorization, so the returned solution always has double-precision accuracy; see last_used_fallback().
+	  * If the matrix can't even be factored in single precision, factorize() fails and Lev-Marq retries with a larger lambda.
+	  *
+	  * \tparam MAX_REFINEMENT_SWEEPS Maximum number of refinement sweeps in each solve()
+	  * \tparam REL_TOL_DIGITS Refinement stops once |b-A*x| <= 10^-REL_TOL_DIGITS * |b|
+	  */
+	template <unsigned int MAX_REFINEMENT_SWEEPS = 10, unsigned int REL_TOL_DIGITS = 10>
+	struct mixed_precision_dense_llt
+	{
+		typedef Eigen::SparseMatrix<double> sparse_matrix_t;
+		static const bool HAS_MARGINAL_COVARIANCE = true;
+
+		static const char* name() { return "mixed_precision_dense_llt"; }
+
+		void analyze(const sparse_matrix_t &A) { m_denseA_f.setZero(A.rows(),A.cols()); }
+		bool factorize(const sparse_matrix_t &A)
+		{
+			m_ref.set_matrix(A);
+			// Scatter the nonzeros (upper triangle) straight into the dense matrix, whose storage is reused between calls:
+			m_denseA_f.setZero(A.rows(),A.cols());
+			for (int j=0;j<A.outerSize();++j)
+				for (sparse_matrix_t::InnerIterator it(A,j);it;++it)
+					m_denseA_f(it.row(),it.col()) = static_cast<float>(it.value());
+			m_chol.compute(m_denseA_f);
+			return m_chol.info()==Eigen::Success;
+		}
+		void solve(const Eigen::VectorXd &b, Eigen::VectorXd &x) { m_ref.solve(m_chol, &double_factorize, b,x); }
+		void marginal_covariance(const size_t first, const size_t n, Eigen::MatrixXd &out_cov) {
+			internal::marginal_covariance_by_solves(*this, static_cast<size_t>(m_ref.m_A.rows()), first,n, out_cov);
+		}
+
+		size_t last_refinement_sweeps() const { return m_ref.m_last_sweeps; } //!< Number of refinement sweeps in the last solve()
+		double last_relative_residual() const { return m_ref.m_last_rel_residual; } //!< |b-A*x|/|b| after the last solve()
+		bool   last_used_fallback() const { return m_ref.m_last_used_fallback; } //!< Whether the last solve() didn't converge and was solved in double precision
+		size_t num_fallbacks() const { return m_ref.m_num_fallbacks; } //!< Number of solve() calls solved in double precision so far
+
+	private:
+		typedef Eigen::LLT<Eigen::MatrixXd,Eigen::Upper> double_chol_t;
+		static void double_factorize(const sparse_matrix_t &A, double_chol_t &chol) { chol.compute(Eigen::MatrixXd(A)); }
+
+		Eigen::MatrixXf   m_denseA_f; //!< Only the upper triangle is used
+		Eigen::LLT<Eigen::MatrixXf,Eigen::Upper> m_chol;
+		internal::mixed_precision_refinement<MAX_REFINEMENT_SWEEPS,REL_TOL_DIGITS,double_chol_t>  m_ref;
+	};
+
+	/** Backend: mixed precision sparse Cholesky, the sparse counterpart of mixed_precision_dense_llt (Eigen's SimplicialLLT in single precision,
+	  * with AMD ordering, plus iterative refinement in double precision and the same fallback to double precision). Suited for the full system or very sparse reduced systems.
+	  * \tparam MAX_REFINEMENT_SWEEPS Maximum number of refinement sweeps in each solve()
+	  * \tparam REL_TOL_DIGITS Refinement stops once |b-A*x| <= 10^-REL_TOL_DIGITS * |b|
+	  */
+	template <unsigned int MAX_REFINEMENT_SWEEPS = 10, unsigned int REL_TOL_DIGITS = 10>
+	struct mixed_precision_simplicial_llt
+	{
+		typedef Eigen::SparseMatrix<double> sparse_matrix_t;
+		static const bool HAS_MARGINAL_COVARIANCE = true;
+
+		static const char* name() { return "mixed_precision_simplicial_llt"; }
+
+		void analyze(const sparse_matrix_t &A)
+		{
+			m_A_f = A.cast<float>();
+			m_chol.analyzePattern(m_A_f);
+		}
+		bool factorize(const sparse_matrix_t &A)
+		{
+			m_ref.set_matrix(A);
+			// The sparsity pattern rarely changes between calls: if so, just convert the values in place.
+			if (A.isCompressed() && m_A_f.isCompressed() && m_A_f.rows()==A.rows() && m_A_f.cols()==A.cols() && m_A_f.nonZeros()==A.nonZeros()
+				&& std::equal(A.outerIndexPtr(),A.outerIndexPtr()+A.outerSize()+1, m_A_f.outerIndexPtr())
+				&& std::equal(A.innerIndexPtr(),A.innerIndexPtr()+A.nonZeros(), m_A_f.innerIndexPtr()))
+			{
+				Eigen::Map<Eigen::VectorXf>(m_A_f.valuePtr(),m_A_f.nonZeros()) = Eigen::Map<const Eigen::VectorXd>(A.valuePtr(),A.nonZeros()).cast<float>();
+			}
+			else m_A_f = A.cast<float>();
+			m_chol.factorize(m_A_f);
+			return m_chol.info()==Eigen::Success;
+		}
+		void solve(const Eigen::VectorXd &b, Eigen::VectorXd &x) { m_ref.solve(m_chol, &double_factorize, b,x); }
+		void marginal_covariance(const size_t first, const size_t n, Eigen::MatrixXd &out_cov) {
+			internal::marginal_covariance_by_solves(*this, static_cast<size_t>(m_ref.m_A.rows()), first,n, out_cov);
+		}
+
+		size_t last_refinement_sweeps() const { return m_ref.m_last_sweeps; } //!< Number of refinement sweeps in the last solve()
+		double last_relative_residual() const { return m_ref.m_last_rel_residual; } //!< |b-A*x|/|b| after the last solve()
+		bool   last_used_fallback() const { return m_ref.m_last_used_fallback; } //!< Whether the last solve() didn't converge and was solved in double precision
+		size_t num_fallbacks() const { return m_ref.m_num_fallbacks; } //!< Number of solve() calls solved in double precision so far
+
+	private:
+		typedef Eigen::SimplicialLLT<sparse_matrix_t, Eigen::Upper> double_chol_t;
+		static void double_factorize(const sparse_matrix_t &A, double_chol_t &chol) { chol.compute(A); }
+
+		Eigen::SparseMatrix<float>  m_A_f;
+		Eigen::SimplicialLLT<Eigen::SparseMatrix<float>, Eigen::Upper> m_chol;
+		internal::mixed_precision_refinement<MAX_REFINEMENT_SWEEPS,REL_TOL_DIGITS,double_chol_t>  m_ref;
+	};
+
+#if defined(SRBA_HAS_CHOLMOD)
+	/** Backend: CHOLMOD supernodal Cholesky (multithreaded if CHOLMOD was built with a parallel BLAS).
+	  * Only available if SRBA_HAS_CHOLMOD is defined and the application links against CHOLMOD. */
+	struct cholmod_supernodal_llt
+	{
+		typedef Eigen::SparseMatrix<double> sparse_matrix_t;
+		static const bool HAS_MARGINAL_COVARIANCE = true;
+
+		static const char* name() { return "cholmod_supernodal_llt"; }
+
+		void analyze(const sparse_matrix_t &A) { m_chol.analyzePattern(A); }
+		bool factorize(const sparse_matrix_t &A)
+		{
+			m_chol.factorize(A);
+			return m_chol.info()==Eigen::Success;
+		}
+		void solve(const Eigen::VectorXd &b, Eigen::VectorXd &x) { x = m_chol.solve(b); }
+		void marginal_covariance(const size_t first, const size_t n, Eigen::MatrixXd &out_cov) {
+			internal::marginal_covariance_by_solves(*this, static_cast<size_t>(m_chol.rows()), first,n, out_cov);
+		}
+
+	private:
+		Eigen::CholmodSupernodalLLT<sparse_matrix_t, Eigen::Upper> m_chol;
+	};
+#endif
+
+} // end NS linear_solvers
+} // end NS srba
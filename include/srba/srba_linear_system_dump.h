@@ -0,0 +1,152 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+/** \file srba_linear_system_dump.h
+  * \brief Loads the linear systems saved by RbaEngine when TSRBAParameters::dump_linear_systems_prefix is set
+  */
+
+#include <mrpt/utils/CFileGZInputStream.h>
+
+namespace srba
+{
+	/** Reads the problem dimensions stored in a linear system dump file, so applications can choose the matching RbaEngine<> type for TLinearSystemDump.
+	  * \exception std::exception If the file can't be read or is not a linear system dump. */
+	inline void get_linear_system_dump_dims(const std::string &file, unsigned int &pose_dims, unsigned int &lm_dims, unsigned int &obs_dims)
+	{
+		mrpt::utils::CFileGZInputStream f;
+		if (!f.open(file))
+			THROW_EXCEPTION_CUSTOM_MSG1("Error opening linear system dump file: '%s'", file.c_str())
+		uint32_t p,l,o;
+		internal::linear_system_dump_io::read_header(f, p,l,o);
+		pose_dims = p; lm_dims = l; obs_dims = o;
+	}
+
+	/** One linear system built by RbaEngine::optimize_edges() and saved to disk (see TSRBAParameters::dump_linear_systems_prefix),
+	  * which can be loaded to run and time any solver engine on real problem instances.
+	  *
+	  * Jacobians and Hessians only hold the numeric part of their blocks. Row indices in Jacobians are indices in \a residuals.
+	  * Hessians already include the noise model of the engine which saved them, and HApf is in row-compressed form (as expected by solvers).
+	  *
+	  * \tparam RBA_ENGINE An RbaEngine<> type with the same kf-to-kf pose, landmark and observation dimensions than the one which saved the file.
+	  */
+	template <class RBA_ENGINE>
+	struct TLinearSystemDump
+	{
+		typedef typename RBA_ENGINE::hessian_traits_t hessian_traits_t;
+		typedef typename hessian_traits_t::TSparseBlocksHessian_Ap  hessian_Ap_t;
+		typedef typename hessian_traits_t::TSparseBlocksHessian_f   hessian_f_t;
+		typedef typename hessian_traits_t::TSparseBlocksHessian_Apf hessian_Apf_t;
+		typedef Eigen::Matrix<double,RBA_ENGINE::OBS_DIMS,RBA_ENGINE::OBS_DIMS> obs_info_matrix_t;
+
+		static const size_t POSE_DIMS = RBA_ENGINE::REL_POSE_DIMS;
+		static const size_t LM_DIMS   = RBA_ENGINE::LM_DIMS;
+
+		size_t nUnknowns_k2k, nUnknowns_k2f;
+		typename RBA_ENGINE::TSparseBlocksJacobians_dh_dAp  dh_dAp;
+		typename RBA_ENGINE::TSparseBlocksJacobians_dh_df   dh_df;
+		std::vector<char>                                  obs_valid;       //!< Per observation: false if its Jacobians were invalid (and ignored in Hessians)
+		typename RBA_ENGINE::vector_residuals_t            residuals;       //!< Per observation: h(x)-z
+		typename mrpt::aligned_containers<obs_info_matrix_t>::vector_t  obs_information; //!< Per observation: its information matrix, as applied by the noise model
+		hessian_Ap_t     HAp;
+		hessian_f_t      Hf;
+		hessian_Apf_t    HApf;
+		Eigen::VectorXd  minus_grad;
+		double           lambda;  //!< The initial Lev-Marq lambda
+
+		TLinearSystemDump() : nUnknowns_k2k(0), nUnknowns_k2f(0), lambda(0) {}
+
+		/** Loads a linear system from a file.
+		  * \exception std::exception If the file can't be read, is not a linear system dump, or has different dimensions than RBA_ENGINE. */
+		void load(const std::string &file)
+		{
+			typedef internal::linear_system_dump_io io;
+
+			mrpt::utils::CFileGZInputStream f;
+			if (!f.open(file))
+				THROW_EXCEPTION_CUSTOM_MSG1("Error opening linear system dump file: '%s'", file.c_str())
+
+			uint32_t pose_dims, lm_dims, obs_dims;
+			io::read_header(f, pose_dims, lm_dims, obs_dims);
+			if (pose_dims!=RBA_ENGINE::REL_POSE_DIMS || lm_dims!=RBA_ENGINE::LM_DIMS || obs_dims!=RBA_ENGINE::OBS_DIMS)
+				THROW_EXCEPTION_CUSTOM_MSG1("Linear system in '%s' has different dimensions than this RbaEngine type", file.c_str())
+
+			uint64_t nK2K, nK2F, nObs;
+			f >> nK2K >> nK2F >> nObs;
+			nUnknowns_k2k = static_cast<size_t>(nK2K);
+			nUnknowns_k2f = static_cast<size_t>(nK2F);
+
+			io::read_sparse_matrix(f, dh_dAp);
+			io::read_sparse_matrix(f, dh_df);
+
+			obs_valid.resize(static_cast<size_t>(nObs));
+			residuals.resize(static_cast<size_t>(nObs));
+			obs_information.resize(static_cast<size_t>(nObs));
+			for (size_t i=0;i<obs_valid.size();i++)
+			{
+				bool valid;
+				f >> valid;
+				obs_valid[i] = valid ? 1:0;
+				for (size_t k=0;k<RBA_ENGINE::OBS_DIMS;k++)
+					f >> residuals[i][k];
+				io::read_matrix(f, obs_information[i]);
+			}
+
+			io::read_sparse_matrix(f, HAp);
+			io::read_sparse_matrix(f, Hf);
+			io::read_sparse_matrix(f, HApf);
+			io::read_vector(f, minus_grad);
+			f >> lambda;
+
+			ASSERT_EQUAL_(HAp.getColCount(),nUnknowns_k2k)
+			ASSERT_EQUAL_(Hf.getColCount(),nUnknowns_k2f)
+			ASSERT_EQUAL_(static_cast<size_t>(minus_grad.size()),POSE_DIMS*nUnknowns_k2k+LM_DIMS*nUnknowns_k2f)
+		}
+
+		/** Evaluates how well \a delta solves (H+lambda*I)*delta = -grad, as the norm of the error relative to that of the gradient.
+		  * Solvers may modify the Hessians (e.g. with the Schur complement), so they must run on copies of them. */
+		double eval_solution_error(const double lambda_, const Eigen::VectorXd &delta) const
+		{
+			ASSERT_EQUAL_(delta.size(),minus_grad.size())
+			const size_t idx_f = POSE_DIMS*nUnknowns_k2k;
+
+			Eigen::VectorXd err = lambda_*delta - minus_grad;
+			// HAp, Hf: upper triangular part only:
+			for (size_t i=0;i<nUnknowns_k2k;i++)
+				for (typename hessian_Ap_t::col_t::const_iterator it=HAp.getCol(i).begin();it!=HAp.getCol(i).end();++it)
+				{
+					const size_t j = it->first;
+					err.segment<POSE_DIMS>(POSE_DIMS*j) += it->second.num * delta.segment<POSE_DIMS>(POSE_DIMS*i);
+					if (j!=i)
+						err.segment<POSE_DIMS>(POSE_DIMS*i) += it->second.num.transpose() * delta.segment<POSE_DIMS>(POSE_DIMS*j);
+				}
+			for (size_t i=0;i<nUnknowns_k2f;i++)
+				for (typename hessian_f_t::col_t::const_iterator it=Hf.getCol(i).begin();it!=Hf.getCol(i).end();++it)
+				{
+					const size_t j = it->first;
+					err.segment<LM_DIMS>(idx_f+LM_DIMS*j) += it->second.num * delta.segment<LM_DIMS>(idx_f+LM_DIMS*i);
+					if (j!=i)
+						err.segment<LM_DIMS>(idx_f+LM_DIMS*i) += it->second.num.transpose() * delta.segment<LM_DIMS>(idx_f+LM_DIMS*j);
+				}
+			// HApf: row "i" (k2k unknowns), column "j" (landmarks)
+			for (size_t i=0;i<nUnknowns_k2k;i++)
+				for (typename hessian_Apf_t::col_t::const_iterator it=HApf.getCol(i).begin();it!=HApf.getCol(i).end();++it)
+				{
+					const size_t j = it->first;
+					err.segment<POSE_DIMS>(POSE_DIMS*i)     += it->second.num * delta.segment<LM_DIMS>(idx_f+LM_DIMS*j);
+					err.segment<LM_DIMS>(idx_f+LM_DIMS*j) += it->second.num.transpose() * delta.segment<POSE_DIMS>(POSE_DIMS*i);
+				}
+
+			const double grad_norm = minus_grad.norm();
+			return grad_norm>0 ? err.norm()/grad_norm : err.norm();
+		}
+	};
+
+} // end of namespace "srba"
@@ -70,6 +70,14 @@ namespace options
 				g *= 1.0/obs_noise_params.std_noise_observations;
 			}
 
+			/** Factor that converts the squared errors of other factors (e.g. kf2kf priors), weighted by their own information matrices, into
+			  * the units of the total squared error of the optimizer, which is the unweighted sum of squared residuals of observations: sigma^2.
+			  * Their H and gradient terms must also go through scale_H() and scale_Jtr(), like those of observations. */
+			inline static double other_factors_sqr_error_scale(const parameters_t & obs_noise_params)
+			{
+				return obs_noise_params.std_noise_observations*obs_noise_params.std_noise_observations;
+			}
+
 		};  // end of "observation_noise_identity"
 
 		/** Usage: A possible type for RBA_OPTIONS::obs_noise_matrix_t.
@@ -130,6 +138,16 @@ namespace options
 				MRPT_UNUSED_PARAM(g); MRPT_UNUSED_PARAM(obs_noise_params);
 			}
 
+			/** Factor that converts the squared errors of other factors (e.g. kf2kf priors), weighted by their own information matrices, into
+			  * the units of the total squared error of the optimizer. There's no scalar conversion from an arbitrary \a lambda, so it's 1:
+			  * other factors are weighted consistently with observations in H and the gradient, but the total error (used to accept or
+			  * reject steps) has unweighted observation residuals. */
+			inline static double other_factors_sqr_error_scale(const parameters_t & obs_noise_params)
+			{
+				MRPT_UNUSED_PARAM(obs_noise_params);
+				return 1.0;
+			}
+
 		};  // end of "observation_noise_constant_matrix"
 
 } } // End of namespaces
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <mrpt/math/CSparseMatrix.h>
+#include "srba_linear_solvers.h"
 
 namespace srba {
 namespace options
@@ -75,4 +76,33 @@ namespace options
 			};
 		};
 
+		/** Usage: A possible type for RBA_OPTIONS::solver_t.
+		  * Meaning: Levenberg-Marquardt solver, with or without Schur complement, solving Ax=b with a pluggable sparse linear solver
+		  * backend (e.g. linear_solvers::eigen_simplicial_ldlt). See srba::linear_solvers for the requirements of backends.
+		  * \tparam BACKEND The linear solver backend
+		  * \tparam USE_SCHUR_ Whether to reduce landmarks with the Schur complement before solving
+		  * \tparam K2K_MARGINALS If true (and BACKEND supports it), the marginal covariances of all kf-to-kf unknowns are returned in extra_results_t
+		  * \ingroup mrpt_srba_options_solver */
+		template <class BACKEND, bool USE_SCHUR_ = true, bool K2K_MARGINALS_ = false>
+		struct solver_LM_backend
+		{
+			typedef BACKEND backend_t;
+			static const bool USE_SCHUR      = USE_SCHUR_;
+			static const bool DENSE_CHOLESKY = false;
+			static const bool K2K_MARGINALS  = K2K_MARGINALS_;
+
+			/** Extra output information to be found in RbaEngine<>::TOptimizeExtraOutputInfo::extra_results */
+			struct extra_results_t
+			{
+				bool hessian_valid; //!< Will be false if the Hessian wasn't evaluated for some reason.
+				/** The last system matrix given to the backend (upper triangle only): the Hessian of all unknowns, or only of kf-to-kf unknowns after Schur reduction */
+				Eigen::SparseMatrix<double>  hessian;
+				/** Only if K2K_MARGINALS=true: the marginal covariance of each kf-to-kf unknown, in the same order than they were optimized */
+				std::vector<Eigen::MatrixXd>  k2k_marginal_covs;
+
+				extra_results_t() { clear(); }
+				void clear() { hessian_valid=false; k2k_marginal_covs.clear(); }
+			};
+		};
+
 } } // End of namespaces
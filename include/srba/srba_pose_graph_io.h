@@ -0,0 +1,283 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#pragma once
+
+/** \file srba_pose_graph_io.h
+  * \brief Streaming readers and writers of pose graphs in the g2o and TORO text formats, for SE(2) and SE(3)
+  */
+
+#include <mrpt/poses/CPose2D.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/poses/CPose3DQuat.h>
+#include "srba_types.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace srba
+{
+	/** Text formats of pose graph files */
+	enum pose_graph_format_t
+	{
+		pgfG2O = 0, //!< g2o: VERTEX_SE2, EDGE_SE2, VERTEX_SE3:QUAT, EDGE_SE3:QUAT
+		pgfTORO     //!< TORO: VERTEX2, EDGE2, VERTEX3, EDGE3
+	};
+
+	/** One vertex or edge of a pose graph file \sa PoseGraphFileReader, PoseGraphFileWriter */
+	template <class POSE>
+	struct TPoseGraphRecord
+	{
+		static const size_t DOF = POSE::is_3D_val ? 6 : 3;
+		typedef Eigen::Matrix<double,DOF,DOF> inf_matrix_t;
+
+		bool         is_edge;     //!< false: a vertex
+		TKeyFrameID  id;          //!< Vertex only: its ID
+		TKeyFrameID  from, to;    //!< Edge only: the IDs of its two vertices
+		POSE         pose;        //!< Vertex: its global pose; Edge: the pose of "to" as seen from "from"
+		inf_matrix_t information; //!< Edge only: the information matrix of the relative pose. For g2o SE(3), the rotation part is wrt the quaternion vector part.
+
+		TPoseGraphRecord() : is_edge(false), id(0), from(0), to(0), information(inf_matrix_t::Identity()) {}
+
+		MRPT_MAKE_ALIGNED_OPERATOR_NEW  // Required by Eigen containers
+	};
+
+	namespace internal
+	{
+		/** Per pose type parsing and formatting of records in pose graph files */
+		template <class POSE> struct pose_graph_io_traits;
+
+		template <> struct pose_graph_io_traits<mrpt::poses::CPose2D>
+		{
+			typedef TPoseGraphRecord<mrpt::poses::CPose2D> record_t;
+
+			static const char* vertex_tag(const pose_graph_format_t fmt) { return fmt==pgfG2O ? "VERTEX_SE2" : "VERTEX2"; }
+			static const char* edge_tag(const pose_graph_format_t fmt)   { return fmt==pgfG2O ? "EDGE_SE2"   : "EDGE2"; }
+			static bool is_vertex_tag(const std::string &s, pose_graph_format_t &fmt) {
+				if (s=="VERTEX_SE2") { fmt=pgfG2O; return true; }
+				if (s=="VERTEX2" || s=="VERTEX") { fmt=pgfTORO; return true; }
+				return false;
+			}
+			static bool is_edge_tag(const std::string &s, pose_graph_format_t &fmt) {
+				if (s=="EDGE_SE2") { fmt=pgfG2O; return true; }
+				if (s=="EDGE2" || s=="EDGE") { fmt=pgfTORO; return true; }
+				return false;
+			}
+			static bool is_other_dim_tag(const std::string &s) {
+				return s=="VERTEX_SE3:QUAT" || s=="EDGE_SE3:QUAT" || s=="VERTEX3" || s=="EDGE3";
+			}
+
+			static void read_pose(std::istream &in, const pose_graph_format_t fmt, mrpt::poses::CPose2D &p)
+			{
+				MRPT_UNUSED_PARAM(fmt);
+				double x,y,phi;
+				in >> x >> y >> phi;
+				p = mrpt::poses::CPose2D(x,y,phi);
+			}
+			static void write_pose(std::ostream &out, const pose_graph_format_t fmt, const mrpt::poses::CPose2D &p)
+			{
+				MRPT_UNUSED_PARAM(fmt);
+				out << p.x() << " " << p.y() << " " << p.phi();
+			}
+			static void read_information(std::istream &in, const pose_graph_format_t fmt, record_t::inf_matrix_t &I)
+			{
+				if (fmt==pgfG2O)
+					in >> I(0,0) >> I(0,1) >> I(0,2) >> I(1,1) >> I(1,2) >> I(2,2);
+				else in >> I(0,0) >> I(0,1) >> I(1,1) >> I(2,2) >> I(0,2) >> I(1,2);
+				I(1,0)=I(0,1); I(2,0)=I(0,2); I(2,1)=I(1,2);
+			}
+			static void write_information(std::ostream &out, const pose_graph_format_t fmt, const record_t::inf_matrix_t &I)
+			{
+				if (fmt==pgfG2O)
+					out << I(0,0) << " " << I(0,1) << " " << I(0,2) << " " << I(1,1) << " " << I(1,2) << " " << I(2,2);
+				else out << I(0,0) << " " << I(0,1) << " " << I(1,1) << " " << I(2,2) << " " << I(0,2) << " " << I(1,2);
+			}
+		};
+
+		template <> struct pose_graph_io_traits<mrpt::poses::CPose3D>
+		{
+			typedef TPoseGraphRecord<mrpt::poses::CPose3D> record_t;
+
+			static const char* vertex_tag(const pose_graph_format_t fmt) { return fmt==pgfG2O ? "VERTEX_SE3:QUAT" : "VERTEX3"; }
+			static const char* edge_tag(const pose_graph_format_t fmt)   { return fmt==pgfG2O ? "EDGE_SE3:QUAT"   : "EDGE3"; }
+			static bool is_vertex_tag(const std::string &s, pose_graph_format_t &fmt) {
+				if (s=="VERTEX_SE3:QUAT") { fmt=pgfG2O; return true; }
+				if (s=="VERTEX3") { fmt=pgfTORO; return true; }
+				return false;
+			}
+			static bool is_edge_tag(const std::string &s, pose_graph_format_t &fmt) {
+				if (s=="EDGE_SE3:QUAT") { fmt=pgfG2O; return true; }
+				if (s=="EDGE3") { fmt=pgfTORO; return true; }
+				return false;
+			}
+			static bool is_other_dim_tag(const std::string &s) {
+				return s=="VERTEX_SE2" || s=="EDGE_SE2" || s=="VERTEX2" || s=="EDGE2" || s=="VERTEX" || s=="EDGE";
+			}
+
+			static void read_pose(std::istream &in, const pose_graph_format_t fmt, mrpt::poses::CPose3D &p)
+			{
+				double x,y,z;
+				in >> x >> y >> z;
+				if (fmt==pgfG2O)
+				{
+					double qx,qy,qz,qw;
+					in >> qx >> qy >> qz >> qw;
+					mrpt::math::CQuaternionDouble q(qw,qx,qy,qz);
+					q.normalize();
+					p = mrpt::poses::CPose3D( mrpt::poses::CPose3DQuat(x,y,z,q) );
+				}
+				else
+				{
+					double roll,pitch,yaw;
+					in >> roll >> pitch >> yaw;
+					p = mrpt::poses::CPose3D(x,y,z,yaw,pitch,roll);
+				}
+			}
+			static void write_pose(std::ostream &out, const pose_graph_format_t fmt, const mrpt::poses::CPose3D &p)
+			{
+				out << p.x() << " " << p.y() << " " << p.z() << " ";
+				if (fmt==pgfG2O)
+				{
+					const mrpt::poses::CPose3DQuat pq(p);
+					out << pq.quat().x() << " " << pq.quat().y() << " " << pq.quat().z() << " " << pq.quat().r();
+				}
+				else out << p.roll() << " " << p.pitch() << " " << p.yaw();
+			}
+			/** Both formats store the upper triangular part, row by row */
+			static void read_information(std::istream &in, const pose_graph_format_t fmt, record_t::inf_matrix_t &I)
+			{
+				MRPT_UNUSED_PARAM(fmt);
+				for (int r=0;r<6;r++)
+					for (int c=r;c<6;c++) {
+						in >> I(r,c);
+						I(c,r) = I(r,c);
+					}
+			}
+			static void write_information(std::ostream &out, const pose_graph_format_t fmt, const record_t::inf_matrix_t &I)
+			{
+				MRPT_UNUSED_PARAM(fmt);
+				for (int r=0;r<6;r++)
+					for (int c=r;c<6;c++)
+						out << (r==0 && c==0 ? "" : " ") << I(r,c);
+			}
+		};
+	} // end NS internal
+
+	/** Reads vertices and edges from a pose graph file in g2o or TORO format, one at a time, so arbitrarily large graphs can be processed
+	  * with bounded memory. The format is detected in each line from its tag; lines with any other tag (comments, "FIX", parameters,...) are skipped.
+	  * \tparam POSE mrpt::poses::CPose2D or mrpt::poses::CPose3D
+	  */
+	template <class POSE>
+	class PoseGraphFileReader
+	{
+	public:
+		typedef TPoseGraphRecord<POSE> record_t;
+
+		PoseGraphFileReader(std::istream &in) : m_in(in), m_line(0), m_num_skipped(0), m_format(pgfG2O) {}
+
+		/** Reads the next vertex or edge.
+		  * \return false at the end of the file.
+		  * \exception std::exception On malformed lines, or records of the other dimensionality (e.g. SE(3) edges while reading SE(2) graphs). */
+		bool next(record_t &rec)
+		{
+			typedef internal::pose_graph_io_traits<POSE> io;
+			std::string sLine, sTag;
+			while (std::getline(m_in,sLine))
+			{
+				m_line++;
+				std::istringstream ss(sLine);
+				if (!(ss >> sTag) || sTag[0]=='#')
+					continue;
+
+				if (io::is_vertex_tag(sTag,m_format))
+				{
+					uint64_t id;
+					ss >> id;
+					io::read_pose(ss, m_format, rec.pose);
+					rec.is_edge = false;
+					rec.id = static_cast<TKeyFrameID>(id);
+				}
+				else if (io::is_edge_tag(sTag,m_format))
+				{
+					uint64_t from,to;
+					ss >> from >> to;
+					io::read_pose(ss, m_format, rec.pose);
+					io::read_information(ss, m_format, rec.information);
+					rec.is_edge = true;
+					rec.from = static_cast<TKeyFrameID>(from);
+					rec.to   = static_cast<TKeyFrameID>(to);
+				}
+				else if (io::is_other_dim_tag(sTag))
+					THROW_EXCEPTION_CUSTOM_MSG1("Line %u: record of a pose graph of the wrong dimensionality", static_cast<unsigned int>(m_line))
+				else
+				{
+					m_num_skipped++;
+					continue;
+				}
+
+				if (ss.fail())
+					THROW_EXCEPTION_CUSTOM_MSG1("Line %u: malformed pose graph record", static_cast<unsigned int>(m_line))
+				return true;
+			}
+			return false;
+		}
+
+		size_t line_number() const { return m_line; }  //!< Number of lines read so far
+		size_t num_skipped_lines() const { return m_num_skipped; }  //!< Number of lines with unknown tags so far
+		pose_graph_format_t format() const { return m_format; } //!< The format of the last record read
+
+	private:
+		std::istream        &m_in;
+		size_t               m_line, m_num_skipped;
+		pose_graph_format_t  m_format;
+	};
+
+	/** Writes vertices and edges of a pose graph, one at a time, in g2o or TORO format.
+	  * \tparam POSE mrpt::poses::CPose2D or mrpt::poses::CPose3D
+	  */
+	template <class POSE>
+	class PoseGraphFileWriter
+	{
+	public:
+		typedef TPoseGraphRecord<POSE> record_t;
+
+		PoseGraphFileWriter(std::ostream &out, const pose_graph_format_t fmt = pgfG2O) : m_out(out), m_format(fmt)
+		{
+			m_out.precision(15);
+		}
+
+		void write_vertex(const TKeyFrameID id, const POSE &pose)
+		{
+			typedef internal::pose_graph_io_traits<POSE> io;
+			m_out << io::vertex_tag(m_format) << " " << id << " ";
+			io::write_pose(m_out, m_format, pose);
+			m_out << "\n";
+		}
+		void write_edge(const TKeyFrameID from, const TKeyFrameID to, const POSE &rel_pose, const typename record_t::inf_matrix_t &information)
+		{
+			typedef internal::pose_graph_io_traits<POSE> io;
+			m_out << io::edge_tag(m_format) << " " << from << " " << to << " ";
+			io::write_pose(m_out, m_format, rel_pose);
+			m_out << " ";
+			io::write_information(m_out, m_format, information);
+			m_out << "\n";
+		}
+		void write(const record_t &rec)
+		{
+			if (rec.is_edge)
+			     write_edge(rec.from, rec.to, rec.pose, rec.information);
+			else write_vertex(rec.id, rec.pose);
+		}
+
+	private:
+		std::ostream        &m_out;
+		pose_graph_format_t  m_format;
+	};
+
+} // end of namespace "srba"
@@ -12,9 +12,14 @@
 #include <mrpt/math/lightweight_geom_data.h>
 #include <mrpt/math/MatrixBlockSparseCols.h>
 #include <mrpt/math/CArrayNumeric.h>
+#include <mrpt/math/types_math.h> // Eigen dense types
 #include <mrpt/utils/TEnumType.h>
 #include <mrpt/system/memory.h> // for MRPT_MAKE_ALIGNED_OPERATOR_NEW
+#include <mrpt/utils/CConfigFileBase.h>
 #include <set>
+#include <map>
+#include <algorithm> // lower_bound()
+#include <limits>
 
 namespace srba
 {
@@ -43,6 +48,37 @@ namespace srba
 	template <class landmark_t,class obs_t>
 	struct sensor_model;
 
+	namespace internal {
+		/** Evaluates the Jacobian dh_dx of a sensor model. Most sensor models don't need the observed values for that, so they
+		  * are only fetched from the store (with eval_at()) by the specializations for those which do (e.g. observations::MultiSensor).
+		  * \sa Implementations are in srba/models/sensors.h */
+		template <class SENSOR_MODEL>
+		struct sensor_jacob_dh_dx
+		{
+			/** Jacobian for the observation \a obs_idx in the observation store \a obs_store */
+			template <class JACOB_T,class LM_ARRAY_T,class OBS_STORE_T,class PARAMS_T>
+			static inline bool eval_at(JACOB_T &dh_dx, const LM_ARRAY_T &xji_l, const OBS_STORE_T &obs_store, const size_t obs_idx, const PARAMS_T &params) {
+				MRPT_UNUSED_PARAM(obs_store); MRPT_UNUSED_PARAM(obs_idx);
+				return SENSOR_MODEL::eval_jacob_dh_dx(dh_dx,xji_l,params);
+			}
+			/** Jacobian for the observed values \a z_obs */
+			template <class JACOB_T,class LM_ARRAY_T,class OBS_ARRAY_T,class PARAMS_T>
+			static inline bool eval(JACOB_T &dh_dx, const LM_ARRAY_T &xji_l, const OBS_ARRAY_T &z_obs, const PARAMS_T &params) {
+				MRPT_UNUSED_PARAM(z_obs);
+				return SENSOR_MODEL::eval_jacob_dh_dx(dh_dx,xji_l,params);
+			}
+		};
+
+		/** Whether a numeric approximation may replace the analytic dh_dx of SENSOR_MODEL where the latter is ill-defined (see TSRBAParameters::numeric_jacobians_fallback).
+		  * Models whose analytic Jacobian is only rejected where h() itself is meaningless (e.g. points behind a camera) specialize it to false.
+		  * \sa Specializations are in srba/models/sensors.h */
+		template <class SENSOR_MODEL>
+		struct sensor_allows_numeric_jacob_fallback
+		{
+			static const bool value = true;
+		};
+	}
+
 	/** The argument "POSE_TRAITS" can be any of those defined in srba/models/kf2kf_poses.h (typically, either kf2kf_poses::SE3 or kf2kf_poses::SE2).
 	  * \sa landmark_traits, observation_traits
 	  */
@@ -53,16 +89,19 @@ namespace srba
 		typedef typename POSE_TRAITS::pose_t  pose_t;  //!< Will be mrpt::poses::CPose3D, ...
 		typedef typename mrpt::math::CArrayDouble<POSE_TRAITS::REL_POSE_DIMS>  array_pose_t;  //!< A fixed-length array of the size of the relative poses between keyframes
 
-		/** A joint structure for one relative pose + an "up-to-date" flag (needed for spanning trees numeric updates) */
+		/** A joint structure for one relative pose + a generation stamp (needed for spanning trees numeric updates)
+		  * \sa TNumericSpanningTree */
 		struct pose_flag_t
 		{
-			pose_t        pose;
-			mutable bool  updated;
+			pose_t            pose;
+			mutable uint64_t  generation; //!< Generation of the numeric spanning tree when \a pose was computed; 0 if never computed or explicitly marked as outdated.
 
-			pose_flag_t() : updated(false) { }
-			pose_flag_t(const pose_t &pose_, const bool updated_) : pose(pose_),updated(updated_) { }
+			pose_flag_t() : generation(0) { }
+			pose_flag_t(const pose_t &pose_, const uint64_t generation_) : pose(pose_),generation(generation_) { }
 
-			inline void mark_outdated() const { updated=false; }
+			/** Whether \a pose has been computed and not marked as outdated. Whether it's older than the edges in its path is checked by TNumericSpanningTree::is_updated(e,path) */
+			inline bool updated() const { return generation!=0; }
+			inline void mark_outdated() const { generation=0; }
 
 			MRPT_MAKE_ALIGNED_OPERATOR_NEW  // Needed because we have fixed-length Eigen matrices (within CPose3D)
 		};
@@ -86,11 +125,27 @@ namespace srba
 			pose_t       inv_pose; //!< Inverse pose: pose_from (-) pose_to , that is: "from" as seen from "to".
 
 			size_t       id; //!< 0-based index of this edge, in the std::list "k2k_edges".
+			mutable uint64_t generation; //!< Generation of the numeric spanning tree when \a inv_pose was last modified (see TSpanningTree::mark_edge_modified())
 
 			MRPT_MAKE_ALIGNED_OPERATOR_NEW    // Needed because we have fixed-length Eigen matrices (within CPose3D)
 		};
 
 		typedef std::deque<k2k_edge_t*>  k2k_edge_vector_t; //!< A sequence of edges (a "path")
+
+		/** A prior factor on the relative pose between a new keyframe and an existing one (e.g. from odometry or IMU preintegration),
+		  *  attached to the kf2kf edge between them. Its error is e = pseudo_log( inv_pose (+) (-)prior ), with inv_pose the current
+		  *  value of the edge, so its components are those of the increments of the optimizer, which are applied as inv_pose <- exp(incr) (+) inv_pose.
+		  * \sa RbaEngine::define_new_keyframe() */
+		struct k2k_prior_t
+		{
+			TKeyFrameID  kf_id;     //!< The existing KF (the "from" of the edge)
+			pose_t       inv_pose;  //!< Prior value of the pose of \a kf_id as seen from the new KF (i.e. the inverse of the odometry increment from \a kf_id to the new KF)
+			Eigen::Matrix<double,POSE_TRAITS::REL_POSE_DIMS,POSE_TRAITS::REL_POSE_DIMS> inf_matrix; //!< Information matrix of the error "e" (see above). It's weighted consistently with the observation noise model (e.g. in the total squared error, it's multiplied by sigma^2 for observation_noise_identity, whose observation residuals are unweighted)
+
+			MRPT_MAKE_ALIGNED_OPERATOR_NEW
+		};
+		typedef typename mrpt::aligned_containers<k2k_prior_t>::vector_t          k2k_priors_t;      //!< The priors of one new KF
+		typedef typename mrpt::aligned_containers<size_t,k2k_prior_t>::map_t      k2k_edge_priors_t; //!< The priors of all kf2kf edges, by edge ID
 	}; // end of kf2kf_pose_traits
 
 	/** The argument "LM_TRAITS" can be any of those defined in srba/models/landmarks.h (typically, either landmarks::Euclidean3D or landmarks::Euclidean2D).
@@ -124,13 +179,28 @@ namespace srba
 		typedef std::map<TLandmarkID, TRelativeLandmarkPos>  TRelativeLandmarkPosMap;
 
 		/** Used in the vector \a "all_lms" */
+		/** Triangulation quality of a landmark, accumulated over pairs of its observing KFs by RbaEngine::landmark_passes_geometric_tests().
+		  * Each pair is evaluated once, with the estimates at that time, when the newest of both observations is first tested. */
+		struct TTriangulationCache
+		{
+			TKeyFrameID last_kf_id;       //!< Observations from KFs up to this one are accounted for (SRBA_INVALID_KEYFRAMEID: none yet)
+			size_t      num_centers;      //!< Number of observations accounted for
+			double      min_cos_parallax; //!< Cosine of the largest angle between the rays from two observing KFs to the landmark (1: none)
+			double      max_baseline;     //!< Largest distance between two observing KFs (0: none)
+
+			TTriangulationCache() : last_kf_id(SRBA_INVALID_KEYFRAMEID), num_centers(0), min_cos_parallax(1.0), max_baseline(0.0) {}
+		};
+
 		struct TLandmarkEntry
 		{
 			bool                 has_known_pos; //!< true: This landmark has a fixed (known) relative position. false: The relative pos of this landmark is an unknown of the problem.
 			TRelativeLandmarkPos *rfp;           //!< Pointers to elements in \a unknown_lms and \a known_lms.
+			size_t               first_obs_idx;  //!< Index (in \a all_observations) of the first observation of this landmark. The rest are linked with k2f_edge_t::next_obs_same_lm
+			size_t               last_obs_idx;   //!< Index (in \a all_observations) of the last observation of this landmark
+			mutable TTriangulationCache triangulation; //!< Reset whenever one of its observations is removed
 
-			TLandmarkEntry() : has_known_pos(true), rfp(NULL) {}
-			TLandmarkEntry(bool has_known_pos_, TRelativeLandmarkPos *rfp_) : has_known_pos(has_known_pos_), rfp(rfp_)
+			TLandmarkEntry() : has_known_pos(true), rfp(NULL), first_obs_idx(SRBA_INVALID_INDEX), last_obs_idx(SRBA_INVALID_INDEX) {}
+			TLandmarkEntry(bool has_known_pos_, TRelativeLandmarkPos *rfp_) : has_known_pos(has_known_pos_), rfp(rfp_), first_obs_idx(SRBA_INVALID_INDEX), last_obs_idx(SRBA_INVALID_INDEX)
 			{}
 		};
 
@@ -180,6 +250,179 @@ namespace srba
 		return p.from==one ? p.to: p.from;
 	}
 
+	/** The symbolic size of a prospective least-squares optimization, as returned by RbaEngine::estimate_local_area_cost() \sa TOptimizationCostModel */
+	struct TOptimizationCostEstimate
+	{
+		size_t num_k2k_unknowns;           //!< Number of kf-to-kf edges to be optimized
+		size_t num_lm_unknowns;            //!< Number of landmarks (relative positions) to be optimized
+		size_t num_total_scalar_unknowns;  //!< The total number of dimensions (scalar values) in all the unknowns
+		size_t num_observations;           //!< Number of observations involved (residuals to evaluate in each iteration)
+		size_t num_jacobian_blocks;        //!< Number of Jacobian blocks to be evaluated with each relinearization
+		size_t num_hessian_blocks_Ap, num_hessian_blocks_f, num_hessian_blocks_Apf; //!< Nonzero blocks in (the upper triangle of) HAp, in Hf and in HApf
+		size_t reduced_system_dim;         //!< Scalar dimension of the linear system to factorize in each iteration (the Schur complement for solvers using it)
+		size_t reduced_system_nnz_blocks;  //!< Nonzero blocks in the upper triangle of the linear system to factorize
+		double schur_block_products;       //!< Number of block products to build the Schur complement (0 for solvers not using it)
+		double factorization_flops;        //!< Approximate FLOPs of one Cholesky factorization of the linear system (ignoring fill-in for sparse solvers)
+		double estimated_time;             //!< Estimated wall time of the whole optimization (seconds), from RbaEngine::parameters.cost_model
+
+		TOptimizationCostEstimate() { clear(); }
+
+		void clear()
+		{
+			num_k2k_unknowns = num_lm_unknowns = num_total_scalar_unknowns = num_observations = num_jacobian_blocks = 0;
+			num_hessian_blocks_Ap = num_hessian_blocks_f = num_hessian_blocks_Apf = 0;
+			reduced_system_dim = reduced_system_nnz_blocks = 0;
+			schur_block_products = factorization_flops = estimated_time = 0;
+		}
+	};
+
+	/** A linear model of the time taken by one local optimization as a function of its symbolic size, for usage in RbaEngine::parameters.cost_model.
+	  * The default coefficients are rough values for a desktop CPU: they should be calibrated on the target machine with fit(), then
+	  * saved with saveToConfigFile() for later runs.
+	  */
+	struct TOptimizationCostModel
+	{
+		enum { NUM_FEATURES = 6 };
+
+		/** Seconds per unit of each feature: fixed overhead, observations, Jacobian blocks, Hessian blocks, Schur block products, factorization FLOPs.
+		  * All the per-iteration costs include the typical number of iterations, since they are fitted against whole optimizations. */
+		double coefs[NUM_FEATURES];
+
+		TOptimizationCostModel()
+		{
+			coefs[0] = 50e-6;
+			coefs[1] = 2e-6;
+			coefs[2] = 1e-6;
+			coefs[3] = 1e-6;
+			coefs[4] = 2e-6;
+			coefs[5] = 5e-9;
+		}
+
+		static void get_features(const TOptimizationCostEstimate &e, double *f)
+		{
+			f[0] = 1.0;
+			f[1] = static_cast<double>(e.num_observations);
+			f[2] = static_cast<double>(e.num_jacobian_blocks);
+			f[3] = static_cast<double>(e.num_hessian_blocks_Ap + e.num_hessian_blocks_f + e.num_hessian_blocks_Apf);
+			f[4] = e.schur_block_products;
+			f[5] = e.factorization_flops;
+		}
+
+		/** Returns the estimated time (seconds) of an optimization of the given size */
+		double predict(const TOptimizationCostEstimate &e) const
+		{
+			double f[NUM_FEATURES];
+			get_features(e,f);
+			double t = 0;
+			for (size_t i=0;i<NUM_FEATURES;i++)
+				t+= coefs[i]*f[i];
+			return t;
+		}
+
+		/** Calibrates the coefficients by non-negative least squares (Lawson-Hanson active set method) from pairs of (cost estimate, measured time)
+		  *  of real optimizations on this machine, e.g. by timing optimize_local_area() calls just after estimate_local_area_cost() with the same arguments.
+		  *  Requires at least NUM_FEATURES samples, with some variety in their sizes.
+		  */
+		void fit(const std::vector<std::pair<TOptimizationCostEstimate,double> > &samples)
+		{
+			ASSERT_ABOVEEQ_(samples.size(),static_cast<size_t>(NUM_FEATURES))
+			Eigen::MatrixXd A(samples.size(),NUM_FEATURES);
+			Eigen::VectorXd b(samples.size());
+			double f[NUM_FEATURES];
+			for (size_t i=0;i<samples.size();i++)
+			{
+				get_features(samples[i].first,f);
+				for (size_t k=0;k<NUM_FEATURES;k++)
+					A(i,k) = f[k];
+				b[i] = samples[i].second;
+			}
+			// Normalize columns for a better conditioning, since features have very different scales:
+			Eigen::VectorXd scale(NUM_FEATURES);
+			for (size_t k=0;k<NUM_FEATURES;k++)
+			{
+				scale[k] = A.col(k).norm();
+				if (scale[k]>0) A.col(k)/=scale[k];
+			}
+			const Eigen::VectorXd x = nnls(A,b);
+			for (size_t k=0;k<NUM_FEATURES;k++)
+				coefs[k] = (scale[k]>0) ? x[k]/scale[k] : 0.0;
+		}
+
+		void loadFromConfigFile(const mrpt::utils::CConfigFileBase & source,const std::string & section)
+		{
+			for (size_t k=0;k<NUM_FEATURES;k++)
+				coefs[k] = source.read_double(section,feature_name(k),coefs[k]);
+		}
+		void saveToConfigFile(mrpt::utils::CConfigFileBase & out,const std::string & section) const
+		{
+			for (size_t k=0;k<NUM_FEATURES;k++)
+				out.write(section,feature_name(k),coefs[k], /* text width */ 30, 30, "Seconds per unit (optimization cost model)");
+		}
+
+	private:
+		/** Lawson-Hanson: argmin |A*x-b| subject to x>=0. Variables are moved from the active set (x=0) to the passive set one at a time,
+		  * by largest gradient; whenever the unconstrained solution on the passive set has non-positive entries, it steps back towards them. */
+		static Eigen::VectorXd nnls(const Eigen::MatrixXd &A, const Eigen::VectorXd &b)
+		{
+			const size_t n = A.cols();
+			const double tol = 10*std::numeric_limits<double>::epsilon()*A.cwiseAbs().colwise().sum().maxCoeff()*std::max(A.rows(),A.cols());
+
+			Eigen::VectorXd x = Eigen::VectorXd::Zero(n);
+			std::vector<bool> passive(n,false);
+			Eigen::VectorXd w = A.transpose()*(b-A*x);
+
+			for (size_t outer_iter=0;outer_iter<3*n;outer_iter++)
+			{
+				// The active variable with the largest gradient, if any would decrease the error:
+				size_t j_max = n;
+				for (size_t j=0;j<n;j++)
+					if (!passive[j] && w[j]>tol && (j_max==n || w[j]>w[j_max]))
+						j_max = j;
+				if (j_max==n)
+					break;
+				passive[j_max] = true;
+
+				Eigen::VectorXd z;
+				for (;;)
+				{
+					// Unconstrained least squares on the passive set:
+					std::vector<size_t> idxs;
+					for (size_t j=0;j<n;j++)
+						if (passive[j]) idxs.push_back(j);
+					z.setZero(n);
+					if (idxs.empty())
+						break;
+					Eigen::MatrixXd Ap(A.rows(),idxs.size());
+					for (size_t k=0;k<idxs.size();k++)
+						Ap.col(k) = A.col(idxs[k]);
+					const Eigen::VectorXd zp = Ap.colPivHouseholderQr().solve(b);
+					for (size_t k=0;k<idxs.size();k++)
+						z[idxs[k]] = zp[k];
+
+					// Feasible? Otherwise, go from x towards z as far as possible and drop the variables which hit zero:
+					double alpha = 1.0;
+					for (size_t j=0;j<n;j++)
+						if (passive[j] && z[j]<=tol)
+							alpha = std::min(alpha, x[j]>z[j] ? x[j]/(x[j]-z[j]) : 0.0);
+					if (alpha>=1.0)
+						break;
+					x += alpha*(z-x);
+					for (size_t j=0;j<n;j++)
+						if (passive[j] && x[j]<=tol) { passive[j] = false; x[j] = 0; }
+				}
+				x = z;
+				w = A.transpose()*(b-A*x);
+			}
+			return x;
+		}
+
+		static const char* feature_name(const size_t k)
+		{
+			static const char* names[NUM_FEATURES] = { "cost_fixed", "cost_per_obs", "cost_per_jacobian", "cost_per_hessian_block", "cost_per_schur_product", "cost_per_factor_flop" };
+			return names[k];
+		}
+	};
+
 	/** Used in TNewKeyFrameInfo */
 	struct TNewEdgeInfo
 	{
@@ -308,6 +551,25 @@ namespace srba
 	{
 		typedef mrpt::math::MatrixBlockSparseCols<Scalar,NROWS,NCOLS,INFO,HAS_REMAP,INDEX_REMAP_MAP_IMPL> base_t;
 
+		/** Returns the index of the column with the remap index \a remapIndex, or SRBA_INVALID_INDEX if there is none (only if HAS_REMAP). O(1) with map_as_vector */
+		size_t findColByRemapIndex(const size_t remapIndex) const
+		{
+			const INDEX_REMAP_MAP_IMPL &remap = base_t::getColInverseRemappedIndices();
+			const typename INDEX_REMAP_MAP_IMPL::const_iterator it = remap.find(remapIndex);
+			return (it==remap.end()) ? SRBA_INVALID_INDEX : it->second;
+		}
+
+		/** Unlinks the remap index \a remapIndex from its column, so findColByRemapIndex() doesn't find it until appendCol() reuses it (only if HAS_REMAP).
+		  * The column itself is kept, since removing it would shift the indices of all the following ones. */
+		void unmapCol(const size_t remapIndex)
+		{
+			// The base class only gives const access to the map. map_as_vector can't erase keys, so the entry is marked as invalid instead:
+			INDEX_REMAP_MAP_IMPL &remap = const_cast<INDEX_REMAP_MAP_IMPL&>(base_t::getColInverseRemappedIndices());
+			const typename INDEX_REMAP_MAP_IMPL::iterator it = remap.find(remapIndex);
+			if (it!=remap.end())
+				it->second = SRBA_INVALID_INDEX;
+		}
+
 		/** Goes over all the columns and keep the largest span MAX_ROW_INDEX - MIN_ROW_INDEX, the column length */
 		size_t findRowSpan(size_t *row_min_idx=NULL, size_t *row_max_idx=NULL) const
 		{
@@ -389,6 +651,57 @@ namespace srba
 		typedef SparseBlockMatrix<double,OBS_DIMS,LM_DIMS,jacob_dh_df_info_t,  true >   TSparseBlocksJacobians_dh_df;  // The "true" is to "remap" indices
 	};
 
+	/** Persistent store of the information matrices (inverse covariances) of landmarks, as a flat array indexed by landmark ID.
+	  * Entries are only overwritten for those landmarks involved in each optimization, so the last estimated uncertainty of
+	  * landmarks out of the local area is kept and can be queried in O(1) at any time.
+	  * \sa TRBA_Problem_state::unknown_lms_inf_matrices
+	  */
+	template <class MATRIX>
+	struct TLandmarkInfMatrixStore
+	{
+		typedef MATRIX matrix_t;
+
+		TLandmarkInfMatrixStore() : m_num_valid(0) {}
+
+		/** Returns the last information matrix of the given landmark, or NULL if it was never estimated. O(1) */
+		inline const matrix_t * find(const TLandmarkID feat_id) const {
+			return (feat_id<m_entries.size() && m_entries[feat_id].valid) ? &m_entries[feat_id].inf_mat : NULL;
+		}
+
+		/** Sets (or overwrites) the information matrix of the given landmark. Amortized O(1) */
+		void set(const TLandmarkID feat_id, const matrix_t &inf_mat)
+		{
+			if (feat_id>=m_entries.size()) m_entries.resize(feat_id+1);
+			TEntry &e = m_entries[feat_id];
+			if (!e.valid) m_num_valid++;
+			e.valid = true;
+			e.inf_mat = inf_mat;
+		}
+
+		/** Forgets the information matrix of the given landmark, if any. O(1) */
+		void invalidate(const TLandmarkID feat_id)
+		{
+			if (feat_id>=m_entries.size() || !m_entries[feat_id].valid) return;
+			m_entries[feat_id].valid = false;
+			m_num_valid--;
+		}
+
+		inline size_t size() const { return m_num_valid; } //!< Number of landmarks with a valid information matrix
+		void clear() { m_entries.clear(); m_num_valid=0; }
+
+	private:
+		struct TEntry
+		{
+			TEntry() : valid(false) {}
+			bool     valid;
+			matrix_t inf_mat;
+
+			MRPT_MAKE_ALIGNED_OPERATOR_NEW  // Required by Eigen containers
+		};
+		typename mrpt::aligned_containers<TEntry>::deque_t m_entries;
+		size_t m_num_valid;
+	};
+
 	/** Types for the Hessian blocks:
 	  * \code
 	  *       [  H_Ap    |  H_Apf  ]
@@ -412,11 +725,8 @@ namespace srba
 		typedef SparseBlockMatrix<double,LM_DIMS       , LM_DIMS       , hessian_f_info_t  , false> TSparseBlocksHessian_f;
 		typedef SparseBlockMatrix<double,REL_POSE_DIMS , LM_DIMS       , hessian_Apf_info_t, false> TSparseBlocksHessian_Apf;
 
-		/** The list with all the information matrices (estimation uncertainty) for each unknown landmark. */
-		typedef mrpt::utils::map_as_vector<
-			TLandmarkID,
-			typename TSparseBlocksHessian_f::matrix_t,
-			typename mrpt::aligned_containers<std::pair<TLandmarkID,typename TSparseBlocksHessian_f::matrix_t > >::deque_t> landmarks2infmatrix_t;
+		/** The information matrices (estimation uncertainty) for each unknown landmark. */
+		typedef TLandmarkInfMatrixStore<typename TSparseBlocksHessian_f::matrix_t> landmarks2infmatrix_t;
 	};
 
 
@@ -485,17 +795,17 @@ namespace srba
 		/** A set of all the observations made from a new KF, as provided by the user */
 		typedef std::deque<new_kf_observation_t> new_kf_observations_t;
 
-		/** Keyframe-to-feature edge: observations in the problem */
+		/** Keyframe-to-feature edge: observations in the problem.
+		  * The observed data itself is not stored here, but in TRBA_Problem_state::obs_data (indexed like \a all_observations),
+		  * so it can be kept in a compact "cold" format for old keyframes. \sa TRBA_Problem_state::get_observation()
+		  */
 		struct kf_observation_t
 		{
 			inline kf_observation_t() {}
-			inline kf_observation_t(const typename obs_traits_t::observation_t &obs_, const TKeyFrameID kf_id_) : obs(obs_), kf_id(kf_id_) {}
+			inline kf_observation_t(const TLandmarkID feat_id_, const TKeyFrameID kf_id_) : feat_id(feat_id_), kf_id(kf_id_) {}
 
-			typename obs_traits_t::observation_t obs;      //!< Observation data
-			typename obs_traits_t::array_obs_t   obs_arr;  //!< Observation data, summarized as an array of its parameters:  obs.obs_data.getAsArray(obs_arr);
+			TLandmarkID   feat_id;  //!< Observed what
 			TKeyFrameID   kf_id;    //!< Observed from
-
-			MRPT_MAKE_ALIGNED_OPERATOR_NEW  // This forces aligned mem allocation
 		};
 
 
@@ -503,9 +813,13 @@ namespace srba
 		struct k2f_edge_t
 		{
 			kf_observation_t  obs;
+			typename lm_traits_t::TRelativeLandmarkPos *feat_rel_pos; //!< Pointer to the known/unknown rel.pos. (always!=NULL)
 			bool              feat_has_known_rel_pos;   //!< whether it's a known or unknown relative position feature
 			bool              is_first_obs_of_unknown;  //!< true if this is the first observation of a feature with unknown relative position
-			typename lm_traits_t::TRelativeLandmarkPos *feat_rel_pos; //!< Pointer to the known/unknown rel.pos. (always!=NULL)
+			bool              is_removed;               //!< Tombstone: the observation was removed (RbaEngine::remove_observation()) and will be purged in the next RbaEngine::compact_observations()
+			size_t            num_dh_dAp_blocks;        //!< Number of blocks of this observation in the Jacobian dh_dAp (the length of the kf2kf path to the landmark base KF when it was added)
+			size_t            next_obs_same_lm;         //!< Index (in all_observations) of the next observation of the same landmark, or SRBA_INVALID_INDEX
+			mutable bool      has_numeric_jacob;        //!< Whether RbaEngine::m_numeric_jacob_cache has an entry for this observation, so the common case (none) needs no lock
 
 			MRPT_MAKE_ALIGNED_OPERATOR_NEW  // This forces aligned mem allocation
 		};
@@ -515,6 +829,7 @@ namespace srba
 		{
 			std::deque<k2k_edge_t*>  adjacent_k2k_edges;
 			std::deque<k2f_edge_t*>  adjacent_k2f_edges;
+			std::vector<std::pair<TKeyFrameID,size_t> > adjacent_kfs_sorted; //!< (adjacent KF ID, k2k edge ID) for each entry in \a adjacent_k2k_edges, sorted by KF ID for fast edge-existence queries \sa TRBA_Problem_state::find_kf2kf_edge()
 		};
 
 	}; // end of "rba_joint_parameterization_traits_t"
@@ -527,6 +842,384 @@ namespace srba
 		topo_dist_t distance; //!< Remaining distance until the given target from this point.
 	};
 
+	/** Storage of the raw data of all observations (one \a array_obs_t per observation), indexed by observation index (same as TRBA_Problem_state::all_observations).
+	  * Data is stored in chunks of CHUNK_SIZE observations. Each chunk can be either "hot" (double precision, as used by optimizers) or "cold" (single precision, half the memory).
+	  * Chunks of old keyframes are moved to cold storage with move_to_cold_storage(), and they are transparently rehydrated
+	  * into the hot format by make_hot() when an optimization touches any of their observations again.
+	  * \note Cold storage is lossy: it keeps only ~7 significant digits, well below any realistic sensor noise. Hot observations keep
+	  *  their full double precision until their chunk is moved to cold storage, so they may change slightly (once) at that point.
+	  */
+	template <class obs_t>
+	struct TObservationDataStore
+	{
+		typedef typename observation_traits<obs_t>::array_obs_t  array_obs_t;
+		static const size_t OBS_DIMS   = obs_t::OBS_DIMS;
+		static const size_t CHUNK_SIZE = 512; //!< Number of observations in each chunk
+
+		TObservationDataStore() : m_size(0), m_num_cold_chunks(0), m_first_new_chunk(0) { }
+
+		/** Allocates at once the chunks for a total of \a n observations, e.g. before appending all those of a new KF. */
+		void reserve(const size_t n)
+		{
+			while (m_chunks.size()*CHUNK_SIZE<n)
+			{
+				m_chunks.push_back(TChunk());
+				m_chunks.back().hot.reserve(CHUNK_SIZE);
+			}
+		}
+
+		/** Appends the data of a new observation, made from keyframe \a kf_id, in hot storage. O(1) */
+		void push_back(const array_obs_t &obs_arr, const TKeyFrameID kf_id)
+		{
+			const size_t ic = m_size / CHUNK_SIZE; // The chunk being filled (there may be more, from reserve())
+			reserve(m_size+1);
+			TChunk &c = m_chunks[ic];
+			if (c.is_cold) rehydrate(ic);
+			c.hot.push_back(obs_arr);
+			c.max_kf_id = (c.hot.size()==1) ? kf_id : std::max(c.max_kf_id,kf_id);
+			m_size++;
+		}
+
+		/** Gets the data of the i'th observation, no matter if it is in hot or cold storage. O(1) */
+		inline void get(const size_t obs_idx, array_obs_t &out_obs_arr) const
+		{
+			ASSERTDEB_(obs_idx<m_size)
+			const TChunk &c = m_chunks[obs_idx / CHUNK_SIZE];
+			const size_t i = obs_idx % CHUNK_SIZE;
+			if (!c.is_cold)
+				out_obs_arr = c.hot[i];
+			else
+				for (size_t k=0;k<OBS_DIMS;k++) out_obs_arr[k] = c.cold[i*OBS_DIMS+k];
+		}
+
+		/** Direct access to the data of the i'th observation, which must be in hot storage (call make_hot() first). O(1) */
+		inline const array_obs_t & get_hot(const size_t obs_idx) const
+		{
+			ASSERTDEB_(obs_idx<m_size)
+			const TChunk &c = m_chunks[obs_idx / CHUNK_SIZE];
+			ASSERTDEB_(!c.is_cold)
+			return c.hot[obs_idx % CHUNK_SIZE];
+		}
+
+		/** Makes sure the chunk with the i'th observation is in hot storage. O(1) if it already was. */
+		inline void make_hot(const size_t obs_idx)
+		{
+			ASSERTDEB_(obs_idx<m_size)
+			const size_t ic = obs_idx / CHUNK_SIZE;
+			if (m_chunks[ic].is_cold) rehydrate(ic);
+		}
+
+		/** Moves to cold storage all the full chunks whose observations were all made from keyframes with IDs < \a min_hot_kf_id.
+		  * Only the chunks rehydrated since the last call and those never moved before are checked; since the latter are filled in order of
+		  * observing KFs, this stops at the first one still too recent. O(number of chunks moved)
+		  * \return The number of chunks moved to cold storage in this call. */
+		size_t move_to_cold_storage(const TKeyFrameID min_hot_kf_id)
+		{
+			size_t nMoved = 0;
+
+			// Rehydrated chunks, unless they're still too recent (e.g. a KF whose observations were split among several chunks):
+			size_t nKept = 0;
+			for (size_t i=0;i<m_rehydrated_chunks.size();i++)
+			{
+				const size_t ic = m_rehydrated_chunks[i];
+				if (m_chunks[ic].max_kf_id<min_hot_kf_id) { freeze(m_chunks[ic]); nMoved++; }
+				else m_rehydrated_chunks[nKept++] = ic;
+			}
+			m_rehydrated_chunks.resize(nKept);
+
+			// Chunks never moved before:
+			while ((m_first_new_chunk+1)*CHUNK_SIZE<m_size // Never the one still being filled, nor those reserved after it
+				&& m_chunks[m_first_new_chunk].max_kf_id<min_hot_kf_id)
+			{
+				freeze(m_chunks[m_first_new_chunk++]);
+				nMoved++;
+			}
+			return nMoved;
+		}
+
+		inline size_t size() const { return m_size; }
+		inline size_t num_chunks() const { return m_chunks.size(); }
+		inline size_t num_cold_chunks() const { return m_num_cold_chunks; }
+
+		void clear() {
+			m_chunks.clear();
+			m_size = 0;
+			m_num_cold_chunks = 0;
+			m_first_new_chunk = 0;
+			m_rehydrated_chunks.clear();
+		}
+
+		void swap(TObservationDataStore &o) {
+			m_chunks.swap(o.m_chunks);
+			std::swap(m_size,o.m_size);
+			std::swap(m_num_cold_chunks,o.m_num_cold_chunks);
+			std::swap(m_first_new_chunk,o.m_first_new_chunk);
+			m_rehydrated_chunks.swap(o.m_rehydrated_chunks);
+		}
+
+	private:
+		struct TChunk
+		{
+			TChunk() : is_cold(false), max_kf_id(0) {}
+
+			bool        is_cold;
+			TKeyFrameID max_kf_id; //!< The largest observing KF ID of all the observations in this chunk
+			typename mrpt::aligned_containers<array_obs_t>::vector_t  hot;  //!< Valid if !is_cold
+			std::vector<float>                                        cold; //!< Valid if is_cold: CHUNK_SIZE*OBS_DIMS values
+		};
+
+		void freeze(TChunk &c)
+		{
+			ASSERTDEB_(!c.is_cold)
+			c.cold.resize(c.hot.size()*OBS_DIMS);
+			for (size_t i=0;i<c.hot.size();i++)
+				for (size_t k=0;k<OBS_DIMS;k++)
+					c.cold[i*OBS_DIMS+k] = static_cast<float>(c.hot[i][k]);
+			typename mrpt::aligned_containers<array_obs_t>::vector_t().swap(c.hot); // Really free the memory
+			c.is_cold = true;
+			m_num_cold_chunks++;
+		}
+
+		void rehydrate(const size_t ic)
+		{
+			TChunk &c = m_chunks[ic];
+			ASSERTDEB_(c.is_cold)
+			const size_t N = c.cold.size()/OBS_DIMS;
+			c.hot.resize(N);
+			for (size_t i=0;i<N;i++)
+				for (size_t k=0;k<OBS_DIMS;k++)
+					c.hot[i][k] = c.cold[i*OBS_DIMS+k];
+			std::vector<float>().swap(c.cold);
+			c.is_cold = false;
+			m_num_cold_chunks--;
+			m_rehydrated_chunks.push_back(ic);
+		}
+
+		std::deque<TChunk> m_chunks;
+		size_t             m_size;
+		size_t             m_num_cold_chunks;
+		size_t             m_first_new_chunk;    //!< Chunks before this one were moved to cold storage at least once
+		std::vector<size_t> m_rehydrated_chunks; //!< Chunks rehydrated and not moved back to cold storage yet
+	};
+
+	/** Storage of the "numeric" spanning trees: the relative pose of each keyframe wrt any other one in its spanning tree (TRBA_Problem_state::TSpanningTree::num).
+	  * Only one canonical direction is stored for each pair of keyframes (i,j), with i>j (the same convention than TSpanningTree::TSpanningTreeSym::all_edges):
+	  * the pose of "j" as seen from "i". Each root "i" keeps its poses in a flat array of blocks of BLOCK_SIZE aligned entries (never reallocated,
+	  * so pointers to them are never invalidated) plus an index by "j", a std::map so insertions are O(log N) and references to entries stay valid too.
+	  *
+	  * The inverse direction (j,i) is computed on the fly by get(). Only if a persistent pointer to it is requested with get_ref() (e.g. by the symbolic
+	  * Jacobians), a copy of the inverse is cached next to the canonical pose, and update_pose() keeps both in sync.
+	  *
+	  * Poses are stamped with the generation at which they were computed (0: never computed, or marked as outdated). Modifying an edge stamps it with
+	  * a new generation in O(1) (see TRBA_Problem_state::TSpanningTree::mark_edge_modified()), so a pose is outdated if it's older than any edge in its path.
+	  * The newest generation of each path is cached in its entry until another edge is modified, see is_updated(e,path).
+	  */
+	template <class kf2kf_pose_t>
+	struct TNumericSpanningTree
+	{
+		typedef typename kf2kf_pose_traits<kf2kf_pose_t>::pose_t       pose_t;
+		typedef typename kf2kf_pose_traits<kf2kf_pose_t>::pose_flag_t  pose_flag_t;
+		static const size_t BLOCK_SIZE = 32; //!< Number of poses in each block of the per-root arrays
+
+		/** One canonical pair (i,j), i>j, in the table of root "i" */
+		struct TEntry
+		{
+			TEntry() : target(SRBA_INVALID_KEYFRAMEID), direct(NULL), inverse(NULL), path_generation(0), path_checked_at(0) {}
+
+			TKeyFrameID  target;  //!< "j"
+			pose_flag_t *direct;  //!< Pose of "j" as seen from "i"
+			pose_flag_t *inverse; //!< Pose of "i" as seen from "j", or NULL if no persistent pointer to it was ever requested.
+			uint64_t     path_generation; //!< Newest generation of the edges in the path (i,j), as of \a path_checked_at
+			uint64_t     path_checked_at; //!< Generation when \a path_generation was computed (0: never)
+		};
+
+		TNumericSpanningTree() : m_num_entries(0), m_num_inverses(0), m_generation(1), m_last_edge_change(0) { }
+
+		/** Returns the pose of \a to as seen from \a from, or NULL if it's not in the table or if from<to and its inverse is not cached. O(log N), N=size of the spanning tree. */
+		const pose_flag_t * find(const TKeyFrameID from, const TKeyFrameID to) const
+		{
+			const TEntry *e = find_entry(std::max(from,to),std::min(from,to));
+			if (!e) return NULL;
+			return (from>to) ? e->direct : e->inverse;
+		}
+
+		/** Gets the pose of \a to as seen from \a from in any direction, inverting the canonical pose on the fly if needed. O(log N)
+		  * \return false if the pair is not in the table. */
+		bool get(const TKeyFrameID from, const TKeyFrameID to, pose_t &out_pose) const
+		{
+			const TEntry *e = find_entry(std::max(from,to),std::min(from,to));
+			if (!e) return false;
+			if (from>to)         out_pose = e->direct->pose;
+			else if (e->inverse) out_pose = e->inverse->pose;
+			else                 out_pose = -e->direct->pose;
+			return true;
+		}
+
+		/** Returns a persistent reference to the pose of \a to as seen from \a from, creating the entry (marked as outdated) and, if from<to, the cached inverse if they didn't exist yet.
+		  * Use it to keep pointers to numeric poses (e.g. in the symbolic Jacobians). O(log N) */
+		pose_flag_t & get_ref(const TKeyFrameID from, const TKeyFrameID to)
+		{
+			ASSERTDEB_(from!=to)
+			TEntry &e = get_entry(std::max(from,to),std::min(from,to));
+			if (from>to) return *e.direct;
+			if (!e.inverse)
+			{
+				e.inverse = alloc_pose(m_roots[to]);
+				e.inverse->pose = -e.direct->pose;
+				e.inverse->generation = e.direct->generation;
+				m_num_inverses++;
+			}
+			return *e.inverse;
+		}
+
+		/** Returns the entry for the canonical pair (i,j), i>j, creating it (marked as outdated) if it didn't exist.
+		  * The reference remains valid while the entry exists, even if other entries are created later. O(log N) */
+		TEntry & get_entry(const TKeyFrameID i, const TKeyFrameID j)
+		{
+			ASSERTDEB_(i>j)
+			if (i>=m_roots.size()) m_roots.resize(i+1);
+			TRootTable &t = m_roots[i];
+			typename entry_index_t::iterator it = t.index.lower_bound(j);
+			if (it==t.index.end() || it->first!=j)
+			{
+				TEntry e;
+				e.target = j;
+				e.direct = alloc_pose(t);
+				it = t.index.insert(it, typename entry_index_t::value_type(j,e));
+				m_num_entries++;
+			}
+			return it->second;
+		}
+
+		/** Whether the canonical pose of a pair and its cached inverse (if any) were computed and not marked as outdated since then */
+		static inline bool is_updated(const TEntry &e) {
+			return e.direct->updated() && (!e.inverse || e.inverse->updated());
+		}
+
+		/** Whether the canonical pose of a pair and its cached inverse (if any) are up-to-date with the edges in \a path, the path of the pair
+		  * in the symbolic spanning tree: they must not be marked as outdated, and no edge in the path can be newer than them.
+		  * O(1) if no edge was modified since the poses were computed or since the last check of this path; O(length of the path) otherwise. */
+		template <class K2K_EDGE_VECTOR>
+		bool is_updated(TEntry &e, const K2K_EDGE_VECTOR &path) const
+		{
+			if (!is_updated(e)) return false;
+			const uint64_t pose_gen = e.inverse ? std::min(e.direct->generation,e.inverse->generation) : e.direct->generation;
+			if (pose_gen>=m_last_edge_change)
+				return true;
+			if (e.path_checked_at<m_last_edge_change)
+			{
+				uint64_t g = 0;
+				for (typename K2K_EDGE_VECTOR::const_iterator it=path.begin();it!=path.end();++it)
+					g = std::max(g,(*it)->generation);
+				e.path_generation = g;
+				e.path_checked_at = m_generation;
+			}
+			return pose_gen>=e.path_generation;
+		}
+
+		/** Marks the canonical pose of the pair (i,j), i>j, and its cached inverse (if any) as outdated, e.g. because its path changed. Does nothing if the pair is not in the table. O(log N) */
+		void mark_outdated(const TKeyFrameID i, const TKeyFrameID j)
+		{
+			const TEntry *e = find_entry(i,j);
+			if (!e) return;
+			e->direct->mark_outdated();
+			if (e->inverse) e->inverse->mark_outdated();
+			const_cast<TEntry*>(e)->path_checked_at = 0;
+		}
+
+		/** Saves a new value for the canonical pose of a pair, and its inverse if it is cached, stamping both with the current generation. */
+		inline void update_pose(TEntry &e, const pose_t &pose_j_wrt_i) const
+		{
+			e.direct->pose = pose_j_wrt_i;
+			e.direct->generation = m_generation;
+			if (e.inverse)
+			{
+				e.inverse->pose = -pose_j_wrt_i; // unary "-" operator inverts SE(3) poses
+				e.inverse->generation = m_generation;
+			}
+		}
+
+		/** Starts a new generation for a modified edge and returns it, to be saved in k2k_edge_t::generation: the poses computed before are outdated
+		  * if their paths go thru that edge, and those computed from now on are stamped with it. O(1) */
+		inline uint64_t new_generation() { m_last_edge_change = ++m_generation; return m_generation; }
+		inline uint64_t current_generation() const { return m_generation; }
+
+		/** Calls f(from,to,pose_flag) for all the stored poses, including the cached inverses */
+		template <class FUNCTOR>
+		void for_each_pose(FUNCTOR &f)
+		{
+			for (size_t i=0;i<m_roots.size();i++)
+				for (typename entry_index_t::iterator it=m_roots[i].index.begin();it!=m_roots[i].index.end();++it)
+				{
+					TEntry &e = it->second;
+					f(static_cast<TKeyFrameID>(i),e.target,*e.direct);
+					if (e.inverse) f(e.target,static_cast<TKeyFrameID>(i),*e.inverse);
+				}
+		}
+
+		/** \overload Calls f(from,to,const pose_flag) */
+		template <class FUNCTOR>
+		void for_each_pose(FUNCTOR &f) const
+		{
+			for (size_t i=0;i<m_roots.size();i++)
+				for (typename entry_index_t::const_iterator it=m_roots[i].index.begin();it!=m_roots[i].index.end();++it)
+				{
+					const TEntry &e = it->second;
+					f(static_cast<TKeyFrameID>(i),e.target,static_cast<const pose_flag_t&>(*e.direct));
+					if (e.inverse) f(e.target,static_cast<TKeyFrameID>(i),static_cast<const pose_flag_t&>(*e.inverse));
+				}
+		}
+
+		inline size_t size() const { return m_num_entries; }  //!< Number of canonical pairs (i,j), i>j
+		inline size_t num_cached_inverses() const { return m_num_inverses; }
+
+		void clear() {
+			m_roots.clear();
+			m_num_entries = 0;
+			m_num_inverses = 0;
+			m_generation = 1;
+			m_last_edge_change = 0;
+		}
+
+	private:
+		typedef typename mrpt::aligned_containers<pose_flag_t>::vector_t  pose_block_t;
+		typedef std::map<TKeyFrameID,TEntry>                              entry_index_t;
+
+		struct TRootTable
+		{
+			TRootTable() : num_poses(0) {}
+
+			entry_index_t              index;     //!< Indexed by target ID
+			std::deque<pose_block_t>   blocks;    //!< Canonical poses and cached inverses, BLOCK_SIZE poses per block
+			size_t                     num_poses;
+		};
+
+		const TEntry * find_entry(const TKeyFrameID i, const TKeyFrameID j) const
+		{
+			if (i>=m_roots.size()) return NULL;
+			const entry_index_t &idx = m_roots[i].index;
+			typename entry_index_t::const_iterator it = idx.find(j);
+			return (it==idx.end()) ? NULL : &it->second;
+		}
+
+		static pose_flag_t * alloc_pose(TRootTable &t)
+		{
+			if (t.num_poses==t.blocks.size()*BLOCK_SIZE)
+			{
+				t.blocks.push_back(pose_block_t());
+				t.blocks.back().reserve(BLOCK_SIZE); // Never grows beyond this, so it's never reallocated
+			}
+			t.blocks.back().push_back(pose_flag_t());
+			t.num_poses++;
+			return &t.blocks.back().back();
+		}
+
+		std::deque<TRootTable> m_roots;  //!< Index are "TKeyFrameID" IDs of the roots (the larger ID of each pair). A deque never invalidates references when growing.
+		size_t m_num_entries, m_num_inverses;
+		uint64_t m_generation;       //!< Current generation; starts at 1 so 0 means "never computed"
+		uint64_t m_last_edge_change; //!< Generation of the last modified edge
+	};
+
 	/** All the important data of a RBA problem at any given instant of time
 	  *  Operations on this structure are performed via the public API of srba::RbaEngine
 	  * \sa RbaEngine
@@ -539,6 +1232,7 @@ namespace srba
 		typedef typename kf2kf_pose_traits<kf2kf_pose_t>::k2k_edge_vector_t  k2k_edge_vector_t;
 		typedef typename kf2kf_pose_traits<kf2kf_pose_t>::frameid2pose_map_t frameid2pose_map_t;
 		typedef typename kf2kf_pose_traits<kf2kf_pose_t>::pose_flag_t        pose_flag_t;
+		typedef typename kf2kf_pose_traits<kf2kf_pose_t>::k2k_edge_priors_t  k2k_edge_priors_t;
 		typedef typename landmark_traits<landmark_t>::TRelativeLandmarkPosMap TRelativeLandmarkPosMap;
 		typedef typename landmark_traits<landmark_t>::TLandmarkEntry          TLandmarkEntry;
 		typedef typename hessian_traits<kf2kf_pose_t,landmark_t,obs_t>::landmarks2infmatrix_t   landmarks2infmatrix_t;
@@ -568,6 +1262,8 @@ namespace srba
 				std::deque<std::pair<TKeyFrameID,std::map<TKeyFrameID, k2k_edge_vector_t > > >
 				> all_edges_maps_t;
 
+			typedef TNumericSpanningTree<kf2kf_pose_t> num_spanning_tree_t;
+
 			const TRBA_Problem_state<kf2kf_pose_t,landmark_t,obs_t,RBA_OPTIONS> *m_parent;
 
 			/** @name Data structures
@@ -595,15 +1291,15 @@ namespace srba
 			sym;
 
 			/** "Numeric" spanning tree: the SE(3) pose of each node wrt to any other:
-			  *   num[SOURCE] |--> map[TARGET] = CPose3D of TARGET as seen from SOURCE
+			  *   num.get(SOURCE,TARGET) = CPose3D of TARGET as seen from SOURCE
 			  *   (typ: SOURCE is the observing KF, TARGET is the reference base of the observed landmark)
 			  *
 			  *  Numeric poses are valid after calling \a update_numeric()
 			  *
-			  *  NOTE: Both symmetric poses, e.g. (i,j) and also (j,i), are stored for convenience of
-			  *         being able to get references/pointers to them.
+			  *  NOTE: Only one direction (i,j), i>j, is stored for each pair. The inverse (j,i) is only kept (and updated)
+			  *         for those entries whose references/pointers were requested with num.get_ref(), e.g. for the Jacobians.
 			  */
-			typename kf2kf_pose_traits<kf2kf_pose_t>::TRelativePosesForEachTarget num;
+			num_spanning_tree_t num;
 
 			/** @} */
 
@@ -616,14 +1312,25 @@ namespace srba
 
 			/** Incremental update of spanning trees after the insertion of ONE new node and ONE OR MORE edges
 			  * \param[in] max_distance Is the maximum distance at which a neighbor can be so we store the shortest path to it.
+			  * \param[in,out] pending_paths If not NULL, the paths in \a sym.all_edges which must be rebuilt are only added to this set
+			  *  (as (max,min) KF ID pairs), so the caller can rebuild them once, with update_symbolic_paths(), after inserting several edges.
 			  */
 			void update_symbolic_new_node(
 				const TKeyFrameID                    new_node_id,
 				const TPairKeyFrameID & new_edge,
-				const topo_dist_t                    max_depth
+				const topo_dist_t                    max_depth,
+				std::set<TPairKeyFrameID>          * pending_paths = NULL
 				);
 
+			/** Rebuilds the shortest paths in \a sym.all_edges between each pair of KFs (with first>second), with one BFS per pair, and marks their numeric poses as outdated. */
+			void update_symbolic_paths(const std::set<TPairKeyFrameID> & kf_pairs);
+
+			/** Must be called after modifying the value of a k2k edge (k2k_edge_t::inv_pose) anywhere: stamps it with a new generation, so all the numeric
+			  * poses whose paths go thru it become outdated and the next update_numeric() with skip_marked_as_uptodate=true recomputes them. O(1) */
+			void mark_edge_modified(const size_t edge_id);
+
 			/** Updates all the numeric SE(3) poses from ALL the \a sym.all_edges
+			  * \param[in] skip_marked_as_uptodate If true, only recompute the outdated poses (see TNumericSpanningTree::is_updated(e,path), mark_edge_modified())
 			  * \return The number of updated poses.
 			  */
 			size_t update_numeric(bool skip_marked_as_uptodate = false);
@@ -636,6 +1343,24 @@ namespace srba
 			  */
 			size_t update_numeric_only_all_from_node( const typename all_edges_maps_t::const_iterator & it,bool skip_marked_as_uptodate = false);
 
+			/** One numeric pose, given by its canonical pair (i,j), i>j, and the path in \a sym.all_edges[i][j] to recompute it. See update_numeric_poses() */
+			struct TNumericPosePath
+			{
+				TNumericPosePath() : from(SRBA_INVALID_KEYFRAMEID), to(SRBA_INVALID_KEYFRAMEID), entry(NULL), path(NULL) {}
+
+				TKeyFrameID                            from;  //!< "i"
+				TKeyFrameID                            to;    //!< "j"
+				typename num_spanning_tree_t::TEntry * entry; //!< num.get_entry(i,j)
+				const k2k_edge_vector_t              * path;  //!< sym.all_edges[i][j]
+			};
+			typedef std::vector<TNumericPosePath> numeric_pose_path_list_t;
+
+			/** Unconditionally recomputes only the given numeric poses. Since neither the structure of \a num nor any other pose or edge is touched,
+			  *  several threads can call this at once for disjoint lists of poses (see RbaEngine::optimize_new_edges_alone()).
+			  * \return The number of updated poses.
+			  */
+			size_t update_numeric_poses(const numeric_pose_path_list_t & poses);
+
 			/** @} */
 
 			/** @name Spanning tree misc. operations
@@ -688,8 +1413,9 @@ namespace srba
 
 		keyframe_vector_t       keyframes;   //!< All key frames (global poses are not included in an RBA problem). Vector indices are "TKeyFrameID" IDs.
 		k2k_edges_deque_t       k2k_edges;   //!< (unknowns) All keyframe-to-keyframe edges
+		k2k_edge_priors_t       k2k_edge_priors; //!< Prior factors of some kf2kf edges, by edge ID (see RbaEngine::define_new_keyframe())
 		TRelativeLandmarkPosMap unknown_lms; //!< (unknown values) Landmarks with an unknown fixed 3D position relative to their base frame_id
-		landmarks2infmatrix_t   unknown_lms_inf_matrices; //!< Information matrices that model the uncertainty in each XYZ position for the unknown LMs - these matrices should be already scaled according to the camera noise in pixel standard deviations.
+		landmarks2infmatrix_t   unknown_lms_inf_matrices; //!< Information matrices that model the uncertainty in each XYZ position for the unknown LMs - these matrices should be already scaled according to the camera noise in pixel standard deviations. Kept for all landmarks, not only for those in the last optimization.
 		TRelativeLandmarkPosMap known_lms;   //!< (known values) Landmarks with a known, fixed 3D position relative to their base frame_id
 
 		/** Index (by feat ID) of ALL landmarks stored in \a unknown_lms and \a known_lms.
@@ -698,6 +1424,7 @@ namespace srba
 
 		TSpanningTree            spanning_tree;
 		all_observations_deque_t all_observations;  //!< All raw observation data (k2f edges)
+		TObservationDataStore<obs_t> obs_data;       //!< The observed values of each entry in \a all_observations (same indices), in hot or cold storage.
 		TLinearSystem            lin_system;        //!< The sparse linear system of equations
 
 		/** Its size grows simultaneously to all_observations, its values are updated during optimization to
@@ -707,23 +1434,41 @@ namespace srba
 		  */
 		std::deque<char>       all_observations_Jacob_validity;
 
+		size_t                 num_removed_observations; //!< Number of tombstones (k2f_edge_t::is_removed) in \a all_observations
+
 		/** @} */
 
 		/** Empties all members */
 		void clear() {
 			keyframes.clear();
 			k2k_edges.clear();
+			k2k_edge_priors.clear();
 			unknown_lms.clear();
 			unknown_lms_inf_matrices.clear();
 			known_lms.clear();
 			all_lms.clear();
 			spanning_tree.clear();
 			all_observations.clear();
+			obs_data.clear();
 			lin_system.clear();
+			all_observations_Jacob_validity.clear();
+			num_removed_observations = 0;
+		}
+
+		/** Rebuilds the full typed observation (feature ID + data) of the given observation index (in \a all_observations). O(1) */
+		typename observation_traits<obs_t>::observation_t get_observation(const size_t obs_idx) const
+		{
+			typename observation_traits<obs_t>::array_obs_t  obs_arr;
+			obs_data.get(obs_idx, obs_arr);
+
+			typename observation_traits<obs_t>::observation_t o;
+			o.feat_id = all_observations[obs_idx].obs.feat_id;
+			o.obs_data.setFromArray(obs_arr);
+			return o;
 		}
 
 		/** Ctor */
-		TRBA_Problem_state() {
+		TRBA_Problem_state() : num_removed_observations(0) {
 			spanning_tree.m_parent=this; // Not passed as ctor argument to avoid compiler warnings...
 		}
 
@@ -746,15 +1491,20 @@ namespace srba
 			double &out_std_degree,
 			double &out_max_degree) const;
 
-		/** Returns true if the pair of KFs are connected thru a kf2kf edge, no matter the direction of the edge. Runs in worst-case O(D) with D the degree of the KF graph (that is, the maximum number of edges adjacent to one KF) */
-		bool are_keyframes_connected(const TKeyFrameID id1, const TKeyFrameID id2) const;
+		/** Returns true if the pair of KFs are connected thru a kf2kf edge, no matter the direction of the edge. Runs in O(log(D)) with D the degree of \a id1 */
+		bool are_keyframes_connected(const TKeyFrameID id1, const TKeyFrameID id2) const { return find_kf2kf_edge(id1,id2)!=SRBA_INVALID_INDEX; }
+
+		/** Returns the ID of the kf2kf edge between the two KFs (no matter its direction), or SRBA_INVALID_INDEX if they are not directly connected.
+		  * Runs in O(log(D)) with D the degree of \a id1 */
+		size_t find_kf2kf_edge(const TKeyFrameID id1, const TKeyFrameID id2) const;
 
 		/** Creates a new kf2kf edge variable. Called from create_kf2kf_edge()
 		  *
 		  * \param[in] init_inv_pose_val The initial value for the inverse pose stored in edge first->second, i.e. the pose of first wrt. second.
 		  * \return The ID of the new kf2kf edge, which coincides with the 0-based index of the new entry in "rba_state.k2k_edges"
 		  *
-		  * \note Runs in O(1)
+		  * \note Runs in O(D) with D the degree of the two KFs (the update of their sorted lists of adjacent KFs), an O(D) memmove in practice
+		  * \exception std::exception If there is already an edge between the two KFs
 		  */
 		size_t alloc_kf2kf_edge(
 			const TPairKeyFrameID &ids,
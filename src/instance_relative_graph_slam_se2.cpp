@@ -0,0 +1,30 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+/* See srba_engine_factory.cpp for docs */
+
+#include <srba/impl/engine_facade_adapter.h>
+
+namespace srba {
+namespace internal
+{
+	struct options_relative_graph_slam_se2 : public RBA_OPTIONS_DEFAULT
+	{
+		typedef options::observation_noise_constant_matrix<observations::RelativePoses_2D> obs_noise_matrix_t; // Default: identity information matrix
+	};
+
+	// Explicit instantiation (all ECPs and solvers):
+	template struct rba_engine_facade_factory<kf2kf_poses::SE2,landmarks::RelativePoses2D,observations::RelativePoses_2D,options_relative_graph_slam_se2>;
+
+	IRbaEngine * create_rba_engine_relative_graph_slam_se2(const TRbaEngineConfig &cfg)
+	{
+		return rba_engine_facade_factory<kf2kf_poses::SE2,landmarks::RelativePoses2D,observations::RelativePoses_2D,options_relative_graph_slam_se2>::create(cfg);
+	}
+
+} } // end NS
@@ -0,0 +1,25 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+/* See srba_engine_factory.cpp for docs */
+
+#include <srba/impl/engine_facade_adapter.h>
+
+namespace srba {
+namespace internal
+{
+	// Explicit instantiation (all ECPs and solvers):
+	template struct rba_engine_facade_factory<kf2kf_poses::SE3,landmarks::Euclidean3D,observations::Cartesian_3D,RBA_OPTIONS_DEFAULT>;
+
+	IRbaEngine * create_rba_engine_se3_lm3d_cartesian3d(const TRbaEngineConfig &cfg)
+	{
+		return rba_engine_facade_factory<kf2kf_poses::SE3,landmarks::Euclidean3D,observations::Cartesian_3D,RBA_OPTIONS_DEFAULT>::create(cfg);
+	}
+
+} } // end NS
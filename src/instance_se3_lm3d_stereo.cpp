@@ -0,0 +1,31 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+/* See srba_engine_factory.cpp for docs */
+
+#include <srba/impl/engine_facade_adapter.h>
+
+namespace srba {
+namespace internal
+{
+	struct options_se3_lm3d_stereo : public RBA_OPTIONS_DEFAULT
+	{
+		typedef options::sensor_pose_on_robot_se3     sensor_pose_on_robot_t;
+		typedef options::observation_noise_identity   obs_noise_matrix_t;
+	};
+
+	// Explicit instantiation (all ECPs and solvers):
+	template struct rba_engine_facade_factory<kf2kf_poses::SE3,landmarks::Euclidean3D,observations::StereoCamera,options_se3_lm3d_stereo>;
+
+	IRbaEngine * create_rba_engine_se3_lm3d_stereo(const TRbaEngineConfig &cfg)
+	{
+		return rba_engine_facade_factory<kf2kf_poses::SE3,landmarks::Euclidean3D,observations::StereoCamera,options_se3_lm3d_stereo>::create(cfg);
+	}
+
+} } // end NS
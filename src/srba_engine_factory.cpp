@@ -0,0 +1,109 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+/* The "srba-engines" library: precompiled RbaEngine<> instances behind the IRbaEngine interface (see srba/srba_engine_facade.h).
+ *
+ * Each problem type (kf2kf pose, landmark and observation types) is instantiated in its own instance_*.cpp file, for all the
+ * ECPs and solvers supported by internal::rba_engine_facade_factory, to avoid huge RAM requirements while compiling.
+ * To add a new problem type, add a new instance_*.cpp file and its entry in the table below.
+ */
+
+#include <srba/srba_engine_facade.h>
+#include <mrpt/utils/CConfigFileBase.h>
+#include <stdexcept>
+
+using namespace srba;
+
+namespace srba {
+namespace internal
+{
+	// Defined in the instance_*.cpp files:
+	IRbaEngine * create_rba_engine_se3_lm3d_cartesian3d(const TRbaEngineConfig &cfg);
+	IRbaEngine * create_rba_engine_se3_lm3d_monocular(const TRbaEngineConfig &cfg);
+	IRbaEngine * create_rba_engine_se3_lm3d_stereo(const TRbaEngineConfig &cfg);
+	IRbaEngine * create_rba_engine_se2_lm2d_rangebearing2d(const TRbaEngineConfig &cfg);
+	IRbaEngine * create_rba_engine_relative_graph_slam_se2(const TRbaEngineConfig &cfg);
+
+	struct TEngineProblemEntry
+	{
+		const char * kf2kf_pose;
+		const char * landmark;
+		const char * observation;
+		IRbaEngine * (*creator)(const TRbaEngineConfig &cfg); //!< Returns NULL for unknown ECPs or solvers
+	};
+
+	const TEngineProblemEntry engine_problems[] = {
+		{ "SE3", "Euclidean3D",     "Cartesian_3D",     &create_rba_engine_se3_lm3d_cartesian3d },
+		{ "SE3", "Euclidean3D",     "MonocularCamera",  &create_rba_engine_se3_lm3d_monocular },
+		{ "SE3", "Euclidean3D",     "StereoCamera",     &create_rba_engine_se3_lm3d_stereo },
+		{ "SE2", "Euclidean2D",     "RangeBearing_2D",  &create_rba_engine_se2_lm2d_rangebearing2d },
+		{ "SE2", "RelativePoses2D", "RelativePoses_2D", &create_rba_engine_relative_graph_slam_se2 }
+	};
+	const size_t num_engine_problems = sizeof(engine_problems)/sizeof(engine_problems[0]);
+} }
+
+TRbaEngineConfig::TRbaEngineConfig() :
+	kf2kf_pose("SE3"),
+	landmark("Euclidean3D"),
+	observation("Cartesian_3D"),
+	solver("LM_schur_dense_cholesky"),
+	ecp("local_areas_fixed_size")
+{
+}
+
+void TRbaEngineConfig::loadFromConfigFile(const mrpt::utils::CConfigFileBase & source,const std::string & section)
+{
+	MRPT_LOAD_CONFIG_VAR(kf2kf_pose,string,source,section)
+	MRPT_LOAD_CONFIG_VAR(landmark,string,source,section)
+	MRPT_LOAD_CONFIG_VAR(observation,string,source,section)
+	MRPT_LOAD_CONFIG_VAR(solver,string,source,section)
+	MRPT_LOAD_CONFIG_VAR(ecp,string,source,section)
+}
+
+void TRbaEngineConfig::saveToConfigFile(mrpt::utils::CConfigFileBase &out,const std::string & section) const
+{
+	out.write(section,"kf2kf_pose",kf2kf_pose, /* text width */ 30, 30, "One of kf2kf_poses::*");
+	out.write(section,"landmark",landmark, /* text width */ 30, 30, "One of landmarks::*");
+	out.write(section,"observation",observation, /* text width */ 30, 30, "One of observations::*");
+	out.write(section,"solver",solver, /* text width */ 30, 30, "LM_schur_dense_cholesky, LM_schur_sparse_cholesky or LM_no_schur_sparse_cholesky");
+	out.write(section,"ecp",ecp, /* text width */ 30, 30, "Edge creation policy: local_areas_fixed_size or classic_linear_rba");
+}
+
+std::string TRbaEngineConfig::asString() const
+{
+	return kf2kf_pose + std::string("/") + landmark + std::string("/") + observation + std::string(" solver=") + solver + std::string(" ecp=") + ecp;
+}
+
+IRbaEnginePtr srba::create_rba_engine(const TRbaEngineConfig &cfg)
+{
+	for (size_t i=0;i<internal::num_engine_problems;i++)
+	{
+		const internal::TEngineProblemEntry &e = internal::engine_problems[i];
+		if (cfg.kf2kf_pose!=e.kf2kf_pose || cfg.landmark!=e.landmark || cfg.observation!=e.observation)
+			continue;
+
+		IRbaEngine *engine = (*e.creator)(cfg);
+		if (!engine)
+			throw std::runtime_error(std::string("create_rba_engine(): Unknown solver or ECP in: ")+cfg.asString());
+		return IRbaEnginePtr(engine);
+	}
+	throw std::runtime_error(std::string("create_rba_engine(): Problem type not available in the precompiled library: ")+cfg.asString());
+}
+
+void srba::get_available_rba_engines(std::vector<TRbaEngineConfig> &out_problems)
+{
+	out_problems.resize(internal::num_engine_problems);
+	for (size_t i=0;i<internal::num_engine_problems;i++)
+	{
+		out_problems[i] = TRbaEngineConfig();
+		out_problems[i].kf2kf_pose  = internal::engine_problems[i].kf2kf_pose;
+		out_problems[i].landmark    = internal::engine_problems[i].landmark;
+		out_problems[i].observation = internal::engine_problems[i].observation;
+	}
+}
@@ -0,0 +1,106 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+#include <srba/srba_api_replay.h>
+#include <mrpt/system/filesystem.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+typedef RbaEngine<
+	kf2kf_poses::SE3,
+	landmarks::Euclidean3D,
+	observations::Cartesian_3D
+	>  my_srba_t;
+
+// Same problem dimensions, but a different engine type:
+struct RBA_OPTIONS_OTHER_SOLVER : public RBA_OPTIONS_DEFAULT
+{
+	typedef options::solver_LM_schur_sparse_cholesky  solver_t;
+};
+typedef RbaEngine<
+	kf2kf_poses::SE3,
+	landmarks::Euclidean3D,
+	observations::Cartesian_3D,
+	RBA_OPTIONS_OTHER_SOLVER
+	>  my_other_srba_t;
+
+// A recorded session must be replayed into a new engine with bit-exact results:
+TEST(ApiRecorder, RecordAndReplay)
+{
+	const string sLogFile = mrpt::system::getTempFileName();
+	const size_t nKFs = 8;
+
+	{
+		my_srba_t rba;
+		rba.get_time_profiler().disable();
+		rba.setVerbosityLevel(0);
+		rba.start_api_recording(sLogFile, "unit test");
+		EXPECT_TRUE(rba.is_api_recording());
+
+		for (size_t k=0;k<nKFs;k++)
+		{
+			if (k==nKFs/2)
+				rba.parameters.srba.max_iters = 5; // Parameter changes must be recorded too
+
+			my_srba_t::new_kf_observations_t  list_obs;
+			for (size_t i=0;i<6;i++)
+			{
+				my_srba_t::new_kf_observation_t obs_field;
+				obs_field.obs.feat_id = i;
+				obs_field.obs.obs_data.pt.x = 1.0+i-0.1*k;
+				obs_field.obs.obs_data.pt.y = 2.0*i+0.01*k*k;
+				obs_field.obs.obs_data.pt.z = 3.0-i;
+				list_obs.push_back(obs_field);
+			}
+			my_srba_t::TNewKeyFrameInfo new_kf_info;
+			rba.define_new_keyframe(list_obs, new_kf_info);
+		}
+
+		my_srba_t::TOptimizeExtraOutputInfo out_info;
+		rba.optimize_local_area(nKFs-1, 2, out_info);
+
+		rba.stop_api_recording();
+		EXPECT_FALSE(rba.is_api_recording());
+	}
+
+	my_srba_t rba;
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+
+	RbaEngineApiReplayer<my_srba_t> replayer;
+	replayer.open(sLogFile);
+	EXPECT_EQ(string("unit test"), replayer.get_user_data());
+	EXPECT_EQ(nKFs+1, replayer.replay_all(rba));
+	EXPECT_EQ(0u, replayer.get_num_mismatches());
+
+	EXPECT_EQ(nKFs, rba.get_rba_state().keyframes.size());
+	EXPECT_EQ(5u, rba.parameters.srba.max_iters);
+
+	mrpt::system::deleteFile(sLogFile);
+}
+
+// Logs can only be replayed by the same RbaEngine type which recorded them:
+TEST(ApiRecorder, RejectOtherEngineType)
+{
+	const string sLogFile = mrpt::system::getTempFileName();
+	{
+		my_srba_t rba;
+		rba.start_api_recording(sLogFile);
+		rba.stop_api_recording();
+	}
+
+	RbaEngineApiReplayer<my_other_srba_t> replayer;
+	EXPECT_THROW(replayer.open(sLogFile), std::exception);
+
+	mrpt::system::deleteFile(sLogFile);
+}
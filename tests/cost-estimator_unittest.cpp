@@ -0,0 +1,143 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+typedef RbaEngine<
+	kf2kf_poses::SE3,
+	landmarks::Euclidean3D,
+	observations::Cartesian_3D
+	>  my_srba_t;
+
+// The dry-run estimation must predict the same problem size than the actual optimization, without modifying the problem:
+TEST(CostEstimator, MatchesActualOptimization)
+{
+	my_srba_t rba;
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+
+	for (size_t k=0;k<6;k++)
+	{
+		my_srba_t::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<8;i++)
+		{
+			my_srba_t::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i+2*k;  // Landmarks are seen from several (not all) KFs
+			obs_field.obs.obs_data.pt.x = 1.0+i-0.2*k;
+			obs_field.obs.obs_data.pt.y = 0.5*i;
+			obs_field.obs.obs_data.pt.z = 2.0+0.1*i;
+			list_obs.push_back(obs_field);
+		}
+		my_srba_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, false /* don't optimize */);
+	}
+
+	const TKeyFrameID root = rba.get_rba_state().keyframes.size()-1;
+	const unsigned int win_size = 3;
+
+	TOptimizationCostEstimate est;
+	rba.estimate_local_area_cost(root, win_size, est);
+
+	EXPECT_GT(est.num_k2k_unknowns, 0u);
+	EXPECT_GT(est.num_lm_unknowns, 0u);
+	EXPECT_GE(est.num_hessian_blocks_Ap, est.num_k2k_unknowns);
+	EXPECT_EQ(est.num_lm_unknowns, est.num_hessian_blocks_f);
+	EXPECT_GE(est.reduced_system_nnz_blocks, est.num_hessian_blocks_Ap);
+	EXPECT_GT(est.estimated_time, 0.0);
+
+	my_srba_t::TOptimizeExtraOutputInfo info;
+	rba.optimize_local_area(root, win_size, info);
+
+	EXPECT_EQ(info.num_kf2kf_edges_optimized, est.num_k2k_unknowns);
+	EXPECT_EQ(info.num_kf2lm_edges_optimized, est.num_lm_unknowns);
+	EXPECT_EQ(info.num_total_scalar_optimized, est.num_total_scalar_unknowns);
+	EXPECT_EQ(info.num_observations, est.num_observations);
+	EXPECT_EQ(info.num_jacobians, est.num_jacobian_blocks);
+}
+
+// Fitting the cost model to samples generated from known coefficients must recover them:
+TEST(CostEstimator, ModelFit)
+{
+	TOptimizationCostModel truth;
+	for (size_t k=0;k<TOptimizationCostModel::NUM_FEATURES;k++)
+		truth.coefs[k] = 1e-6*(k+1);
+
+	std::vector<std::pair<TOptimizationCostEstimate,double> > samples;
+	for (size_t i=0;i<20;i++)
+	{
+		TOptimizationCostEstimate e;
+		e.num_observations = 10+7*i;
+		e.num_jacobian_blocks = 20+3*i*i;
+		e.num_hessian_blocks_Ap = 5+(i%4)*11;
+		e.schur_block_products = 100.0+(i%3)*50+i;
+		e.factorization_flops = 1e3*(1+(i%5)) + 17*i;
+		samples.push_back(std::make_pair(e, truth.predict(e)));
+	}
+
+	TOptimizationCostModel model;
+	model.fit(samples);
+	for (size_t k=0;k<TOptimizationCostModel::NUM_FEATURES;k++)
+		EXPECT_NEAR(truth.coefs[k], model.coefs[k], 1e-9);
+}
+
+// With samples which would need a negative coefficient, the fit must be the non-negative least squares optimum (KKT conditions):
+// zero gradient of the squared error for positive coefficients, and non-decreasing error for those clamped to zero.
+TEST(CostEstimator, ModelFitNonNegative)
+{
+	TOptimizationCostModel truth;
+	for (size_t k=0;k<TOptimizationCostModel::NUM_FEATURES;k++)
+		truth.coefs[k] = 1e-6*(k+1);
+	truth.coefs[2] = -3e-6;
+
+	std::vector<std::pair<TOptimizationCostEstimate,double> > samples;
+	for (size_t i=0;i<20;i++)
+	{
+		TOptimizationCostEstimate e;
+		e.num_observations = 10+7*i;
+		e.num_jacobian_blocks = 20+3*i*i;
+		e.num_hessian_blocks_Ap = 5+(i%4)*11;
+		e.schur_block_products = 100.0+(i%3)*50+i;
+		e.factorization_flops = 1e3*(1+(i%5)) + 17*i;
+		samples.push_back(std::make_pair(e, truth.predict(e)));
+	}
+
+	TOptimizationCostModel model;
+	model.fit(samples);
+
+	const size_t N = TOptimizationCostModel::NUM_FEATURES;
+	Eigen::MatrixXd A(samples.size(),N);
+	Eigen::VectorXd b(samples.size());
+	double f[N];
+	for (size_t i=0;i<samples.size();i++)
+	{
+		TOptimizationCostModel::get_features(samples[i].first,f);
+		for (size_t k=0;k<N;k++)
+			A(i,k) = f[k];
+		b[i] = samples[i].second;
+	}
+	Eigen::VectorXd x(N);
+	for (size_t k=0;k<N;k++)
+		x[k] = model.coefs[k];
+	const Eigen::VectorXd r = b-A*x;
+
+	EXPECT_EQ(0.0, model.coefs[2]);
+	for (size_t k=0;k<N;k++)
+	{
+		EXPECT_GE(model.coefs[k], 0.0);
+		const double g = A.col(k).dot(r)/(A.col(k).norm()*b.norm()); // Minus the (normalized) gradient
+		if (model.coefs[k]>0)
+		     EXPECT_NEAR(0.0, g, 1e-8);
+		else EXPECT_LT(g, 1e-8);
+	}
+}
@@ -0,0 +1,152 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#if defined(SRBA_HAS_ENGINES_LIB)
+
+#include <srba.h>
+#include <srba/srba_engine_facade.h>
+#include <mrpt/utils/CConfigFileMemory.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, observations::Cartesian_3D>  srba_t;
+
+// KF "k" observes 8 landmarks, with IDs "k...k+7":
+static void make_kf_observations(const size_t k, generic_observations_t &list_obs)
+{
+	list_obs.resize(8);
+	for (size_t i=0;i<8;i++)
+	{
+		list_obs[i].feat_id = i+k;
+		list_obs[i].obs_data.resize(3);
+		list_obs[i].obs_data[0] = 1.0+i-0.2*k;
+		list_obs[i].obs_data[1] = 0.5*i+0.01*k*k;
+		list_obs[i].obs_data[2] = 2.0+0.1*i;
+	}
+}
+
+// An engine from the library must give the same results than the header-only one, with all solvers and ECPs:
+TEST(EngineFacade, SameResultsThanTemplate)
+{
+	const char* solvers[] = { "LM_schur_dense_cholesky", "LM_schur_sparse_cholesky", "LM_no_schur_sparse_cholesky" };
+	const char* ecps[] = { "local_areas_fixed_size", "classic_linear_rba" };
+
+	srba_t rba;
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+	for (size_t k=0;k<5;k++)
+	{
+		generic_observations_t gen_obs;
+		make_kf_observations(k,gen_obs);
+		srba_t::new_kf_observations_t list_obs;
+		for (size_t i=0;i<gen_obs.size();i++)
+		{
+			srba_t::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = gen_obs[i].feat_id;
+			obs_field.obs.obs_data.setFromArray(gen_obs[i].obs_data);
+			list_obs.push_back(obs_field);
+		}
+		srba_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, true);
+	}
+
+	for (size_t s=0;s<sizeof(solvers)/sizeof(solvers[0]);s++)
+	{
+		for (size_t e=0;e<sizeof(ecps)/sizeof(ecps[0]);e++)
+		{
+			TRbaEngineConfig cfg;
+			cfg.solver = solvers[s];
+			cfg.ecp = ecps[e];
+			IRbaEnginePtr engine = create_rba_engine(cfg);
+			ASSERT_TRUE(engine.get()!=NULL);
+			engine->enable_time_profiler(false);
+			engine->setVerbosityLevel(0);
+			EXPECT_EQ(3u, engine->get_obs_dims());
+
+			for (size_t k=0;k<5;k++)
+			{
+				generic_observations_t gen_obs;
+				make_kf_observations(k,gen_obs);
+				TGenericNewKeyFrameInfo new_kf_info;
+				engine->define_new_keyframe(gen_obs, new_kf_info, true);
+				EXPECT_EQ(k, new_kf_info.kf_id);
+			}
+			EXPECT_EQ(5u, engine->get_num_keyframes());
+
+			if (cfg.ecp=="local_areas_fixed_size")
+			{
+				ASSERT_EQ(rba.get_k2k_edges().size(), engine->get_num_kf2kf_edges());
+				for (size_t i=0;i<rba.get_k2k_edges().size();i++)
+				{
+					TKeyFrameID from,to;
+					mrpt::poses::CPose3D inv_pose;
+					engine->get_kf2kf_edge(i,from,to,inv_pose);
+					EXPECT_EQ(rba.get_k2k_edges()[i].from, from);
+					EXPECT_EQ(rba.get_k2k_edges()[i].to, to);
+					EXPECT_NEAR(0.0, (inv_pose.getAsVectorVal()-rba.get_k2k_edges()[i].inv_pose.getAsVectorVal()).norm(), 1e-6) << cfg.asString();
+				}
+			}
+			EXPECT_NEAR(rba.eval_overall_squared_error(), engine->eval_overall_squared_error(), 1e-6) << cfg.asString();
+		}
+	}
+}
+
+TEST(EngineFacade, Errors)
+{
+	TRbaEngineConfig cfg;
+	cfg.solver = "no_such_solver";
+	EXPECT_THROW(create_rba_engine(cfg), std::exception);
+
+	cfg = TRbaEngineConfig();
+	cfg.observation = "no_such_obs";
+	EXPECT_THROW(create_rba_engine(cfg), std::exception);
+
+	// Wrong length of observations:
+	IRbaEnginePtr engine = create_rba_engine(TRbaEngineConfig());
+	generic_observations_t gen_obs(1);
+	gen_obs[0].obs_data.resize(2);
+	TGenericNewKeyFrameInfo new_kf_info;
+	EXPECT_THROW(engine->define_new_keyframe(gen_obs, new_kf_info), std::exception);
+
+	std::vector<TRbaEngineConfig> problems;
+	get_available_rba_engines(problems);
+	EXPECT_FALSE(problems.empty());
+}
+
+// Configuration of the engine and its parameters from a config file:
+TEST(EngineFacade, ParamsFromConfigFile)
+{
+	mrpt::utils::CConfigFileMemory cfg_file;
+	cfg_file.write("engine","observation","MonocularCamera");
+	cfg_file.write("engine","solver","LM_schur_sparse_cholesky");
+	cfg_file.write("srba","max_iters",7);
+	cfg_file.write("sensor_pose","relative_pose","[0 0 0 -90 0 -90]");
+	cfg_file.write("cost_model","cost_per_obs",3e-6);
+
+	TRbaEngineConfig cfg;
+	cfg.loadFromConfigFile(cfg_file,"engine");
+	EXPECT_EQ(string("MonocularCamera"), cfg.observation);
+
+	IRbaEnginePtr engine = create_rba_engine(cfg);
+	EXPECT_EQ(2u, engine->get_obs_dims());
+	engine->load_parameters(cfg_file);
+
+	mrpt::utils::CConfigFileMemory out;
+	engine->save_parameters(out);
+	EXPECT_EQ(7, out.read_int("srba","max_iters",0));
+	mrpt::poses::CPose3D p;
+	p.fromString(out.read_string("sensor_pose","relative_pose",""));
+	EXPECT_NEAR(-90.0, mrpt::utils::RAD2DEG(p.yaw()), 1e-6);
+	EXPECT_NEAR(3e-6, out.read_double("cost_model","cost_per_obs",0), 1e-12);
+}
+
+#endif
@@ -0,0 +1,73 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+
+#include <gtest/gtest.h>
+
+#if __cplusplus>=201103L || (defined(_MSC_VER) && _MSC_VER>=1700)
+
+#include <srba/srba_ingestion_queue.h>
+#include <thread>
+
+using namespace srba;
+using namespace std;
+
+typedef RbaEngine<
+	kf2kf_poses::SE3,
+	landmarks::Euclidean3D,
+	observations::Cartesian_3D
+	>  my_srba_t;
+
+// KFs submitted concurrently from several producer threads must be processed in timestamp order:
+TEST(IngestionQueue, MultipleProducersTimestampOrder)
+{
+	const size_t nThreads = 4, nKFsPerThread = 5;
+
+	my_srba_t rba;
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+
+	RbaEngineIngestionQueue<my_srba_t> queue;
+	std::vector<RbaEngineIngestionQueue<my_srba_t>::handle_t> handles(nThreads*nKFsPerThread);
+
+	std::vector<std::thread> producers;
+	for (size_t th=0;th<nThreads;th++)
+	{
+		producers.push_back(std::thread([&queue,&handles,th,nThreads,nKFsPerThread]() {
+			for (size_t k=0;k<nKFsPerThread;k++)
+			{
+				// Each KF sees the same four landmarks:
+				my_srba_t::new_kf_observations_t  list_obs;
+				for (size_t i=0;i<4;i++)
+				{
+					my_srba_t::new_kf_observation_t obs_field;
+					obs_field.obs.feat_id = i;
+					obs_field.obs.obs_data.pt.x = 1.0+i;
+					obs_field.obs.obs_data.pt.y = 2.0*i;
+					obs_field.obs.obs_data.pt.z = 3.0-i;
+					list_obs.push_back(obs_field);
+				}
+				const size_t t = k*nThreads + th; // Interleaved timestamps
+				handles[t] = queue.submit(std::move(list_obs), static_cast<double>(t));
+			}
+		}));
+	}
+	for (size_t th=0;th<nThreads;th++)
+		producers[th].join();
+
+	EXPECT_FALSE(queue.empty());
+	EXPECT_EQ(nThreads*nKFsPerThread, queue.process_pending(rba));
+	EXPECT_TRUE(queue.empty());
+
+	for (size_t t=0;t<handles.size();t++)
+		EXPECT_EQ(static_cast<TKeyFrameID>(t), handles[t].get().kf_id);
+}
+
+#endif
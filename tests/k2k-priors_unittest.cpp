@@ -0,0 +1,196 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, observations::Cartesian_3D>  srba_t;
+
+// KF "k" observes 8 landmarks, with IDs "k...k+7", from x=0.2*k:
+static void make_kf_observations(const size_t k, srba_t::new_kf_observations_t &list_obs)
+{
+	list_obs.clear();
+	for (size_t i=0;i<8;i++)
+	{
+		srba_t::new_kf_observation_t obs_field;
+		obs_field.obs.feat_id = i+k;
+		obs_field.obs.obs_data.pt.x = 1.0+i-0.2*k;
+		obs_field.obs.obs_data.pt.y = 0.5*i;
+		obs_field.obs.obs_data.pt.z = 2.0+0.1*i;
+		list_obs.push_back(obs_field);
+	}
+}
+
+static void build_problem(srba_t &rba, const size_t nKFs)
+{
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+	for (size_t k=0;k<nKFs;k++)
+	{
+		srba_t::new_kf_observations_t  list_obs;
+		make_kf_observations(k,list_obs);
+		srba_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, true);
+	}
+}
+
+// A prior between the new KF and the previous one is attached to their edge (created if the ECP didn't):
+TEST(K2KPriors, AttachedToEdge)
+{
+	srba_t rba;
+	build_problem(rba,4);
+
+	srba_t::k2k_priors_t priors(1);
+	priors[0].kf_id = 3;
+	priors[0].inv_pose = mrpt::poses::CPose3D(-0.2,0,0,0,0,0);
+	priors[0].inf_matrix.setIdentity();
+
+	srba_t::new_kf_observations_t  list_obs;
+	make_kf_observations(4,list_obs);
+	srba_t::TNewKeyFrameInfo new_kf_info;
+	rba.define_new_keyframe(list_obs, priors, new_kf_info, true);
+
+	const srba_t::rba_problem_state_t &st = rba.get_rba_state();
+	const size_t ed_id = st.find_kf2kf_edge(3,4);
+	ASSERT_NE(SRBA_INVALID_INDEX, ed_id);
+	ASSERT_EQ(1u, st.k2k_edge_priors.size());
+	EXPECT_EQ(ed_id, st.k2k_edge_priors.begin()->first);
+	EXPECT_EQ(3u, st.k2k_edges[ed_id].from);
+	EXPECT_EQ(4u, st.k2k_edges[ed_id].to);
+
+	// The prior agrees with the observations, so the optimized edge must still be close to it:
+	EXPECT_NEAR(0.0, (st.k2k_edges[ed_id].inv_pose.getAsVectorVal() - priors[0].inv_pose.getAsVectorVal()).norm(), 1e-3);
+}
+
+// A prior which disagrees with the observations adds to the overall error:
+TEST(K2KPriors, ContributesToOverallError)
+{
+	srba_t rba;
+	build_problem(rba,4);
+	const double err_without = rba.eval_overall_squared_error();
+
+	srba_t::k2k_priors_t priors(1);
+	priors[0].kf_id = 3;
+	priors[0].inv_pose = mrpt::poses::CPose3D(-1.0,0.5,0,0,0,0);
+	priors[0].inf_matrix.setIdentity();
+
+	srba_t::new_kf_observations_t  list_obs;
+	make_kf_observations(4,list_obs);
+	srba_t::TNewKeyFrameInfo new_kf_info;
+	rba.define_new_keyframe(list_obs, priors, new_kf_info, true);
+
+	EXPECT_GT(rba.eval_overall_squared_error(), err_without + 1e-6);
+}
+
+// A KF without observations, only constrained by a prior: the RMSE is per residual, so it's still well-defined:
+TEST(K2KPriors, PriorOnlyEdge)
+{
+	srba_t rba;
+	build_problem(rba,4);
+
+	srba_t::k2k_priors_t priors(1);
+	priors[0].kf_id = 0;
+	priors[0].inv_pose = mrpt::poses::CPose3D(-0.8,0,0,0,0,0);
+	priors[0].inf_matrix.setIdentity();
+
+	srba_t::TNewKeyFrameInfo new_kf_info;
+	rba.define_new_keyframe(srba_t::new_kf_observations_t(), priors, new_kf_info, false);
+
+	srba_t::TOptimizeLocalAreaParams params;
+	params.optimize_landmarks = false;
+
+	// The dry-run estimation keeps the prior-only edge too:
+	TOptimizationCostEstimate est;
+	rba.estimate_local_area_cost(4, 1, est, params);
+	EXPECT_EQ(1u, est.num_k2k_unknowns);
+	EXPECT_EQ(1u, est.num_hessian_blocks_Ap);
+	EXPECT_EQ(0u, est.num_observations);
+
+	srba_t::TOptimizeExtraOutputInfo info;
+	rba.optimize_local_area(4, 1, info, params);
+
+	EXPECT_EQ(0u, info.num_observations);
+	EXPECT_EQ(1u, info.num_priors);
+	EXPECT_EQ(1u, info.num_kf2kf_edges_optimized);
+	EXPECT_LT(info.obs_rmse, 1e-3); // Also fails for NaN or inf
+	EXPECT_LT(info.total_sqr_error_final, 1e-6);
+
+	const srba_t::rba_problem_state_t &st = rba.get_rba_state();
+	const size_t ed_id = st.find_kf2kf_edge(0,4);
+	ASSERT_NE(SRBA_INVALID_INDEX, ed_id);
+	EXPECT_NEAR(0.0, (st.k2k_edges[ed_id].inv_pose.getAsVectorVal() - priors[0].inv_pose.getAsVectorVal()).norm(), 1e-3);
+}
+
+// With std_noise_observations!=1, the optimum must be that of the weighted problem sum(|r|^2)/sigma^2 + e^t*Lambda*e.
+// KF #1 sees 8 landmarks (fixed here) displaced by x_obs in X, while its prior says x_prior. The landmarks are symmetric
+// around the X axis, so the optimum has no rotation and: x = (N/sigma^2*x_obs + lambda*x_prior) / (N/sigma^2 + lambda)
+TEST(K2KPriors, WeightedOptimumWithObsNoise)
+{
+	const double sigma = 0.5, lambda = 16.0, x_obs = -0.2, x_prior = -0.5;
+	const size_t N = 8;
+
+	srba_t rba;
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+	rba.parameters.obs_noise.std_noise_observations = sigma;
+	rba.parameters.srba.max_iters = 100;
+
+	for (size_t k=0;k<2;k++)
+	{
+		srba_t::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<N;i++)
+		{
+			srba_t::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i;
+			obs_field.obs.obs_data.pt.x = 2.0+i + (k==1 ? x_obs : 0.0);
+			obs_field.obs.obs_data.pt.y = (i & 1) ? 1.0 : -1.0;
+			obs_field.obs.obs_data.pt.z = (i & 2) ? 1.0 : -1.0;
+			list_obs.push_back(obs_field);
+		}
+
+		srba_t::k2k_priors_t priors;
+		if (k==1)
+		{
+			priors.resize(1);
+			priors[0].kf_id = 0;
+			priors[0].inv_pose = mrpt::poses::CPose3D(x_prior,0,0,0,0,0);
+			priors[0].inf_matrix.setIdentity();
+			priors[0].inf_matrix *= lambda;
+		}
+		srba_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, priors, new_kf_info, false /* don't optimize */);
+	}
+
+	srba_t::TOptimizeLocalAreaParams params;
+	params.optimize_landmarks = false;
+	srba_t::TOptimizeExtraOutputInfo info;
+	rba.optimize_local_area(1, 1, info, params);
+	EXPECT_EQ(1u, info.num_priors);
+
+	const srba_t::rba_problem_state_t &st = rba.get_rba_state();
+	const size_t ed_id = st.find_kf2kf_edge(0,1);
+	ASSERT_NE(SRBA_INVALID_INDEX, ed_id);
+
+	const double w = N/(sigma*sigma);
+	const double x_opt = (w*x_obs + lambda*x_prior)/(w+lambda);
+	const mrpt::poses::CPose3D &p = st.k2k_edges[ed_id].inv_pose;
+	EXPECT_NEAR(x_opt, p.x(), 1e-6);
+	EXPECT_NEAR(0.0, p.y(), 1e-6);
+	EXPECT_NEAR(0.0, p.z(), 1e-6);
+	EXPECT_NEAR(0.0, p.yaw(), 1e-6);
+	EXPECT_NEAR(0.0, p.pitch(), 1e-6);
+	EXPECT_NEAR(0.0, p.roll(), 1e-6);
+
+	// The total squared error is in units of unweighted observation residuals:
+	EXPECT_NEAR(N*mrpt::utils::square(x_opt-x_obs) + sigma*sigma*lambda*mrpt::utils::square(x_opt-x_prior), info.total_sqr_error_final, 1e-9);
+}
@@ -0,0 +1,193 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, observations::Cartesian_3D>  srba_t;
+
+const size_t NUM_NEAR_LMS = 4; // IDs: 0-3, ~2-4m away
+const size_t NUM_FAR_LMS  = 3; // IDs: 4-6, ~1000m away
+
+// 2 KFs 1m apart, both observing all the landmarks:
+static void build_problem(srba_t &rba)
+{
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+
+	for (size_t k=0;k<2;k++)
+	{
+		srba_t::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<NUM_NEAR_LMS+NUM_FAR_LMS;i++)
+		{
+			const bool is_far = (i>=NUM_NEAR_LMS);
+			srba_t::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i;
+			obs_field.obs.obs_data.pt.x = 0.5*i - 1.0*k;
+			obs_field.obs.obs_data.pt.y = is_far ? 10.0*i : 1.0;
+			obs_field.obs.obs_data.pt.z = is_far ? 1000.0 : 2.0+0.5*i;
+			list_obs.push_back(obs_field);
+		}
+		srba_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, true /* optimize */);
+	}
+}
+
+TEST(LandmarkAdmission, DisabledByDefault)
+{
+	srba_t rba;
+	build_problem(rba);
+
+	srba_t::TOptimizeExtraOutputInfo info;
+	rba.optimize_local_area(1, 2, info);
+	EXPECT_EQ(NUM_NEAR_LMS+NUM_FAR_LMS, info.num_kf2lm_edges_optimized);
+	EXPECT_EQ(0u, info.num_lm_rejected_by_geometry);
+}
+
+TEST(LandmarkAdmission, RejectLowParallax)
+{
+	srba_t rba;
+	build_problem(rba);
+
+	// The far landmarks are seen with a parallax of ~0.06 deg:
+	srba_t::TOptimizeLocalAreaParams params;
+	params.min_landmark_parallax_deg = 1.0;
+
+	srba_t::TOptimizeExtraOutputInfo info;
+	rba.optimize_local_area(1, 2, info, params);
+	EXPECT_EQ(NUM_NEAR_LMS, info.num_kf2lm_edges_optimized);
+	EXPECT_EQ(NUM_FAR_LMS, info.num_lm_rejected_by_geometry);
+	for (size_t i=0;i<info.optimized_landmark_indices.size();i++)
+		EXPECT_LT(info.optimized_landmark_indices[i], NUM_NEAR_LMS);
+
+	// Same unknowns in the cost estimation:
+	TOptimizationCostEstimate cost;
+	rba.estimate_local_area_cost(1, 2, cost, params);
+	EXPECT_EQ(NUM_NEAR_LMS, cost.num_lm_unknowns);
+}
+
+TEST(LandmarkAdmission, RejectShortBaseline)
+{
+	srba_t rba;
+	build_problem(rba);
+
+	srba_t::TOptimizeLocalAreaParams params;
+	params.min_landmark_baseline_depth_ratio = 0.01;
+
+	srba_t::TOptimizeExtraOutputInfo info;
+	rba.optimize_local_area(1, 2, info, params);
+	EXPECT_EQ(NUM_NEAR_LMS, info.num_kf2lm_edges_optimized);
+	EXPECT_EQ(NUM_FAR_LMS, info.num_lm_rejected_by_geometry);
+}
+
+TEST(LandmarkAdmission, HessianConditioning)
+{
+	srba_t rba;
+	build_problem(rba);
+
+	// Cartesian 3D observations fully constrain any landmark, even from a single KF (Hf ~ 2*I):
+	srba_t::TOptimizeLocalAreaParams params;
+	params.max_landmark_hf_condition_number = 10;
+
+	srba_t::TOptimizeExtraOutputInfo info;
+	rba.optimize_local_area(1, 2, info, params);
+	EXPECT_EQ(NUM_NEAR_LMS+NUM_FAR_LMS, info.num_kf2lm_edges_optimized);
+	EXPECT_EQ(0u, info.num_lm_rejected_by_geometry);
+}
+
+// A landmark seen from a single KF isn't triangulated at all, so it's rejected while triangulation tests are enabled,
+// until it's seen again from another KF:
+TEST(LandmarkAdmission, RejectSingleView)
+{
+	srba_t rba;
+	build_problem(rba);
+
+	const TLandmarkID SINGLE_LM = NUM_NEAR_LMS+NUM_FAR_LMS;
+	for (size_t k=2;k<4;k++)
+	{
+		srba_t::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<NUM_NEAR_LMS;i++)
+		{
+			srba_t::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i;
+			obs_field.obs.obs_data.pt.x = 0.5*i - 1.0*k;
+			obs_field.obs.obs_data.pt.y = 1.0;
+			obs_field.obs.obs_data.pt.z = 2.0+0.5*i;
+			list_obs.push_back(obs_field);
+		}
+		srba_t::new_kf_observation_t obs_field;
+		obs_field.obs.feat_id = SINGLE_LM;
+		obs_field.obs.obs_data.pt.x = 3.0 - 1.0*k;
+		obs_field.obs.obs_data.pt.y = -1.0;
+		obs_field.obs.obs_data.pt.z = 3.0;
+		list_obs.push_back(obs_field);
+
+		srba_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, true /* optimize, without admission tests */);
+
+		srba_t::TOptimizeLocalAreaParams params;
+		params.dont_optimize_landmarks_seen_less_than_n_times = 1;
+		params.min_landmark_baseline_depth_ratio = 0.01;
+
+		srba_t::TOptimizeExtraOutputInfo info;
+		rba.optimize_local_area(k, 1, info, params);
+
+		bool single_lm_optimized = false;
+		for (size_t i=0;i<info.optimized_landmark_indices.size();i++)
+			if (info.optimized_landmark_indices[i]==SINGLE_LM)
+				single_lm_optimized = true;
+		EXPECT_EQ(k==3, single_lm_optimized); // KF #2 is its only observer until KF #3 is added
+	}
+}
+
+// Range-bearing observations of a distant landmark only constrain its range well, so its Hessian block is ill-conditioned
+// (~(range/1m)^2), even if seen from several KFs:
+TEST(LandmarkAdmission, RejectIllConditionedHessian)
+{
+	typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, observations::RangeBearing_3D>  srba_rb_t;
+	srba_rb_t rba;
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+
+	// 2 KFs 1m apart, both observing all the landmarks:
+	for (size_t k=0;k<2;k++)
+	{
+		srba_rb_t::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<NUM_NEAR_LMS+NUM_FAR_LMS;i++)
+		{
+			const bool is_far = (i>=NUM_NEAR_LMS);
+			const double x = (is_far ? 1000.0 : 2.0+0.5*i) - 1.0*k;
+			const double y = is_far ? 10.0*i : 1.0;
+			const double z = is_far ? 50.0 : 0.5;
+
+			srba_rb_t::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i;
+			mrpt::math::CArrayDouble<3> obs_arr;
+			sensor_model<landmarks::Euclidean3D,observations::RangeBearing_3D>::predict(x,y,z, obs_arr);
+			obs_field.obs.obs_data.setFromArray(obs_arr);
+			list_obs.push_back(obs_field);
+		}
+		srba_rb_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, true /* optimize */);
+	}
+
+	srba_rb_t::TOptimizeLocalAreaParams params;
+	params.max_landmark_hf_condition_number = 100;
+
+	srba_rb_t::TOptimizeExtraOutputInfo info;
+	rba.optimize_local_area(1, 2, info, params);
+	EXPECT_EQ(NUM_NEAR_LMS, info.num_kf2lm_edges_optimized);
+	EXPECT_EQ(NUM_FAR_LMS, info.num_lm_rejected_by_geometry);
+	for (size_t i=0;i<info.optimized_landmark_indices.size();i++)
+		EXPECT_LT(info.optimized_landmark_indices[i], NUM_NEAR_LMS);
+}
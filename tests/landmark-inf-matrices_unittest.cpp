@@ -0,0 +1,77 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, observations::Cartesian_3D>  srba_t;
+typedef srba_t::hessian_traits_t::TSparseBlocksHessian_f::matrix_t  inf_matrix_t;
+
+// Landmarks out of the last optimization must keep their information matrices:
+TEST(LandmarkInfMatrices, PersistentAcrossOptimizations)
+{
+	srba_t rba;
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+
+	// 5 KFs, each one observing 8 landmarks, with IDs "k...k+7":
+	for (size_t k=0;k<5;k++)
+	{
+		srba_t::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<8;i++)
+		{
+			srba_t::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i+k;
+			obs_field.obs.obs_data.pt.x = 1.0+i-0.2*k;
+			obs_field.obs.obs_data.pt.y = 0.5*i+0.01*k*k;
+			obs_field.obs.obs_data.pt.z = 2.0+0.1*i;
+			list_obs.push_back(obs_field);
+		}
+		srba_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, false /* don't optimize */);
+	}
+
+	EXPECT_TRUE(rba.get_unknown_feat_inf_matrix(3)==NULL);
+
+	srba_t::TOptimizeExtraOutputInfo info;
+	rba.optimize_local_area(4, 4, info);
+	ASSERT_FALSE(info.optimized_landmark_indices.empty());
+
+	map<TLandmarkID,inf_matrix_t> inf_mats;
+	for (size_t i=0;i<info.optimized_landmark_indices.size();i++)
+	{
+		const TLandmarkID lm_id = info.optimized_landmark_indices[i];
+		const inf_matrix_t *m = rba.get_unknown_feat_inf_matrix(lm_id);
+		ASSERT_TRUE(m!=NULL);
+		EXPECT_GT(m->trace(), 0.0);
+		inf_mats[lm_id] = *m;
+	}
+
+	// Now, only optimize LM #4 (the only one seen from the 5 KFs):
+	srba_t::TOptimizeLocalAreaParams params;
+	params.dont_optimize_landmarks_seen_less_than_n_times = 5;
+	rba.optimize_local_area(4, 4, info, params);
+	ASSERT_EQ(1u, info.optimized_landmark_indices.size());
+	EXPECT_EQ(4u, info.optimized_landmark_indices[0]);
+
+	for (map<TLandmarkID,inf_matrix_t>::const_iterator it=inf_mats.begin();it!=inf_mats.end();++it)
+	{
+		const inf_matrix_t *m = rba.get_unknown_feat_inf_matrix(it->first);
+		ASSERT_TRUE(m!=NULL);
+		if (it->first!=4)
+			EXPECT_EQ(0.0, (*m - it->second).norm());
+	}
+
+	EXPECT_TRUE(rba.remove_landmark(2));
+	EXPECT_TRUE(rba.get_unknown_feat_inf_matrix(2)==NULL);
+}
@@ -0,0 +1,155 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+template <class SOLVER>
+struct RBA_OPTIONS_SOLVER : public RBA_OPTIONS_DEFAULT
+{
+	typedef SOLVER solver_t;
+};
+
+template <class RBA>
+void run_optimization(RBA &rba, typename RBA::TOptimizeExtraOutputInfo &out_info)
+{
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+
+	for (size_t k=0;k<5;k++)
+	{
+		typename RBA::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<8;i++)
+		{
+			typename RBA::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i+k;
+			obs_field.obs.obs_data.pt.x = 1.0+i-0.2*k;
+			obs_field.obs.obs_data.pt.y = 0.5*i+0.01*k*k;
+			obs_field.obs.obs_data.pt.z = 2.0+0.1*i;
+			list_obs.push_back(obs_field);
+		}
+		typename RBA::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, false /* don't optimize */);
+	}
+	rba.optimize_local_area(4, 3, out_info);
+}
+
+template <class SOLVER>
+void check_backend_vs_builtin()
+{
+	typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, observations::Cartesian_3D>  builtin_srba_t;
+	typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, observations::Cartesian_3D, RBA_OPTIONS_SOLVER<SOLVER> >  backend_srba_t;
+
+	builtin_srba_t rba_ref;
+	typename builtin_srba_t::TOptimizeExtraOutputInfo info_ref;
+	run_optimization(rba_ref, info_ref);
+
+	backend_srba_t rba;
+	typename backend_srba_t::TOptimizeExtraOutputInfo info;
+	run_optimization(rba, info);
+
+	EXPECT_EQ(info_ref.num_total_scalar_optimized, info.num_total_scalar_optimized);
+	EXPECT_NEAR(info_ref.total_sqr_error_init, info.total_sqr_error_init, 1e-9);
+	EXPECT_NEAR(info_ref.total_sqr_error_final, info.total_sqr_error_final, 1e-6);
+	EXPECT_TRUE(info.extra_results.hessian_valid);
+	EXPECT_GT(info.extra_results.hessian.nonZeros(), 0);
+
+	if (SOLVER::K2K_MARGINALS)
+	{
+		ASSERT_EQ(info.num_kf2kf_edges_optimized, info.extra_results.k2k_marginal_covs.size());
+		for (size_t i=0;i<info.extra_results.k2k_marginal_covs.size();i++)
+		{
+			const Eigen::MatrixXd &C = info.extra_results.k2k_marginal_covs[i];
+			EXPECT_EQ(6, C.rows());
+			EXPECT_NEAR(0.0, (C-C.transpose()).norm(), 1e-9);
+			EXPECT_GT(C.diagonal().minCoeff(), 0.0);
+		}
+	}
+}
+
+// External backends must reach the same solution than the built-in solvers:
+TEST(LinearSolverBackend, EigenLDLT_Schur)
+{
+	check_backend_vs_builtin< options::solver_LM_backend<linear_solvers::eigen_simplicial_ldlt,true,true> >();
+}
+TEST(LinearSolverBackend, EigenLDLT_NoSchur)
+{
+	check_backend_vs_builtin< options::solver_LM_backend<linear_solvers::eigen_simplicial_ldlt,false> >();
+}
+TEST(LinearSolverBackend, EigenLLT_Schur)
+{
+	check_backend_vs_builtin< options::solver_LM_backend<linear_solvers::eigen_simplicial_llt,true> >();
+}
+TEST(LinearSolverBackend, CSparse_Schur)
+{
+	check_backend_vs_builtin< options::solver_LM_backend<linear_solvers::csparse_cholesky,true,true> >();
+}
+TEST(LinearSolverBackend, MixedPrecisionDense_Schur)
+{
+	check_backend_vs_builtin< options::solver_LM_backend<linear_solvers::mixed_precision_dense_llt<>,true,true> >();
+}
+TEST(LinearSolverBackend, MixedPrecisionSimplicial_NoSchur)
+{
+	check_backend_vs_builtin< options::solver_LM_backend<linear_solvers::mixed_precision_simplicial_llt<>,false> >();
+}
+
+// Solves A*x=b with BACKEND, A being SPD with eigenvalues in [min_eig,~4N], and checks the solution against a double-precision LLT:
+template <class BACKEND>
+void check_mixed_precision(BACKEND &backend, const double min_eig)
+{
+	const int N = 60;
+	Eigen::MatrixXd M = Eigen::MatrixXd::Random(N,N);
+	const Eigen::MatrixXd A = M.transpose()*M + min_eig*Eigen::MatrixXd::Identity(N,N);
+	const Eigen::VectorXd b = Eigen::VectorXd::Random(N);
+	const Eigen::VectorXd x_ref = A.llt().solve(b);
+
+	const Eigen::MatrixXd A_upper = A.triangularView<Eigen::Upper>();
+	const typename BACKEND::sparse_matrix_t sA = A_upper.sparseView();
+
+	backend.analyze(sA);
+	ASSERT_TRUE(backend.factorize(sA));
+	Eigen::VectorXd x;
+	backend.solve(b,x);
+
+	EXPECT_LT((x-x_ref).norm()/x_ref.norm(), 1e-8);
+	EXPECT_LE(backend.last_relative_residual(), 1e-10);
+}
+
+// Iterative refinement recovers double-precision solutions from the single-precision factorization, with the default parameters:
+TEST(LinearSolverBackend, MixedPrecisionRefinement)
+{
+	linear_solvers::mixed_precision_dense_llt<> backend;
+	check_mixed_precision(backend, 1e-2);  // cond. number ~1e5
+	EXPECT_GT(backend.last_refinement_sweeps(), 0u);
+	EXPECT_FALSE(backend.last_used_fallback());
+}
+TEST(LinearSolverBackend, MixedPrecisionRefinementSimplicial)
+{
+	linear_solvers::mixed_precision_simplicial_llt<> backend;
+	check_mixed_precision(backend, 1e-2);
+	EXPECT_GT(backend.last_refinement_sweeps(), 0u);
+	EXPECT_FALSE(backend.last_used_fallback());
+}
+
+// If refinement can't reach the tolerance, the system is solved again in double precision:
+TEST(LinearSolverBackend, MixedPrecisionFallback)
+{
+	linear_solvers::mixed_precision_dense_llt<1> too_few_sweeps;
+	check_mixed_precision(too_few_sweeps, 1e-2);
+	EXPECT_TRUE(too_few_sweeps.last_used_fallback());
+	EXPECT_EQ(1u, too_few_sweeps.num_fallbacks());
+
+	linear_solvers::mixed_precision_simplicial_llt<1> too_few_sweeps_simplicial;
+	check_mixed_precision(too_few_sweeps_simplicial, 1e-2);
+	EXPECT_TRUE(too_few_sweeps_simplicial.last_used_fallback());
+}
@@ -0,0 +1,100 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+#include <srba/srba_linear_system_dump.h>
+#include <mrpt/system/filesystem.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+typedef RbaEngine<
+	kf2kf_poses::SE3,
+	landmarks::Euclidean3D,
+	observations::Cartesian_3D
+	>  my_srba_t;
+
+// Linear systems saved by optimize_edges() must be loaded back and solved by all the solver engines:
+TEST(LinearSystemDump, SaveLoadAndSolve)
+{
+	const string sPrefix = mrpt::system::getTempFileName();
+
+	my_srba_t rba;
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+
+	for (size_t k=0;k<4;k++)
+	{
+		my_srba_t::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<8;i++)
+		{
+			my_srba_t::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i;
+			obs_field.obs.obs_data.pt.x = 1.0+i-0.2*k;
+			obs_field.obs.obs_data.pt.y = 0.5*i+0.01*k*k;
+			obs_field.obs.obs_data.pt.z = 2.0+0.1*i;
+			list_obs.push_back(obs_field);
+		}
+		my_srba_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, false /* don't optimize */);
+	}
+
+	rba.parameters.srba.dump_linear_systems_prefix = sPrefix;
+	my_srba_t::TOptimizeExtraOutputInfo info;
+	rba.optimize_local_area(3, 2, info);
+	rba.parameters.srba.dump_linear_systems_prefix.clear();
+
+	const string sFile = sPrefix + "_00000.srbals";
+	ASSERT_TRUE(mrpt::system::fileExists(sFile));
+
+	unsigned int pose_dims, lm_dims, obs_dims;
+	get_linear_system_dump_dims(sFile, pose_dims,lm_dims,obs_dims);
+	EXPECT_EQ(static_cast<unsigned int>(my_srba_t::REL_POSE_DIMS), pose_dims);
+	EXPECT_EQ(static_cast<unsigned int>(my_srba_t::LM_DIMS), lm_dims);
+	EXPECT_EQ(static_cast<unsigned int>(my_srba_t::OBS_DIMS), obs_dims);
+
+	TLinearSystemDump<my_srba_t> sys;
+	sys.load(sFile);
+	EXPECT_EQ(info.num_kf2kf_edges_optimized, sys.nUnknowns_k2k);
+	EXPECT_EQ(info.num_kf2lm_edges_optimized, sys.nUnknowns_k2f);
+	EXPECT_EQ(info.num_observations, sys.residuals.size());
+	EXPECT_GT(sys.lambda, 0.0);
+
+	// Default noise: identity information matrices:
+	for (size_t i=0;i<sys.obs_information.size();i++)
+		EXPECT_NEAR(0.0, (sys.obs_information[i]-TLinearSystemDump<my_srba_t>::obs_info_matrix_t::Identity()).norm(), 1e-12);
+
+	{
+		TLinearSystemDump<my_srba_t>::hessian_Ap_t  HAp  = sys.HAp;
+		TLinearSystemDump<my_srba_t>::hessian_f_t   Hf   = sys.Hf;
+		TLinearSystemDump<my_srba_t>::hessian_Apf_t HApf = sys.HApf;
+		Eigen::VectorXd minus_grad = sys.minus_grad;
+		mrpt::utils::CTimeLogger profiler(false);
+
+		internal::solver_engine<true,true,my_srba_t> solver(0, profiler, HAp,Hf,HApf, minus_grad, sys.nUnknowns_k2k, sys.nUnknowns_k2f);
+		ASSERT_TRUE(solver.solve(sys.lambda));
+		EXPECT_LT(sys.eval_solution_error(sys.lambda, solver.delta_eps), 1e-6);
+	}
+	{
+		TLinearSystemDump<my_srba_t>::hessian_Ap_t  HAp  = sys.HAp;
+		TLinearSystemDump<my_srba_t>::hessian_f_t   Hf   = sys.Hf;
+		TLinearSystemDump<my_srba_t>::hessian_Apf_t HApf = sys.HApf;
+		Eigen::VectorXd minus_grad = sys.minus_grad;
+		mrpt::utils::CTimeLogger profiler(false);
+
+		internal::solver_engine<false,false,my_srba_t> solver(0, profiler, HAp,Hf,HApf, minus_grad, sys.nUnknowns_k2k, sys.nUnknowns_k2f);
+		ASSERT_TRUE(solver.solve(sys.lambda));
+		EXPECT_LT(sys.eval_solution_error(sys.lambda, solver.delta_eps), 1e-6);
+	}
+
+	for (unsigned int i=0;mrpt::system::fileExists(mrpt::format("%s_%05u.srbals",sPrefix.c_str(),i));i++)
+		mrpt::system::deleteFile(mrpt::format("%s_%05u.srbals",sPrefix.c_str(),i));
+}
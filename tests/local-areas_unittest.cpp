@@ -0,0 +1,77 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, observations::Cartesian_3D>  srba_t;
+
+// A chain of 20 KFs, each one observing 8 landmarks, with IDs "k...k+7":
+static void build_problem(srba_t &rba)
+{
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+
+	for (size_t k=0;k<20;k++)
+	{
+		srba_t::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<8;i++)
+		{
+			srba_t::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i+k;
+			obs_field.obs.obs_data.pt.x = 1.0+i-0.2*k;
+			obs_field.obs.obs_data.pt.y = 0.5*i+0.01*k*k;
+			obs_field.obs.obs_data.pt.z = 2.0+0.1*i;
+			list_obs.push_back(obs_field);
+		}
+		srba_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, false /* don't optimize */);
+	}
+}
+
+// Optimizing several areas at once (concurrently, if they are independent) must give the same results than one by one:
+TEST(LocalAreas, SameResultsThanOneByOne)
+{
+	srba_t rba_ref, rba;
+	build_problem(rba_ref);
+	build_problem(rba);
+
+	const TKeyFrameID roots[2] = { 3, 17 };
+
+	std::vector<srba_t::TLocalAreaRequest>  areas;
+	std::vector<srba_t::TOptimizeExtraOutputInfo> infos_ref(2), infos;
+	for (int i=0;i<2;i++)
+	{
+		areas.push_back(srba_t::TLocalAreaRequest(roots[i],2));
+		rba_ref.optimize_local_area(roots[i],2, infos_ref[i]);
+	}
+	rba.optimize_local_areas(areas, infos);
+
+	ASSERT_EQ(2u, infos.size());
+	for (int i=0;i<2;i++)
+	{
+		EXPECT_EQ(infos_ref[i].num_observations, infos[i].num_observations);
+		EXPECT_NEAR(infos_ref[i].total_sqr_error_final, infos[i].total_sqr_error_final, 1e-9);
+	}
+
+	const srba_t::rba_problem_state_t &st_ref = rba_ref.get_rba_state(), &st = rba.get_rba_state();
+	ASSERT_EQ(st_ref.k2k_edges.size(), st.k2k_edges.size());
+	for (size_t i=0;i<st.k2k_edges.size();i++)
+		EXPECT_NEAR(0.0, (st_ref.k2k_edges[i].inv_pose.getHomogeneousMatrixVal()-st.k2k_edges[i].inv_pose.getHomogeneousMatrixVal()).array().abs().maxCoeff(), 1e-9) << "k2k edge #" << i;
+
+	// The numeric spanning trees must be in sync with the edges afterwards:
+	srba_t::TOptimizeExtraOutputInfo info_ref, info;
+	rba_ref.optimize_local_area(10,2, info_ref);
+	rba.optimize_local_area(10,2, info);
+	EXPECT_NEAR(info_ref.total_sqr_error_init, info.total_sqr_error_init, 1e-9);
+}
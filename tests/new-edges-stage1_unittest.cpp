@@ -0,0 +1,113 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+// A test edge-creation policy: link each new KF to the base KF of every landmark it observes again,
+// so a KF observing landmarks of several KFs gets several new edges at once:
+struct ecp_link_to_all_bases
+{
+	struct parameters_t
+	{
+		void loadFromConfigFile(const mrpt::utils::CConfigFileBase &,const std::string &) { }
+		void saveToConfigFile(mrpt::utils::CConfigFileBase &,const std::string &) const { }
+	};
+
+	template <class traits_t,class rba_engine_t>
+	void eval(
+		const TKeyFrameID               new_kf_id,
+		const typename traits_t::new_kf_observations_t   & obs,
+		std::vector<TNewEdgeInfo> &new_k2k_edge_ids,
+		rba_engine_t       & rba_engine,
+		const parameters_t &)
+	{
+		base_sorted_lst_t  obs_for_each_base_sorted;
+		srba::internal::make_ordered_list_base_kfs<traits_t,typename rba_engine_t::rba_problem_state_t>(obs, rba_engine.get_rba_state(), obs_for_each_base_sorted);
+
+		for (base_sorted_lst_t::const_iterator it=obs_for_each_base_sorted.begin();it!=obs_for_each_base_sorted.end();++it)
+		{
+			TNewEdgeInfo nei;
+			nei.id = rba_engine.create_kf2kf_edge(new_kf_id, TPairKeyFrameID(it->second, new_kf_id), obs);
+			nei.has_approx_init_val = false; // Estimate it in stage 1
+			new_k2k_edge_ids.push_back(nei);
+		}
+	}
+};
+
+struct RBA_OPTIONS_STAGE1 : public RBA_OPTIONS_DEFAULT
+{
+	typedef ecp_link_to_all_bases  edge_creation_policy_t;
+};
+
+typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, observations::Cartesian_3D, RBA_OPTIONS_STAGE1>  srba_t;
+
+// KF #0 observes landmarks "0...7", KF #1 sees "0...15", and so it becomes the base of "8...15".
+// KF #2 sees all of them, so it gets two new edges, to #0 and #1, whose stage-1 problems are independent:
+static void build_problem(srba_t &rba, const bool concurrently)
+{
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+	rba.parameters.srba.optimize_new_edges_concurrently = concurrently;
+	rba.parameters.srba.max_iters = 3;  // Don't let both converge to the optimum, so any difference in the stage-1 problems shows up
+
+	for (size_t k=0;k<3;k++)
+	{
+		srba_t::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<16;i++)
+		{
+			if (k==0 && i>=8)
+				continue;
+
+			// Landmarks at fixed positions, seen from KFs displaced along X, with some deterministic noise:
+			srba_t::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i;
+			obs_field.obs.obs_data.pt.x = 1.0+0.5*i-0.8*k + 0.01*std::sin(1.0+i+3.0*k);
+			obs_field.obs.obs_data.pt.y = 0.3*(i%5)-0.5+0.2*k + 0.01*std::cos(2.0+i*k);
+			obs_field.obs.obs_data.pt.z = 2.0+0.1*i + 0.01*std::sin(3.0*i+k);
+			list_obs.push_back(obs_field);
+		}
+		srba_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, true /* optimize */);
+
+		if (k==2) {
+			ASSERT_EQ(2u, new_kf_info.created_edge_ids.size());
+		}
+	}
+}
+
+// Initializing independent new edges concurrently must give the same results than one by one:
+TEST(NewEdgesStage1, ConcurrentSameAsSerial)
+{
+	srba_t rba_ref, rba;
+	build_problem(rba_ref, false);
+	build_problem(rba, true);
+
+	const srba_t::rba_problem_state_t &st_ref = rba_ref.get_rba_state(), &st = rba.get_rba_state();
+	ASSERT_EQ(3u, st_ref.k2k_edges.size());
+	ASSERT_EQ(st_ref.k2k_edges.size(), st.k2k_edges.size());
+	for (size_t i=0;i<st.k2k_edges.size();i++)
+	{
+		EXPECT_EQ(st_ref.k2k_edges[i].from, st.k2k_edges[i].from);
+		EXPECT_EQ(st_ref.k2k_edges[i].to, st.k2k_edges[i].to);
+		EXPECT_NEAR(0.0, (st_ref.k2k_edges[i].inv_pose.getHomogeneousMatrixVal()-st.k2k_edges[i].inv_pose.getHomogeneousMatrixVal()).array().abs().maxCoeff(), 1e-9) << "k2k edge #" << i;
+	}
+
+	// The numeric spanning trees must be in sync with the edges afterwards:
+	srba_t::TOptimizeExtraOutputInfo info_ref, info;
+	rba_ref.optimize_local_area(2,1, info_ref);
+	rba.optimize_local_area(2,1, info);
+	EXPECT_EQ(info_ref.num_observations, info.num_observations);
+	EXPECT_NEAR(info_ref.total_sqr_error_init, info.total_sqr_error_init, 1e-9);
+	EXPECT_NEAR(info_ref.total_sqr_error_final, info.total_sqr_error_final, 1e-9);
+}
@@ -0,0 +1,143 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+typedef TObservationDataStore<observations::Cartesian_3D>  store_t;
+
+static const size_t CHUNK = store_t::CHUNK_SIZE;
+
+// Values with more significant digits than a float can hold:
+static store_t::array_obs_t make_obs(const size_t i)
+{
+	store_t::array_obs_t o;
+	o[0] = 0.1 + 1e-9*i;
+	o[1] = 1.0/3.0 + i;
+	o[2] = -2.718281828459045 * (i+1);
+	return o;
+}
+
+// 3 chunks minus one observation, 100 observations per KF:
+static void build_store(store_t &store)
+{
+	for (size_t i=0;i<3*CHUNK-1;i++)
+		store.push_back(make_obs(i), static_cast<TKeyFrameID>(i/100));
+}
+
+static void expect_exact(const store_t &store, const size_t i)
+{
+	store_t::array_obs_t o;
+	store.get(i,o);
+	const store_t::array_obs_t ref = make_obs(i);
+	for (size_t k=0;k<store_t::OBS_DIMS;k++)
+		EXPECT_EQ(ref[k], o[k]);
+}
+
+static void expect_single_precision(const store_t &store, const size_t i)
+{
+	store_t::array_obs_t o;
+	store.get(i,o);
+	const store_t::array_obs_t ref = make_obs(i);
+	for (size_t k=0;k<store_t::OBS_DIMS;k++)
+		EXPECT_EQ(static_cast<double>(static_cast<float>(ref[k])), o[k]);
+}
+
+TEST(ObsDataStore, HotEntriesKeepDoublePrecision)
+{
+	store_t store;
+	build_store(store);
+	EXPECT_EQ(3*CHUNK-1, store.size());
+	EXPECT_EQ(3u, store.num_chunks());
+	EXPECT_EQ(0u, store.num_cold_chunks());
+
+	for (size_t i=0;i<store.size();i++)
+	{
+		expect_exact(store,i);
+		EXPECT_EQ(make_obs(i)[1], store.get_hot(i)[1]);
+	}
+}
+
+TEST(ObsDataStore, MoveToColdStorage)
+{
+	store_t store;
+	build_store(store);
+
+	// Chunk #0 has KFs 0-5, chunk #1 KFs 5-10: only the former is older than KF #6
+	EXPECT_EQ(1u, store.move_to_cold_storage(6));
+	EXPECT_EQ(1u, store.num_cold_chunks());
+	EXPECT_EQ(0u, store.move_to_cold_storage(6)); // Nothing left to move
+
+	// Reads across the hot/cold boundary:
+	expect_single_precision(store,0);
+	expect_single_precision(store,CHUNK-1);
+	expect_exact(store,CHUNK);
+	expect_exact(store,2*CHUNK);
+
+	// The last chunk is never moved, since it's still being filled:
+	EXPECT_EQ(1u, store.move_to_cold_storage(1000));
+	EXPECT_EQ(2u, store.num_cold_chunks());
+	expect_single_precision(store,2*CHUNK-1);
+	expect_exact(store,2*CHUNK);
+
+	// Appending after a move:
+	store.push_back(make_obs(3*CHUNK-1), 1000);
+	EXPECT_EQ(3*CHUNK, store.size());
+	expect_exact(store,3*CHUNK-1);
+}
+
+TEST(ObsDataStore, MakeHot)
+{
+	store_t store;
+	build_store(store);
+	store.move_to_cold_storage(6);
+
+	store.make_hot(10);
+	EXPECT_EQ(0u, store.num_cold_chunks());
+	// Rehydrated values keep the precision of cold storage:
+	EXPECT_EQ(static_cast<double>(static_cast<float>(make_obs(10)[2])), store.get_hot(10)[2]);
+	expect_single_precision(store,CHUNK-1);
+
+	store.make_hot(CHUNK); // Already hot
+	EXPECT_EQ(0u, store.num_cold_chunks());
+
+	// A rehydrated chunk is moved back once it's old enough:
+	EXPECT_EQ(1u, store.move_to_cold_storage(6));
+	EXPECT_EQ(1u, store.num_cold_chunks());
+	expect_single_precision(store,10);
+}
+
+// Chunks reserved in advance are neither counted as filled nor moved to cold storage:
+TEST(ObsDataStore, Reserve)
+{
+	store_t store;
+	store.reserve(3*CHUNK);
+	EXPECT_EQ(3u, store.num_chunks());
+	EXPECT_EQ(0u, store.size());
+
+	for (size_t i=0;i<CHUNK+10;i++)
+		store.push_back(make_obs(i), static_cast<TKeyFrameID>(i/100));
+	EXPECT_EQ(3u, store.num_chunks());
+
+	// Only chunk #0 is full:
+	EXPECT_EQ(1u, store.move_to_cold_storage(1000));
+	expect_single_precision(store,CHUNK-1);
+	expect_exact(store,CHUNK+9);
+
+	for (size_t i=CHUNK+10;i<3*CHUNK+1;i++)
+		store.push_back(make_obs(i), static_cast<TKeyFrameID>(i/100));
+	EXPECT_EQ(4u, store.num_chunks());
+	expect_exact(store,3*CHUNK);
+	EXPECT_EQ(2u, store.move_to_cold_storage(1000));
+	expect_single_precision(store,3*CHUNK-1);
+}
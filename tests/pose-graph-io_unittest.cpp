@@ -0,0 +1,80 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+#include <srba/srba_pose_graph_io.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace mrpt::poses;
+using namespace std;
+
+template <class POSE>
+static void test_round_trip(const pose_graph_format_t fmt, const POSE &p)
+{
+	typedef TPoseGraphRecord<POSE> record_t;
+	typename record_t::inf_matrix_t I;
+	I.setRandom();
+	I = (I*I.transpose()).eval();
+
+	stringstream ss;
+	{
+		PoseGraphFileWriter<POSE> writer(ss,fmt);
+		ss << "# A comment\nFIX 0\n";
+		writer.write_vertex(3, p);
+		writer.write_edge(3, 7, p, I);
+	}
+
+	PoseGraphFileReader<POSE> reader(ss);
+	record_t rec;
+	ASSERT_TRUE(reader.next(rec));
+	EXPECT_FALSE(rec.is_edge);
+	EXPECT_EQ(3u, rec.id);
+	EXPECT_NEAR(0.0, (rec.pose.getHomogeneousMatrixVal()-p.getHomogeneousMatrixVal()).array().abs().maxCoeff(), 1e-9);
+
+	ASSERT_TRUE(reader.next(rec));
+	EXPECT_TRUE(rec.is_edge);
+	EXPECT_EQ(3u, rec.from);
+	EXPECT_EQ(7u, rec.to);
+	EXPECT_NEAR(0.0, (rec.pose.getHomogeneousMatrixVal()-p.getHomogeneousMatrixVal()).array().abs().maxCoeff(), 1e-9);
+	EXPECT_NEAR(0.0, (rec.information-I).array().abs().maxCoeff(), 1e-9);
+	EXPECT_EQ(fmt, reader.format());
+
+	EXPECT_FALSE(reader.next(rec));
+	EXPECT_EQ(1u, reader.num_skipped_lines()); // "FIX"
+}
+
+TEST(PoseGraphIO, RoundTripSE2)
+{
+	test_round_trip(pgfG2O,  CPose2D(1.0,-2.0,0.3));
+	test_round_trip(pgfTORO, CPose2D(1.0,-2.0,0.3));
+}
+
+TEST(PoseGraphIO, RoundTripSE3)
+{
+	test_round_trip(pgfG2O,  CPose3D(1.0,-2.0,3.0, 0.3,-0.2,0.1));
+	test_round_trip(pgfTORO, CPose3D(1.0,-2.0,3.0, 0.3,-0.2,0.1));
+}
+
+TEST(PoseGraphIO, MalformedLines)
+{
+	TPoseGraphRecord<CPose2D> rec;
+	{
+		stringstream ss("VERTEX_SE2 0 0 0 0\nEDGE_SE2 0 1 1.0 0.0\n");
+		PoseGraphFileReader<CPose2D> reader(ss);
+		EXPECT_TRUE(reader.next(rec));
+		EXPECT_ANY_THROW(reader.next(rec));
+	}
+	{
+		stringstream ss("VERTEX_SE3:QUAT 0 0 0 0 0 0 0 1\n");
+		PoseGraphFileReader<CPose2D> reader(ss);
+		EXPECT_ANY_THROW(reader.next(rec));
+	}
+}
@@ -0,0 +1,156 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, observations::Cartesian_3D>  srba_t;
+
+// 5 KFs, each one observing 8 landmarks, with IDs "k...k+7":
+static void build_problem(srba_t &rba)
+{
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+	rba.parameters.srba.removed_obs_compaction_ratio = 0; // Only compact explicitly
+
+	for (size_t k=0;k<5;k++)
+	{
+		srba_t::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<8;i++)
+		{
+			srba_t::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i+k;
+			obs_field.obs.obs_data.pt.x = 1.0+i-0.2*k;
+			obs_field.obs.obs_data.pt.y = 0.5*i+0.01*k*k;
+			obs_field.obs.obs_data.pt.z = 2.0+0.1*i;
+			list_obs.push_back(obs_field);
+		}
+		srba_t::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, false /* don't optimize */);
+	}
+}
+
+// Check that the per-landmark lists of observations and the per-KF lists of edges agree with all_observations
+// (tombstones of removed landmarks are not in any list):
+static void check_obs_indices(const srba_t &rba)
+{
+	const srba_t::rba_problem_state_t &st = rba.get_rba_state();
+
+	size_t nObsInLists = 0;
+	for (size_t lm=0;lm<st.all_lms.size();lm++)
+		for (size_t i=st.all_lms[lm].first_obs_idx;i!=SRBA_INVALID_INDEX;i=st.all_observations[i].next_obs_same_lm)
+		{
+			EXPECT_EQ(lm, st.all_observations[i].obs.feat_id);
+			if (!st.all_observations[i].is_removed)
+				nObsInLists++;
+		}
+
+	size_t nAdjEdges = 0;
+	for (size_t kf=0;kf<st.keyframes.size();kf++)
+		for (size_t i=0;i<st.keyframes[kf].adjacent_k2f_edges.size();i++)
+		{
+			EXPECT_EQ(kf, st.keyframes[kf].adjacent_k2f_edges[i]->obs.kf_id);
+			nAdjEdges++;
+		}
+
+	EXPECT_EQ(st.all_observations.size(), nAdjEdges);
+	EXPECT_EQ(st.all_observations.size(), nObsInLists + st.num_removed_observations);
+	EXPECT_EQ(st.all_observations.size(), st.obs_data.size());
+}
+
+TEST(RemoveObservations, RemoveObservation)
+{
+	srba_t rba;
+	build_problem(rba);
+
+	srba_t::TOptimizeExtraOutputInfo info_before, info_after;
+	rba.optimize_local_area(4, 3, info_before);
+
+	EXPECT_TRUE(rba.remove_observation(4,5));
+	EXPECT_FALSE(rba.remove_observation(4,5)); // Already removed
+	EXPECT_FALSE(rba.remove_observation(0,9)); // Never observed
+	EXPECT_EQ(1u, rba.get_rba_state().num_removed_observations);
+	check_obs_indices(rba);
+
+	rba.optimize_local_area(4, 3, info_after);
+	EXPECT_EQ(info_before.num_observations-1, info_after.num_observations);
+}
+
+TEST(RemoveObservations, RemoveLandmark)
+{
+	srba_t rba;
+	build_problem(rba);
+
+	// LM #3 is observed from KFs #0-#3:
+	ASSERT_EQ(1u, rba.get_unknown_feats().count(3));
+	EXPECT_TRUE(rba.remove_landmark(3));
+	EXPECT_FALSE(rba.remove_landmark(3));
+	EXPECT_EQ(0u, rba.get_unknown_feats().count(3));
+	EXPECT_EQ(4u, rba.get_rba_state().num_removed_observations);
+	EXPECT_EQ(SRBA_INVALID_INDEX, rba.get_rba_state().lin_system.dh_df.findColByRemapIndex(3));
+	check_obs_indices(rba);
+
+	srba_t::TOptimizeExtraOutputInfo info;
+	rba.optimize_local_area(4, 3, info);
+	EXPECT_GT(info.num_observations, 0u);
+	EXPECT_LT(info.total_sqr_error_final, info.total_sqr_error_init+1e-9);
+
+	// The ID can be reused by a new KF, with a new column in dh_df:
+	srba_t::new_kf_observations_t  list_obs;
+	for (size_t i=0;i<8;i++)
+	{
+		srba_t::new_kf_observation_t obs_field;
+		obs_field.obs.feat_id = (i==0) ? 3 : i+4;
+		obs_field.obs.obs_data.pt.x = 0.1*i;
+		obs_field.obs.obs_data.pt.y = 0.5*i;
+		obs_field.obs.obs_data.pt.z = 2.0+0.1*i;
+		list_obs.push_back(obs_field);
+	}
+	srba_t::TNewKeyFrameInfo new_kf_info;
+	rba.define_new_keyframe(list_obs, new_kf_info, false /* don't optimize */);
+	EXPECT_EQ(1u, rba.get_unknown_feats().count(3));
+	EXPECT_NE(SRBA_INVALID_INDEX, rba.get_rba_state().lin_system.dh_df.findColByRemapIndex(3));
+	check_obs_indices(rba);
+}
+
+// Compacting must not change the results of optimizations:
+TEST(RemoveObservations, Compaction)
+{
+	srba_t rba_ref, rba;
+	build_problem(rba_ref);
+	build_problem(rba);
+
+	srba_t *rbas[2] = { &rba_ref, &rba };
+	for (int i=0;i<2;i++)
+	{
+		rbas[i]->remove_observation(4,8);
+		rbas[i]->remove_observation(2,6);
+		rbas[i]->remove_landmark(10); // Seen from KFs #3 and #4
+	}
+
+	EXPECT_EQ(4u, rba.compact_observations());
+	EXPECT_EQ(0u, rba.get_rba_state().num_removed_observations);
+	EXPECT_EQ(rba_ref.get_rba_state().all_observations.size()-4, rba.get_rba_state().all_observations.size());
+	check_obs_indices(rba);
+	check_obs_indices(rba_ref);
+
+	srba_t::TOptimizeExtraOutputInfo info_ref, info;
+	rba_ref.optimize_local_area(4, 3, info_ref);
+	rba.optimize_local_area(4, 3, info);
+
+	EXPECT_EQ(info_ref.num_observations, info.num_observations);
+	EXPECT_EQ(info_ref.num_total_scalar_optimized, info.num_total_scalar_optimized);
+	EXPECT_NEAR(info_ref.total_sqr_error_init, info.total_sqr_error_init, 1e-9);
+	EXPECT_NEAR(info_ref.total_sqr_error_final, info.total_sqr_error_final, 1e-9);
+	EXPECT_EQ(0u, rba.compact_observations());
+}
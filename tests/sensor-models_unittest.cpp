@@ -0,0 +1,249 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2015, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <srba.h>
+
+#include <gtest/gtest.h>
+
+using namespace srba;
+using namespace std;
+
+typedef sensor_model<landmarks::Euclidean3D,observations::RangeBearing_3D> rb3d_model_t;
+
+static const double test_pts[][3] = {
+	{ 1.0, 2.0, 3.0 },
+	{ -4.0, 0.5, -1.0 },
+	{ 0.1, -3.0, 0.2 },
+	{ -2.0, -2.0, 5.0 } };
+
+// The closed-form prediction must match mrpt::poses::CPose3D::sphericalCoordinates():
+TEST(SensorModels, RangeBearing3D_Prediction)
+{
+	const mrpt::poses::CPose3D origin;
+	for (size_t i=0;i<sizeof(test_pts)/sizeof(test_pts[0]);i++)
+	{
+		const double *p = test_pts[i];
+		double range,yaw,pitch;
+		origin.sphericalCoordinates(mrpt::math::TPoint3D(p[0],p[1],p[2]), range,yaw,pitch);
+
+		observation_traits<observations::RangeBearing_3D>::array_obs_t pred;
+		rb3d_model_t::predict(p[0],p[1],p[2], pred);
+		EXPECT_NEAR(range, pred[0], 1e-12);
+		EXPECT_NEAR(yaw,   pred[1], 1e-12);
+		EXPECT_NEAR(pitch, pred[2], 1e-12);
+	}
+}
+
+// The analytic Jacobian must match a numeric one:
+TEST(SensorModels, RangeBearing3D_Jacobian)
+{
+	const double eps = 1e-6;
+	rb3d_model_t::TObservationParams params;
+	for (size_t i=0;i<sizeof(test_pts)/sizeof(test_pts[0]);i++)
+	{
+		rb3d_model_t::array_landmark_t x;
+		for (int k=0;k<3;k++) x[k] = test_pts[i][k];
+
+		rb3d_model_t::TJacobian_dh_dx dh_dx;
+		ASSERT_TRUE(rb3d_model_t::eval_jacob_dh_dx(dh_dx, x, params));
+
+		for (int k=0;k<3;k++)
+		{
+			observation_traits<observations::RangeBearing_3D>::array_obs_t h1,h2;
+			rb3d_model_t::array_landmark_t x1=x, x2=x;
+			x1[k]-=eps; x2[k]+=eps;
+			rb3d_model_t::predict(x1[0],x1[1],x1[2], h1);
+			rb3d_model_t::predict(x2[0],x2[1],x2[2], h2);
+			for (int r=0;r<3;r++)
+				EXPECT_NEAR((h2[r]-h1[r])/(2*eps), dh_dx(r,k), 1e-6);
+		}
+	}
+
+	// Undefined on the Z axis:
+	rb3d_model_t::array_landmark_t x;
+	x[0]=0; x[1]=0; x[2]=1.0;
+	rb3d_model_t::TJacobian_dh_dx dh_dx;
+	EXPECT_FALSE(rb3d_model_t::eval_jacob_dh_dx(dh_dx, x, params));
+}
+
+typedef observations::MultiSensor<observations::Cartesian_3D,observations::RangeBearing_3D> multi_obs_t;
+typedef sensor_model<landmarks::Euclidean3D,multi_obs_t> multi_model_t;
+
+TEST(SensorModels, MultiSensor_ArrayRoundTrip)
+{
+	EXPECT_EQ(4u, multi_obs_t::OBS_DIMS);
+
+	multi_obs_t::obs_data_t o, o2;
+	o.sensor = 1;
+	o.b.range = 2.0; o.b.yaw = 0.3; o.b.pitch = -0.1;
+
+	observation_traits<multi_obs_t>::array_obs_t arr;
+	o.getAsArray(arr);
+	EXPECT_EQ(1.0, arr[3]);
+
+	o2.setFromArray(arr);
+	EXPECT_EQ(1u, o2.sensor);
+	EXPECT_EQ(o.b.range, o2.b.range);
+	EXPECT_EQ(o.b.yaw,   o2.b.yaw);
+	EXPECT_EQ(o.b.pitch, o2.b.pitch);
+}
+
+// The analytic Jacobian of each sensor, at its own pose on the rig, must match a numeric one:
+TEST(SensorModels, MultiSensor_Jacobian)
+{
+	const double eps = 1e-6;
+	const mrpt::poses::CPose3D origin;
+	multi_model_t::TObservationParams params;
+	params.sensor_pose_a = mrpt::poses::CPose3D(0.1,-0.2,0.3, 0.4,-0.1,0.2);
+	params.sensor_pose_b = mrpt::poses::CPose3D(-0.5,0.2,0.1, -0.3,0.2,0.1);
+	params.std_noise_a = 0.5;
+	params.std_noise_b = 2.0;
+
+	for (unsigned int sensor=0;sensor<2;sensor++)
+	{
+		for (size_t i=0;i<sizeof(test_pts)/sizeof(test_pts[0]);i++)
+		{
+			multi_model_t::array_landmark_t x;
+			for (int k=0;k<3;k++) x[k] = test_pts[i][k];
+
+			multi_model_t::array_obs_t z;
+			z.setZero();
+			z[3] = sensor;
+
+			multi_model_t::TJacobian_dh_dx dh_dx;
+			ASSERT_TRUE(multi_model_t::eval_jacob_dh_dx(dh_dx, x, z, params));
+
+			for (int k=0;k<3;k++)
+			{
+				multi_model_t::array_obs_t err1,err2;
+				multi_model_t::array_landmark_t x1=x, x2=x;
+				x1[k]-=eps; x2[k]+=eps;
+				multi_model_t::observe_error(err1, z, origin, x1, params);  // "z - h(x)"
+				multi_model_t::observe_error(err2, z, origin, x2, params);
+				for (int r=0;r<4;r++)
+					EXPECT_NEAR((err1[r]-err2[r])/(2*eps), dh_dx(r,k), 1e-5);
+			}
+		}
+	}
+
+	// The inverse sensor model must be consistent with the sensor pose:
+	multi_obs_t::obs_data_t o;
+	o.sensor = 0;
+	o.a.pt = mrpt::math::TPoint3D(1.0,2.0,3.0);
+	multi_model_t::array_landmark_t lm;
+	multi_model_t::inverse_sensor_model(lm, o, params);
+
+	multi_model_t::array_obs_t z, err;
+	o.getAsArray(z);
+	multi_model_t::observe_error(err, z, origin, lm, params);
+	for (int r=0;r<4;r++)
+		EXPECT_NEAR(0.0, err[r], 1e-9);
+}
+
+// Camera models must never fall back to numeric Jacobians (they're ill-defined only for points behind the camera):
+TEST(SensorModels, NumericJacobianFallbackAllowed)
+{
+	EXPECT_TRUE (static_cast<bool>(internal::sensor_allows_numeric_jacob_fallback<rb3d_model_t>::value));
+	EXPECT_FALSE(static_cast<bool>(internal::sensor_allows_numeric_jacob_fallback< sensor_model<landmarks::Euclidean3D,observations::MonocularCamera> >::value));
+	EXPECT_FALSE(static_cast<bool>(internal::sensor_allows_numeric_jacob_fallback< sensor_model<landmarks::Euclidean3D,observations::StereoCamera> >::value));
+}
+
+// A rig allows the numeric fallback only if none of its sensors disallows it, whatever their order:
+TEST(SensorModels, MultiSensorNumericJacobianFallback)
+{
+	EXPECT_TRUE (static_cast<bool>(internal::sensor_allows_numeric_jacob_fallback<multi_model_t>::value));
+	EXPECT_FALSE(static_cast<bool>(internal::sensor_allows_numeric_jacob_fallback< sensor_model<landmarks::Euclidean3D,observations::MultiSensor<observations::RangeBearing_3D,observations::MonocularCamera> > >::value));
+	EXPECT_FALSE(static_cast<bool>(internal::sensor_allows_numeric_jacob_fallback< sensor_model<landmarks::Euclidean3D,observations::MultiSensor<observations::MonocularCamera,observations::RangeBearing_3D> > >::value));
+	EXPECT_FALSE(static_cast<bool>(internal::sensor_allows_numeric_jacob_fallback< sensor_model<landmarks::Euclidean3D,observations::MultiSensor<observations::MonocularCamera,observations::StereoCamera> > >::value));
+}
+
+// Cartesian 3D observations, but their analytic Jacobian can be forced to be ill-defined (while h() stays smooth):
+struct TestCartesian_3D : public observations::Cartesian_3D { };
+static bool test_cartesian_jacob_ill_defined = false;
+
+namespace srba {
+	template <>
+	struct sensor_model<landmarks::Euclidean3D,TestCartesian_3D> : public sensor_model<landmarks::Euclidean3D,observations::Cartesian_3D>
+	{
+		typedef TestCartesian_3D OBS_T;
+
+		static bool eval_jacob_dh_dx(TJacobian_dh_dx &dh_dx, const array_landmark_t &xji_l, const TObservationParams &sensor_params)
+		{
+			if (test_cartesian_jacob_ill_defined)
+				return false;
+			return sensor_model<landmarks::Euclidean3D,observations::Cartesian_3D>::eval_jacob_dh_dx(dh_dx,xji_l,sensor_params);
+		}
+	};
+}
+
+// A chain of 3 KFs, each one observing 8 landmarks, with IDs "k...k+7":
+template <class RBA>
+static void build_cartesian_problem(RBA &rba)
+{
+	rba.get_time_profiler().disable();
+	rba.setVerbosityLevel(0);
+
+	for (size_t k=0;k<3;k++)
+	{
+		typename RBA::new_kf_observations_t  list_obs;
+		for (size_t i=0;i<8;i++)
+		{
+			typename RBA::new_kf_observation_t obs_field;
+			obs_field.obs.feat_id = i+k;
+			obs_field.obs.obs_data.pt.x = 1.0+i-0.2*k;
+			obs_field.obs.obs_data.pt.y = 0.5*i+0.01*k*k;
+			obs_field.obs.obs_data.pt.z = 2.0+0.1*i;
+			list_obs.push_back(obs_field);
+		}
+		typename RBA::TNewKeyFrameInfo new_kf_info;
+		rba.define_new_keyframe(list_obs, new_kf_info, false /* don't optimize */);
+	}
+}
+
+// Ill-defined analytic Jacobians are replaced by cached numeric ones, which are dropped once the analytic ones are valid again:
+TEST(SensorModels, NumericJacobianFallback)
+{
+	typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, observations::Cartesian_3D>  srba_ref_t;
+	typedef RbaEngine<kf2kf_poses::SE3, landmarks::Euclidean3D, TestCartesian_3D>            srba_test_t;
+
+	srba_ref_t  rba_ref;
+	srba_test_t rba;
+	build_cartesian_problem(rba_ref);
+	build_cartesian_problem(rba);
+	rba.parameters.srba.numeric_jacobians_fallback = true;
+
+	srba_ref_t::TOptimizeExtraOutputInfo  info_ref;
+	srba_test_t::TOptimizeExtraOutputInfo info;
+	rba_ref.optimize_local_area(2, 2, info_ref);
+
+	test_cartesian_jacob_ill_defined = true;
+	rba.optimize_local_area(2, 2, info);
+	test_cartesian_jacob_ill_defined = false;
+
+	// The numeric Jacobians were used and cached:
+	const srba_test_t::rba_problem_state_t &st = rba.get_rba_state();
+	EXPECT_FALSE(rba.m_numeric_jacob_cache.empty());
+	size_t nFlagged = 0;
+	for (size_t i=0;i<st.all_observations.size();i++)
+		if (st.all_observations[i].has_numeric_jacob) nFlagged++;
+	EXPECT_EQ(rba.m_numeric_jacob_cache.size(), nFlagged);
+	for (srba_test_t::numeric_jacob_cache_t::const_iterator it=rba.m_numeric_jacob_cache.begin();it!=rba.m_numeric_jacob_cache.end();++it)
+	{
+		EXPECT_TRUE(st.all_observations[it->first].has_numeric_jacob);
+		EXPECT_NEAR(0.0, (it->second.dh_dx - Eigen::Matrix3d::Identity()).array().abs().maxCoeff(), 1e-6);
+	}
+	EXPECT_EQ(info_ref.num_observations, info.num_observations);
+	EXPECT_NEAR(info_ref.total_sqr_error_final, info.total_sqr_error_final, 1e-6);
+
+	// Well-defined again: the cache entries are dropped
+	rba.optimize_local_area(2, 2, info);
+	EXPECT_TRUE(rba.m_numeric_jacob_cache.empty());
+	for (size_t i=0;i<st.all_observations.size();i++)
+		EXPECT_FALSE(st.all_observations[i].has_numeric_jacob);
+}
@@ -150,11 +150,8 @@ void test_spantree_topology(
 			return;
 		}
 
-		// Get the numeric ST of this KF:
-		kf2kf_pose_traits<my_srba_t::kf2kf_pose_t>::TRelativePosesForEachTarget::const_iterator it_num_st_i = rba.get_rba_state().spanning_tree.num.find(kf);
-		ASSERT_(it_num_st_i != rba.get_rba_state().spanning_tree.num.end())
-
-		const my_srba_t::frameid2pose_map_t & num_st_i = it_num_st_i->second;
+		// The numeric ST of this KF:
+		const my_srba_t::rba_problem_state_t::TSpanningTree::num_spanning_tree_t & num_st = rba.get_rba_state().spanning_tree.num;
 
 		// For each reachable KF:
 		for (my_srba_t::frameid2pose_map_t::const_iterator it=st.begin();it!=st.end();++it)
@@ -200,10 +197,9 @@ void test_spantree_topology(
 			// -------------------------------------------------------------------------------
 			const mrpt::poses::CPose3D &rel_pose_complete_st = it->second.pose;
 
-			my_srba_t::frameid2pose_map_t::const_iterator it_num_st_i_j = num_st_i.find(dst_kf);
-			ASSERT_(it_num_st_i_j != num_st_i.end())
-
-			const mrpt::poses::CPose3D &rel_pose_incr_st = it_num_st_i_j->second.pose;
+			mrpt::poses::CPose3D rel_pose_incr_st;
+			const bool found_num = num_st.get(kf,dst_kf, rel_pose_incr_st);
+			ASSERT_(found_num)
 
 			EXPECT_NEAR(0, (rel_pose_complete_st.getAsVectorVal() - rel_pose_incr_st.getAsVectorVal()).array().abs().sum(), 1e-6)
 				<< "Error in numeric relative pose of KF " << dst_kf << " from KF " << kf <<":" << endl
@@ -244,3 +240,188 @@ TEST(SpanTreeTests,LinearGraphsInv)        { run_spantree_topology(100);  }
 TEST(SpanTreeTests,LinearGraphsWithLoops)     { run_spantree_topology(1);  }
 TEST(SpanTreeTests,LinearGraphsWithLoopsInv)  { run_spantree_topology(101);  }
 
+
+// The numeric spanning tree only stores one direction for each pair, plus the inverses explicitly requested:
+TEST(SpanTreeTests,NumericOneDirectionStorage)
+{
+	typedef TNumericSpanningTree<kf2kf_poses::SE3> num_st_t;
+	num_st_t num;
+
+	const mrpt::poses::CPose3D p10(1.0,2.0,3.0, 0.1,0.2,0.3);
+	num_st_t::TEntry &e = num.get_entry(1,0);
+	EXPECT_FALSE(num_st_t::is_updated(e));
+	num.update_pose(e, p10);
+	EXPECT_TRUE(num_st_t::is_updated(e));
+
+	EXPECT_EQ(1u, num.size());
+	EXPECT_EQ(0u, num.num_cached_inverses());
+	EXPECT_TRUE(num.find(1,0)!=NULL);
+	EXPECT_TRUE(num.find(0,1)==NULL);  // Not cached yet
+
+	mrpt::poses::CPose3D p;
+	ASSERT_TRUE(num.get(0,1, p));  // On-the-fly inverse
+	EXPECT_NEAR(0, ((-p10).getAsVectorVal() - p.getAsVectorVal()).array().abs().sum(), 1e-9);
+	EXPECT_FALSE(num.get(2,0, p));
+
+	// Persistent pointers survive the insertion of many more entries, and cached inverses are kept up-to-date:
+	const num_st_t::pose_flag_t *p01 = &num.get_ref(0,1);
+	const num_st_t::pose_flag_t *p10_ptr = &num.get_ref(1,0);
+	EXPECT_EQ(1u, num.num_cached_inverses());
+	EXPECT_TRUE(p01->updated());
+	const num_st_t::pose_flag_t *p150_0 = &num.get_ref(150,0);
+	const num_st_t::TEntry *e150_149 = &num.get_entry(150,149);
+
+	for (TKeyFrameID i=2;i<200;i++)
+		for (TKeyFrameID j=0;j<i;j+=3)
+			num.get_ref(j,i);
+	EXPECT_TRUE(p01==num.find(0,1));
+	EXPECT_TRUE(p10_ptr==num.find(1,0));
+	EXPECT_TRUE(p150_0==num.find(150,0));
+	EXPECT_TRUE(e150_149==&num.get_entry(150,149)); // So are references to entries
+
+	const mrpt::poses::CPose3D p10_new(-1.0,0.5,0.0, -0.2,0.0,0.1);
+	p01->mark_outdated();
+	num_st_t::TEntry &e2 = num.get_entry(1,0);
+	EXPECT_FALSE(num_st_t::is_updated(e2));
+	num.update_pose(e2, p10_new);
+	EXPECT_TRUE(p01->updated());
+	EXPECT_NEAR(0, ((-p10_new).getAsVectorVal() - p01->pose.getAsVectorVal()).array().abs().sum(), 1e-9);
+
+	// Marking a pair as outdated affects both directions:
+	num.mark_outdated(1,0);
+	EXPECT_FALSE(num_st_t::is_updated(e2));
+	EXPECT_FALSE(p01->updated());
+	EXPECT_FALSE(p10_ptr->updated());
+	num.update_pose(e2, p10);
+	EXPECT_TRUE(num_st_t::is_updated(e2));
+	num.mark_outdated(2,1); // Not in the table: no-op
+}
+
+// Edge-existence queries on a hub KF connected to many others, and rejection of duplicated edges:
+TEST(SpanTreeTests,EdgeExistenceIndex)
+{
+	my_srba_t::traits_t::new_kf_observations_t  dummy_obs; // Not used
+	my_srba_t rba;
+	rba.enable_time_profiler(false);
+
+	const TKeyFrameID nKFs = 100;
+	for (TKeyFrameID kf=0;kf<nKFs;kf++)
+		rba.alloc_keyframe();
+
+	// KF #50 is connected to all the others, with edges in both directions:
+	std::vector<size_t> edge_ids(nKFs, SRBA_INVALID_INDEX);
+	for (TKeyFrameID kf=0;kf<nKFs;kf++)
+		if (kf!=50)
+			edge_ids[kf] = rba.create_kf2kf_edge(std::max(kf,TKeyFrameID(50)), (kf%2) ? TPairKeyFrameID(kf,50) : TPairKeyFrameID(50,kf), dummy_obs);
+
+	const my_srba_t::rba_problem_state_t &st = rba.get_rba_state();
+	for (TKeyFrameID kf=0;kf<nKFs;kf++)
+	{
+		EXPECT_EQ(edge_ids[kf], st.find_kf2kf_edge(50,kf));
+		EXPECT_EQ(edge_ids[kf], st.find_kf2kf_edge(kf,50));
+		EXPECT_EQ(kf!=50, st.are_keyframes_connected(kf,50));
+	}
+	EXPECT_FALSE(st.are_keyframes_connected(10,20));
+
+	const size_t nEdges = st.k2k_edges.size();
+	EXPECT_THROW(rba.create_kf2kf_edge(51, TPairKeyFrameID(51,50), dummy_obs), std::exception);
+	EXPECT_THROW(rba.create_kf2kf_edge(50, TPairKeyFrameID(50,51), dummy_obs), std::exception);
+	EXPECT_EQ(nEdges, st.k2k_edges.size());
+}
+
+// Recomputing only a given subset of numeric poses (as done by concurrent optimizations) must not touch the rest:
+TEST(SpanTreeTests,UpdateOnlyGivenNumericPoses)
+{
+	my_srba_t::traits_t::new_kf_observations_t  dummy_obs; // Not used
+	my_srba_t rba;
+	rba.enable_time_profiler(false);
+	rba.parameters.srba.max_tree_depth = 4;
+
+	// Linear graph: 0 <- 1 <- 2 <- 3
+	const mrpt::poses::CPose3D step(1.0,0.0,0.0, 0.1,0.0,0.0);
+	std::vector<size_t> edge_ids;
+	for (TKeyFrameID kf=0;kf<4;kf++)
+	{
+		const TKeyFrameID new_kf = rba.alloc_keyframe();
+		if (new_kf)
+			edge_ids.push_back( rba.create_kf2kf_edge(new_kf, TPairKeyFrameID(new_kf-1,new_kf), dummy_obs, -step) );
+	}
+
+	my_srba_t::rba_problem_state_t &st = rba.get_rba_state();
+	st.spanning_tree.update_numeric(false);
+
+	mrpt::poses::CPose3D p30_old, p21_old;
+	ASSERT_TRUE(st.spanning_tree.num.get(3,0, p30_old));
+	ASSERT_TRUE(st.spanning_tree.num.get(2,1, p21_old));
+
+	// Modify the edge 2->3, and only recompute the pose (3,0) (but not (3,2), also through that edge):
+	st.k2k_edges[edge_ids[2]].inv_pose = -(step+step);
+
+	my_srba_t::rba_problem_state_t::TSpanningTree::numeric_pose_path_list_t poses(1);
+	poses[0].from  = 3;
+	poses[0].to    = 0;
+	poses[0].entry = &st.spanning_tree.num.get_entry(3,0);
+	poses[0].path  = &st.spanning_tree.sym.all_edges[3][0];
+	EXPECT_EQ(1u, st.spanning_tree.update_numeric_poses(poses));
+
+	mrpt::poses::CPose3D p30_new, p21_new, p32;
+	ASSERT_TRUE(st.spanning_tree.num.get(3,0, p30_new));
+	ASSERT_TRUE(st.spanning_tree.num.get(2,1, p21_new));
+	ASSERT_TRUE(st.spanning_tree.num.get(3,2, p32));
+	const mrpt::poses::CPose3D p30_expected = -(step+step+step+step);
+	EXPECT_NEAR(0, (p30_expected.getAsVectorVal() - p30_new.getAsVectorVal()).array().abs().sum(), 1e-9);
+	EXPECT_NEAR(0, (p21_old.getAsVectorVal() - p21_new.getAsVectorVal()).array().abs().sum(), 1e-12);
+	EXPECT_NEAR(0, ((-step).getAsVectorVal() - p32.getAsVectorVal()).array().abs().sum(), 1e-9); // Not updated
+}
+
+// Modifying an edge only outdates the numeric poses whose paths go thru it:
+TEST(SpanTreeTests,MarkEdgeModified)
+{
+	my_srba_t::traits_t::new_kf_observations_t  dummy_obs; // Not used
+	my_srba_t rba;
+	rba.enable_time_profiler(false);
+	rba.parameters.srba.max_tree_depth = 4;
+
+	// Linear graph: 0 <- 1 <- 2 <- 3
+	const mrpt::poses::CPose3D step(1.0,0.0,0.0, 0.1,0.0,0.0);
+	std::vector<size_t> edge_ids;
+	for (TKeyFrameID kf=0;kf<4;kf++)
+	{
+		const TKeyFrameID new_kf = rba.alloc_keyframe();
+		if (new_kf)
+			edge_ids.push_back( rba.create_kf2kf_edge(new_kf, TPairKeyFrameID(new_kf-1,new_kf), dummy_obs, -step) );
+	}
+
+	my_srba_t::rba_problem_state_t &st = rba.get_rba_state();
+	st.spanning_tree.update_numeric(false);
+
+	typedef my_srba_t::rba_problem_state_t::TSpanningTree::num_spanning_tree_t num_st_t;
+	num_st_t &num = st.spanning_tree.num;
+	my_srba_t::rba_problem_state_t::TSpanningTree::all_edges_maps_t &paths = st.spanning_tree.sym.all_edges;
+	EXPECT_TRUE(num.is_updated(num.get_entry(3,0), paths[3][0]));
+
+	// The edge 2->3 is in the paths of (3,2), (3,1) and (3,0), and modifying it only stamps the edge:
+	const uint64_t gen_before = num.current_generation();
+	st.k2k_edges[edge_ids[2]].inv_pose = -(step+step);
+	st.spanning_tree.mark_edge_modified(edge_ids[2]);
+	EXPECT_EQ(gen_before+1, num.current_generation());
+	EXPECT_EQ(num.current_generation(), st.k2k_edges[edge_ids[2]].generation);
+
+	EXPECT_FALSE(num.is_updated(num.get_entry(3,0), paths[3][0]));
+	EXPECT_FALSE(num.is_updated(num.get_entry(3,2), paths[3][2]));
+	EXPECT_TRUE (num.is_updated(num.get_entry(2,0), paths[2][0]));
+	EXPECT_TRUE (num.is_updated(num.get_entry(1,0), paths[1][0]));
+	EXPECT_FALSE(num.is_updated(num.get_entry(3,0), paths[3][0])); // Cached result of its path
+
+	st.spanning_tree.update_numeric(true);
+	mrpt::poses::CPose3D p30;
+	ASSERT_TRUE(num.get(3,0, p30));
+	const mrpt::poses::CPose3D p30_expected = -(step+step+step+step);
+	EXPECT_NEAR(0, (p30_expected.getAsVectorVal() - p30.getAsVectorVal()).array().abs().sum(), 1e-9);
+	EXPECT_TRUE(num.is_updated(num.get_entry(3,0), paths[3][0]));
+	EXPECT_TRUE(num.is_updated(num.get_entry(3,2), paths[3][2]));
+
+	// Explicit invalidation still works:
+	num.mark_outdated(2,0);
+	EXPECT_FALSE(num.is_updated(num.get_entry(2,0), paths[2][0]));
+}